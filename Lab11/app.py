@@ -1,6 +1,9 @@
+import heapq
 import os
+import tempfile
 
-from flask import Flask, request
+from flask import Flask, abort, request, send_file
+from werkzeug.security import safe_join
 import random
 import string
 
@@ -8,24 +11,89 @@ app = Flask(__name__)
 
 path = "file_sandbox"
 
+CHUNK_SIZE = 64 * 1024
+PAGE_SIZE = 100
+MAX_PAGE_SIZE = 1000
+# Larger files are only served by /files/<name>, which streams them
+MAX_INLINE_CONTENT = 1024 * 1024
+
+
+def sandbox_path(name):
+    # Rejects absolute paths and '..' so requests stay inside the sandbox
+    full_path = safe_join(path, name or "")
+    if full_path is None:
+        abort(400)
+    return full_path
+
+
+def write_atomic(full_path, chunks):
+    """Write chunks to a temporary file next to full_path, then rename it
+    over full_path, so readers never see a partly written file."""
+    fd, tmp_path = tempfile.mkstemp(dir=os.path.dirname(full_path) or ".", prefix=".upload-")
+    try:
+        with os.fdopen(fd, 'wb') as f:
+            os.fchmod(fd, 0o644)    # mkstemp creates it private
+            for chunk in chunks:
+                f.write(chunk)
+        os.replace(tmp_path, full_path)
+    except BaseException:
+        os.unlink(tmp_path)
+        raise
+
+
+def request_chunks():
+    # The body is read as it arrives instead of being buffered whole
+    while True:
+        chunk = request.stream.read(CHUNK_SIZE)
+        if not chunk:
+            return
+        yield chunk
+
+
 @app.get('/get_files')
 def get_files():
     folder_path = "" if request.args.get('folder_path') is None else request.args.get('folder_path')
-
-    complete_path = os.path.join(path, folder_path)
-    # return the list of files in the directory
-    files = os.listdir(complete_path)
-    return {'files': files}
+    cursor = request.args.get('cursor', "")
+    # limit=0 or a negative limit would index files[-1] below
+    limit = max(1, min(request.args.get('limit', PAGE_SIZE, type=int), MAX_PAGE_SIZE))
+
+    complete_path = sandbox_path(folder_path)
+    # One page of names in sorted order, after the cursor. Only `limit` names
+    # are kept while the directory is scanned.
+    with os.scandir(complete_path) as entries:
+        files = heapq.nsmallest(limit + 1, (e.name for e in entries if e.name > cursor))
+    next_cursor = files[limit - 1] if len(files) > limit else None
+    return {'files': files[:limit], 'next_cursor': next_cursor}
 
 @app.get("/get_file_content")
 def get_file_content():
     file_name = request.args.get('file_name')
 
+    full_path = sandbox_path(file_name)
+    if os.path.getsize(full_path) > MAX_INLINE_CONTENT:
+        abort(413, description="File too large, use /files/" + file_name)
     # read the file in the directory
-    with open(os.path.join(path, file_name), 'r') as f:
+    with open(full_path, 'r') as f:
         content = f.read()
     return {'content': content}
 
+@app.get('/files/<path:file_name>')
+def download_file(file_name):
+    # Streamed from disk (sendfile when the server supports it), with
+    # Range, If-Range and ETag handled by send_file
+    full_path = sandbox_path(file_name)
+    if not os.path.isfile(full_path):
+        abort(404)
+    return send_file(os.path.abspath(full_path), conditional=True, max_age=0)
+
+@app.put('/files/<path:file_name>')
+def upload_file(file_name):
+    full_path = sandbox_path(file_name)
+    if not os.path.isdir(os.path.dirname(full_path)):
+        abort(404)
+    write_atomic(full_path, request_chunks())
+    return {'message': 'File uploaded successfully'}, 201
+
 @app.post('/create_file')
 def create_file():
     requestJson = request.get_json(force=True)
@@ -36,8 +104,7 @@ def create_file():
     if file_name == "":
         file_name = ''.join(random.choices(string.ascii_letters + string.digits, k=10))
 
-    with open(os.path.join(path, file_name), 'w') as f:
-        f.write(file_content)
+    write_atomic(sandbox_path(file_name), [file_content.encode()])
     return {'message': 'File created successfully'}
 
 @app.post('/create_folder')
@@ -45,7 +112,7 @@ def create_folder():
     folder_name = request.args.get('folder_name')
 
     # create the folder in the directory
-    os.makedirs(os.path.join(path, folder_name), exist_ok=True)
+    os.makedirs(sandbox_path(folder_name), exist_ok=True)
     return {'message': 'Folder created successfully'}
 
 @app.delete('/delete_file')
@@ -53,7 +120,7 @@ def delete_file():
     file_name = request.args.get('file_name')
 
     # delete the file in the directory
-    os.remove(os.path.join(path, file_name))
+    os.remove(sandbox_path(file_name))
     return {'message': 'File deleted successfully'}
 
 @app.patch('/update_file')
@@ -64,10 +131,12 @@ def update_file():
     file_content: str = requestJson.get('file_content')
 
     # update the file in the directory
-    with open(os.path.join(path, file_name), 'w') as f:
-        f.write(file_content)
+    write_atomic(sandbox_path(file_name), [file_content.encode()])
     return {'message': 'File updated successfully'}
 
 
 if __name__ == '__main__':
-    app.run()
+    # Development server, one thread per request. For many concurrent
+    # downloads run it on an async worker, e.g.:
+    #   gunicorn -k gevent -w 4 app:app
+    app.run(threaded=True)
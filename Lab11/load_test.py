@@ -0,0 +1,149 @@
+"""Concurrent large-file load test for app.py.
+
+Starts the server (or uses --url with --pid), uploads one large file, then
+has --clients threads download it, whole or by random Range requests, for
+--duration seconds. Reports requests/s, throughput and the server's peak RSS.
+
+    python load_test.py --size-mb 256 --clients 16 --duration 20
+"""
+import argparse
+import http.client
+import os
+import random
+import subprocess
+import sys
+import threading
+import time
+import urllib.parse
+
+FILE_NAME = "load_test.bin"
+
+
+def rss_kb(pid):
+    with open('/proc/{}/status'.format(pid)) as f:
+        for line in f:
+            if line.startswith('VmRSS:'):
+                return int(line.split()[1])
+    return 0
+
+
+def wait_for_server(host, port, timeout=10):
+    deadline = time.time() + timeout
+    while time.time() < deadline:
+        try:
+            conn = http.client.HTTPConnection(host, port, timeout=1)
+            conn.request('GET', '/get_files?limit=1')
+            conn.getresponse().read()
+            return
+        except OSError:
+            time.sleep(0.1)
+    sys.exit('server did not start')
+
+
+def upload(host, port, size):
+    def body():
+        block = os.urandom(1024 * 1024)
+        for _ in range(size // len(block)):
+            yield block
+
+    conn = http.client.HTTPConnection(host, port)
+    conn.request('PUT', '/files/' + FILE_NAME, body=body(),
+                 headers={'Content-Length': str(size)})
+    response = conn.getresponse()
+    response.read()
+    if response.status != 201:
+        sys.exit('upload failed: {}'.format(response.status))
+
+
+def client(host, port, size, range_ratio, stop, stats, lock):
+    conn = http.client.HTTPConnection(host, port)
+    requests = received = errors = 0
+    while not stop.is_set():
+        headers = {}
+        if random.random() < range_ratio:
+            start = random.randrange(size)
+            headers['Range'] = 'bytes={}-{}'.format(start, min(size, start + 1024 * 1024) - 1)
+        try:
+            conn.request('GET', '/files/' + FILE_NAME, headers=headers)
+            response = conn.getresponse()
+            while True:
+                chunk = response.read(64 * 1024)
+                if not chunk:
+                    break
+                received += len(chunk)
+            if response.status not in (200, 206):
+                errors += 1
+            requests += 1
+        except (OSError, http.client.HTTPException):
+            errors += 1
+            conn.close()
+            conn = http.client.HTTPConnection(host, port)
+    with lock:
+        stats['requests'] += requests
+        stats['bytes'] += received
+        stats['errors'] += errors
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('--url', default='http://127.0.0.1:5050')
+    parser.add_argument('--pid', type=int, help='server pid when using an already running server')
+    parser.add_argument('--size-mb', type=int, default=128)
+    parser.add_argument('--clients', type=int, default=8)
+    parser.add_argument('--duration', type=float, default=10)
+    parser.add_argument('--range-ratio', type=float, default=0.5,
+                        help='share of requests that read a random 1 MB range')
+    args = parser.parse_args()
+
+    url = urllib.parse.urlsplit(args.url)
+    host, port = url.hostname, url.port or 80
+    server = None
+    pid = args.pid
+    if pid is None:
+        server = subprocess.Popen(
+            [sys.executable, '-c', 'import app; app.app.run(port={}, threaded=True)'.format(port)],
+            cwd=os.path.dirname(os.path.abspath(__file__)),
+            stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+        pid = server.pid
+
+    try:
+        wait_for_server(host, port)
+        size = args.size_mb * 1024 * 1024
+        upload(host, port, size)
+        idle_rss = rss_kb(pid)
+
+        stats = {'requests': 0, 'bytes': 0, 'errors': 0}
+        lock = threading.Lock()
+        stop = threading.Event()
+        threads = [threading.Thread(target=client,
+                                    args=(host, port, size, args.range_ratio, stop, stats, lock))
+                   for _ in range(args.clients)]
+        start = time.time()
+        for thread in threads:
+            thread.start()
+        peak_rss = idle_rss
+        while time.time() - start < args.duration:
+            time.sleep(0.2)
+            peak_rss = max(peak_rss, rss_kb(pid))
+        stop.set()
+        for thread in threads:
+            thread.join()
+        elapsed = time.time() - start
+
+        print('file           {} MB'.format(args.size_mb))
+        print('clients        {}'.format(args.clients))
+        print('requests/s     {:.1f}'.format(stats['requests'] / elapsed))
+        print('throughput     {:.1f} MB/s'.format(stats['bytes'] / elapsed / 1e6))
+        print('errors         {}'.format(stats['errors']))
+        print('server RSS     {:.1f} MB idle, {:.1f} MB peak'.format(idle_rss / 1024, peak_rss / 1024))
+    finally:
+        if server is not None:
+            server.terminate()
+            server.wait()
+            path = os.path.join(os.path.dirname(os.path.abspath(__file__)), 'file_sandbox', FILE_NAME)
+            if os.path.exists(path):
+                os.remove(path)
+
+
+if __name__ == '__main__':
+    main()
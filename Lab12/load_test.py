@@ -0,0 +1,145 @@
+"""Load test of the sensor API with many configured sensors.
+
+Creates --sensors configuration files in a temporary directory, starts the
+server there (or uses --url when it is already running in such a
+directory), then has --clients threads read random sensors for --duration
+seconds. Reports requests/s, sensors/s and the p50/p99 latency.
+
+    python load_test.py --sensors 10000 --clients 16 --duration 10
+    python load_test.py --sensors 10000 --batch 100
+
+--batch N reads N sensors per request through /sensors. --app-dir runs
+another copy of main.py, e.g. an older version for comparison.
+"""
+import argparse
+import http.client
+import json
+import os
+import random
+import shutil
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+import urllib.parse
+
+
+def wait_for_server(host, port, timeout=10):
+    deadline = time.time() + timeout
+    while time.time() < deadline:
+        try:
+            conn = http.client.HTTPConnection(host, port, timeout=1)
+            conn.request('GET', '/sensor/0')
+            conn.getresponse().read()
+            return
+        except OSError:
+            time.sleep(0.1)
+    sys.exit('server did not start')
+
+
+def create_configs(directory, count):
+    os.makedirs(directory, exist_ok=True)
+    for i in range(count):
+        with open(os.path.join(directory, '{}.json'.format(i)), 'w') as f:
+            json.dump({'scale': '{}x'.format(1 + i % 5), 'unit': 'Celsius'}, f)
+
+
+def client(host, port, sensors, batch, stop, latencies, stats, lock):
+    conn = http.client.HTTPConnection(host, port)
+    mine = []
+    requests = errors = 0
+    while not stop.is_set():
+        if batch:
+            ids = ','.join(str(random.randrange(sensors)) for _ in range(batch))
+            url = '/sensors?ids=' + ids
+        else:
+            url = '/sensor/{}'.format(random.randrange(sensors))
+        start = time.perf_counter()
+        try:
+            conn.request('GET', url)
+            response = conn.getresponse()
+            response.read()
+            if response.status != 200:
+                errors += 1
+            requests += 1
+            mine.append(time.perf_counter() - start)
+        except (OSError, http.client.HTTPException):
+            errors += 1
+            conn.close()
+            conn = http.client.HTTPConnection(host, port)
+    with lock:
+        latencies.extend(mine)
+        stats['requests'] += requests
+        stats['errors'] += errors
+
+
+def percentile(values, p):
+    return values[min(len(values) - 1, int(len(values) * p / 100))]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('--url', help='already running server, its configs must exist')
+    parser.add_argument('--port', type=int, default=8050)
+    parser.add_argument('--app-dir', default=os.path.dirname(os.path.abspath(__file__)),
+                        help='directory of the main.py to start')
+    parser.add_argument('--sensors', type=int, default=10000)
+    parser.add_argument('--clients', type=int, default=16)
+    parser.add_argument('--duration', type=float, default=10)
+    parser.add_argument('--batch', type=int, default=0, help='sensors per request through /sensors')
+    args = parser.parse_args()
+
+    server = None
+    work_dir = None
+    if args.url:
+        url = urllib.parse.urlsplit(args.url)
+        host, port = url.hostname, url.port or 80
+    else:
+        host, port = '127.0.0.1', args.port
+        work_dir = tempfile.mkdtemp(prefix='sensor-load-')
+        create_configs(os.path.join(work_dir, 'configs'), args.sensors)
+        server = subprocess.Popen(
+            [sys.executable, '-m', 'uvicorn', '--app-dir', os.path.abspath(args.app_dir),
+             '--port', str(port), '--log-level', 'warning', 'main:app'],
+            cwd=work_dir, stdout=subprocess.DEVNULL)
+
+    try:
+        wait_for_server(host, port)
+        latencies = []
+        stats = {'requests': 0, 'errors': 0}
+        lock = threading.Lock()
+        stop = threading.Event()
+        threads = [threading.Thread(target=client,
+                                    args=(host, port, args.sensors, args.batch, stop, latencies, stats, lock))
+                   for _ in range(args.clients)]
+        start = time.time()
+        for thread in threads:
+            thread.start()
+        time.sleep(args.duration)
+        stop.set()
+        for thread in threads:
+            thread.join()
+        elapsed = time.time() - start
+
+        latencies.sort()
+        per_request = args.batch or 1
+        print('sensors        {}'.format(args.sensors))
+        print('clients        {}'.format(args.clients))
+        print('sensors/req    {}'.format(per_request))
+        print('requests/s     {:.1f}'.format(stats['requests'] / elapsed))
+        print('sensors/s      {:.1f}'.format(stats['requests'] * per_request / elapsed))
+        if latencies:
+            print('latency        p50 {:.2f} ms, p99 {:.2f} ms'.format(
+                percentile(latencies, 50) * 1e3, percentile(latencies, 99) * 1e3))
+        print('errors         {}'.format(stats['errors']))
+    finally:
+        if server is not None:
+            server.terminate()
+            server.wait()
+        if work_dir is not None:
+            shutil.rmtree(work_dir)
+
+
+if __name__ == '__main__':
+    main()
@@ -1,67 +1,326 @@
-from fastapi import FastAPI, HTTPException
+from array import array
+from collections import deque
+from contextlib import asynccontextmanager
+from dataclasses import dataclass
+from fastapi import FastAPI, HTTPException, Query
+from fastapi.responses import StreamingResponse
 from pydantic import BaseModel
-from typing import Dict
+from typing import Dict, Optional, Set, Tuple
+import asyncio
 import random
 import os
 import json
+import tempfile
+import threading
+import time
+
+HISTORY_SIZE = 256              # Samples kept per sensor
+# Seconds between simulated changes, and the share of sensors changed each time
+SIMULATION_INTERVAL = float(os.environ.get("SENSOR_SIMULATION_INTERVAL", "1.0"))
+SIMULATION_CHANGE_RATIO = float(os.environ.get("SENSOR_SIMULATION_CHANGE_RATIO", "0.1"))
+
+
+@asynccontextmanager
+async def lifespan(app: FastAPI):
+    task = asyncio.create_task(simulate_sensors())
+    yield
+    task.cancel()
+
+
+app = FastAPI(lifespan=lifespan)
+
+
+class SensorHistory:
+    """The last HISTORY_SIZE samples of a sensor, in a ring buffer. The min,
+    max and mean of that window are kept up to date as samples arrive."""
+
+    def __init__(self, size: int = HISTORY_SIZE):
+        self.samples = array("d", bytes(8 * size))
+        self.count = 0          # Samples received so far
+        self.total = 0.0        # Sum of the samples in the window
+        self.lows = deque()     # (sample number, value), values increasing: lows[0] is the min
+        self.highs = deque()    # (sample number, value), values decreasing: highs[0] is the max
+
+    def add(self, value: float):
+        size = len(self.samples)
+        number = self.count
+        slot = number % size
+        self.count += 1
+        if slot == 0:
+            # Sum again once per turn, so rounding errors don't add up
+            self.total = sum(self.samples) if number else 0.0
+        if number >= size:
+            self.total -= self.samples[slot]
+        self.samples[slot] = value
+        self.total += value
+
+        oldest = self.count - size
+        while self.lows and self.lows[-1][1] >= value:
+            self.lows.pop()
+        self.lows.append((number, value))
+        if self.lows[0][0] < oldest:
+            self.lows.popleft()
+        while self.highs and self.highs[-1][1] <= value:
+            self.highs.pop()
+        self.highs.append((number, value))
+        if self.highs[0][0] < oldest:
+            self.highs.popleft()
+
+    @property
+    def last(self) -> float:
+        return self.samples[(self.count - 1) % len(self.samples)]
+
+    def window(self) -> list:
+        size = len(self.samples)
+        if self.count <= size:
+            return self.samples[:self.count].tolist()
+        slot = self.count % size
+        return (self.samples[slot:] + self.samples[:slot]).tolist()
+
+    def stats(self) -> dict:
+        n = min(self.count, len(self.samples))
+        return {"samples": n, "min": self.lows[0][1], "max": self.highs[0][1], "mean": round(self.total / n, 2)}
 
-app = FastAPI()
 
 # Simulated sensors and configuration store
-sensors: Dict[str, float] = {}
+sensors: Dict[str, SensorHistory] = {}
+sensors_lock = threading.Lock()     # Samples are added by the simulation and by reads of new sensors
 config_dir = "configs"
 os.makedirs(config_dir, exist_ok=True)
 
 
+def config_path(sensor_id: str) -> str:
+    # Sensor ids name files in config_dir, so they must not be paths
+    if not sensor_id or sensor_id.startswith(".") or os.path.basename(sensor_id) != sensor_id:
+        raise HTTPException(status_code=400, detail=f"Invalid sensor id '{sensor_id}'.")
+    return os.path.join(config_dir, f"{sensor_id}.json")
+
+
+def write_atomic(path: str, data: dict) -> os.stat_result:
+    """Write data to a temporary file next to path, then rename it over
+    path, so readers never see a partly written configuration. Returns
+    the status of the new file."""
+    fd, tmp_path = tempfile.mkstemp(dir=os.path.dirname(path), prefix=".tmp-")
+    try:
+        with os.fdopen(fd, "w") as f:
+            os.fchmod(fd, 0o644)    # mkstemp creates it private
+            json.dump(data, f)
+            f.flush()
+            st = os.fstat(f.fileno())
+        os.replace(tmp_path, path)
+    except BaseException:
+        os.unlink(tmp_path)
+        raise
+    return st
+
+
+@dataclass
+class SensorConfig:
+    version: Tuple[int, int, int]   # (inode, size, mtime) of the file it was read from
+    scale: float = 1.0
+    unit: str = "Unknown"
+    error: Optional[str] = None
+
+
+class ConfigStore:
+    """Parsed sensor configurations. A file is read again only when its
+    inode, size or mtime changed, so edits made outside the API are seen
+    on the next request."""
+
+    def __init__(self):
+        self.configs: Dict[str, SensorConfig] = {}
+
+    @staticmethod
+    def _version(path: str) -> Optional[Tuple[int, int, int]]:
+        try:
+            st = os.stat(path)
+        except FileNotFoundError:
+            return None
+        return st.st_ino, st.st_size, st.st_mtime_ns
+
+    @staticmethod
+    def _parse(data: dict, version: Tuple[int, int, int]) -> SensorConfig:
+        config = SensorConfig(version)
+        try:
+            config.unit = data.get("unit", "Unknown")
+            config.scale = float(data.get("scale", "1x").replace("x", ""))
+        except Exception as e:
+            config.error = str(e)
+        return config
+
+    def _load(self, path: str, version: Tuple[int, int, int]) -> SensorConfig:
+        try:
+            with open(path, "r") as f:
+                data = json.load(f)
+        except Exception as e:
+            return SensorConfig(version, error=str(e))
+        return self._parse(data, version)
+
+    def get(self, sensor_id: str) -> Optional[SensorConfig]:
+        path = config_path(sensor_id)
+        version = self._version(path)
+        if version is None:
+            self.configs.pop(sensor_id, None)
+            return None
+        config = self.configs.get(sensor_id)
+        if config is None or config.version != version:
+            config = self._load(path, version)
+            self.configs[sensor_id] = config
+        return config
+
+    def exists(self, sensor_id: str) -> bool:
+        return self.get(sensor_id) is not None
+
+    def put(self, sensor_id: str, data: dict):
+        st = write_atomic(config_path(sensor_id), data)
+        # The rename keeps the inode, so a later replacement is still detected
+        self.configs[sensor_id] = self._parse(data, (st.st_ino, st.st_size, st.st_mtime_ns))
+
+
+config_store = ConfigStore()
+
+
 # Helper to simulate sensor readings
 def simulate_sensor_value() -> float:
     return round(random.uniform(10.0, 100.0), 2)
 
 
-# GET: Read sensor value
-@app.get("/sensor/{sensor_id}")
-def get_sensor_value(sensor_id: str):
-    value = sensors.get(sensor_id, simulate_sensor_value())
-    sensors[sensor_id] = value  # Persist simulated value
-
-    config_path = os.path.join(config_dir, f"{sensor_id}.json")
-    if os.path.exists(config_path):
-        with open(config_path, "r") as f:
-            config = json.load(f)
-        try:
-            scale_str = config.get("scale", "1x")
-            unit = config.get("unit", "Unknown")
-            scale = float(scale_str.replace("x", ""))
-            value *= scale
-        except Exception as e:
-            raise HTTPException(status_code=500, detail=f"Error applying configuration: {e}")
-    else:
+def read_sensor(sensor_id: str, stats: bool = False) -> dict:
+    # Validates the id before any history is kept for it
+    config = config_store.get(sensor_id)
+
+    with sensors_lock:
+        history = sensors.get(sensor_id)
+        if history is None:
+            history = sensors[sensor_id] = SensorHistory()
+            history.add(simulate_sensor_value())  # Persist simulated value
+        value = history.last
+        window = history.stats() if stats else None
+
+    if config is None:
         return {
             "sensor_id": sensor_id,
             "raw_value": "Sensor is not configured",
         }
+    if config.error is not None:
+        raise HTTPException(status_code=500, detail=f"Error applying configuration: {config.error}")
 
-    return {
+    reading = {
         "sensor_id": sensor_id,
-        "raw_value": sensors[sensor_id],
-        "scaled_value": round(value, 2),
-        "scale": f"{scale}x",
-        "unit": unit
+        "raw_value": value,
+        "scaled_value": round(value * config.scale, 2),
+        "scale": f"{config.scale}x",
+        "unit": config.unit
     }
+    if window is not None:
+        reading["window"] = window
+    return reading
+
+
+class Subscriber:
+    """A stream client: changes are merged in pending until it takes them,
+    so a slow client gets fewer, larger updates instead of a backlog."""
+
+    def __init__(self, ids: Optional[Set[str]]):
+        self.ids = ids          # None for all sensors
+        self.pending: Dict[str, float] = {}
+        self.event = asyncio.Event()
+
+
+subscribers: Set[Subscriber] = set()
+
+
+def publish(changes: Dict[str, float]):
+    for subscriber in subscribers:
+        if subscriber.ids is None:
+            subscriber.pending.update(changes)
+        else:
+            subscriber.pending.update((k, v) for k, v in changes.items() if k in subscriber.ids)
+        if subscriber.pending:
+            subscriber.event.set()
+
+
+async def simulate_sensors():
+    # New random values for a share of the known sensors, at each interval
+    while True:
+        await asyncio.sleep(SIMULATION_INTERVAL)
+        changes = {}
+        with sensors_lock:
+            count = round(len(sensors) * SIMULATION_CHANGE_RATIO)
+            for sensor_id in random.sample(list(sensors), count):
+                value = simulate_sensor_value()
+                sensors[sensor_id].add(value)
+                changes[sensor_id] = value
+        if changes:
+            publish(changes)
+
+
+def sse_event(values: Dict[str, float]) -> str:
+    return f"data: {json.dumps({'time': time.time(), 'sensors': values})}\n\n"
+
+
+# GET: Read sensor value
+@app.get("/sensor/{sensor_id}")
+def get_sensor_value(sensor_id: str, stats: bool = False):
+    return read_sensor(sensor_id, stats)
+
+
+# GET: Recent samples of a sensor, oldest first
+@app.get("/sensor/{sensor_id}/history")
+def get_sensor_history(sensor_id: str):
+    with sensors_lock:
+        history = sensors.get(sensor_id)
+        if history is None:
+            raise HTTPException(status_code=404, detail=f"Sensor '{sensor_id}' has no samples.")
+        return {"sensor_id": sensor_id, "values": history.window(), **history.stats()}
+
+
+# GET: Read many sensor values, ids separated by commas
+@app.get("/sensors")
+def get_sensor_values(ids: str = Query(...), stats: bool = False):
+    results = []
+    for sensor_id in ids.split(","):
+        try:
+            results.append(read_sensor(sensor_id, stats))
+        except HTTPException as e:
+            results.append({"sensor_id": sensor_id, "error": e.detail})
+    return {"sensors": results}
+
+
+# GET: Server-sent events with the raw values of the sensors that changed,
+# all sensors or those listed in ids. The first event holds the current values.
+@app.get("/sensors/stream")
+async def stream_sensor_values(ids: Optional[str] = None):
+    subscriber = Subscriber(set(ids.split(",")) if ids else None)
+
+    async def events():
+        subscribers.add(subscriber)
+        try:
+            with sensors_lock:
+                names = sensors if subscriber.ids is None else subscriber.ids & sensors.keys()
+                current = {sensor_id: sensors[sensor_id].last for sensor_id in names}
+            yield sse_event(current)
+            while True:
+                await subscriber.event.wait()
+                subscriber.event.clear()
+                changes, subscriber.pending = subscriber.pending, {}
+                yield sse_event(changes)
+        finally:
+            subscribers.discard(subscriber)
+
+    return StreamingResponse(events(), media_type="text/event-stream", headers={"Cache-Control": "no-cache"})
 
 
 # POST: Create default config
 @app.post("/sensor/{sensor_id}")
 def create_config(sensor_id: str):
-    config_path = os.path.join(config_dir, f"{sensor_id}.json")
-    if os.path.exists(config_path):
+    if config_store.exists(sensor_id):
         raise HTTPException(
             status_code=409,
             detail=f"Configuration for sensor '{sensor_id}' already exists."
         )
     default_config = {"scale": "1x", "unit": "Celsius"}
-    with open(config_path, "w") as f:
-        json.dump(default_config, f)
+    config_store.put(sensor_id, default_config)
     return {"message": f"Configuration file for sensor '{sensor_id}' created."}
 
 
@@ -73,12 +332,26 @@ class ConfigModel(BaseModel):
 
 @app.put("/sensor/{sensor_id}")
 def update_config(sensor_id: str, config: ConfigModel):
-    config_path = os.path.join(config_dir, f"{sensor_id}.json")
-    if not os.path.exists(config_path):
+    if not config_store.exists(sensor_id):
         raise HTTPException(
             status_code=406,
             detail=f"Configuration for sensor '{sensor_id}' does not exist and cannot be created via PUT."
         )
-    with open(config_path, "w") as f:
-        json.dump(config.dict(), f)
+    config_store.put(sensor_id, config.dict())
     return {"message": f"Configuration file for sensor '{sensor_id}' updated."}
+
+
+# PUT: Replace many config files, only those that already exist
+@app.put("/sensors")
+def update_configs(configs: Dict[str, ConfigModel]):
+    for sensor_id in configs:
+        config_path(sensor_id)
+    updated = []
+    missing = []
+    for sensor_id, config in configs.items():
+        if config_store.exists(sensor_id):
+            config_store.put(sensor_id, config.dict())
+            updated.append(sensor_id)
+        else:
+            missing.append(sensor_id)
+    return {"updated": updated, "missing": missing}
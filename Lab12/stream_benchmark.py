@@ -0,0 +1,174 @@
+"""Polling versus streaming benchmark for the sensor API.
+
+Starts the server in a temporary directory with --sensors configured
+sensors, a share of which change every interval, then for --duration
+seconds follows all of them in each mode:
+
+    poll    one GET /sensor/<id> per sensor every --refresh seconds
+    batch   one GET /sensors?ids=... per --chunk sensors every --refresh seconds
+    stream  one GET /sensors/stream connection
+
+Reports requests, response body bytes and server CPU time per second, and how
+long a refresh takes (or how late streamed changes arrive).
+
+    python stream_benchmark.py --sensors 1000 --duration 10
+"""
+import argparse
+import http.client
+import json
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+
+
+def wait_for_server(host, port, timeout=10):
+    deadline = time.time() + timeout
+    while time.time() < deadline:
+        try:
+            conn = http.client.HTTPConnection(host, port, timeout=1)
+            conn.request('GET', '/sensor/0')
+            conn.getresponse().read()
+            return
+        except OSError:
+            time.sleep(0.1)
+    sys.exit('server did not start')
+
+
+def cpu_seconds(pid):
+    with open('/proc/{}/stat'.format(pid)) as f:
+        fields = f.read().rsplit(')', 1)[1].split()
+    return (int(fields[11]) + int(fields[12])) / os.sysconf('SC_CLK_TCK')
+
+
+def get(conn, url):
+    conn.request('GET', url)
+    response = conn.getresponse()
+    return len(response.read())
+
+
+def batch_urls(sensors, chunk):
+    return ['/sensors?ids=' + ','.join(str(i) for i in range(start, min(sensors, start + chunk)))
+            for start in range(0, sensors, chunk)]
+
+
+def poll(host, port, urls, clients, refresh, duration):
+    """Fetch all urls every refresh seconds, over clients connections."""
+    stats = {'requests': 0, 'bytes': 0, 'refreshes': []}
+    conns = [http.client.HTTPConnection(host, port) for _ in range(clients)]
+    end = time.time() + duration
+    while time.time() < end:
+        start = time.time()
+        received = [0] * clients
+
+        def worker(n):
+            for url in urls[n::clients]:
+                received[n] += get(conns[n], url)
+
+        threads = [threading.Thread(target=worker, args=(n,)) for n in range(clients)]
+        for thread in threads:
+            thread.start()
+        for thread in threads:
+            thread.join()
+        elapsed = time.time() - start
+        stats['requests'] += len(urls)
+        stats['bytes'] += sum(received)
+        stats['refreshes'].append(elapsed)
+        time.sleep(max(0.0, refresh - elapsed))
+    return stats
+
+
+def stream(host, port, duration):
+    stats = {'requests': 1, 'bytes': 0, 'events': 0, 'changes': 0, 'delays': []}
+    conn = http.client.HTTPConnection(host, port, timeout=duration + 5)
+    conn.request('GET', '/sensors/stream')
+    response = conn.getresponse()
+    end = time.time() + duration
+    first = True
+    while time.time() < end:
+        line = response.fp.readline()
+        stats['bytes'] += len(line)
+        if not line.startswith(b'data: '):
+            continue
+        event = json.loads(line[6:])
+        if first:
+            first = False   # the current values, not changes
+            continue
+        stats['events'] += 1
+        stats['changes'] += len(event['sensors'])
+        stats['delays'].append(time.time() - event['time'])
+    conn.close()
+    return stats
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('--port', type=int, default=8051)
+    parser.add_argument('--sensors', type=int, default=1000)
+    parser.add_argument('--duration', type=float, default=10)
+    parser.add_argument('--refresh', type=float, default=1.0, help='polling period in seconds')
+    parser.add_argument('--clients', type=int, default=8, help='connections used to poll')
+    parser.add_argument('--chunk', type=int, default=500, help='sensors per batch request')
+    parser.add_argument('--interval', type=float, default=0.1, help='seconds between simulated changes')
+    parser.add_argument('--change-ratio', type=float, default=0.01, help='share of sensors changed each interval')
+    parser.add_argument('--modes', default='poll,batch,stream')
+    args = parser.parse_args()
+
+    host, port = '127.0.0.1', args.port
+    work_dir = tempfile.mkdtemp(prefix='sensor-stream-')
+    os.makedirs(os.path.join(work_dir, 'configs'))
+    for i in range(args.sensors):
+        with open(os.path.join(work_dir, 'configs', '{}.json'.format(i)), 'w') as f:
+            json.dump({'scale': '1x', 'unit': 'Celsius'}, f)
+    env = dict(os.environ, SENSOR_SIMULATION_INTERVAL=str(args.interval),
+               SENSOR_SIMULATION_CHANGE_RATIO=str(args.change_ratio))
+    server = subprocess.Popen(
+        [sys.executable, '-m', 'uvicorn', '--app-dir', os.path.dirname(os.path.abspath(__file__)),
+         '--port', str(port), '--log-level', 'warning', 'main:app'],
+        cwd=work_dir, env=env, stdout=subprocess.DEVNULL)
+
+    try:
+        wait_for_server(host, port)
+        # Reading the sensors once makes them known to the simulation
+        conn = http.client.HTTPConnection(host, port)
+        for url in batch_urls(args.sensors, args.chunk):
+            get(conn, url)
+        conn.close()
+
+        print('{} sensors, {:.0f} changes/s, polled every {} s'.format(
+            args.sensors, args.sensors * args.change_ratio / args.interval, args.refresh))
+        print('{:8} {:>10} {:>12} {:>14}  {}'.format('mode', 'requests/s', 'body KB/s', 'server CPU %', 'freshness'))
+        for mode in args.modes.split(','):
+            cpu = cpu_seconds(server.pid)
+            start = time.time()
+            if mode == 'poll':
+                urls = ['/sensor/{}'.format(i) for i in range(args.sensors)]
+                stats = poll(host, port, urls, args.clients, args.refresh, args.duration)
+            elif mode == 'batch':
+                stats = poll(host, port, batch_urls(args.sensors, args.chunk), args.clients, args.refresh, args.duration)
+            else:
+                stats = stream(host, port, args.duration)
+            elapsed = time.time() - start
+            cpu = cpu_seconds(server.pid) - cpu
+
+            if mode == 'stream':
+                delays = sorted(stats['delays']) or [0]
+                freshness = '{} changes, delay p50 {:.1f} ms, max {:.1f} ms'.format(
+                    stats['changes'], delays[len(delays) // 2] * 1e3, delays[-1] * 1e3)
+            else:
+                refreshes = stats['refreshes']
+                freshness = 'refresh takes {:.0f} ms, up to {:.0f} ms stale'.format(
+                    sum(refreshes) / len(refreshes) * 1e3, (args.refresh + max(refreshes)) * 1e3)
+            print('{:8} {:>10.1f} {:>12.1f} {:>14.1f}  {}'.format(
+                mode, stats['requests'] / elapsed, stats['bytes'] / elapsed / 1024, cpu / elapsed * 100, freshness))
+    finally:
+        server.terminate()
+        server.wait()
+        shutil.rmtree(work_dir)
+
+
+if __name__ == '__main__':
+    main()
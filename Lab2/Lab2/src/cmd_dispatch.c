@@ -0,0 +1,181 @@
+/* Table-driven text command dispatcher
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "cmd_dispatch.h"
+
+#define CMD_SEPARATOR ';'
+
+static bool is_key_char(char c)
+{
+    return (c >= 'A' && c <= 'Z') || c == '_';
+}
+
+static bool is_digit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+// Parse one command of [p, end); all fields reference the input
+static int parse(const char *p, const char *end, cmd_args_t *args)
+{
+    const char *s;
+    uint32_t n;
+    bool negative;
+
+    memset(args, 0, sizeof(*args));
+
+    for (s = p; p < end && is_key_char(*p); p++) {
+    }
+    if (p == s || p - s > CMD_MAX_KEY_LEN) {
+        return CMD_ERR_SYNTAX;
+    }
+    args->key = s;
+    args->key_len = (uint8_t)(p - s);
+
+    for (n = 0, s = p; p < end && is_digit(*p) && p - s < 9; p++) {
+        n = n * 10 + (uint32_t)(*p - '0');
+    }
+    if (p < end && is_digit(*p)) {
+        return CMD_ERR_SYNTAX;
+    }
+    args->has_index = p != s;
+    args->index = n;
+
+    if (p == end) {
+        args->op = CMD_OP_NONE;
+        return 0;
+    }
+    args->op = *p++;
+    if (args->op == CMD_OP_GET) {
+        return p == end ? 0 : CMD_ERR_SYNTAX;
+    }
+    if (args->op != CMD_OP_SET) {
+        return CMD_ERR_SYNTAX;
+    }
+
+    args->arg = p;
+    args->arg_len = (size_t)(end - p);
+    negative = p < end && *p == '-';
+    if (negative) {
+        p++;
+    }
+    for (n = 0, s = p; p < end && is_digit(*p) && p - s < 9; p++) {
+        n = n * 10 + (uint32_t)(*p - '0');
+    }
+    args->has_value = p == end && p != s;
+    args->value = negative ? -(int32_t)n : (int32_t)n;
+    return 0;
+}
+
+static const cmd_entry_t *lookup(const cmd_entry_t *table, const cmd_args_t *args)
+{
+    const cmd_entry_t *entry = &table[CMD_HASH(args->key[0], args->key[args->key_len - 1],
+                                               args->key_len, (unsigned char)args->op)];
+
+    if (entry->handler == NULL || entry->op != args->op || entry->key_len != args->key_len
+            || memcmp(entry->key, args->key, args->key_len) != 0) {
+        return NULL;
+    }
+    return entry;
+}
+
+static const char *next_command(const char *p, const char *end)
+{
+    const char *sep = memchr(p, CMD_SEPARATOR, (size_t)(end - p));
+    return sep != NULL ? sep : end;
+}
+
+int cmd_dispatch(const cmd_entry_t table[CMD_TABLE_SIZE], void *ctx,
+                 const char *data, size_t len, cmd_reply_t *reply)
+{
+    const char *end = data + len;
+    const char *p;
+    const char *stop;
+    cmd_args_t args;
+    int count = 0;
+    int ret;
+
+    // Trailing line ends from terminal tools are not part of the command
+    while (end > data && (end[-1] == '\n' || end[-1] == '\r')) {
+        end--;
+    }
+    if (end == data) {
+        return CMD_ERR_SYNTAX;
+    }
+
+    for (p = data;; p = stop + 1) {
+        stop = next_command(p, end);
+        ret = parse(p, stop, &args);
+        if (ret < 0) {
+            return ret;
+        }
+        if (lookup(table, &args) == NULL) {
+            return CMD_ERR_UNKNOWN;
+        }
+        if (stop == end) {
+            break;
+        }
+    }
+
+    for (p = data;; p = stop + 1) {
+        stop = next_command(p, end);
+        parse(p, stop, &args);
+        ret = lookup(table, &args)->handler(ctx, &args, reply);
+        if (ret < 0) {
+            return ret;
+        }
+        count++;
+        if (stop == end) {
+            return count;
+        }
+    }
+}
+
+int cmd_table_check(const cmd_entry_t table[CMD_TABLE_SIZE])
+{
+    for (int i = 0; i < CMD_TABLE_SIZE; i++) {
+        const cmd_entry_t *entry = &table[i];
+
+        if (entry->handler == NULL) {
+            continue;
+        }
+        if (entry->key_len == 0 || entry->key_len != strlen(entry->key)
+                || CMD_HASH(entry->key[0], entry->key[entry->key_len - 1], entry->key_len,
+                            (unsigned char)entry->op) != (unsigned)i) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void cmd_reply_printf(cmd_reply_t *reply, const char *fmt, ...)
+{
+    va_list ap;
+    size_t start;
+    int n;
+
+    if (reply == NULL || reply->buf == NULL || reply->len + 1 >= reply->size) {
+        return;
+    }
+    start = reply->len;
+    if (start > 0) {
+        reply->buf[start++] = CMD_SEPARATOR;
+    }
+    va_start(ap, fmt);
+    n = vsnprintf(reply->buf + start, reply->size - start, fmt, ap);
+    va_end(ap);
+    if (n >= 0 && (size_t)n < reply->size - start) {
+        reply->len = start + (size_t)n;
+    } else {
+        reply->buf[reply->len] = '\0';
+    }
+}
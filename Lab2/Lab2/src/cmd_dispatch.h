@@ -0,0 +1,92 @@
+/* Table-driven text command dispatcher
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Command syntax, several commands may be separated by ';':
+ *
+ *   <KEY>[<index>]            e.g. "TOGGLE4"
+ *   <KEY>[<index>]=<arg>      e.g. "GPIO4=1"
+ *   <KEY>[<index>]?           e.g. "GPIO4?"
+ *
+ * KEY is made of upper case letters and '_'. Commands are looked up in a
+ * table indexed by CMD_HASH() of the key and operator; the table is built
+ * at compile time with CMD_ENTRY(), so dispatch is one hash and one key
+ * comparison. Two keys hashing to the same slot make the compiler warn
+ * about an overridden initializer (-Woverride-init). */
+#define CMD_TABLE_SIZE  64
+
+#define CMD_OP_NONE     0
+#define CMD_OP_SET      '='
+#define CMD_OP_GET      '?'
+
+#define CMD_MAX_KEY_LEN 15
+
+#define CMD_HASH(first, last, len, op) \
+    ((((unsigned)(first) * 31u) + ((unsigned)(last) * 7u) + ((unsigned)(len) * 3u) + (unsigned)(op)) \
+     & (CMD_TABLE_SIZE - 1))
+
+/* Table slot for a command; first/last are the first and last characters
+ * of the key, which must be a string literal. They are spelled out because
+ * indexing a literal does not give a constant expression; cmd_table_check()
+ * catches a mismatch. */
+#define CMD_ENTRY(first, last, key, op, handler) \
+    [CMD_HASH(first, last, sizeof(key) - 1, op)] = { key, sizeof(key) - 1, op, handler }
+
+#define CMD_ERR_SYNTAX   -1  /* Malformed command */
+#define CMD_ERR_UNKNOWN  -2  /* No such command */
+#define CMD_ERR_ARG      -3  /* Bad index or argument, reported by handlers */
+
+/* Parsed command; strings point into the received data */
+typedef struct {
+    const char *key;
+    uint8_t key_len;
+    char op;
+    bool has_index;
+    uint32_t index;
+    const char *arg;        /* Text after '=', not terminated */
+    size_t arg_len;
+    bool has_value;         /* arg is a decimal number */
+    int32_t value;
+} cmd_args_t;
+
+/* Text returned to the sender */
+typedef struct {
+    char *buf;
+    size_t size;
+    size_t len;
+} cmd_reply_t;
+
+/* Returns 0 on success or a CMD_ERR_* code */
+typedef int (*cmd_handler_t)(void *ctx, const cmd_args_t *args, cmd_reply_t *reply);
+
+typedef struct {
+    const char *key;
+    uint8_t key_len;
+    char op;
+    cmd_handler_t handler;
+} cmd_entry_t;
+
+/* Execute the commands of one message.
+ * The whole message is parsed and looked up before the first handler runs;
+ * execution stops at the first handler error.
+ * Returns the number of commands executed or a CMD_ERR_* code. */
+int cmd_dispatch(const cmd_entry_t table[CMD_TABLE_SIZE], void *ctx,
+                 const char *data, size_t len, cmd_reply_t *reply);
+
+/* Check that every entry sits in the slot of its key and operator.
+ * Returns the index of the first misplaced entry, or -1. */
+int cmd_table_check(const cmd_entry_t table[CMD_TABLE_SIZE]);
+
+/* Append formatted text to a reply, separating replies with ';'.
+ * Output that does not fit is dropped. */
+void cmd_reply_printf(cmd_reply_t *reply, const char *fmt, ...);
@@ -0,0 +1,148 @@
+/* GPIO command decoding for the UDP control channel
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+#include "gpio_cmd.h"
+
+#define FRAME_HEADER_LEN  2
+#define FRAME_OP_LEN      3
+
+static int pin_allowed(const gpio_cmd_port_t *port, uint32_t pin)
+{
+    return pin < 64 && (port->pin_mask & (1ULL << pin)) != 0;
+}
+
+static int handle_frame(const gpio_cmd_port_t *port, const uint8_t *data, size_t len)
+{
+    size_t count;
+    const uint8_t *op;
+
+    if (len < FRAME_HEADER_LEN) {
+        return GPIO_CMD_ERR_FORMAT;
+    }
+    count = data[1];
+    if (count == 0 || count > GPIO_CMD_FRAME_MAX_OPS
+            || len != FRAME_HEADER_LEN + count * FRAME_OP_LEN) {
+        return GPIO_CMD_ERR_FORMAT;
+    }
+
+    // Validate the whole batch first so a bad frame changes nothing
+    for (op = data + FRAME_HEADER_LEN; op < data + len; op += FRAME_OP_LEN) {
+        if (op[0] != GPIO_CMD_OP_SET_LEVEL) {
+            return GPIO_CMD_ERR_OP;
+        }
+        if (!pin_allowed(port, op[1])) {
+            return GPIO_CMD_ERR_PIN;
+        }
+    }
+    for (op = data + FRAME_HEADER_LEN; op < data + len; op += FRAME_OP_LEN) {
+        port->set_level(port->ctx, op[1], op[2] ? 1 : 0);
+    }
+    return (int)count;
+}
+
+static int cmd_gpio_set(void *ctx, const cmd_args_t *args, cmd_reply_t *reply)
+{
+    const gpio_cmd_port_t *port = ctx;
+
+    (void)reply;
+    if (!args->has_index || !pin_allowed(port, args->index)
+            || !args->has_value || (args->value != 0 && args->value != 1)) {
+        return CMD_ERR_ARG;
+    }
+    port->set_level(port->ctx, (uint8_t)args->index, (uint8_t)args->value);
+    return 0;
+}
+
+static int cmd_gpio_get(void *ctx, const cmd_args_t *args, cmd_reply_t *reply)
+{
+    const gpio_cmd_port_t *port = ctx;
+
+    if (!args->has_index || !pin_allowed(port, args->index)) {
+        return CMD_ERR_ARG;
+    }
+    cmd_reply_printf(reply, "GPIO%u=%u", (unsigned)args->index,
+                     port->get_level(port->ctx, (uint8_t)args->index));
+    return 0;
+}
+
+static int cmd_toggle(void *ctx, const cmd_args_t *args, cmd_reply_t *reply)
+{
+    const gpio_cmd_port_t *port = ctx;
+    uint8_t pin = (uint8_t)args->index;
+
+    (void)reply;
+    if (!args->has_index || !pin_allowed(port, args->index)) {
+        return CMD_ERR_ARG;
+    }
+    port->set_level(port->ctx, pin, !port->get_level(port->ctx, pin));
+    return 0;
+}
+
+static int cmd_all_set(void *ctx, const cmd_args_t *args, cmd_reply_t *reply)
+{
+    const gpio_cmd_port_t *port = ctx;
+
+    (void)reply;
+    if (args->has_index || !args->has_value || (args->value != 0 && args->value != 1)) {
+        return CMD_ERR_ARG;
+    }
+    for (uint8_t pin = 0; pin < 64; pin++) {
+        if (pin_allowed(port, pin)) {
+            port->set_level(port->ctx, pin, (uint8_t)args->value);
+        }
+    }
+    return 0;
+}
+
+static int cmd_levels_get(void *ctx, const cmd_args_t *args, cmd_reply_t *reply)
+{
+    const gpio_cmd_port_t *port = ctx;
+    uint64_t levels = 0;
+
+    if (args->has_index) {
+        return CMD_ERR_ARG;
+    }
+    for (uint8_t pin = 0; pin < 64; pin++) {
+        if (pin_allowed(port, pin) && port->get_level(port->ctx, pin)) {
+            levels |= 1ULL << pin;
+        }
+    }
+    cmd_reply_printf(reply, "LEVELS=%llx", (unsigned long long)levels);
+    return 0;
+}
+
+static int cmd_ping(void *ctx, const cmd_args_t *args, cmd_reply_t *reply)
+{
+    (void)ctx;
+    if (args->has_index || args->arg_len == 0 || args->arg_len > GPIO_CMD_PING_MAX_LEN) {
+        return CMD_ERR_ARG;
+    }
+    cmd_reply_printf(reply, "PING=%.*s", (int)args->arg_len, args->arg);
+    return 0;
+}
+
+const cmd_entry_t gpio_cmd_table[CMD_TABLE_SIZE] = {
+    CMD_ENTRY('G', 'O', "GPIO", CMD_OP_SET, cmd_gpio_set),
+    CMD_ENTRY('G', 'O', "GPIO", CMD_OP_GET, cmd_gpio_get),
+    CMD_ENTRY('T', 'E', "TOGGLE", CMD_OP_NONE, cmd_toggle),
+    CMD_ENTRY('A', 'L', "ALL", CMD_OP_SET, cmd_all_set),
+    CMD_ENTRY('L', 'S', "LEVELS", CMD_OP_GET, cmd_levels_get),
+    CMD_ENTRY('P', 'G', "PING", CMD_OP_SET, cmd_ping),
+};
+
+int gpio_cmd_handle(const gpio_cmd_port_t *port, const uint8_t *data, size_t len,
+                    cmd_reply_t *reply)
+{
+    if (len == 0) {
+        return GPIO_CMD_ERR_FORMAT;
+    }
+    if (data[0] == GPIO_CMD_FRAME_MAGIC) {
+        return handle_frame(port, data, len);
+    }
+    return cmd_dispatch(gpio_cmd_table, (void *)port, (const char *)data, len, reply);
+}
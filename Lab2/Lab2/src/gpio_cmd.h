@@ -0,0 +1,58 @@
+/* GPIO command decoding for the UDP control channel
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "cmd_dispatch.h"
+
+/* Two datagram formats are accepted:
+ *
+ * - text commands, dispatched through cmd_dispatch():
+ *     GPIO<pin>=<0|1>   set a pin
+ *     GPIO<pin>?        read a pin, replies "GPIO<pin>=<level>"
+ *     TOGGLE<pin>       invert a pin
+ *     ALL=<0|1>         set every pin of the port
+ *     LEVELS?           read every pin, replies "LEVELS=<hex mask>"
+ *     PING=<token>      replies "PING=<token>"; appended to a batch it
+ *                       acknowledges the whole datagram (see udp_bench.py)
+ *   several of them may be sent at once, separated by ';'
+ * - binary: GPIO_CMD_FRAME_MAGIC, <count>, then <count> operations of
+ *           3 bytes each: <op>, <pin>, <value>
+ *
+ * A binary frame is checked completely before any operation is applied.
+ * Text commands run one by one as they are parsed: when one is rejected,
+ * those before it have already been applied. */
+#define GPIO_CMD_FRAME_MAGIC    0xA5
+#define GPIO_CMD_FRAME_MAX_OPS  32
+#define GPIO_CMD_OP_SET_LEVEL   0x01
+#define GPIO_CMD_PING_MAX_LEN   32
+
+#define GPIO_CMD_ERR_FORMAT     -1  /* Malformed datagram */
+#define GPIO_CMD_ERR_PIN        -2  /* Pin not allowed by the port */
+#define GPIO_CMD_ERR_OP         -3  /* Unknown operation */
+
+/* Pin side of the decoder; replaced by a mock when testing on a host */
+typedef struct {
+    uint64_t pin_mask;  /* Pins that may be driven */
+    void (*set_level)(void *ctx, uint8_t pin, uint8_t level);
+    uint8_t (*get_level)(void *ctx, uint8_t pin);
+    void *ctx;
+} gpio_cmd_port_t;
+
+/* Text command table, checked by the host tests with cmd_table_check() */
+extern const cmd_entry_t gpio_cmd_table[CMD_TABLE_SIZE];
+
+/* Decode one datagram and apply it; text replies are appended to reply,
+ * which may be NULL.
+ * Returns the number of operations applied, a GPIO_CMD_ERR_* code for
+ * binary frames or a CMD_ERR_* code for text commands. */
+int gpio_cmd_handle(const gpio_cmd_port_t *port, const uint8_t *data, size_t len,
+                    cmd_reply_t *reply);
@@ -24,6 +24,10 @@
 
 #include "driver/gpio.h"
 
+#include "button.h"
+#include "gpio_cmd.h"
+#include "udp_drain.h"
+
 #define CONFIG_ESP_WIFI_SSID      "lab-iot"
 #define CONFIG_ESP_WIFI_PASS      "IoT-IoT-IoT"
 #define CONFIG_ESP_MAXIMUM_RETRY  5
@@ -56,8 +60,8 @@ void configure_IO(){
      gpio_config_t io_conf = {};
      // disable interrupt
      io_conf.intr_type = GPIO_INTR_DISABLE;
-     // set as output mode
-     io_conf.mode = GPIO_MODE_OUTPUT;
+     // set as output mode, with the input kept on so the level can be read back
+     io_conf.mode = GPIO_MODE_INPUT_OUTPUT;
      // bit mask of the pins that you want to set
      io_conf.pin_bit_mask = GPIO_OUTPUT_PIN_SEL;
      // disable pull-down mode
@@ -72,8 +76,8 @@ void configure_IO(){
     // gpio_set_direction(GPIO_INPUT_IO, GPIO_MODE_INPUT);
     // gpio_set_pull_mode(GPIO_INPUT_IO, GPIO_PULLUP_ONLY);
 
-    //interrupt of rising edge
-    io_conf.intr_type = GPIO_INTR_POSEDGE;
+    //edge interrupts are set up by button_init()
+    io_conf.intr_type = GPIO_INTR_DISABLE;
     //bit mask of the pins, use GPIO 2 here
     io_conf.pin_bit_mask = GPIO_INPUT_PIN_SEL;
     //set as input mode
@@ -165,16 +169,30 @@ bool wifi_init_sta(void)
     return false;
 }
 
-void handle_message(char *rx_buffer, int len)
+// The LED on GPIO_OUTPUT_IO is active low: "GPIO4=0" turns it on
+static void set_output_level(void *ctx, uint8_t pin, uint8_t level)
 {
-    ESP_LOGI(TAG, "Handling message: %s", rx_buffer);
-    ESP_LOGI(TAG, "strcmp(rx_buffer, \"GPIO4=1\") = %d", strcmp(rx_buffer, "GPIO4=1"));
-    if (strcmp(rx_buffer, "GPIO4=0") == 0) {
-        ESP_LOGI(TAG, "Turning ON the LED");
-        gpio_set_level(GPIO_OUTPUT_IO, 1);
-    } else if (strcmp(rx_buffer, "GPIO4=1") == 0) {
-        ESP_LOGI(TAG, "Turning OFF the LED");
-        gpio_set_level(GPIO_OUTPUT_IO, 0);
+    gpio_set_level(pin, pin == GPIO_OUTPUT_IO ? !level : level);
+}
+
+static uint8_t get_output_level(void *ctx, uint8_t pin)
+{
+    int level = gpio_get_level(pin);
+    return pin == GPIO_OUTPUT_IO ? !level : level;
+}
+
+static const gpio_cmd_port_t gpio_port = {
+    .pin_mask = GPIO_OUTPUT_PIN_SEL,
+    .set_level = set_output_level,
+    .get_level = get_output_level,
+    .ctx = NULL,
+};
+
+void handle_message(const uint8_t *rx_buffer, int len, cmd_reply_t *reply)
+{
+    int ret = gpio_cmd_handle(&gpio_port, rx_buffer, len, reply);
+    if (ret < 0) {
+        ESP_LOGW(TAG, "Rejected %d byte command: %d", len, ret);
     }
 }
 
@@ -194,15 +212,23 @@ static void button_task(void *pvParameters)
         vTaskDelete(NULL);
     }
 
-    bool last_state = true;
+    const button_config_t button = {
+        .pin = GPIO_INPUT_IO,
+        .active_low = true,
+    };
+    QueueHandle_t button_queue;
+    if (button_init(&button, 1, &button_queue) != ESP_OK) {
+        ESP_LOGE(TAG, "Unable to set up the button");
+        vTaskDelete(NULL);
+    }
+
     bool toggle_state = false;
 
     while(1) {
-        bool current_state = gpio_get_level(GPIO_INPUT_IO);
-        // ESP_LOGE(TAG, "Current state: %d", current_state);
-        
-        // Button press detected (active low)
-        if (current_state == 0 && last_state == 1) {
+        button_event_t event;
+        xQueueReceive(button_queue, &event, portMAX_DELAY);
+
+        if (event.type == BUTTON_EVENT_PRESS) {
             const char *message = toggle_state ? "GPIO4=1" : "GPIO4=0";
             ESP_LOGE(TAG, "Sending message: %s", message);
             int err = sendto(sock, message, strlen(message), 0, 
@@ -215,16 +241,13 @@ static void button_task(void *pvParameters)
                 toggle_state = !toggle_state;
             }
         }
-        
-        last_state = current_state;
-        vTaskDelay(50 / portTICK_PERIOD_MS);  // Debounce delay
     }
 }
 
 static void udp_task(void *pvParameters)
 {
-    char rx_buffer[128];
-    char addr_str[128];
+    uint8_t rx_buffer[128];
+    char tx_buffer[128];
     int addr_family = 0;
     int ip_protocol = 0;
     
@@ -251,27 +274,15 @@ static void udp_task(void *pvParameters)
         ESP_LOGI(TAG, "Socket bound, port %d", CONFIG_LOCAL_PORT);
 
         while (1) {
-
-            struct sockaddr source_addr;
-            socklen_t socklen = sizeof(source_addr);
-            int len = recvfrom(sock, rx_buffer, sizeof(rx_buffer) - 1, 0, &source_addr, &socklen);
-
-            // Error occurred during receiving
-            if (len < 0) {
+            // Block until a datagram arrives, then drain everything queued
+            // without blocking before waiting again
+            int batch = udp_drain(sock, handle_message, rx_buffer, sizeof(rx_buffer),
+                                  tx_buffer, sizeof(tx_buffer));
+            if (batch < 0) {
                 ESP_LOGE(TAG, "recvfrom failed: errno %d", errno);
                 break;
             }
-            // Data received
-            else {
-                 inet_ntoa_r(((struct sockaddr_in *)&source_addr)->sin_addr, addr_str, sizeof(addr_str) - 1);
-                rx_buffer[len] = 0; // Null-terminate whatever we received and treat like a string
-                ESP_LOGI(TAG, "Received %d bytes from %s:", len, addr_str);
-                ESP_LOGI(TAG, "%s", rx_buffer);
-
-                handle_message(rx_buffer, len);
-            }
-
-            vTaskDelay(200 / portTICK_PERIOD_MS);
+            ESP_LOGD(TAG, "Handled %d datagrams", batch);
         }
 
         if (sock != -1) {
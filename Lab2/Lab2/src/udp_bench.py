@@ -0,0 +1,188 @@
+"""Load generator and latency benchmark for the UDP GPIO control channel.
+
+Each simulated peer has its own socket and sends at a fixed rate. Every
+datagram except binary frames ends with "PING=<peer>.<seq>", which the
+device echoes, so round trip time, loss and reordering are measured per
+message. Works against the board or against tools/udp_host.c.
+
+    python udp_bench.py 192.168.89.40 --peers 4 --rate 50 --duration 10 \\
+        --mix set=3,levels=1,ping=1 --json run.json --label build-42
+"""
+import argparse
+import asyncio
+import csv
+import json
+import random
+import time
+
+PEER_PORT = 10002
+
+# Message kinds; {pin} is filled in, PING is appended to all but 'frame'
+MESSAGES = {
+    'ping': '',
+    'set': 'GPIO{pin}={level}',
+    'get': 'GPIO{pin}?',
+    'toggle': 'TOGGLE{pin}',
+    'levels': 'LEVELS?',
+    'frame': None,      # binary set-level frame, not acknowledged
+}
+
+
+def percentile(values, pct):
+    if not values:
+        return None
+    values = sorted(values)
+    return values[min(len(values) - 1, int(round(pct / 100 * (len(values) - 1))))]
+
+
+class Peer(asyncio.DatagramProtocol):
+    def __init__(self, number, args, kinds, weights):
+        self.number = number
+        self.args = args
+        self.kinds = kinds
+        self.weights = weights
+        self.seq = 0
+        self.pending = {}       # seq -> (kind, send time)
+        self.records = []       # (peer, seq, kind, sent, rtt_us or None)
+        self.highest = -1
+        self.reordered = 0
+        self.duplicates = 0
+        self.transport = None
+
+    def connection_made(self, transport):
+        self.transport = transport
+
+    def datagram_received(self, data, addr):
+        now = time.perf_counter()
+        for part in data.decode(errors='replace').split(';'):
+            if not part.startswith('PING='):
+                continue
+            peer, _, seq = part[5:].partition('.')
+            if peer != str(self.number) or not seq.isdigit():
+                continue
+            seq = int(seq)
+            entry = self.pending.pop(seq, None)
+            if entry is None:
+                self.duplicates += 1
+                continue
+            if seq < self.highest:
+                self.reordered += 1
+            self.highest = max(self.highest, seq)
+            kind, sent = entry
+            self.records.append((self.number, seq, kind, sent, (now - sent) * 1e6))
+
+    def message(self, kind):
+        if kind == 'frame':
+            return bytes([0xA5, 1, 0x01, self.args.pin, random.randint(0, 1)])
+        text = MESSAGES[kind].format(pin=self.args.pin, level=random.randint(0, 1))
+        ping = 'PING={}.{}'.format(self.number, self.seq)
+        return (text + ';' + ping if text else ping).encode()
+
+    async def run(self, start, count):
+        interval = 1 / self.args.rate
+        for i in range(count):
+            # Fixed schedule, so a slow reply does not lower the offered load
+            delay = start + i * interval - time.perf_counter()
+            if delay > 0:
+                await asyncio.sleep(delay)
+            kind = random.choices(self.kinds, self.weights)[0]
+            sent = time.perf_counter()
+            self.transport.sendto(self.message(kind))
+            if kind == 'frame':
+                self.records.append((self.number, self.seq, kind, sent, None))
+            else:
+                self.pending[self.seq] = (kind, sent)
+            self.seq += 1
+
+    def finish(self):
+        for seq, (kind, sent) in self.pending.items():
+            self.records.append((self.number, seq, kind, sent, None))
+
+
+async def bench(args):
+    mix = dict(item.split('=') for item in args.mix.split(','))
+    for kind in mix:
+        if kind not in MESSAGES:
+            raise SystemExit('unknown message kind ' + kind)
+    kinds = list(mix)
+    weights = [float(mix[k]) for k in kinds]
+
+    loop = asyncio.get_running_loop()
+    peers = []
+    for number in range(args.peers):
+        _, peer = await loop.create_datagram_endpoint(
+            lambda n=number: Peer(n, args, kinds, weights), remote_addr=(args.host, args.port))
+        peers.append(peer)
+
+    count = int(args.rate * args.duration)
+    start = time.perf_counter() + 0.1
+    # Stagger the peers across one send interval
+    await asyncio.gather(*(peer.run(start + i / args.rate / args.peers, count)
+                           for i, peer in enumerate(peers)))
+    elapsed = time.perf_counter() - start
+    await asyncio.sleep(args.timeout)
+    for peer in peers:
+        peer.finish()
+        peer.transport.close()
+    return peers, elapsed
+
+
+def summarize(args, peers, elapsed):
+    records = [r for peer in peers for r in peer.records]
+    acked = [r for r in records if r[2] != 'frame']
+    rtts = [r[4] for r in acked if r[4] is not None]
+    lost = len(acked) - len(rtts)
+    return {
+        'label': args.label,
+        'host': args.host,
+        'peers': args.peers,
+        'rate_per_peer': args.rate,
+        'mix': args.mix,
+        'sent': len(records),
+        'send_rate': round(len(records) / elapsed, 1),
+        'acked_sent': len(acked),
+        'received': len(rtts),
+        'lost': lost,
+        'loss_pct': round(100 * lost / len(acked), 3) if acked else 0.0,
+        'reordered': sum(peer.reordered for peer in peers),
+        'duplicates': sum(peer.duplicates for peer in peers),
+        'rtt_p50_us': round(percentile(rtts, 50), 1) if rtts else None,
+        'rtt_p99_us': round(percentile(rtts, 99), 1) if rtts else None,
+        'rtt_max_us': round(max(rtts), 1) if rtts else None,
+    }
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('host', help='board address, or 127.0.0.1 for tools/udp_host.c')
+    parser.add_argument('--port', type=int, default=PEER_PORT)
+    parser.add_argument('--peers', type=int, default=1, help='simulated senders, one socket each')
+    parser.add_argument('--rate', type=float, default=10, help='datagrams per second per peer')
+    parser.add_argument('--duration', type=float, default=10, help='seconds of sending')
+    parser.add_argument('--mix', default='ping=1',
+                        help='weighted kinds from ' + ','.join(MESSAGES) + ', e.g. set=3,levels=1')
+    parser.add_argument('--pin', type=int, default=4)
+    parser.add_argument('--timeout', type=float, default=1.0, help='wait for late replies')
+    parser.add_argument('--label', default='', help='build name stored in the results')
+    parser.add_argument('--csv', help='write one row per datagram')
+    parser.add_argument('--json', help='write the summary')
+    args = parser.parse_args()
+
+    peers, elapsed = asyncio.run(bench(args))
+    summary = summarize(args, peers, elapsed)
+
+    if args.csv:
+        with open(args.csv, 'w', newline='') as f:
+            writer = csv.writer(f)
+            writer.writerow(['peer', 'seq', 'kind', 'sent_s', 'rtt_us'])
+            for peer, seq, kind, sent, rtt in sorted(r for p in peers for r in p.records):
+                writer.writerow([peer, seq, kind, '%.6f' % sent, '' if rtt is None else '%.1f' % rtt])
+    if args.json:
+        with open(args.json, 'w') as f:
+            json.dump(summary, f, indent=2)
+    for key, value in summary.items():
+        print('{:14} {}'.format(key, value))
+
+
+if __name__ == '__main__':
+    main()
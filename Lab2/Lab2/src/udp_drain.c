@@ -0,0 +1,44 @@
+/* Draining of the UDP command socket
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+#include <errno.h>
+
+#ifdef ESP_PLATFORM
+#include "lwip/sockets.h"
+#else
+#include <sys/socket.h>
+#endif
+
+#include "udp_drain.h"
+
+int udp_drain(int sock, udp_drain_handler_t handler, uint8_t *rx_buffer, size_t rx_size,
+              char *tx_buffer, size_t tx_size)
+{
+    int flags = 0;
+    int batch = 0;
+    int len;
+    struct sockaddr_storage source_addr;
+    socklen_t socklen = sizeof(source_addr);
+
+    while ((len = recvfrom(sock, rx_buffer, rx_size, flags,
+                           (struct sockaddr *)&source_addr, &socklen)) >= 0) {
+        cmd_reply_t reply = { .buf = tx_buffer, .size = tx_size, .len = 0 };
+        handler(rx_buffer, len, &reply);
+        // Queries are answered to the sender
+        if (reply.len > 0) {
+            sendto(sock, tx_buffer, reply.len, 0, (struct sockaddr *)&source_addr, socklen);
+        }
+        batch++;
+        flags = MSG_DONTWAIT;
+        socklen = sizeof(source_addr);
+    }
+    if (flags == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+        return -1;
+    }
+    return batch;
+}
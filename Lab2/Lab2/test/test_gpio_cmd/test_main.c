@@ -0,0 +1,142 @@
+/* Replay of a UDP command stream through gpio_cmd_handle()
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+
+   Run on the host with: pio test -e native
+*/
+#include <stdio.h>
+#include <string.h>
+#include <unity.h>
+
+#include "gpio_cmd.h"
+
+/* Datagram literal and its length; binary frames may contain '\0' */
+#define DGRAM(s) s, sizeof(s) - 1
+
+/* One datagram as received by udp_task, the return value of
+ * gpio_cmd_handle(), the reply sent back and the pin calls it made:
+ * "S<pin>=<level>" for set_level and "G<pin>" for get_level. */
+typedef struct {
+    const char *data;
+    size_t len;
+    int ret;
+    const char *reply;
+    const char *calls;
+} datagram_t;
+
+/* Datagrams as sent by udp_sender.py, udp_bench.py and a terminal,
+ * against the LED on GPIO4 and a second output on GPIO2. */
+static const datagram_t stream[] = {
+    { DGRAM("GPIO4=1"), 1, "", "S4=1" },
+    { DGRAM("GPIO4=0\n"), 1, "", "S4=0" },
+    { DGRAM("GPIO4?"), 1, "GPIO4=0", "G4" },
+    { DGRAM("TOGGLE4"), 1, "", "G4 S4=1" },
+    { DGRAM("GPIO2=1;PING=0.17"), 2, "PING=0.17", "S2=1" },
+    { DGRAM("LEVELS?;PING=1.3"), 2, "LEVELS=14;PING=1.3", "G2 G4" },
+    { DGRAM("ALL=0"), 1, "", "S2=0 S4=0" },
+    { DGRAM("GPIO4?;GPIO2?"), 2, "GPIO4=0;GPIO2=0", "G4 G2" },
+    { DGRAM("\xA5\x02\x01\x04\x01\x01\x02\x01"), 2, "", "S4=1 S2=1" },
+    { DGRAM("\xA5\x01\x01\x04\x00"), 1, "", "S4=0" },
+    /* Rejected datagrams leave the pins alone */
+    { DGRAM("\xA5\x02\x01\x04\x01\x01\x07\x01"), GPIO_CMD_ERR_PIN, "", "" },
+    { DGRAM("\xA5\x01\x02\x04\x01"), GPIO_CMD_ERR_OP, "", "" },
+    { DGRAM("\xA5\x02\x01\x04\x01"), GPIO_CMD_ERR_FORMAT, "", "" },
+    { DGRAM("\xA5\x00"), GPIO_CMD_ERR_FORMAT, "", "" },
+    { DGRAM(""), GPIO_CMD_ERR_FORMAT, "", "" },
+    { DGRAM("GPIO4=1;RESET=1"), CMD_ERR_UNKNOWN, "", "" },
+    { DGRAM("GPIO4"), CMD_ERR_UNKNOWN, "", "" },
+    { DGRAM("gpio4=1"), CMD_ERR_SYNTAX, "", "" },
+    { DGRAM("GPIO4=1;;GPIO2=1"), CMD_ERR_SYNTAX, "", "" },
+    { DGRAM("GPIO4=2"), CMD_ERR_ARG, "", "" },
+    { DGRAM("GPIO7=1"), CMD_ERR_ARG, "", "" },
+    { DGRAM("PING="), CMD_ERR_ARG, "", "" },
+    /* Commands before a failing handler have run */
+    { DGRAM("GPIO4=1;GPIO7=1"), CMD_ERR_ARG, "", "S4=1" },
+    { DGRAM("GPIO4?"), 1, "GPIO4=1", "G4" },
+};
+
+static uint64_t s_levels;
+static char s_calls[128];
+
+static void log_call(const char *fmt, unsigned pin, unsigned level)
+{
+    size_t len = strlen(s_calls);
+
+    snprintf(s_calls + len, sizeof(s_calls) - len, fmt, len > 0 ? " " : "", pin, level);
+}
+
+static void set_level(void *ctx, uint8_t pin, uint8_t level)
+{
+    (void)ctx;
+    log_call("%sS%u=%u", pin, level);
+    s_levels = (s_levels & ~(1ULL << pin)) | ((uint64_t)level << pin);
+}
+
+static uint8_t get_level(void *ctx, uint8_t pin)
+{
+    (void)ctx;
+    log_call("%sG%u", pin, 0);
+    return (s_levels >> pin) & 1;
+}
+
+static const gpio_cmd_port_t port = {
+    .pin_mask = (1ULL << 2) | (1ULL << 4),
+    .set_level = set_level,
+    .get_level = get_level,
+};
+
+void setUp(void)
+{
+    s_levels = 0;
+}
+
+void tearDown(void)
+{
+}
+
+static void test_replay(void)
+{
+    char tx_buffer[128];
+    char what[48];
+
+    for (size_t i = 0; i < sizeof(stream) / sizeof(stream[0]); i++) {
+        const datagram_t *d = &stream[i];
+        cmd_reply_t reply = { .buf = tx_buffer, .size = sizeof(tx_buffer), .len = 0 };
+
+        snprintf(what, sizeof(what), "datagram %u", (unsigned)i);
+        s_calls[0] = '\0';
+        tx_buffer[0] = '\0';
+        TEST_ASSERT_EQUAL_INT_MESSAGE(d->ret, gpio_cmd_handle(&port, (const uint8_t *)d->data,
+                                                              d->len, &reply), what);
+        TEST_ASSERT_EQUAL_STRING_MESSAGE(d->reply, tx_buffer, what);
+        TEST_ASSERT_EQUAL_STRING_MESSAGE(d->calls, s_calls, what);
+    }
+}
+
+static void test_reply_overflow(void)
+{
+    char tx_buffer[12];
+    cmd_reply_t reply = { .buf = tx_buffer, .size = sizeof(tx_buffer), .len = 0 };
+    static const char data[] = "GPIO4?;GPIO2?;LEVELS?";
+
+    /* Replies that do not fit are dropped, the commands still run */
+    TEST_ASSERT_EQUAL_INT(3, gpio_cmd_handle(&port, (const uint8_t *)data,
+                                             sizeof(data) - 1, &reply));
+    TEST_ASSERT_EQUAL_STRING("GPIO4=0", tx_buffer);
+
+    /* No reply buffer at all */
+    TEST_ASSERT_EQUAL_INT(3, gpio_cmd_handle(&port, (const uint8_t *)data,
+                                             sizeof(data) - 1, NULL));
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_replay);
+    RUN_TEST(test_reply_overflow);
+    return UNITY_END();
+}
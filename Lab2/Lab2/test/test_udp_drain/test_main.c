@@ -0,0 +1,239 @@
+/* Paced replay of UDP commands through udp_drain()
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+
+   A sender thread sends "GPIO4=<bit>;PING=<seq>" datagrams over localhost
+   at 1000 per second, the rate the control channel has to sustain, while
+   the test drains the socket with udp_drain() as udp_task() does. Every
+   datagram must be handled once and in order and every PING answered. The
+   delay between the time a datagram was due to be sent and the time it is
+   handled must stay bounded and must not grow over the run: a loop that
+   falls behind builds a backlog in the socket, and then loses datagrams.
+
+   Run on the host with: pio test -e native
+*/
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unity.h>
+
+#include "gpio_cmd.h"
+#include "udp_drain.h"
+
+#define RATE_HZ         1000
+#define COUNT           (3 * RATE_HZ)
+#define WINDOW          (RATE_HZ / 2)   /* Datagrams averaged at each end of the run */
+#define MAX_LAG_US      50000
+#define MAX_GROWTH_US   2000
+
+typedef struct {
+    int sock;
+    struct sockaddr_in dest;
+    struct timespec start;
+    int replies;
+    int reply_errors;
+} sender_t;
+
+static uint64_t s_levels;
+static struct timespec s_start;
+static int s_handled;
+static int s_out_of_order;
+static int s_rejected;
+static int64_t s_lag_us[COUNT];
+
+static int64_t elapsed_us(const struct timespec *from, const struct timespec *to)
+{
+    return (int64_t)(to->tv_sec - from->tv_sec) * 1000000 + (to->tv_nsec - from->tv_nsec) / 1000;
+}
+
+static void set_level(void *ctx, uint8_t pin, uint8_t level)
+{
+    (void)ctx;
+    s_levels = (s_levels & ~(1ULL << pin)) | ((uint64_t)level << pin);
+}
+
+static uint8_t get_level(void *ctx, uint8_t pin)
+{
+    (void)ctx;
+    return (s_levels >> pin) & 1;
+}
+
+static const gpio_cmd_port_t port = {
+    .pin_mask = 1ULL << 4,
+    .set_level = set_level,
+    .get_level = get_level,
+};
+
+/* handle_message() of main.c, recording when each datagram was handled */
+static void handle(const uint8_t *data, int len, cmd_reply_t *reply)
+{
+    struct timespec now;
+    char text[64];
+    const char *ping;
+    int seq;
+
+    if (gpio_cmd_handle(&port, data, len, reply) != 2) {
+        s_rejected++;
+        return;
+    }
+    snprintf(text, sizeof(text), "%.*s", len, (const char *)data);
+    ping = strstr(text, "PING=");
+    seq = ping != NULL ? atoi(ping + 5) : -1;
+    if (seq != s_handled) {
+        s_out_of_order++;
+        return;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    s_lag_us[seq] = elapsed_us(&s_start, &now) - (int64_t)seq * 1000000 / RATE_HZ;
+    s_handled++;
+}
+
+/* Count the replies queued for the sender; they must come in order */
+static void read_replies(sender_t *s, int flags)
+{
+    char buf[64];
+    char expected[32];
+    ssize_t len;
+
+    while ((len = recv(s->sock, buf, sizeof(buf) - 1, flags)) >= 0) {
+        buf[len] = '\0';
+        snprintf(expected, sizeof(expected), "PING=%d", s->replies);
+        if (strcmp(buf, expected) != 0) {
+            s->reply_errors++;
+        }
+        s->replies++;
+    }
+}
+
+static void *send_paced(void *arg)
+{
+    sender_t *s = arg;
+    char data[32];
+
+    for (int seq = 0; seq < COUNT; seq++) {
+        struct timespec due = s->start;
+        int len;
+
+        due.tv_nsec += (long)((int64_t)seq * 1000000000 / RATE_HZ % 1000000000);
+        due.tv_sec += (time_t)((int64_t)seq / RATE_HZ) + due.tv_nsec / 1000000000;
+        due.tv_nsec %= 1000000000;
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &due, NULL);
+        len = snprintf(data, sizeof(data), "GPIO4=%d;PING=%d", seq & 1, seq);
+        sendto(s->sock, data, len, 0, (struct sockaddr *)&s->dest, sizeof(s->dest));
+        read_replies(s, MSG_DONTWAIT);
+    }
+    /* The socket times out once the last replies are in */
+    read_replies(s, 0);
+    return NULL;
+}
+
+static void open_socket(int *sock_out, struct sockaddr_in *addr)
+{
+    struct timeval timeout = { .tv_sec = 1 };
+    socklen_t addr_len = sizeof(*addr);
+    int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_IP);
+
+    *sock_out = sock;
+    TEST_ASSERT_TRUE(sock >= 0);
+    memset(addr, 0, sizeof(*addr));
+    addr->sin_family = AF_INET;
+    addr->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    TEST_ASSERT_EQUAL_INT(0, bind(sock, (struct sockaddr *)addr, sizeof(*addr)));
+    TEST_ASSERT_EQUAL_INT(0, getsockname(sock, (struct sockaddr *)addr, &addr_len));
+    TEST_ASSERT_EQUAL_INT(0, setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)));
+}
+
+static int64_t mean_lag_us(int from)
+{
+    int64_t sum = 0;
+
+    for (int i = from; i < from + WINDOW; i++) {
+        sum += s_lag_us[i];
+    }
+    return sum / WINDOW;
+}
+
+void setUp(void)
+{
+    s_levels = 0;
+    s_handled = 0;
+    s_out_of_order = 0;
+    s_rejected = 0;
+}
+
+void tearDown(void)
+{
+}
+
+static void test_paced_replay(void)
+{
+    uint8_t rx_buffer[128];
+    char tx_buffer[128];
+    struct sockaddr_in unused;
+    sender_t sender;
+    pthread_t thread;
+    int64_t max_lag = 0;
+    int max_batch = 0;
+    int batch;
+    int sock;
+
+    open_socket(&sock, &sender.dest);
+    open_socket(&sender.sock, &unused);
+    sender.replies = 0;
+    sender.reply_errors = 0;
+    clock_gettime(CLOCK_MONOTONIC, &s_start);
+    s_start.tv_nsec += 10000000;
+    if (s_start.tv_nsec >= 1000000000) {
+        s_start.tv_sec++;
+        s_start.tv_nsec -= 1000000000;
+    }
+    sender.start = s_start;
+    TEST_ASSERT_EQUAL_INT(0, pthread_create(&thread, NULL, send_paced, &sender));
+
+    /* A datagram that does not arrive within the socket timeout ends it */
+    while (s_handled < COUNT
+            && (batch = udp_drain(sock, handle, rx_buffer, sizeof(rx_buffer),
+                                  tx_buffer, sizeof(tx_buffer))) >= 0) {
+        if (batch > max_batch) {
+            max_batch = batch;
+        }
+    }
+    pthread_join(thread, NULL);
+    close(sender.sock);
+    close(sock);
+
+    for (int i = 0; i < s_handled; i++) {
+        if (s_lag_us[i] > max_lag) {
+            max_lag = s_lag_us[i];
+        }
+    }
+    printf("%d datagrams at %d/s: max lag %lld us, mean lag %lld us at the start, %lld us at "
+           "the end, largest batch %d\n", s_handled, RATE_HZ, (long long)max_lag,
+           (long long)mean_lag_us(0), (long long)mean_lag_us(COUNT - WINDOW), max_batch);
+
+    TEST_ASSERT_EQUAL_INT(0, s_rejected);
+    TEST_ASSERT_EQUAL_INT(0, s_out_of_order);
+    TEST_ASSERT_EQUAL_INT(COUNT, s_handled);
+    TEST_ASSERT_EQUAL_INT(COUNT, sender.replies);
+    TEST_ASSERT_EQUAL_INT(0, sender.reply_errors);
+    TEST_ASSERT_TRUE(max_lag < MAX_LAG_US);
+    TEST_ASSERT_TRUE(mean_lag_us(COUNT - WINDOW) < mean_lag_us(0) + MAX_GROWTH_US);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_paced_replay);
+    return UNITY_END();
+}
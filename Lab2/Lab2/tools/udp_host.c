@@ -0,0 +1,72 @@
+/* Host build of the UDP command handler, for udp_bench.py
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+
+   Serves the same commands as udp_task in src/main.c, with the pins kept in
+   memory:
+
+     cc -O2 -Isrc tools/udp_host.c src/gpio_cmd.c src/cmd_dispatch.c -o udp_host
+     ./udp_host 10002
+*/
+#include <arpa/inet.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+
+#include "gpio_cmd.h"
+
+static uint64_t s_levels;
+
+static void set_level(void *ctx, uint8_t pin, uint8_t level)
+{
+    (void)ctx;
+    s_levels = (s_levels & ~(1ULL << pin)) | ((uint64_t)level << pin);
+}
+
+static uint8_t get_level(void *ctx, uint8_t pin)
+{
+    (void)ctx;
+    return (s_levels >> pin) & 1;
+}
+
+static const gpio_cmd_port_t port = {
+    .pin_mask = 1ULL << 4,
+    .set_level = set_level,
+    .get_level = get_level,
+};
+
+int main(int argc, char **argv)
+{
+    struct sockaddr_in local_addr = {
+        .sin_family = AF_INET,
+        .sin_addr.s_addr = htonl(INADDR_ANY),
+        .sin_port = htons(argc > 1 ? atoi(argv[1]) : 10002),
+    };
+    uint8_t rx_buffer[128];
+    char tx_buffer[128];
+    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+
+    if (sock < 0 || bind(sock, (struct sockaddr *)&local_addr, sizeof(local_addr)) < 0) {
+        perror("udp_host");
+        return 1;
+    }
+    while (1) {
+        struct sockaddr_storage source_addr;
+        socklen_t socklen = sizeof(source_addr);
+        ssize_t len = recvfrom(sock, rx_buffer, sizeof(rx_buffer), 0,
+                               (struct sockaddr *)&source_addr, &socklen);
+        if (len < 0) {
+            perror("recvfrom");
+            return 1;
+        }
+        cmd_reply_t reply = { .buf = tx_buffer, .size = sizeof(tx_buffer), .len = 0 };
+        gpio_cmd_handle(&port, rx_buffer, (size_t)len, &reply);
+        if (reply.len > 0) {
+            sendto(sock, tx_buffer, reply.len, 0, (struct sockaddr *)&source_addr, socklen);
+        }
+    }
+}
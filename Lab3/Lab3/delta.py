@@ -0,0 +1,205 @@
+"""Binary delta between two firmware images, applied on the device by
+src/delta_patch.c. See delta_patch.h for the format.
+
+    python delta.py old.bin new.bin out.delta
+"""
+import hashlib
+import struct
+import sys
+import zlib
+
+MAGIC = b'EDLT'
+VERSION = 1
+OP_END, OP_ADD, OP_INSERT = 0, 1, 2
+
+SEED = 8        # bytes that must match exactly to start an ADD
+MAX_GAP = 16    # mismatching bytes tolerated inside an ADD
+BLOCK = 64
+
+
+def varint(value):
+    out = bytearray()
+    while True:
+        byte = value & 0x7f
+        value >>= 7
+        if value:
+            out.append(byte | 0x80)
+        else:
+            out.append(byte)
+            return bytes(out)
+
+
+def zigzag(value):
+    return (value << 1) if value >= 0 else ((-value << 1) - 1)
+
+
+def image_digest(image):
+    # esp_partition_get_sha256() of an app partition is the SHA-256 esptool
+    # appends to the image
+    return image[-32:]
+
+
+def index_old(old):
+    """Offsets of the SEED-byte blocks of old that start at a multiple of SEED.
+
+    Any match of 2 * SEED - 1 bytes or more contains one of them, and
+    make_delta() extends a match backwards, so indexing every SEED-th offset
+    instead of every byte finds the same matches with SEED times fewer
+    entries."""
+    index = {}
+    for pos in range(0, len(old) - SEED + 1, SEED):
+        index.setdefault(old[pos:pos + SEED], pos)
+    return index
+
+
+def extend(old, new, src, dst):
+    """Length of the approximate match of new[dst:] against old[src:]."""
+    limit = min(len(old) - src, len(new) - dst)
+    length = 0
+    last = 0
+    while length < limit and length - last <= MAX_GAP:
+        if old[src + length:src + length + BLOCK] == new[dst + length:dst + length + BLOCK] \
+                and length + BLOCK <= limit:
+            length += BLOCK
+            last = length
+            continue
+        if old[src + length] == new[dst + length]:
+            last = length + 1
+        length += 1
+    return last
+
+
+def encode_add(old, new, src, dst, length):
+    out = bytearray()
+    pos = 0
+    while pos < length:
+        same = 0
+        while pos + same < length and old[src + pos + same] == new[dst + pos + same]:
+            same += 1
+        pos += same
+        diff = bytearray()
+        # Keep short runs of equal bytes inside the diff, a record costs more
+        while pos + len(diff) < length:
+            i = pos + len(diff)
+            if old[src + i] == new[dst + i] and \
+                    old[src + i:src + i + 3] == new[dst + i:dst + i + 3]:
+                break
+            diff.append((new[dst + i] - old[src + i]) & 0xff)
+        out += varint(same) + varint(len(diff)) + diff
+        pos += len(diff)
+    return bytes(out)
+
+
+def make_delta(old, new):
+    index = index_old(old)
+    ops = bytearray()
+    last_src = 0
+    literal = 0
+    dst = 0
+
+    def flush_literal(end):
+        if end > literal:
+            ops.extend(bytes([OP_INSERT]) + varint(end - literal) + new[literal:end])
+
+    while dst < len(new):
+        # Prefer continuing where the previous ADD stopped, then the index
+        src = None
+        if new[dst:dst + SEED] == old[last_src:last_src + SEED] and dst + SEED <= len(new):
+            src = last_src
+        else:
+            src = index.get(new[dst:dst + SEED])
+            if src is not None:
+                # The block may sit inside a longer match that started before it
+                back = 0
+                while back < min(src, dst - literal) and old[src - back - 1] == new[dst - back - 1]:
+                    back += 1
+                src -= back
+                dst -= back
+        length = extend(old, new, src, dst) if src is not None else 0
+        if length < SEED:
+            dst += 1
+            continue
+        flush_literal(dst)
+        ops.append(OP_ADD)
+        ops += varint(zigzag(src - last_src)) + varint(length)
+        ops += encode_add(old, new, src, dst, length)
+        last_src = src + length
+        dst += length
+        literal = dst
+    flush_literal(len(new))
+    ops.append(OP_END)
+
+    header = MAGIC + struct.pack('<B3xII', VERSION, len(old), len(new)) + image_digest(old)
+    return header + bytes(ops)
+
+
+def apply_delta(old, delta):
+    """Reference applier, used to check make_delta() output."""
+    if delta[:4] != MAGIC or delta[4] != VERSION:
+        raise ValueError('not a delta')
+    old_size, new_size = struct.unpack_from('<II', delta, 8)
+    if old_size != len(old) or delta[16:48] != image_digest(old):
+        raise ValueError('delta is for a different image')
+    pos = 48
+
+    def read_varint():
+        nonlocal pos
+        value = shift = 0
+        while True:
+            byte = delta[pos]
+            pos += 1
+            value |= (byte & 0x7f) << shift
+            shift += 7
+            if not byte & 0x80:
+                return value
+
+    new = bytearray()
+    src = 0
+    while True:
+        op = delta[pos]
+        pos += 1
+        if op == OP_END:
+            break
+        if op == OP_INSERT:
+            length = read_varint()
+            new += delta[pos:pos + length]
+            pos += length
+        elif op == OP_ADD:
+            value = read_varint()
+            src += (value >> 1) ^ -(value & 1)
+            remaining = read_varint()
+            while remaining:
+                same = read_varint()
+                new += old[src:src + same]
+                src += same
+                count = read_varint()
+                new += bytes((o + d) & 0xff for o, d in zip(old[src:src + count], delta[pos:pos + count]))
+                src += count
+                pos += count
+                remaining -= same + count
+        else:
+            raise ValueError('bad op %d' % op)
+    if len(new) != new_size:
+        raise ValueError('size mismatch')
+    return bytes(new)
+
+
+def main():
+    if len(sys.argv) != 4:
+        sys.exit(__doc__)
+    with open(sys.argv[1], 'rb') as f:
+        old = f.read()
+    with open(sys.argv[2], 'rb') as f:
+        new = f.read()
+    delta = make_delta(old, new)
+    if apply_delta(old, delta) != new:
+        sys.exit('delta does not reproduce the new image')
+    with open(sys.argv[3], 'wb') as f:
+        f.write(delta)
+    print('image {} bytes, delta {} bytes ({:.2%}), gzip of image {} bytes, sha256 {}'.format(
+        len(new), len(delta), len(delta) / len(new), len(zlib.compress(new, 9)),
+        hashlib.sha256(new).hexdigest()))
+
+
+if __name__ == '__main__':
+    main()
@@ -1,17 +1,115 @@
-import io
-from flask import Flask, send_file
-import os.path
+import hashlib
+import os
+import re
+import shutil
+import threading
+
+from flask import Flask, abort, request, send_file
+
+import delta
 
 app = Flask(__name__)
 
+FIRMWARE_PATH = ".pio/build/esp-wrover-kit/firmware.bin"
+VERSION_PREFIX = 'v0.1.'  # keep in sync with versioning.py
+ARCHIVE_DIR = "firmware"  # every image served, kept as delta bases
+DELTA_DIR = os.path.join(ARCHIVE_DIR, "deltas")
+
+delta_lock = threading.Lock()
+
+
+def current_version():
+    with open("versioning", 'r') as version_file:
+        return VERSION_PREFIX + version_file.read().strip()
+
+
 @app.route('/firmware.bin')
 def firm():
-    with open(".pio/build/esp-wrover-kit/firmware.bin", 'rb') as bites:
-        print(bites)
-        return send_file(
-                     io.BytesIO(bites.read()),
-                     mimetype='application/octet-stream'
-               )
+    # The ETag is the firmware version, so a device already running it gets
+    # a 304 (If-None-Match) and an interrupted download can resume with
+    # Range/If-Range. The file is streamed instead of read into memory.
+    return send_file(
+                 FIRMWARE_PATH,
+                 mimetype='application/octet-stream',
+                 conditional=True,
+                 etag=archive_current(),
+                 max_age=0
+           )
+
+def archive_current():
+    # A new image is archived once, with its hash, and the deltas to it from
+    # every older image are built in the background; requests only serve
+    # files that already exist.
+    version = current_version()
+    path = os.path.join(ARCHIVE_DIR, version + '.bin')
+    if not os.path.exists(path):
+        os.makedirs(DELTA_DIR, exist_ok=True)
+        tmp = '{}.{}.tmp'.format(path, os.getpid())
+        shutil.copyfile(FIRMWARE_PATH, tmp)
+        os.replace(tmp, path)
+        threading.Thread(target=build_deltas, args=(version,), daemon=True).start()
+    return version
+
+
+def image_hash(version):
+    """SHA-256 of an archived image, computed once and kept beside it."""
+    path = os.path.join(ARCHIVE_DIR, version + '.bin')
+    hash_path = path + '.sha256'
+    if not os.path.exists(hash_path):
+        with open(path, 'rb') as f:
+            digest = hashlib.sha256(f.read()).hexdigest()
+        with open(hash_path, 'w') as f:
+            f.write(digest)
+    with open(hash_path) as f:
+        return f.read().strip()
+
+
+def delta_path(old_hash, new_hash):
+    # Keyed by content, so rebuilding an identical image reuses its deltas
+    return os.path.join(DELTA_DIR, '{}-{}.delta'.format(old_hash, new_hash))
+
+
+def build_deltas(version):
+    with delta_lock:
+        new_hash = image_hash(version)
+        with open(os.path.join(ARCHIVE_DIR, version + '.bin'), 'rb') as f:
+            new = f.read()
+        for name in sorted(os.listdir(ARCHIVE_DIR)):
+            if not name.endswith('.bin') or name == version + '.bin':
+                continue
+            old_hash = image_hash(name[:-len('.bin')])
+            path = delta_path(old_hash, new_hash)
+            if old_hash == new_hash or os.path.exists(path):
+                continue
+            with open(os.path.join(ARCHIVE_DIR, name), 'rb') as f:
+                old = f.read()
+            patch = delta.make_delta(old, new)
+            # Written aside and renamed, so a request never sees half a delta
+            tmp = '{}.{}.tmp'.format(path, os.getpid())
+            with open(tmp, 'wb') as f:
+                f.write(patch)
+            os.replace(tmp, path)
+            print('delta {} -> {}: {} of {} bytes ({:.2%})'.format(
+                name[:-len('.bin')], version, len(patch), len(new), len(patch) / len(new)))
+
+
+@app.route('/firmware.delta')
+def firm_delta():
+    # The device reports the version it runs. Without an archived image of
+    # that version, or while its delta is still being built, the device gets
+    # a 404 and falls back to the full /firmware.bin.
+    version = archive_current()
+    base = request.args.get('from', '')
+    if base == version:
+        return '', 304
+    if not re.fullmatch(r'[\w.]+', base):
+        abort(400)
+    if not os.path.exists(os.path.join(ARCHIVE_DIR, base + '.bin')):
+        abort(404)
+    path = delta_path(image_hash(base), image_hash(version))
+    if not os.path.exists(path):
+        abort(404)
+    return send_file(path, mimetype='application/octet-stream', max_age=0)
 
 @app.route("/")
 def hello():
@@ -19,8 +117,9 @@ def hello():
 
 @app.route("/version")
 def version():
-    with open("versioning", 'r') as version_file:
-        return version_file.read()
-    
+    return current_version()
+
 if __name__ == '__main__':
+    # Start on the deltas of a freshly built image before the first request
+    archive_current()
     app.run(host='0.0.0.0', ssl_context=('ca_cert.pem', 'ca_key.pem'), debug=True)
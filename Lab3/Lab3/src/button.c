@@ -0,0 +1,121 @@
+/* Interrupt driven, debounced buttons
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+#include "freertos/FreeRTOS.h"
+#include "freertos/timers.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "button.h"
+
+typedef struct {
+    button_config_t config;
+    button_fsm_t fsm;
+    TimerHandle_t timer;
+    bool edge;                  /* Set by the ISR, cleared by the timer */
+} button_t;
+
+static const char *TAG = "button";
+
+static button_t s_buttons[BUTTON_MAX_COUNT];
+static size_t s_button_count;
+static QueueHandle_t s_queue;
+static portMUX_TYPE s_edge_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static bool is_pressed(const button_t *button)
+{
+    return gpio_get_level(button->config.pin) == (button->config.active_low ? 0 : 1);
+}
+
+// Every edge restarts the debounce timer; the level is only read once the
+// input has been quiet for the debounce time
+static void IRAM_ATTR button_isr_handler(void *arg)
+{
+    button_t *button = arg;
+    BaseType_t woken = pdFALSE;
+
+    portENTER_CRITICAL_ISR(&s_edge_lock);
+    button->edge = true;
+    portEXIT_CRITICAL_ISR(&s_edge_lock);
+    xTimerChangePeriodFromISR(button->timer, pdMS_TO_TICKS(button->config.debounce_ms), &woken);
+    if (woken) {
+        portYIELD_FROM_ISR();
+    }
+}
+
+// Runs in the timer service task
+static void button_timer_cb(TimerHandle_t timer)
+{
+    button_t *button = pvTimerGetTimerID(timer);
+    uint32_t now_ms = (uint32_t)(esp_timer_get_time() / 1000);
+    bool edge;
+    button_event_t event;
+
+    portENTER_CRITICAL(&s_edge_lock);
+    edge = button->edge;
+    button->edge = false;
+    portEXIT_CRITICAL(&s_edge_lock);
+
+    event.pin = button->config.pin;
+    event.type = button_fsm_update(&button->fsm, edge, is_pressed(button), now_ms);
+    if (event.type != BUTTON_EVENT_NONE && xQueueSend(s_queue, &event, 0) != pdTRUE) {
+        ESP_LOGW(TAG, "Event queue full, GPIO%d event dropped", event.pin);
+    }
+    if (button->fsm.timeout_ms > 0) {
+        xTimerChangePeriod(timer, pdMS_TO_TICKS(button->fsm.timeout_ms), 0);
+    }
+}
+
+esp_err_t button_init(const button_config_t *config, size_t count, QueueHandle_t *queue)
+{
+    esp_err_t err;
+
+    if (count == 0 || count > BUTTON_MAX_COUNT - s_button_count) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_queue == NULL) {
+        s_queue = xQueueCreate(BUTTON_QUEUE_LEN, sizeof(button_event_t));
+        if (s_queue == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    // Shared with other drivers; already installed is fine
+    err = gpio_install_isr_service(0);
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {
+        return err;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        button_t *button = &s_buttons[s_button_count];
+
+        button->config = config[i];
+        if (button->config.debounce_ms == 0) {
+            button->config.debounce_ms = BUTTON_DEBOUNCE_MS;
+        }
+        button->edge = false;
+        button->timer = xTimerCreate("button", pdMS_TO_TICKS(button->config.debounce_ms),
+                                     pdFALSE, button, button_timer_cb);
+        if (button->timer == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+        gpio_set_direction(button->config.pin, GPIO_MODE_INPUT);
+        button_fsm_init(&button->fsm, button->config.long_press_ms, is_pressed(button));
+
+        gpio_set_intr_type(button->config.pin, GPIO_INTR_ANYEDGE);
+        err = gpio_isr_handler_add(button->config.pin, button_isr_handler, button);
+        if (err != ESP_OK) {
+            xTimerDelete(button->timer, 0);
+            return err;
+        }
+        s_button_count++;
+    }
+
+    *queue = s_queue;
+    return ESP_OK;
+}
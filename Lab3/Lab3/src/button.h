@@ -0,0 +1,40 @@
+/* Interrupt driven, debounced buttons
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "driver/gpio.h"
+#include "esp_err.h"
+
+#include "button_fsm.h"
+
+#define BUTTON_MAX_COUNT        4
+#define BUTTON_QUEUE_LEN        8
+#define BUTTON_DEBOUNCE_MS      20
+
+typedef struct {
+    gpio_num_t pin;
+    bool active_low;
+    uint32_t debounce_ms;       /* 0 selects BUTTON_DEBOUNCE_MS */
+    uint32_t long_press_ms;     /* 0 disables long press events */
+} button_config_t;
+
+typedef struct {
+    gpio_num_t pin;
+    button_event_type_t type;
+} button_event_t;
+
+/* Configure the pins as inputs with an edge interrupt and start reporting
+ * debounced button_event_t items on the returned queue. Nothing runs while
+ * the buttons are idle; consumers block on the queue.
+ * The pins keep the pull configuration set by the caller. */
+esp_err_t button_init(const button_config_t *config, size_t count, QueueHandle_t *queue);
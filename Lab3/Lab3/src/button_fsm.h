@@ -0,0 +1,45 @@
+/* Button debounce state machine
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Platform independent part of the button driver. The driver runs it
+ * from a one-shot timer that every edge restarts with the debounce time:
+ *
+ * - when the timer expires after an edge, the input has been stable for the
+ *   debounce time and its level is the new debounced state;
+ * - otherwise the timer was armed for the long press.
+ *
+ * After each update, timeout_ms tells when to run the machine again
+ * (0: only on the next edge). */
+
+typedef enum {
+    BUTTON_EVENT_NONE = 0,
+    BUTTON_EVENT_PRESS,
+    BUTTON_EVENT_RELEASE,
+    BUTTON_EVENT_LONG_PRESS,
+} button_event_type_t;
+
+typedef struct {
+    uint32_t long_press_ms;     /* 0 disables long press events */
+    bool pressed;               /* Debounced state */
+    bool long_sent;
+    uint32_t press_ms;
+    uint32_t timeout_ms;
+} button_fsm_t;
+
+void button_fsm_init(button_fsm_t *fsm, uint32_t long_press_ms, bool pressed);
+
+/* Run the machine when its timer expires.
+ * edge: at least one edge was seen since the previous update
+ * pressed: current input level
+ * now_ms: current time */
+button_event_type_t button_fsm_update(button_fsm_t *fsm, bool edge, bool pressed, uint32_t now_ms);
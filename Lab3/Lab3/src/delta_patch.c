@@ -0,0 +1,254 @@
+/* Streaming firmware delta applier
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+#include <string.h>
+
+#include "delta_patch.h"
+
+#define OP_END      0x00
+#define OP_ADD      0x01
+#define OP_INSERT   0x02
+
+enum {
+    STATE_HEADER,
+    STATE_OP,
+    STATE_ADD_SRC,
+    STATE_ADD_LEN,
+    STATE_ADD_SAME,
+    STATE_ADD_COUNT,
+    STATE_ADD_DIFF,
+    STATE_INSERT_LEN,
+    STATE_INSERT_DATA,
+    STATE_DONE,
+    STATE_ERROR,
+};
+
+static uint32_t get_le32(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static delta_patch_err_t flush(delta_patch_t *patch)
+{
+    uint32_t offset = patch->written - patch->fill;
+
+    if (patch->fill > 0 && patch->io->write_new(patch->io->ctx, offset, patch->buffer, patch->fill) != 0) {
+        return DELTA_PATCH_ERR_IO;
+    }
+    patch->fill = 0;
+    return DELTA_PATCH_OK;
+}
+
+// Copy len old image bytes to the output, adding diff to them if given
+static delta_patch_err_t emit_add(delta_patch_t *patch, const uint8_t *diff, uint32_t len)
+{
+    while (len > 0) {
+        uint32_t n = sizeof(patch->buffer) - patch->fill;
+        if (n > len) {
+            n = len;
+        }
+        uint8_t *out = patch->buffer + patch->fill;
+        if (patch->io->read_old(patch->io->ctx, patch->src, out, n) != 0) {
+            return DELTA_PATCH_ERR_IO;
+        }
+        if (diff != NULL) {
+            for (uint32_t i = 0; i < n; i++) {
+                out[i] += diff[i];
+            }
+            diff += n;
+        }
+        patch->src += n;
+        patch->fill += n;
+        patch->written += n;
+        len -= n;
+        if (patch->fill == sizeof(patch->buffer) && flush(patch) != DELTA_PATCH_OK) {
+            return DELTA_PATCH_ERR_IO;
+        }
+    }
+    return DELTA_PATCH_OK;
+}
+
+static delta_patch_err_t emit_insert(delta_patch_t *patch, const uint8_t *data, uint32_t len)
+{
+    while (len > 0) {
+        uint32_t n = sizeof(patch->buffer) - patch->fill;
+        if (n > len) {
+            n = len;
+        }
+        memcpy(patch->buffer + patch->fill, data, n);
+        data += n;
+        patch->fill += n;
+        patch->written += n;
+        len -= n;
+        if (patch->fill == sizeof(patch->buffer) && flush(patch) != DELTA_PATCH_OK) {
+            return DELTA_PATCH_ERR_IO;
+        }
+    }
+    return DELTA_PATCH_OK;
+}
+
+static delta_patch_err_t parse_header(delta_patch_t *patch, const uint8_t *raw)
+{
+    if (memcmp(raw, DELTA_PATCH_MAGIC, 4) != 0 || raw[4] != DELTA_PATCH_VERSION) {
+        return DELTA_PATCH_ERR_FORMAT;
+    }
+    patch->header.old_size = get_le32(raw + 8);
+    patch->header.new_size = get_le32(raw + 12);
+    memcpy(patch->header.old_digest, raw + 16, sizeof(patch->header.old_digest));
+    if (patch->io->begin != NULL && patch->io->begin(patch->io->ctx, &patch->header) != 0) {
+        return DELTA_PATCH_ERR_REJECTED;
+    }
+    return DELTA_PATCH_OK;
+}
+
+// A varint field is complete: validate it and move to the next state
+static delta_patch_err_t on_value(delta_patch_t *patch, uint32_t value)
+{
+    switch (patch->state) {
+    case STATE_ADD_SRC:
+        // zigzag encoded offset relative to where the previous ADD stopped
+        patch->src += (value >> 1) ^ -(value & 1);
+        patch->state = STATE_ADD_LEN;
+        break;
+    case STATE_ADD_LEN:
+        if (value == 0 || patch->src > patch->header.old_size || value > patch->header.old_size - patch->src ||
+            value > patch->header.new_size - patch->written) {
+            return DELTA_PATCH_ERR_RANGE;
+        }
+        patch->remaining = value;
+        patch->state = STATE_ADD_SAME;
+        break;
+    case STATE_ADD_SAME:
+        if (value > patch->remaining) {
+            return DELTA_PATCH_ERR_FORMAT;
+        }
+        patch->remaining -= value;
+        patch->state = STATE_ADD_COUNT;
+        return emit_add(patch, NULL, value);
+    case STATE_ADD_COUNT:
+        if (value > patch->remaining) {
+            return DELTA_PATCH_ERR_FORMAT;
+        }
+        patch->remaining -= value;
+        patch->count = value;
+        patch->state = value > 0 ? STATE_ADD_DIFF : patch->remaining > 0 ? STATE_ADD_SAME : STATE_OP;
+        break;
+    case STATE_INSERT_LEN:
+        if (value == 0 || value > patch->header.new_size - patch->written) {
+            return DELTA_PATCH_ERR_RANGE;
+        }
+        patch->count = value;
+        patch->state = STATE_INSERT_DATA;
+        break;
+    default:
+        return DELTA_PATCH_ERR_FORMAT;
+    }
+    return DELTA_PATCH_OK;
+}
+
+void delta_patch_init(delta_patch_t *patch, const delta_patch_io_t *io)
+{
+    memset(patch, 0, sizeof(*patch));
+    patch->io = io;
+    patch->state = STATE_HEADER;
+}
+
+delta_patch_err_t delta_patch_feed(delta_patch_t *patch, const uint8_t *data, size_t len)
+{
+    const uint8_t *end = data + len;
+    delta_patch_err_t err = DELTA_PATCH_OK;
+
+    while (data < end && err == DELTA_PATCH_OK) {
+        uint32_t n;
+
+        switch (patch->state) {
+        case STATE_HEADER:
+            // The header is collected in the output buffer, which is still unused
+            n = DELTA_PATCH_HEADER_SIZE - patch->fill;
+            if (n > (uint32_t)(end - data)) {
+                n = end - data;
+            }
+            memcpy(patch->buffer + patch->fill, data, n);
+            patch->fill += n;
+            data += n;
+            if (patch->fill == DELTA_PATCH_HEADER_SIZE) {
+                patch->fill = 0;
+                err = parse_header(patch, patch->buffer);
+                patch->state = STATE_OP;
+            }
+            break;
+        case STATE_OP:
+            switch (*data++) {
+            case OP_END:
+                patch->state = STATE_DONE;
+                break;
+            case OP_ADD:
+                patch->state = STATE_ADD_SRC;
+                break;
+            case OP_INSERT:
+                patch->state = STATE_INSERT_LEN;
+                break;
+            default:
+                err = DELTA_PATCH_ERR_FORMAT;
+                break;
+            }
+            break;
+        case STATE_ADD_DIFF:
+        case STATE_INSERT_DATA:
+            n = patch->count;
+            if (n > (uint32_t)(end - data)) {
+                n = end - data;
+            }
+            if (patch->state == STATE_ADD_DIFF) {
+                err = emit_add(patch, data, n);
+            } else {
+                err = emit_insert(patch, data, n);
+            }
+            data += n;
+            patch->count -= n;
+            if (patch->count == 0) {
+                patch->state = patch->remaining > 0 && patch->state == STATE_ADD_DIFF ? STATE_ADD_SAME : STATE_OP;
+            }
+            break;
+        case STATE_DONE:
+            // Trailing bytes after END
+            err = DELTA_PATCH_ERR_FORMAT;
+            break;
+        case STATE_ERROR:
+            return DELTA_PATCH_ERR_FORMAT;
+        default:
+            // LEB128 varint field
+            if (patch->shift > 28) {
+                err = DELTA_PATCH_ERR_FORMAT;
+                break;
+            }
+            patch->value |= (uint32_t)(*data & 0x7f) << patch->shift;
+            patch->shift += 7;
+            if ((*data++ & 0x80) == 0) {
+                uint32_t value = patch->value;
+                patch->value = 0;
+                patch->shift = 0;
+                err = on_value(patch, value);
+            }
+            break;
+        }
+    }
+
+    if (err != DELTA_PATCH_OK) {
+        patch->state = STATE_ERROR;
+    }
+    return err;
+}
+
+delta_patch_err_t delta_patch_finish(delta_patch_t *patch)
+{
+    if (patch->state != STATE_DONE || patch->written != patch->header.new_size) {
+        return DELTA_PATCH_ERR_FORMAT;
+    }
+    return flush(patch);
+}
@@ -0,0 +1,75 @@
+/* Streaming firmware delta applier
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Delta format, as written by delta.py (all integers little endian):
+ *
+ *   header   "EDLT", u8 version, u8 reserved[3], u32 old_size, u32 new_size,
+ *            u8 old_digest[32] (SHA-256 appended to the running image)
+ *   ops      0x01 ADD     varint src_delta (zigzag), varint len, then diff
+ *                         records until len bytes: varint same, varint count,
+ *                         count bytes added to the old bytes
+ *            0x02 INSERT  varint len, len bytes
+ *            0x00 END
+ *
+ * ADD reads from the old image starting where the previous ADD stopped plus
+ * src_delta. The new image is written strictly in order, so it can go
+ * straight into an erased partition. Nothing here depends on ESP-IDF; the
+ * caller supplies the partition access. */
+
+#define DELTA_PATCH_MAGIC       "EDLT"
+#define DELTA_PATCH_VERSION     1
+#define DELTA_PATCH_HEADER_SIZE 48
+#define DELTA_PATCH_CHUNK       256
+
+typedef enum {
+    DELTA_PATCH_OK = 0,
+    DELTA_PATCH_ERR_FORMAT = -1,        /* malformed or truncated delta */
+    DELTA_PATCH_ERR_RANGE = -2,         /* op outside the old or new image */
+    DELTA_PATCH_ERR_IO = -3,            /* a callback failed */
+    DELTA_PATCH_ERR_REJECTED = -4,      /* begin() refused the delta */
+} delta_patch_err_t;
+
+typedef struct {
+    uint32_t old_size;
+    uint32_t new_size;
+    uint8_t old_digest[32];
+} delta_patch_header_t;
+
+typedef struct {
+    /* Called once the header is parsed, before anything is written. Check the
+     * digest against the running image here; nonzero rejects the delta. */
+    int (*begin)(void *ctx, const delta_patch_header_t *header);
+    int (*read_old)(void *ctx, uint32_t offset, void *data, size_t len);
+    int (*write_new)(void *ctx, uint32_t offset, const void *data, size_t len);
+    void *ctx;
+} delta_patch_io_t;
+
+typedef struct {
+    const delta_patch_io_t *io;
+    delta_patch_header_t header;
+    uint8_t state;
+    uint8_t shift;
+    uint32_t value;             /* varint being decoded */
+    uint32_t src;               /* next old image offset for ADD */
+    uint32_t remaining;         /* bytes left in the current op */
+    uint32_t count;             /* bytes left in the current diff/insert run */
+    uint32_t written;           /* new image bytes produced */
+    uint16_t fill;
+    uint8_t buffer[DELTA_PATCH_CHUNK];
+} delta_patch_t;
+
+void delta_patch_init(delta_patch_t *patch, const delta_patch_io_t *io);
+/* Feed the next piece of the delta, of any size. Errors are sticky. */
+delta_patch_err_t delta_patch_feed(delta_patch_t *patch, const uint8_t *data, size_t len);
+/* Flush the output and check that the delta ended with a complete image. */
+delta_patch_err_t delta_patch_finish(delta_patch_t *patch);
@@ -6,6 +6,7 @@
    software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
    CONDITIONS OF ANY KIND, either express or implied.
 */
+#include <inttypes.h>
 #include <string.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
@@ -17,8 +18,10 @@
 #include "esp_log.h"
 #include "nvs_flash.h"
 #include "esp_http_client.h"
-#include "esp_https_ota.h"
-#include "esp_tls.h"
+#include "esp_ota_ops.h"
+#include "esp_partition.h"
+#include "esp_timer.h"
+#include "spi_flash_mmu.h"
 
 #include "lwip/err.h"
 #include "lwip/sys.h"
@@ -27,6 +30,8 @@
 #include "lwip/netdb.h"
 
 #include "../include/version.h"
+#include "button.h"
+#include "delta_patch.h"
 
 #define CONFIG_ESP_WIFI_SSID      "lab-iot"
 #define CONFIG_ESP_WIFI_PASS      "IoT-IoT-IoT"
@@ -36,7 +41,15 @@
 
 //TODO: Modificati adresa IP de mai jos pentru a coincide cu cea a PC-ul pe care rulati scriptul python
 #define CONFIG_EXAMPLE_FIRMWARE_UPGRADE_URL "https://192.168.89.49:5000/firmware.bin"
-#define CURRENT_REMOTE_VERSION_URL "https://192.168.89.49:5000/version" 
+#define CONFIG_EXAMPLE_FIRMWARE_DELTA_URL   "https://192.168.89.49:5000/firmware.delta?from=" VERSION_SHORT
+
+#define OTA_NVS_NAMESPACE   "ota"
+#define OTA_NVS_KEY         "progress"
+#define OTA_BUFFER_SIZE     4096
+#define OTA_MAX_ATTEMPTS    5
+#define OTA_SAVE_INTERVAL   (16 * SPI_FLASH_SEC_SIZE)
+#define HTTP_STATUS_PARTIAL_CONTENT 206
+#define HTTP_STATUS_NOT_MODIFIED    304
 
 #define GPIO_OUTPUT_IO 4
 #define GPIO_OUTPUT_PIN_SEL (1ULL<<GPIO_OUTPUT_IO)
@@ -56,37 +69,7 @@ extern const uint8_t server_cert_pem_start[] asm("_binary_ca_cert_pem_start");
 extern const uint8_t server_cert_pem_end[] asm("_binary_ca_cert_pem_end");
 
 static int s_retry_num = 0;
-
-esp_err_t _http_event_handler(esp_http_client_event_t *evt)
-{
-    switch (evt->event_id) {
-    case HTTP_EVENT_ERROR:
-        ESP_LOGI(TAG, "HTTP_EVENT_ERROR");
-        break;
-    case HTTP_EVENT_ON_CONNECTED:
-        ESP_LOGI(TAG, "HTTP_EVENT_ON_CONNECTED");
-        break;
-    case HTTP_EVENT_HEADER_SENT:
-        ESP_LOGI(TAG, "HTTP_EVENT_HEADER_SENT");
-        break;
-    case HTTP_EVENT_ON_HEADER:
-        ESP_LOGI(TAG, "HTTP_EVENT_ON_HEADER, key=%s, value=%s", evt->header_key, evt->header_value);
-        break;
-    case HTTP_EVENT_ON_DATA:
-        ESP_LOGI(TAG, "HTTP_EVENT_ON_DATA, len=%d", evt->data_len);
-        break;
-    case HTTP_EVENT_ON_FINISH:
-        ESP_LOGI(TAG, "HTTP_EVENT_ON_FINISH");
-        break;
-    case HTTP_EVENT_DISCONNECTED:
-        ESP_LOGI(TAG, "HTTP_EVENT_DISCONNECTED");
-        break;
-    case HTTP_EVENT_REDIRECT:
-        ESP_LOGI(TAG, "HTTP_EVENT_REDIRECT");
-        break;
-    }
-    return ESP_OK;
-}
+static char s_ota_buffer[OTA_BUFFER_SIZE];
 
 static void event_handler(void* arg, esp_event_base_t event_base,
                                 int32_t event_id, void* event_data)
@@ -170,111 +153,347 @@ bool wifi_init_sta(void)
     return false;
 }
 
-static void ota_task(void *pvParameters)
+/* Download progress, kept in NVS so an interrupted download resumes with a
+ * Range request instead of starting over */
+typedef struct {
+    char etag[32];
+    uint32_t offset;
+} ota_progress_t;
+
+static void ota_progress_load(ota_progress_t *progress)
+{
+    nvs_handle_t nvs;
+    size_t len = sizeof(*progress);
+
+    memset(progress, 0, sizeof(*progress));
+    if (nvs_open(OTA_NVS_NAMESPACE, NVS_READONLY, &nvs) == ESP_OK) {
+        if (nvs_get_blob(nvs, OTA_NVS_KEY, progress, &len) != ESP_OK || len != sizeof(*progress)) {
+            memset(progress, 0, sizeof(*progress));
+        }
+        nvs_close(nvs);
+    }
+}
+
+static void ota_progress_save(const ota_progress_t *progress)
+{
+    nvs_handle_t nvs;
+
+    if (nvs_open(OTA_NVS_NAMESPACE, NVS_READWRITE, &nvs) == ESP_OK) {
+        nvs_set_blob(nvs, OTA_NVS_KEY, progress, sizeof(*progress));
+        nvs_commit(nvs);
+        nvs_close(nvs);
+    }
+}
+
+/* One download attempt into the inactive partition.
+ * Sends the running version in If-None-Match, so an unchanged image costs a
+ * single 304 response, and resumes at progress->offset with Range/If-Range.
+ * Each flash sector is erased right before it is first written. */
+static esp_err_t ota_download(esp_http_client_handle_t client, const esp_partition_t *partition,
+                              ota_progress_t *progress, bool *up_to_date, uint32_t *received)
+{
+    char range[32];
+    char *etag = NULL;
+    uint32_t erased;
+    uint32_t saved;
+    int status;
+    int len;
+    esp_err_t err;
+
+    *up_to_date = false;
+
+    // Resume on a sector boundary; the sector is erased and written again
+    progress->offset &= ~(SPI_FLASH_SEC_SIZE - 1);
+    esp_http_client_set_header(client, "If-None-Match", "\"" VERSION_SHORT "\"");
+    if (progress->offset > 0 && progress->etag[0] != '\0') {
+        snprintf(range, sizeof(range), "bytes=%" PRIu32 "-", progress->offset);
+        esp_http_client_set_header(client, "Range", range);
+        esp_http_client_set_header(client, "If-Range", progress->etag);
+    } else {
+        progress->offset = 0;
+        esp_http_client_delete_header(client, "Range");
+        esp_http_client_delete_header(client, "If-Range");
+    }
+
+    err = esp_http_client_open(client, 0);
+    if (err != ESP_OK) {
+        return err;
+    }
+    if (esp_http_client_fetch_headers(client) < 0) {
+        esp_http_client_close(client);
+        return ESP_FAIL;
+    }
+
+    status = esp_http_client_get_status_code(client);
+    if (status == HTTP_STATUS_NOT_MODIFIED) {
+        esp_http_client_flush_response(client, NULL);
+        *up_to_date = true;
+        return ESP_OK;
+    }
+    if (status == HttpStatus_Ok) {
+        // New image, or the one being resumed changed on the server
+        progress->offset = 0;
+        progress->etag[0] = '\0';
+        if (esp_http_client_get_header(client, "ETag", &etag) == ESP_OK && etag != NULL) {
+            strlcpy(progress->etag, etag, sizeof(progress->etag));
+        }
+    } else if (status != HTTP_STATUS_PARTIAL_CONTENT || progress->offset == 0) {
+        ESP_LOGE(TAG, "Unexpected HTTP status %d", status);
+        esp_http_client_close(client);
+        return ESP_FAIL;
+    }
+    ESP_LOGI(TAG, "Downloading %s from offset %" PRIu32, progress->etag, progress->offset);
+
+    erased = progress->offset;
+    saved = progress->offset;
+    while ((len = esp_http_client_read(client, s_ota_buffer, sizeof(s_ota_buffer))) > 0) {
+        if (progress->offset + len > partition->size) {
+            err = ESP_ERR_INVALID_SIZE;
+            break;
+        }
+        while (erased < progress->offset + len) {
+            err = esp_partition_erase_range(partition, erased, SPI_FLASH_SEC_SIZE);
+            if (err != ESP_OK) {
+                break;
+            }
+            erased += SPI_FLASH_SEC_SIZE;
+        }
+        if (err == ESP_OK) {
+            err = esp_partition_write(partition, progress->offset, s_ota_buffer, len);
+        }
+        if (err != ESP_OK) {
+            break;
+        }
+        progress->offset += len;
+        *received += len;
+
+        if (progress->offset - saved >= OTA_SAVE_INTERVAL) {
+            saved = progress->offset & ~(SPI_FLASH_SEC_SIZE - 1);
+            ota_progress_t checkpoint = *progress;
+            checkpoint.offset = saved;
+            ota_progress_save(&checkpoint);
+        }
+    }
+
+    if (err == ESP_OK && (len < 0 || !esp_http_client_is_complete_data_received(client))) {
+        err = ESP_FAIL;
+    }
+    if (err != ESP_OK) {
+        esp_http_client_close(client);
+    }
+    return err;
+}
+
+typedef struct {
+    const esp_partition_t *running;
+    const esp_partition_t *target;
+    uint32_t erased;
+} ota_delta_ctx_t;
+
+static int ota_delta_begin(void *ctx, const delta_patch_header_t *header)
+{
+    ota_delta_ctx_t *delta = ctx;
+    uint8_t digest[32];
+
+    if (header->old_size > delta->running->size || header->new_size > delta->target->size) {
+        return -1;
+    }
+    // The delta must have been made against the image we are running
+    if (esp_partition_get_sha256(delta->running, digest) != ESP_OK ||
+        memcmp(digest, header->old_digest, sizeof(digest)) != 0) {
+        ESP_LOGW(TAG, "Delta was made for a different image");
+        return -1;
+    }
+    return 0;
+}
+
+static int ota_delta_read_old(void *ctx, uint32_t offset, void *data, size_t len)
+{
+    ota_delta_ctx_t *delta = ctx;
+
+    return esp_partition_read(delta->running, offset, data, len) == ESP_OK ? 0 : -1;
+}
+
+static int ota_delta_write_new(void *ctx, uint32_t offset, const void *data, size_t len)
+{
+    ota_delta_ctx_t *delta = ctx;
+
+    while (delta->erased < offset + len) {
+        if (esp_partition_erase_range(delta->target, delta->erased, SPI_FLASH_SEC_SIZE) != ESP_OK) {
+            return -1;
+        }
+        delta->erased += SPI_FLASH_SEC_SIZE;
+    }
+    return esp_partition_write(delta->target, offset, data, len) == ESP_OK ? 0 : -1;
+}
+
+/* Ask the server for a delta from the running version and patch it into the
+ * inactive partition, reading the unchanged parts from the running one.
+ * Returns ESP_ERR_NOT_FOUND when the server has no delta for this version. */
+static esp_err_t ota_delta_download(esp_http_client_handle_t client, const esp_partition_t *partition,
+                                    bool *up_to_date, uint32_t *received)
 {
-    xEventGroupWaitBits(s_event_start_ota, BIT_BTN_PRESSED, pdTRUE, pdTRUE, portMAX_DELAY);
+    ota_delta_ctx_t ctx = {
+        .running = esp_ota_get_running_partition(),
+        .target = partition,
+    };
+    const delta_patch_io_t io = {
+        .begin = ota_delta_begin,
+        .read_old = ota_delta_read_old,
+        .write_new = ota_delta_write_new,
+        .ctx = &ctx,
+    };
+    delta_patch_t patch;
+    int status;
+    int len;
+    esp_err_t err = ESP_OK;
+
+    *up_to_date = false;
+    esp_http_client_set_url(client, CONFIG_EXAMPLE_FIRMWARE_DELTA_URL);
+    esp_http_client_delete_header(client, "If-None-Match");
+    esp_http_client_delete_header(client, "Range");
+    esp_http_client_delete_header(client, "If-Range");
+
+    err = esp_http_client_open(client, 0);
+    if (err == ESP_OK && esp_http_client_fetch_headers(client) < 0) {
+        err = ESP_FAIL;
+    }
+    if (err != ESP_OK) {
+        esp_http_client_close(client);
+        esp_http_client_set_url(client, CONFIG_EXAMPLE_FIRMWARE_UPGRADE_URL);
+        return err;
+    }
 
-    ESP_ERROR_CHECK(esp_tls_init_global_ca_store());
-    ESP_ERROR_CHECK(esp_tls_set_global_ca_store((unsigned char *)server_cert_pem_start, server_cert_pem_end - server_cert_pem_start));
+    status = esp_http_client_get_status_code(client);
+    if (status == HTTP_STATUS_NOT_MODIFIED) {
+        *up_to_date = true;
+    } else if (status != HttpStatus_Ok) {
+        err = ESP_ERR_NOT_FOUND;
+    } else {
+        delta_patch_init(&patch, &io);
+        while ((len = esp_http_client_read(client, s_ota_buffer, sizeof(s_ota_buffer))) > 0) {
+            *received += len;
+            if (delta_patch_feed(&patch, (const uint8_t *)s_ota_buffer, len) != DELTA_PATCH_OK) {
+                err = ESP_FAIL;
+                break;
+            }
+        }
+        if (err == ESP_OK && (len < 0 || delta_patch_finish(&patch) != DELTA_PATCH_OK)) {
+            err = ESP_FAIL;
+        }
+    }
 
-    // call CURRENT_REMOTE_VERSION_URL to get the current version
-    // if the version is the same as the current one, do nothing
-    // if the version is different, start the OTA process
+    if (err == ESP_OK || err == ESP_ERR_NOT_FOUND) {
+        esp_http_client_flush_response(client, NULL);
+    } else {
+        esp_http_client_close(client);
+    }
+    esp_http_client_set_url(client, CONFIG_EXAMPLE_FIRMWARE_UPGRADE_URL);
+    return err;
+}
 
-    bool got_version = false;
+static void ota_update(void)
+{
+    const esp_partition_t *partition = esp_ota_get_next_update_partition(NULL);
+    ota_progress_t progress;
+    bool up_to_date = false;
+    uint32_t received = 0;
+    int64_t start = esp_timer_get_time();
+    esp_err_t err = ESP_FAIL;
+
+    if (partition == NULL) {
+        ESP_LOGE(TAG, "No OTA partition");
+        return;
+    }
 
-    // configure call
-    esp_http_client_config_t config_version = {
-        .url = CURRENT_REMOTE_VERSION_URL,
+    esp_http_client_config_t config = {
+        .url = CONFIG_EXAMPLE_FIRMWARE_UPGRADE_URL,
         .cert_pem = (char *)server_cert_pem_start,
-        .cert_len = 1422,
-        .event_handler = _http_event_handler,
         .keep_alive_enable = true,
-        .use_global_ca_store = true,
-        .skip_cert_common_name_check = true
+        .skip_cert_common_name_check = true,
+#if CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+        .save_client_session = true,
+#endif
     };
-    
+    // One client for every attempt, so the connection and TLS session are reused
+    esp_http_client_handle_t client = esp_http_client_init(&config);
+    if (client == NULL) {
+        return;
+    }
 
-    esp_http_client_handle_t client = esp_http_client_init(&config_version);
-    esp_err_t err = esp_http_client_perform(client);
+    ota_progress_load(&progress);
+    // A delta rewrites the partition from the start, so only try it when no
+    // full download is waiting to be resumed
+    if (progress.offset == 0) {
+        err = ota_delta_download(client, partition, &up_to_date, &received);
+        if (err != ESP_OK) {
+            ESP_LOGI(TAG, "No delta update (%s), downloading the full image", esp_err_to_name(err));
+        }
+    }
+    for (int attempt = 0; attempt < OTA_MAX_ATTEMPTS && err != ESP_OK; attempt++) {
+        err = ota_download(client, partition, &progress, &up_to_date, &received);
+        if (err == ESP_OK) {
+            break;
+        }
+        ESP_LOGW(TAG, "Download interrupted at %" PRIu32 ": %s", progress.offset, esp_err_to_name(err));
+        ota_progress_save(&progress);
+        vTaskDelay(1000 / portTICK_PERIOD_MS);
+    }
+    esp_http_client_cleanup(client);
 
-    char *buffer = NULL;
-    // check if the call was successful
+    ESP_LOGI(TAG, "%" PRIu32 " bytes in %lld ms", received, (esp_timer_get_time() - start) / 1000);
     if (err != ESP_OK) {
-        ESP_LOGE(TAG, "HTTP GET request failed: %s", esp_err_to_name(err));
-        esp_http_client_cleanup(client);
-    }else{
-        // get the response
-        int content_length = esp_http_client_fetch_headers(client);
-        buffer = malloc(content_length + 1);
-        esp_http_client_read(client, buffer, content_length);
-        buffer[content_length] = '\0';
-
-        ESP_LOGI(TAG, "Current remote version: %s", buffer);
-
-        // check if the version is the same as the current one
-        if (strcmp(buffer, VERSION_SHORT) == 0) {
-            ESP_LOGI(TAG, "Current version is the same as the remote one");
-            esp_http_client_cleanup(client);
-        }
+        ESP_LOGE(TAG, "Firmware upgrade failed");
+        return;
+    }
+    if (up_to_date) {
+        ESP_LOGI(TAG, "Running version %s is up to date", VERSION_SHORT);
+        return;
     }
 
-    // start the OTA process
-    if(got_version && strcmp(buffer, VERSION_SHORT) != 0){
-
-        ESP_LOGI(TAG, "Starting OTA example task");
-        esp_http_client_config_t config = {
-            .url = CONFIG_EXAMPLE_FIRMWARE_UPGRADE_URL,
-            .cert_pem = (char *)server_cert_pem_start,
-            .cert_len = 1422,
-            .event_handler = _http_event_handler,
-            .keep_alive_enable = true,
-            .use_global_ca_store = true,
-            .skip_cert_common_name_check = true
-        };
-
-        esp_https_ota_config_t ota_config = {
-            .http_config = &config,
-        };
-        
-        ESP_LOGI(TAG, "Attempting to download update from %s", config.url);
-        esp_err_t ret = esp_https_ota(&ota_config);
-        if (ret == ESP_OK) {
-            ESP_LOGI(TAG, "OTA Succeed, Rebooting...");
-            esp_restart();
-        } else {
-            ESP_LOGE(TAG, "Firmware upgrade failed");
-        }
-        
+    memset(&progress, 0, sizeof(progress));
+    ota_progress_save(&progress);
+
+    // Validates the image before switching to it
+    err = esp_ota_set_boot_partition(partition);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Downloaded image is not valid: %s", esp_err_to_name(err));
+        return;
     }
+    ESP_LOGI(TAG, "OTA Succeed, Rebooting...");
+    esp_restart();
+}
+
+static void ota_task(void *pvParameters)
+{
     while (1) {
-        vTaskDelay(1000 / portTICK_PERIOD_MS);
+        xEventGroupWaitBits(s_event_start_ota, BIT_BTN_PRESSED, pdTRUE, pdTRUE, portMAX_DELAY);
+        ota_update();
     }
 }
 
 static void button_task(void * pvParameter)
 {
-    uint8_t u8Count = 5;
-    int val = 1;
+    const button_config_t button = {
+        .pin = GPIO_INPUT_IO,
+        .active_low = true,
+        .debounce_ms = 50,
+    };
+    QueueHandle_t button_queue;
+    if (button_init(&button, 1, &button_queue) != ESP_OK) {
+        ESP_LOGE(TAG, "Unable to set up the button");
+        vTaskDelete(NULL);
+    }
 
     while(1)
     {
-        if (gpio_get_level(GPIO_INPUT_IO) != val)
-            u8Count--;
-        else
-            u8Count = 5;
-
-        if(!u8Count) {
-            val = gpio_get_level(GPIO_INPUT_IO);
-
-            if(!gpio_get_level(GPIO_INPUT_IO)){
-                ESP_LOGI(TAG, "Button pressed");
-                xEventGroupSetBits(s_event_start_ota, BIT_BTN_PRESSED);
-                val = gpio_get_level(GPIO_INPUT_IO);
-            }
-        }
+        button_event_t event;
+        xQueueReceive(button_queue, &event, portMAX_DELAY);
 
-        vTaskDelay(10 / portTICK_PERIOD_MS);
+        if (event.type == BUTTON_EVENT_PRESS) {
+            ESP_LOGI(TAG, "Button pressed");
+            xEventGroupSetBits(s_event_start_ota, BIT_BTN_PRESSED);
+        }
     }
 }
 
@@ -0,0 +1,238 @@
+/* Host tests of the button debounce state machine
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+
+   Feeds timestamped input edges through the same one-shot timer scheme as
+   button.c and checks the events and when they are reported.
+
+   Run on the host with: pio test -e native
+*/
+#include <stdio.h>
+#include <string.h>
+#include <unity.h>
+
+#include "button_fsm.h"
+
+#define DEBOUNCE_MS     20
+#define LONG_PRESS_MS   1000
+#define MAX_EVENTS      16
+
+typedef struct {
+    uint32_t ms;
+    bool pressed;
+} edge_t;
+
+typedef struct {
+    uint32_t ms;
+    button_event_type_t type;
+} event_t;
+
+static event_t s_events[MAX_EVENTS];
+static size_t s_event_count;
+
+static void record(button_event_type_t type, uint32_t ms)
+{
+    if (type != BUTTON_EVENT_NONE && s_event_count < MAX_EVENTS) {
+        s_events[s_event_count].ms = ms;
+        s_events[s_event_count].type = type;
+        s_event_count++;
+    }
+}
+
+/* Model of button.c: every edge restarts the timer with the debounce time,
+ * the timer runs the machine and rearms itself with timeout_ms. The input
+ * starts released at start_ms and the simulation runs until end_ms. */
+static void replay(uint32_t long_press_ms, uint32_t start_ms, const edge_t *edges,
+                   size_t count, uint32_t end_ms)
+{
+    button_fsm_t fsm;
+    bool level = false;
+    bool edge = false;
+    bool armed = false;
+    uint32_t expiry = 0;
+    size_t next = 0;
+
+    button_fsm_init(&fsm, long_press_ms, false);
+    for (uint32_t now = start_ms; now != end_ms; now++) {
+        while (next < count && edges[next].ms == now) {
+            level = edges[next++].pressed;
+            edge = true;
+            armed = true;
+            expiry = now + DEBOUNCE_MS;
+        }
+        if (armed && now == expiry) {
+            armed = false;
+            record(button_fsm_update(&fsm, edge, level, now), now);
+            edge = false;
+            if (fsm.timeout_ms > 0) {
+                armed = true;
+                expiry = now + fsm.timeout_ms;
+            }
+        }
+    }
+}
+
+static void check_events(const event_t *expected, size_t count)
+{
+    char what[32];
+
+    TEST_ASSERT_EQUAL_INT(count, s_event_count);
+    for (size_t i = 0; i < count && i < s_event_count; i++) {
+        snprintf(what, sizeof(what), "event %u", (unsigned)i);
+        TEST_ASSERT_EQUAL_INT_MESSAGE(expected[i].type, s_events[i].type, what);
+        TEST_ASSERT_EQUAL_INT_MESSAGE(expected[i].ms, s_events[i].ms, what);
+    }
+}
+
+void setUp(void)
+{
+    s_event_count = 0;
+}
+
+void tearDown(void)
+{
+}
+
+static void test_bouncing_contacts(void)
+{
+    static const edge_t edges[] = {
+        { 100, true }, { 102, false }, { 103, true }, { 107, false }, { 108, true },
+        { 400, false }, { 401, true }, { 404, false },
+    };
+    static const event_t expected[] = {
+        { 128, BUTTON_EVENT_PRESS },
+        { 424, BUTTON_EVENT_RELEASE },
+    };
+
+    replay(LONG_PRESS_MS, 0, edges, sizeof(edges) / sizeof(edges[0]), 2000);
+    check_events(expected, sizeof(expected) / sizeof(expected[0]));
+}
+
+static void test_glitch_shorter_than_debounce(void)
+{
+    static const edge_t edges[] = {
+        { 100, true }, { 105, false },
+        { 300, true }, { 300 + DEBOUNCE_MS - 1, false },
+    };
+
+    replay(LONG_PRESS_MS, 0, edges, sizeof(edges) / sizeof(edges[0]), 2000);
+    TEST_ASSERT_EQUAL_INT(0, s_event_count);
+}
+
+static void test_long_press(void)
+{
+    static const edge_t edges[] = {
+        { 100, true }, { 101, false }, { 102, true },
+        { 1800, false },
+    };
+    static const event_t expected[] = {
+        { 122, BUTTON_EVENT_PRESS },
+        { 122 + LONG_PRESS_MS, BUTTON_EVENT_LONG_PRESS },
+        { 1820, BUTTON_EVENT_RELEASE },
+    };
+
+    replay(LONG_PRESS_MS, 0, edges, sizeof(edges) / sizeof(edges[0]), 3000);
+    check_events(expected, sizeof(expected) / sizeof(expected[0]));
+}
+
+static void test_long_press_survives_glitch(void)
+{
+    /* A glitch restarts the timer, which then has to be rearmed for the
+     * rest of the long press time */
+    static const edge_t edges[] = {
+        { 100, true },
+        { 600, false }, { 603, true },
+        { 1500, false },
+    };
+    static const event_t expected[] = {
+        { 120, BUTTON_EVENT_PRESS },
+        { 120 + LONG_PRESS_MS, BUTTON_EVENT_LONG_PRESS },
+        { 1520, BUTTON_EVENT_RELEASE },
+    };
+
+    replay(LONG_PRESS_MS, 0, edges, sizeof(edges) / sizeof(edges[0]), 3000);
+    check_events(expected, sizeof(expected) / sizeof(expected[0]));
+}
+
+static void test_released_just_before_long_press(void)
+{
+    static const edge_t edges[] = {
+        { 100, true },
+        { 100 + LONG_PRESS_MS - 1, false },
+    };
+    static const event_t expected[] = {
+        { 120, BUTTON_EVENT_PRESS },
+        { 120 + LONG_PRESS_MS - 1, BUTTON_EVENT_RELEASE },
+    };
+
+    replay(LONG_PRESS_MS, 0, edges, sizeof(edges) / sizeof(edges[0]), 3000);
+    check_events(expected, sizeof(expected) / sizeof(expected[0]));
+}
+
+static void test_double_click(void)
+{
+    static const edge_t edges[] = {
+        { 100, true }, { 101, false }, { 102, true },
+        { 180, false },
+        { 250, true }, { 252, false }, { 253, true },
+        { 330, false }, { 331, true }, { 332, false },
+    };
+    static const event_t expected[] = {
+        { 122, BUTTON_EVENT_PRESS },
+        { 200, BUTTON_EVENT_RELEASE },
+        { 273, BUTTON_EVENT_PRESS },
+        { 352, BUTTON_EVENT_RELEASE },
+    };
+
+    replay(LONG_PRESS_MS, 0, edges, sizeof(edges) / sizeof(edges[0]), 3000);
+    check_events(expected, sizeof(expected) / sizeof(expected[0]));
+}
+
+static void test_long_press_disabled(void)
+{
+    static const edge_t edges[] = {
+        { 100, true },
+        { 5000, false },
+    };
+    static const event_t expected[] = {
+        { 120, BUTTON_EVENT_PRESS },
+        { 5020, BUTTON_EVENT_RELEASE },
+    };
+
+    replay(0, 0, edges, sizeof(edges) / sizeof(edges[0]), 6000);
+    check_events(expected, sizeof(expected) / sizeof(expected[0]));
+}
+
+static void test_clock_wrap(void)
+{
+    static const edge_t edges[] = {
+        { UINT32_MAX - 500, true },
+        { 1000, false },
+    };
+    static const event_t expected[] = {
+        { UINT32_MAX - 480, BUTTON_EVENT_PRESS },
+        { 519, BUTTON_EVENT_LONG_PRESS },
+        { 1020, BUTTON_EVENT_RELEASE },
+    };
+
+    replay(LONG_PRESS_MS, UINT32_MAX - 1000, edges, sizeof(edges) / sizeof(edges[0]), 2000);
+    check_events(expected, sizeof(expected) / sizeof(expected[0]));
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_bouncing_contacts);
+    RUN_TEST(test_glitch_shorter_than_debounce);
+    RUN_TEST(test_long_press);
+    RUN_TEST(test_long_press_survives_glitch);
+    RUN_TEST(test_released_just_before_long_press);
+    RUN_TEST(test_double_click);
+    RUN_TEST(test_long_press_disabled);
+    RUN_TEST(test_clock_wrap);
+    return UNITY_END();
+}
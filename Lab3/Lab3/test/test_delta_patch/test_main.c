@@ -0,0 +1,274 @@
+/* Host tests of the streaming delta applier
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+
+   Applies deltas made by delta.py between real firmware builds: the EFR32
+   images built for Lab7, Lab8 and Lab9, which are in the repository. The
+   running partition is the old image file, padded with 0xff to a sector;
+   the target partition is a temporary file that, like flash, is erased a
+   sector at a time ahead of the writes, the way ota_delta_write_new() does,
+   and can only be written where it is erased. The delta is fed in chunks of
+   1 byte to 4 KB, as the HTTP client hands them over.
+
+   The deltas were made from the project directory with
+       python delta.py <old>.bin <new>.bin test/test_delta_patch/<old>_to_<new>.delta
+
+   Run on the host from the project directory with: pio test -e native
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unity.h>
+
+#include "delta_patch.h"
+
+#define BUILDS          "../../"
+#define DELTAS          "test/test_delta_patch/"
+#define SECTOR_SIZE     4096
+#define PARTITION_SIZE  (64 * SECTOR_SIZE)
+#define MAX_CHUNK       4096
+
+typedef struct {
+    const char *name;
+    const char *old_path;
+    const char *new_path;
+    const char *delta_path;
+} triple_t;
+
+static const triple_t triples[] = {
+    { "Lab7 to Lab9", BUILDS "Lab7/GNU ARM v12.2.1 - Default/Lab7.bin",
+      BUILDS "Lab9/GNU ARM v12.2.1 - Default/Lab9.bin", DELTAS "lab7_to_lab9.delta" },
+    { "Lab8 to Lab9", BUILDS "Lab8/GNU ARM v12.2.1 - Default/lab8.bin",
+      BUILDS "Lab9/GNU ARM v12.2.1 - Default/Lab9.bin", DELTAS "lab8_to_lab9.delta" },
+    { "Lab7 to Lab8", BUILDS "Lab7/GNU ARM v12.2.1 - Default/Lab7.bin",
+      BUILDS "Lab8/GNU ARM v12.2.1 - Default/lab8.bin", DELTAS "lab7_to_lab8.delta" },
+};
+
+typedef struct {
+    uint8_t *data;
+    size_t len;
+} blob_t;
+
+/* The two partitions of ota_delta_ctx_t, backed by files */
+typedef struct {
+    FILE *running;
+    uint32_t running_size;
+    uint8_t running_digest[32];
+    FILE *target;
+    uint32_t erased;
+    int bad_writes;
+} partitions_t;
+
+static blob_t load(const char *path)
+{
+    blob_t blob = { NULL, 0 };
+    FILE *file = fopen(path, "rb");
+
+    if (file == NULL) {
+        return blob;
+    }
+    fseek(file, 0, SEEK_END);
+    blob.len = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    blob.data = malloc(blob.len);
+    if (fread(blob.data, 1, blob.len, file) != blob.len) {
+        free(blob.data);
+        blob.data = NULL;
+    }
+    fclose(file);
+    return blob;
+}
+
+static int io_begin(void *ctx, const delta_patch_header_t *header)
+{
+    partitions_t *p = ctx;
+
+    if (header->old_size > p->running_size || header->new_size > PARTITION_SIZE) {
+        return -1;
+    }
+    return memcmp(p->running_digest, header->old_digest, sizeof(p->running_digest)) != 0;
+}
+
+static int io_read_old(void *ctx, uint32_t offset, void *data, size_t len)
+{
+    partitions_t *p = ctx;
+    size_t got;
+
+    if (offset + len > p->running_size || fseek(p->running, offset, SEEK_SET) != 0) {
+        return -1;
+    }
+    // The padding of the partition past the image reads as erased flash
+    got = fread(data, 1, len, p->running);
+    memset((uint8_t *)data + got, 0xff, len - got);
+    return 0;
+}
+
+static int io_write_new(void *ctx, uint32_t offset, const void *data, size_t len)
+{
+    static uint8_t erased_sector[SECTOR_SIZE];
+    partitions_t *p = ctx;
+    uint8_t current[DELTA_PATCH_CHUNK];
+
+    if (offset + len > PARTITION_SIZE || len > sizeof(current)) {
+        return -1;
+    }
+    memset(erased_sector, 0xff, sizeof(erased_sector));
+    while (p->erased < offset + len) {
+        fseek(p->target, p->erased, SEEK_SET);
+        fwrite(erased_sector, 1, sizeof(erased_sector), p->target);
+        p->erased += SECTOR_SIZE;
+    }
+    fseek(p->target, offset, SEEK_SET);
+    if (fread(current, 1, len, p->target) != len) {
+        return -1;
+    }
+    for (size_t i = 0; i < len; i++) {
+        if (current[i] != 0xff) {
+            p->bad_writes++;
+            return -1;
+        }
+    }
+    fseek(p->target, offset, SEEK_SET);
+    return fwrite(data, 1, len, p->target) == len ? 0 : -1;
+}
+
+static void open_partitions(partitions_t *p, const char *old_path)
+{
+    blob_t old = load(old_path);
+
+    TEST_ASSERT_NOT_NULL_MESSAGE(old.data, old_path);
+    memset(p, 0, sizeof(*p));
+    // As delta.py's image_digest(): on the ESP32, the SHA-256 esptool appends
+    memcpy(p->running_digest, old.data + old.len - 32, 32);
+    p->running_size = (old.len + SECTOR_SIZE - 1) / SECTOR_SIZE * SECTOR_SIZE;
+    free(old.data);
+    p->running = fopen(old_path, "rb");
+    p->target = tmpfile();
+    TEST_ASSERT_NOT_NULL(p->running);
+    TEST_ASSERT_NOT_NULL(p->target);
+}
+
+static void close_partitions(partitions_t *p)
+{
+    fclose(p->running);
+    fclose(p->target);
+}
+
+/* Feed the delta in chunks drawn from seed, stopping after len bytes */
+static delta_patch_err_t apply(partitions_t *p, const blob_t *delta, size_t len, unsigned seed)
+{
+    const delta_patch_io_t io = {
+        .begin = io_begin,
+        .read_old = io_read_old,
+        .write_new = io_write_new,
+        .ctx = p,
+    };
+    delta_patch_t patch;
+    delta_patch_err_t err = DELTA_PATCH_OK;
+    size_t pos = 0;
+
+    delta_patch_init(&patch, &io);
+    srand(seed);
+    while (pos < len && err == DELTA_PATCH_OK) {
+        size_t n = 1 + (size_t)rand() % MAX_CHUNK;
+
+        if (n > len - pos) {
+            n = len - pos;
+        }
+        err = delta_patch_feed(&patch, delta->data + pos, n);
+        pos += n;
+    }
+    return err != DELTA_PATCH_OK ? err : delta_patch_finish(&patch);
+}
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+static void test_real_builds(void)
+{
+    for (size_t i = 0; i < sizeof(triples) / sizeof(triples[0]); i++) {
+        const triple_t *t = &triples[i];
+        blob_t new_image = load(t->new_path);
+        blob_t delta = load(t->delta_path);
+        partitions_t p;
+        uint8_t *written;
+
+        TEST_ASSERT_NOT_NULL_MESSAGE(new_image.data, t->new_path);
+        TEST_ASSERT_NOT_NULL_MESSAGE(delta.data, t->delta_path);
+        for (unsigned seed = 1; seed <= 3; seed++) {
+            open_partitions(&p, t->old_path);
+            TEST_ASSERT_EQUAL_INT_MESSAGE(DELTA_PATCH_OK, apply(&p, &delta, delta.len, seed), t->name);
+            TEST_ASSERT_EQUAL_INT_MESSAGE(0, p.bad_writes, t->name);
+
+            written = malloc(new_image.len);
+            fseek(p.target, 0, SEEK_SET);
+            TEST_ASSERT_EQUAL_size_t(new_image.len, fread(written, 1, new_image.len, p.target));
+            TEST_ASSERT_EQUAL_MEMORY_MESSAGE(new_image.data, written, new_image.len, t->name);
+            free(written);
+            close_partitions(&p);
+        }
+        printf("%s: image %u bytes, delta %u bytes (%.1f%%)\n", t->name, (unsigned)new_image.len,
+               (unsigned)delta.len, 100.0 * delta.len / new_image.len);
+        free(new_image.data);
+        free(delta.data);
+    }
+}
+
+static void test_wrong_running_image(void)
+{
+    blob_t delta = load(triples[0].delta_path);
+    partitions_t p;
+
+    /* These builds carry no appended SHA-256, and their last 32 bytes are the
+     * same, so a delta for another running image is made by changing the
+     * digest in its header */
+    TEST_ASSERT_NOT_NULL(delta.data);
+    delta.data[16] ^= 1;
+    open_partitions(&p, triples[0].old_path);
+    TEST_ASSERT_EQUAL_INT(DELTA_PATCH_ERR_REJECTED, apply(&p, &delta, delta.len, 1));
+    TEST_ASSERT_EQUAL_UINT32(0, p.erased);
+    close_partitions(&p);
+    free(delta.data);
+}
+
+static void test_truncated_and_corrupt(void)
+{
+    blob_t delta = load(triples[1].delta_path);
+    partitions_t p;
+
+    TEST_ASSERT_NOT_NULL(delta.data);
+    // Cut anywhere, the delta is never taken for a complete image
+    for (size_t len = DELTA_PATCH_HEADER_SIZE; len < delta.len; len += delta.len / 7) {
+        open_partitions(&p, triples[1].old_path);
+        TEST_ASSERT_NOT_EQUAL(DELTA_PATCH_OK, apply(&p, &delta, len, 1));
+        close_partitions(&p);
+    }
+    open_partitions(&p, triples[1].old_path);
+    TEST_ASSERT_NOT_EQUAL(DELTA_PATCH_OK, apply(&p, &delta, delta.len - 1, 1));
+    close_partitions(&p);
+
+    // An unknown op right after the header
+    delta.data[DELTA_PATCH_HEADER_SIZE] = 0x7f;
+    open_partitions(&p, triples[1].old_path);
+    TEST_ASSERT_EQUAL_INT(DELTA_PATCH_ERR_FORMAT, apply(&p, &delta, delta.len, 1));
+    close_partitions(&p);
+    free(delta.data);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_real_builds);
+    RUN_TEST(test_wrong_running_image);
+    RUN_TEST(test_truncated_and_corrupt);
+    return UNITY_END();
+}
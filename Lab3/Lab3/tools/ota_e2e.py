@@ -0,0 +1,291 @@
+"""End-to-end check of the resumable OTA download against server.py.
+
+Runs the Flask app of server.py over plain HTTP on localhost, in a scratch
+directory with a generated firmware image, and drives it with a model of
+ota_update()/ota_download() from src/main.c: same headers, sector-aligned
+resume offsets, NVS checkpoints every OTA_SAVE_INTERVAL bytes, one
+keep-alive connection for all attempts and a flash partition that may only
+be written where it was erased. Interruptions are injected by dropping the
+connection after a given number of body bytes, or by a power loss that
+loses everything but the flash and the NVS checkpoint.
+
+    lab3/bin/python tools/ota_e2e.py [--size BYTES]
+
+TLS and the delta path are not exercised; the device only probes
+/firmware.delta, which has no delta for the versions used here.
+"""
+import argparse
+import http.client
+import importlib.util
+import logging
+import os
+import random
+import sys
+import tempfile
+import threading
+
+from werkzeug.serving import WSGIRequestHandler, make_server
+
+# Same values as src/main.c
+SECTOR_SIZE = 4096
+OTA_BUFFER_SIZE = 4096
+OTA_MAX_ATTEMPTS = 5
+OTA_SAVE_INTERVAL = 16 * SECTOR_SIZE
+PARTITION_SIZE = 0x180000
+
+RUNNING_VERSION = 'v0.1.50'
+
+
+class PowerLoss(Exception):
+    pass
+
+
+class Flash:
+    """Partition that, like NOR flash, can only be written once erased."""
+
+    def __init__(self, size):
+        self.data = bytearray(random.getrandbits(8) for _ in range(size))
+
+    def erase_sector(self, offset):
+        assert offset % SECTOR_SIZE == 0
+        self.data[offset:offset + SECTOR_SIZE] = b'\xff' * SECTOR_SIZE
+
+    def write(self, offset, chunk):
+        if any(b != 0xff for b in self.data[offset:offset + len(chunk)]):
+            raise AssertionError('write at {} over data that was not erased'.format(offset))
+        self.data[offset:offset + len(chunk)] = chunk
+
+
+class Device:
+    """The OTA client of src/main.c, with the flash and NVS surviving reboots."""
+
+    def __init__(self, port):
+        self.port = port
+        self.flash = Flash(PARTITION_SIZE)
+        self.nvs = None
+        self.faults = []
+        self.log = []           # (status, body bytes) per request
+        self.connections = 0
+        self.conn = None
+
+    def connect(self):
+        if self.conn is None:
+            self.conn = http.client.HTTPConnection('127.0.0.1', self.port, timeout=10)
+            self.connections += 1
+        return self.conn
+
+    def drop(self):
+        if self.conn is not None:
+            self.conn.close()
+            self.conn = None
+
+    def request(self, path, headers):
+        conn = self.connect()
+        try:
+            conn.request('GET', path, headers=headers)
+            return conn.getresponse()
+        except (http.client.HTTPException, OSError):
+            self.drop()
+            conn = self.connect()
+            conn.request('GET', path, headers=headers)
+            return conn.getresponse()
+
+    def ota_download(self, progress):
+        progress['offset'] &= ~(SECTOR_SIZE - 1)
+        headers = {'If-None-Match': '"{}"'.format(RUNNING_VERSION)}
+        if progress['offset'] > 0 and progress['etag']:
+            headers['Range'] = 'bytes={}-'.format(progress['offset'])
+            headers['If-Range'] = progress['etag']
+        else:
+            progress['offset'] = 0
+
+        resp = self.request('/firmware.bin', headers)
+        if resp.status == 304:
+            resp.read()
+            self.log.append((304, 0))
+            return 'up to date'
+        if resp.status == 200:
+            progress['offset'] = 0
+            progress['etag'] = resp.getheader('ETag', '')
+        elif resp.status != 206 or progress['offset'] == 0:
+            self.drop()
+            return 'fail'
+
+        length = int(resp.getheader('Content-Length'))
+        cut = self.faults.pop(0) if self.faults else None
+        erased = saved = progress['offset']
+        body = 0
+        while body < length:
+            chunk = resp.read(min(OTA_BUFFER_SIZE, length - body))
+            if not chunk:
+                break
+            if cut is not None and body + len(chunk) > cut[1]:
+                self.log.append((resp.status, body))
+                self.drop()
+                if cut[0] == 'power':
+                    raise PowerLoss()
+                return 'fail'
+            if progress['offset'] + len(chunk) > PARTITION_SIZE:
+                self.drop()
+                return 'fail'
+            while erased < progress['offset'] + len(chunk):
+                self.flash.erase_sector(erased)
+                erased += SECTOR_SIZE
+            self.flash.write(progress['offset'], chunk)
+            progress['offset'] += len(chunk)
+            body += len(chunk)
+            if progress['offset'] - saved >= OTA_SAVE_INTERVAL:
+                saved = progress['offset'] & ~(SECTOR_SIZE - 1)
+                self.nvs = dict(progress, offset=saved)
+        self.log.append((resp.status, body))
+        if body != length:
+            self.drop()
+            return 'fail'
+        return 'ok'
+
+    def ota_update(self):
+        """One press of the button; returns the outcome, or raises PowerLoss."""
+        progress = dict(self.nvs) if self.nvs else {'etag': '', 'offset': 0}
+        result = 'fail'
+        if progress['offset'] == 0:
+            resp = self.request('/firmware.delta?from=' + RUNNING_VERSION, {})
+            resp.read()
+            self.log.append((resp.status, 0))
+            if resp.status == 304:
+                return 'up to date'
+        for _ in range(OTA_MAX_ATTEMPTS):
+            result = self.ota_download(progress)
+            if result != 'fail':
+                break
+            self.nvs = dict(progress)
+        if result == 'ok':
+            self.nvs = None
+        return result
+
+    def reboot(self):
+        self.drop()
+
+
+class QuietHandler(WSGIRequestHandler):
+    # Keep-alive, like esp_http_client with keep_alive_enable
+    protocol_version = 'HTTP/1.1'
+
+    def log_request(self, *args):
+        pass
+
+    def log_error(self, *args):
+        pass
+
+
+def load_server(workdir):
+    here = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+    sys.path.insert(0, here)
+    spec = importlib.util.spec_from_file_location('server', os.path.join(here, 'server.py'))
+    server = importlib.util.module_from_spec(spec)
+    spec.loader.exec_module(server)
+    # send_file() resolves relative paths against the app root
+    server.app.root_path = workdir
+    return server
+
+
+def publish(size, build_no, seed):
+    rng = random.Random(seed)
+    os.makedirs('.pio/build/esp-wrover-kit', exist_ok=True)
+    image = bytes(rng.getrandbits(8) for _ in range(size))
+    with open('.pio/build/esp-wrover-kit/firmware.bin', 'wb') as f:
+        f.write(image)
+    with open('versioning', 'w') as f:
+        f.write(str(build_no))
+    return image
+
+
+def run(name, port, image, faults=(), reboots=0, expect='ok', max_ratio=None):
+    device = Device(port)
+    device.faults = list(faults)
+    boots = 0
+    while True:
+        boots += 1
+        try:
+            result = device.ota_update()
+            break
+        except PowerLoss:
+            device.reboot()
+            if boots > reboots:
+                result = 'power loss'
+                break
+    device.drop()
+
+    transferred = sum(n for _, n in device.log)
+    statuses = ' '.join(str(s) for s, _ in device.log)
+    ok = result == expect
+    if expect == 'ok':
+        ok = ok and device.flash.data[:len(image)] == image
+    if max_ratio is not None:
+        ok = ok and transferred <= max_ratio * len(image)
+    print('{:<28} {:<10} {:>9} bytes ({:4.2f}x) {:>2} conn  {}  {}'.format(
+        name, result, transferred, transferred / len(image), device.connections,
+        statuses, 'OK' if ok else 'FAILED'))
+    return ok
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('--size', type=int, default=600 * 1024, help='image size in bytes')
+    args = parser.parse_args()
+    size = args.size
+
+    logging.getLogger('werkzeug').setLevel(logging.ERROR)
+    random.seed(1)
+    workdir = tempfile.mkdtemp(prefix='ota_e2e_')
+    os.chdir(workdir)
+    image = publish(size, 51, 51)
+    server = load_server(workdir)
+    httpd = make_server('127.0.0.1', 0, server.app, threaded=True, request_handler=QuietHandler)
+    threading.Thread(target=httpd.serve_forever, daemon=True).start()
+    port = httpd.server_port
+
+    ok = True
+    ok &= run('clean download', port, image, max_ratio=1.0)
+    ok &= run('two dropped connections', port, image,
+              faults=[('drop', size // 3 + 1000), ('drop', size // 2 + 3000)], max_ratio=1.1)
+    # A checkpoint is written every OTA_SAVE_INTERVAL; at most that much
+    # plus the resumed sector is fetched again after a power loss.
+    ok &= run('power loss', port, image,
+              faults=[('power', size // 2)], reboots=1,
+              max_ratio=1.0 + (OTA_SAVE_INTERVAL + SECTOR_SIZE) / size)
+    ok &= run('power loss, then a drop', port, image,
+              faults=[('power', size // 4), ('drop', size // 4)], reboots=1)
+    ok &= run('too many drops', port, image,
+              faults=[('drop', 1000)] * OTA_MAX_ATTEMPTS, expect='fail')
+
+    # The image changes while a download is pending: If-Range no longer
+    # matches and the server sends the new image in full.
+    device = Device(port)
+    device.faults = [('power', size // 2)]
+    try:
+        device.ota_update()
+    except PowerLoss:
+        device.reboot()
+    new_image = publish(size, 52, 52)
+    result = device.ota_update()
+    device.drop()
+    statuses = [s for s, _ in device.log]
+    changed_ok = (result == 'ok' and statuses[-1] == 200
+                  and device.flash.data[:size] == new_image)
+    print('{:<28} {:<10} {:>37}  {}  {}'.format(
+        'image changed on server', result, '', ' '.join(str(s) for s in statuses),
+        'OK' if changed_ok else 'FAILED'))
+    ok &= changed_ok
+
+    # Running the published version: one 304 and nothing else
+    global RUNNING_VERSION
+    RUNNING_VERSION = 'v0.1.52'
+    ok &= run('up to date', port, new_image, expect='up to date', max_ratio=0)
+
+    httpd.shutdown()
+    print('ota_e2e:', 'OK' if ok else 'FAILED')
+    return 0 if ok else 1
+
+
+if __name__ == '__main__':
+    sys.exit(main())
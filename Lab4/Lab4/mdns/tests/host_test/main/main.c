@@ -4,6 +4,14 @@
  * SPDX-License-Identifier: Unlicense OR CC0-1.0
  */
 #include <stdio.h>
+#include <stdatomic.h>
+#include <malloc.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <net/if.h>
+#include <sys/socket.h>
 #include "mdns.h"
 #include "esp_log.h"
 #include "freertos/FreeRTOS.h"
@@ -31,6 +39,290 @@ static void query_mdns_host(const char *host_name)
     ESP_LOGI(TAG, "Query A: %s.local resolved to: " IPSTR, host_name, IP2STR(&addr));
 }
 
+#if CONFIG_TEST_RX_BENCHMARK || CONFIG_TEST_SERVICE_HEAP || CONFIG_TEST_TX_BENCHMARK
+// Heap counters, the allocator is wrapped at link time (see CMakeLists.txt)
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t nmemb, size_t size);
+char *__real_strdup(const char *s);
+char *__real_strndup(const char *s, size_t n);
+void __real_free(void *ptr);
+
+static atomic_uint s_allocs;        // allocations made
+static atomic_long s_heap_blocks;   // blocks in use
+static atomic_long s_heap_bytes;    // bytes in use, including the allocator's rounding
+
+static void *count_alloc(void *ptr)
+{
+    if (ptr) {
+        atomic_fetch_add(&s_allocs, 1);
+        atomic_fetch_add(&s_heap_blocks, 1);
+        atomic_fetch_add(&s_heap_bytes, malloc_usable_size(ptr));
+    }
+    return ptr;
+}
+
+void *__wrap_malloc(size_t size)
+{
+    return count_alloc(__real_malloc(size));
+}
+
+void *__wrap_calloc(size_t nmemb, size_t size)
+{
+    return count_alloc(__real_calloc(nmemb, size));
+}
+
+char *__wrap_strdup(const char *s)
+{
+    return count_alloc(__real_strdup(s));
+}
+
+char *__wrap_strndup(const char *s, size_t n)
+{
+    return count_alloc(__real_strndup(s, n));
+}
+
+void __wrap_free(void *ptr)
+{
+    if (ptr) {
+        atomic_fetch_sub(&s_heap_blocks, 1);
+        atomic_fetch_sub(&s_heap_bytes, malloc_usable_size(ptr));
+    }
+    __real_free(ptr);
+}
+#endif
+
+#if CONFIG_TEST_RX_BENCHMARK || CONFIG_TEST_TX_BENCHMARK
+static uint64_t now_us(clockid_t clock)
+{
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+#endif
+
+#if CONFIG_TEST_RX_BENCHMARK_ANSWERED || CONFIG_TEST_TX_BENCHMARK
+// mdns_if_t is a size_t
+size_t __real__mdns_udp_pcb_write(size_t tcpip_if, mdns_ip_protocol_t ip_protocol, const esp_ip_addr_t *ip,
+                                  uint16_t port, uint8_t *data, size_t len);
+
+static atomic_uint s_responses;     // packets sent
+
+size_t __wrap__mdns_udp_pcb_write(size_t tcpip_if, mdns_ip_protocol_t ip_protocol, const esp_ip_addr_t *ip,
+                                  uint16_t port, uint8_t *data, size_t len)
+{
+    atomic_fetch_add(&s_responses, 1);
+    return __real__mdns_udp_pcb_write(tcpip_if, ip_protocol, ip, port, data, len);
+}
+#endif
+
+#ifdef CONFIG_TEST_SERVICE_HEAP
+#define HEAP_TEST_SERVICES  50
+#define HEAP_TEST_TXT_ITEMS 10
+
+/**
+ * @brief Report the heap held by services with TXT records, and the allocations
+ *        made by TXT updates
+ */
+static void service_heap_test(void)
+{
+    int services = HEAP_TEST_SERVICES;
+    if (services > CONFIG_MDNS_MAX_SERVICES) {
+        ESP_LOGW(TAG, "Only %d services, set CONFIG_MDNS_MAX_SERVICES=%d", CONFIG_MDNS_MAX_SERVICES, HEAP_TEST_SERVICES);
+        services = CONFIG_MDNS_MAX_SERVICES;
+    }
+    char keys[HEAP_TEST_TXT_ITEMS][8];
+    char values[HEAP_TEST_TXT_ITEMS][16];
+    mdns_txt_item_t txt[HEAP_TEST_TXT_ITEMS];
+    for (int i = 0; i < HEAP_TEST_TXT_ITEMS; i++) {
+        snprintf(keys[i], sizeof(keys[i]), "key%d", i);
+        snprintf(values[i], sizeof(values[i]), "value-%d", i);
+        txt[i].key = keys[i];
+        txt[i].value = values[i];
+    }
+    vTaskDelay(pdMS_TO_TICKS(3000));    // let probing and announcing of the host finish
+
+    long blocks = atomic_load(&s_heap_blocks);
+    long bytes = atomic_load(&s_heap_bytes);
+    for (int i = 0; i < services; i++) {
+        char instance[32];
+        char type[16];
+        snprintf(instance, sizeof(instance), "heap-test-%d", i);
+        snprintf(type, sizeof(type), "_svc%d", i);
+        ESP_ERROR_CHECK(mdns_service_add(instance, type, "_tcp", 8000 + i, txt, HEAP_TEST_TXT_ITEMS));
+    }
+    vTaskDelay(pdMS_TO_TICKS(5000));    // probing and announcing packets are freed by now
+    blocks = atomic_load(&s_heap_blocks) - blocks;
+    bytes = atomic_load(&s_heap_bytes) - bytes;
+    ESP_LOGI(TAG, "service heap: %d services with %d TXT items hold %ld blocks, %ld bytes (%ld blocks per service)",
+             services, HEAP_TEST_TXT_ITEMS, blocks, bytes, blocks / services);
+
+    const int updates = 100;
+    unsigned allocs = atomic_load(&s_allocs);
+    blocks = atomic_load(&s_heap_blocks);
+    for (int i = 0; i < updates; i++) {
+        ESP_ERROR_CHECK(mdns_service_txt_item_set("_svc0", "_tcp", "key5", i % 2 ? "odd" : "even"));
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    vTaskDelay(pdMS_TO_TICKS(3000));
+    ESP_LOGI(TAG, "service heap: %d TXT item updates made %.1f allocations each (including the announcements), %ld blocks left",
+             updates, (double)(atomic_load(&s_allocs) - allocs) / updates, atomic_load(&s_heap_blocks) - blocks);
+    mdns_service_remove_all();
+}
+#endif // CONFIG_TEST_SERVICE_HEAP
+
+#ifdef CONFIG_TEST_RX_BENCHMARK
+typedef struct mdns_rx_packet_s mdns_rx_packet_t;
+void __real__mdns_packet_free(mdns_rx_packet_t *packet);
+
+static atomic_uint s_packets;
+
+void __wrap__mdns_packet_free(mdns_rx_packet_t *packet)
+{
+    atomic_fetch_add(&s_packets, 1);
+    __real__mdns_packet_free(packet);
+}
+
+/**
+ * @brief Send queries for an unknown name to our own interface (multicast loopback)
+ *        and wait for the engine to process them
+ */
+static void rx_benchmark(void)
+{
+#ifdef CONFIG_TEST_RX_BENCHMARK_ANSWERED
+    // Query "_bench._tcp.local PTR", answered with the PTR, SRV, TXT and A records of our service
+    static const uint8_t query[] = {
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x06, '_', 'b', 'e', 'n', 'c', 'h', 0x04, '_', 't', 'c', 'p', 0x05, 'l', 'o', 'c', 'a', 'l', 0x00,
+        0x00, 0x0c, 0x00, 0x01
+    };
+    mdns_txt_item_t txt[] = { {"board", "esp32"}, {"path", "/"}, {"version", "1.0"} };
+    ESP_ERROR_CHECK(mdns_service_add("Benchmark", "_bench", "_tcp", 80, txt, sizeof(txt) / sizeof(txt[0])));
+#else
+    // Query "bench.local A", answered by nobody, so only the receive path is measured
+    static const uint8_t query[] = {
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x05, 'b', 'e', 'n', 'c', 'h', 0x05, 'l', 'o', 'c', 'a', 'l', 0x00,
+        0x00, 0x01, 0x00, 0x01
+    };
+#endif
+    const unsigned total = CONFIG_TEST_RX_BENCHMARK_PACKETS;
+    struct sockaddr_in dest = { .sin_family = AF_INET, .sin_port = htons(5353) };
+    dest.sin_addr.s_addr = inet_addr("224.0.0.251");
+
+    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    struct ifreq ifr = { 0 };
+    strncpy(ifr.ifr_name, CONFIG_TEST_NETIF_NAME, sizeof(ifr.ifr_name) - 1);
+    unsigned char loop = 1;
+    if (sock < 0 ||
+            setsockopt(sock, SOL_SOCKET, SO_BINDTODEVICE, &ifr, sizeof(ifr)) < 0 ||
+            setsockopt(sock, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop)) < 0) {
+        ESP_LOGE(TAG, "Failed to create the benchmark socket");
+        return;
+    }
+    vTaskDelay(pdMS_TO_TICKS(3000));    // let probing and announcing finish
+
+    unsigned packets = atomic_load(&s_packets);
+    unsigned allocs = atomic_load(&s_allocs);
+    uint64_t start = now_us(CLOCK_MONOTONIC);
+    uint64_t cpu_start = now_us(CLOCK_PROCESS_CPUTIME_ID);
+#ifdef CONFIG_TEST_RX_BENCHMARK_ANSWERED
+    unsigned responses_start = atomic_load(&s_responses);
+#endif
+    for (unsigned i = 0; i < total; i++) {
+        if (sendto(sock, query, sizeof(query), 0, (struct sockaddr *)&dest, sizeof(dest)) < 0) {
+            vTaskDelay(1);  // socket buffer full, let the receiver catch up
+            i--;
+        }
+    }
+    // Datagrams dropped by the kernel never arrive, stop once the count stalls
+    unsigned last = 0;
+    unsigned processed;
+    while ((processed = atomic_load(&s_packets) - packets) < total && processed != last) {
+        last = processed;
+        vTaskDelay(pdMS_TO_TICKS(200));
+    }
+#ifdef CONFIG_TEST_RX_BENCHMARK_ANSWERED
+    // Shared answers are delayed by up to 100 ms, wait for the last ones too
+    unsigned responses;
+    last = 0;
+    while ((responses = atomic_load(&s_responses) - responses_start) != last) {
+        last = responses;
+        vTaskDelay(pdMS_TO_TICKS(200));
+    }
+#endif
+    uint64_t elapsed = now_us(CLOCK_MONOTONIC) - start;
+    uint64_t cpu = now_us(CLOCK_PROCESS_CPUTIME_ID) - cpu_start;
+    allocs = atomic_load(&s_allocs) - allocs;
+    close(sock);
+
+    ESP_LOGI(TAG, "rx benchmark: %u/%u packets in %llu ms, %.0f packets/s, %.2f allocations/packet",
+             processed, total, (unsigned long long)(elapsed / 1000),
+             processed * 1e6 / elapsed, processed ? (double)allocs / processed : 0.0);
+#ifdef CONFIG_TEST_RX_BENCHMARK_ANSWERED
+    // The sender runs in this process too, its share is the same for any responder
+    ESP_LOGI(TAG, "rx benchmark: %u responses, %.1f us CPU per query answered",
+             responses, responses ? (double)cpu / responses : 0.0);
+    mdns_service_remove_all();
+#else
+    ESP_LOGI(TAG, "rx benchmark: %.1f us CPU per packet", processed ? (double)cpu / processed : 0.0);
+#endif
+}
+#endif // CONFIG_TEST_RX_BENCHMARK
+
+#ifdef CONFIG_TEST_TX_BENCHMARK
+/**
+ * @brief Update the TXT record of a service announced on three interfaces, over IPv4 and IPv6 each,
+ *        and report the CPU time and the allocations per packet sent
+ */
+static void tx_benchmark(esp_netif_t *sta)
+{
+    static const esp_netif_inherent_config_t base_cg[] = {
+        { .if_key = "TX_BENCH_2", .if_desc = CONFIG_TEST_TX_BENCHMARK_NETIF2 },
+        { .if_key = "TX_BENCH_3", .if_desc = CONFIG_TEST_TX_BENCHMARK_NETIF3 },
+    };
+    esp_netif_t *netifs[3] = { sta };
+    for (int i = 1; i < 3; i++) {
+        esp_netif_config_t cfg = { .base = &base_cg[i - 1] };
+        netifs[i] = esp_netif_new(&cfg);
+        ESP_ERROR_CHECK(mdns_register_netif(netifs[i]));
+    }
+    for (int i = 0; i < 3; i++) {
+        ESP_ERROR_CHECK(mdns_netif_action(netifs[i], MDNS_EVENT_ENABLE_IP4 | MDNS_EVENT_ENABLE_IP6));
+    }
+    mdns_txt_item_t txt[] = { {"board", "esp32"}, {"path", "/"}, {"seq", "0"} };
+    ESP_ERROR_CHECK(mdns_service_add("Benchmark", "_bench", "_tcp", 80, txt, sizeof(txt) / sizeof(txt[0])));
+    vTaskDelay(pdMS_TO_TICKS(5000));    // let probing and announcing finish on all interfaces
+
+    const int updates = CONFIG_TEST_TX_BENCHMARK_UPDATES;
+    unsigned sent = atomic_load(&s_responses);
+    unsigned allocs = atomic_load(&s_allocs);
+    uint64_t cpu_start = now_us(CLOCK_PROCESS_CPUTIME_ID);
+    for (int i = 0; i < updates; i++) {
+        char seq[12];
+        snprintf(seq, sizeof(seq), "%d", i);
+        ESP_ERROR_CHECK(mdns_service_txt_item_set("_bench", "_tcp", "seq", seq));
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    // Wait for the last announcements
+    unsigned last = 0;
+    while (atomic_load(&s_responses) - sent != last) {
+        last = atomic_load(&s_responses) - sent;
+        vTaskDelay(pdMS_TO_TICKS(1000));
+    }
+    uint64_t cpu = now_us(CLOCK_PROCESS_CPUTIME_ID) - cpu_start;
+    allocs = atomic_load(&s_allocs) - allocs;
+
+    ESP_LOGI(TAG, "tx benchmark: %d TXT updates sent %u packets on 3 interfaces x 2 protocols", updates, last);
+    ESP_LOGI(TAG, "tx benchmark: %.1f us CPU, %.2f allocations per packet sent",
+             last ? (double)cpu / last : 0.0, last ? (double)allocs / last : 0.0);
+    mdns_service_remove_all();
+    for (int i = 1; i < 3; i++) {
+        mdns_unregister_netif(netifs[i]);
+        esp_netif_destroy(netifs[i]);
+    }
+}
+#endif // CONFIG_TEST_TX_BENCHMARK
+
 int main(int argc, char *argv[])
 {
 
@@ -44,6 +336,25 @@ int main(int argc, char *argv[])
     ESP_ERROR_CHECK(mdns_register_netif(sta));
     ESP_ERROR_CHECK(mdns_netif_action(sta, MDNS_EVENT_ENABLE_IP4 | MDNS_EVENT_IP4_REVERSE_LOOKUP | MDNS_EVENT_IP6_REVERSE_LOOKUP));
 
+#ifdef CONFIG_TEST_RX_BENCHMARK
+    rx_benchmark();
+    esp_netif_destroy(sta);
+    mdns_free();
+    return 0;
+#endif
+#ifdef CONFIG_TEST_TX_BENCHMARK
+    tx_benchmark(sta);
+    esp_netif_destroy(sta);
+    mdns_free();
+    return 0;
+#endif
+#ifdef CONFIG_TEST_SERVICE_HEAP
+    service_heap_test();
+    esp_netif_destroy(sta);
+    mdns_free();
+    return 0;
+#endif
+
 #ifdef REGISTER_SERVICE
     //set default mDNS instance name
     mdns_instance_name_set("myesp-inst");
@@ -51,10 +51,16 @@ esp_err_t esp_timer_create(const esp_timer_create_args_t *create_args,
     return ESP_OK;
 }
 
+static uint32_t s_tick = 0;
+
 uint32_t xTaskGetTickCount(void)
 {
-    static uint32_t tick = 0;
-    return tick++;
+    return s_tick++;
+}
+
+void ForceTickAdvance(uint32_t ticks)
+{
+    s_tick += ticks;
 }
 
 /// Queue mock
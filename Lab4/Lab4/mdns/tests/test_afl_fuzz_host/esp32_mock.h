@@ -129,6 +129,8 @@ void GetLastItem(void *pvBuffer);
 
 void ForceTaskDelete(void);
 
+void ForceTickAdvance(uint32_t ticks);
+
 esp_err_t esp_event_handler_register(const char *event_base, int32_t event_id, void *event_handler, void *event_handler_arg);
 
 esp_err_t esp_event_handler_unregister(const char *event_base, int32_t event_id, void *event_handler);
@@ -0,0 +1,127 @@
+# SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+# SPDX-License-Identifier: Unlicense OR CC0-1.0
+"""Generates the hand made worst case packets of the performance corpus (perf_corpus/)
+
+Each packet stays within 1460 bytes and aims at one expensive parser path for the services
+and searches set up by test.c. Inputs found by `make perf-fuzz` are added next to these.
+"""
+import os
+import struct
+
+MAX_LEN = 1460
+TYPE_A, TYPE_PTR, TYPE_TXT, TYPE_SRV, TYPE_ANY = 1, 12, 16, 33, 255
+QUERY, RESPONSE = 0x0000, 0x8400
+
+
+def name(*labels):
+    return b''.join(bytes([len(label)]) + label.encode() for label in labels) + b'\0'
+
+
+def pointer(offset):
+    return struct.pack('>H', 0xC000 | offset)
+
+
+def packet(flags, questions=(), answers=(), additional=()):
+    data = struct.pack('>6H', 0, flags, len(questions), len(answers), 0, len(additional))
+    for q in questions:
+        data += q(len(data))
+    for a in list(answers) + list(additional):
+        data += a(len(data))
+    assert len(data) <= MAX_LEN, len(data)
+    return data
+
+
+def question(qname, qtype):
+    return lambda offset: qname(offset) + struct.pack('>HH', qtype, 1)
+
+
+def record(rname, rtype, rdata, ttl=120):
+    def build(offset):
+        head = rname(offset)
+        body = rdata(offset + len(head) + 10)
+        return head + struct.pack('>HHIH', rtype, 0x8001, ttl, len(body)) + body
+    return build
+
+
+def pointer_chain():
+    """Every question is one label and a pointer to the name of the question before it, so
+    reading the n-th name follows n - 1 pointers"""
+    offsets = []
+
+    def chained(offset):
+        prev = offsets[-1] if offsets else None
+        offsets.append(offset)
+        return name('local') if prev is None else b'\x01a' + pointer(prev)
+    return packet(QUERY, [question(chained, TYPE_ANY) for _ in range(180)])
+
+
+def pointer_chain_answers():
+    """The same chain in answers, every record is also checked against the searches"""
+    offsets = []
+
+    def chained(offset):
+        prev = offsets[-1] if offsets else None
+        offsets.append(offset)
+        return name('_fritz', '_tcp', 'local') if prev is None else b'\x01a' + pointer(prev)
+    return packet(RESPONSE, answers=[record(chained, TYPE_A, lambda o: b'\x0a\x00\x00\x01') for _ in range(75)])
+
+
+def all_services():
+    """ANY and PTR questions for every service, the response answers all of them"""
+    services = ['_fritz', '_telnet', '_workstation', '_arduino', '_http', '_afpovertcp', '_rfb', '_smb',
+                '_adisk', '_airport', '_printer', '_airplay', '_raop', '_uscan', '_uscans', '_ippusb',
+                '_scanner', '_ipp', '_ipps', '_pdl-datastream', '_ptp']
+    local = []
+
+    def service_name(service):
+        def build(offset):
+            if not local:
+                local.append(offset + len(service) + 6)
+                return name(service, '_tcp', 'local')
+            return bytes([len(service)]) + service.encode() + b'\x04_tcp' + pointer(local[0])
+        return build
+    questions = [question(service_name(s), t) for s in services for t in (TYPE_PTR, TYPE_ANY)]
+    questions.append(question(lambda o: name('_services', '_dns-sd', '_udp', 'local'), TYPE_PTR))
+    questions.append(question(lambda o: name('minifritz', 'local'), TYPE_ANY))
+    return packet(QUERY, questions)
+
+
+def many_instances():
+    """PTR answers for distinct instances of a searched service, each one a new result"""
+    answers = [record(lambda o: name('_fritz', '_tcp', 'local') if o == 12 else pointer(12), TYPE_PTR,
+                      lambda o, i=i: bytes([4]) + ('i%03d' % i).encode() + pointer(12)) for i in range(60)]
+    return packet(RESPONSE, answers=answers)
+
+
+def many_txt_items():
+    """One TXT record with as many items as fit, for the searched instance"""
+    items = b''.join(b'\x03k%02d' % (i % 100) for i in range(300))[:1300]
+    return packet(RESPONSE, answers=[record(lambda o: name('minifritz', '_fritz', '_tcp', 'local'), TYPE_TXT,
+                                            lambda o: items)])
+
+
+def many_srv_a():
+    """SRV and A answers for the searched instance and many hosts, each adding addresses"""
+    answers = [record(lambda o: name('minifritz', '_fritz', '_tcp', 'local'), TYPE_SRV,
+                      lambda o: struct.pack('>HHH', 0, 0, 22) + name('minifritz', 'local'))]
+    target = 12 + len(name('minifritz', '_fritz', '_tcp', 'local')) + 10 + 6
+    answers += [record(lambda o: pointer(target), TYPE_A, lambda o, i=i: bytes([10, 0, i // 256, i % 256]))
+                for i in range(70)]
+    return packet(RESPONSE, answers=answers)
+
+
+CORPUS = {
+    'ptr_chain.bin': pointer_chain,
+    'ptr_chain_answers.bin': pointer_chain_answers,
+    'all_services.bin': all_services,
+    'many_instances.bin': many_instances,
+    'many_txt_items.bin': many_txt_items,
+    'many_srv_a.bin': many_srv_a,
+}
+
+if __name__ == '__main__':
+    out = os.path.join(os.path.dirname(os.path.abspath(__file__)), 'perf_corpus')
+    os.makedirs(out, exist_ok=True)
+    for file_name, generate in CORPUS.items():
+        with open(os.path.join(out, file_name), 'wb') as f:
+            f.write(generate())
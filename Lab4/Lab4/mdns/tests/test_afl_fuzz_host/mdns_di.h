@@ -18,6 +18,12 @@ mdns_search_once_t *(*mdns_test_static_search_init)(const char *name, const char
         mdns_query_notify_t notifier) = NULL;
 esp_err_t         (*mdns_test_static_send_search_action)(mdns_action_type_t type, mdns_search_once_t *search) = NULL;
 void              (*mdns_test_static_search_free)(mdns_search_once_t *search) = NULL;
+void              (*mdns_test_static_clear_tx_queue_head)(void) = NULL;
+mdns_service_names_t *(*mdns_test_static_get_service_names)(mdns_service_t *service) = NULL;
+void              (*mdns_test_static_dispatch_tx_packet)(mdns_tx_packet_t *p) = NULL;
+void              (*mdns_test_static_search_run)(void) = NULL;
+
+extern mdns_server_t *_mdns_server;
 
 static void _mdns_execute_action(mdns_action_t *action);
 static mdns_srv_item_t *_mdns_get_service_item(const char *service, const char *proto, const char *hostname);
@@ -25,6 +31,10 @@ static mdns_search_once_t *_mdns_search_init(const char *name, const char *servi
         uint32_t timeout, uint8_t max_results, mdns_query_notify_t notifier);
 static esp_err_t _mdns_send_search_action(mdns_action_type_t type, mdns_search_once_t *search);
 static void _mdns_search_free(mdns_search_once_t *search);
+static void _mdns_clear_tx_queue_head(void);
+static mdns_service_names_t *_mdns_get_service_names(mdns_service_t *service);
+static void _mdns_dispatch_tx_packet(mdns_tx_packet_t *p);
+static void _mdns_search_run(void);
 
 void mdns_test_init_di(void)
 {
@@ -33,6 +43,10 @@ void mdns_test_init_di(void)
     mdns_test_static_search_init = _mdns_search_init;
     mdns_test_static_send_search_action = _mdns_send_search_action;
     mdns_test_static_search_free = _mdns_search_free;
+    mdns_test_static_clear_tx_queue_head = _mdns_clear_tx_queue_head;
+    mdns_test_static_get_service_names = _mdns_get_service_names;
+    mdns_test_static_dispatch_tx_packet = _mdns_dispatch_tx_packet;
+    mdns_test_static_search_run = _mdns_search_run;
 }
 
 void mdns_test_execute_action(void *action)
@@ -52,10 +66,34 @@ esp_err_t mdns_test_send_search_action(mdns_action_type_t type, mdns_search_once
 
 mdns_search_once_t *mdns_test_search_init(const char *name, const char *service, const char *proto, uint16_t type, uint32_t timeout, uint8_t max_results)
 {
-    return mdns_test_static_search_init(name, service, proto, type, timeout, type != MDNS_TYPE_PTR, max_results, NULL);
+    return mdns_test_static_search_init(name, service, proto, type, type != MDNS_TYPE_PTR, timeout, max_results, NULL);
 }
 
 mdns_srv_item_t *mdns_test_mdns_get_service_item(const char *service, const char *proto)
 {
     return mdns_test_static_mdns_get_service_item(service, proto, NULL);
 }
+
+void mdns_test_clear_tx_queue(void)
+{
+    mdns_test_static_clear_tx_queue_head();
+}
+
+void mdns_test_send_tx_queue(void)
+{
+    for (mdns_tx_packet_t *p = _mdns_server->tx_queue_head; p; p = p->next) {
+        mdns_test_static_dispatch_tx_packet(p);
+    }
+}
+
+void mdns_test_build_service_names(void)
+{
+    for (mdns_srv_item_t *s = _mdns_server->services; s; s = s->next) {
+        mdns_test_static_get_service_names(s->service);
+    }
+}
+
+void mdns_test_search_run(void)
+{
+    mdns_test_static_search_run();
+}
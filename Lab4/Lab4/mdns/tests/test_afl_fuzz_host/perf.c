@@ -0,0 +1,324 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/*
+ * Parser performance harness -- measures CPU time, heap allocations and stack usage of mdns_parse_packet()
+ *
+ * Every input is parsed in a process forked after the test setup (a child per file given on the
+ * command line, or the AFL deferred fork server for stdin), so all inputs start from the same state.
+ * Inputs above the budget make the run fail, or abort under AFL, which keeps them as crashes.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <malloc.h>
+#include <ucontext.h>
+#include <sys/wait.h>
+
+#define PERF_PACKET_MAX             1460
+#define PERF_MAX_US_DEFAULT         1500
+#define PERF_MAX_ALLOCS_DEFAULT     1000
+#define PERF_MAX_PEAK_DEFAULT       (32 * 1024)
+#define PERF_MAX_STACK_DEFAULT      (8 * 1024)
+#define PERF_REPEAT_DEFAULT         16
+#define PERF_STACK_SIZE             (64 * 1024)
+#define PERF_STACK_FILL             0xa5
+
+//
+// Test setup and parser entry (test.c, mdns_di.h)
+void mdns_test_setup(void);
+void mdns_test_queries(void);
+void mdns_test_parse(const uint8_t *data, size_t len);
+void mdns_test_clear_tx_queue(void);
+void mdns_test_send_tx_queue(void);
+void mdns_test_build_service_names(void);
+
+typedef struct {
+    uint64_t ns;            // fastest of the repeated parses
+    uint32_t allocs;        // allocations of the first parse
+    uint32_t bytes;         // bytes requested by these allocations
+    uint32_t peak;          // highest heap usage above the level before the parse
+    uint32_t stack;         // stack high-water mark of a parse and of sending the answers it queued
+} perf_cost_t;
+
+typedef struct {
+    uint32_t max_us;
+    uint32_t max_allocs;
+    uint32_t max_peak;
+    uint32_t max_stack;
+    int repeat;
+} perf_budget_t;
+
+//
+// Allocation counting, malloc() and friends are wrapped at link time (-Wl,--wrap)
+static bool s_counting;
+static perf_cost_t s_cost;
+static int64_t s_live;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t nmemb, size_t size);
+char *__real_strdup(const char *s);
+char *__real_strndup(const char *s, size_t n);
+void __real_free(void *ptr);
+
+static void *perf_count_alloc(void *ptr, size_t size)
+{
+    if (s_counting && ptr) {
+        s_cost.allocs++;
+        s_cost.bytes += size;
+        s_live += malloc_usable_size(ptr);
+        if (s_live > (int64_t)s_cost.peak) {
+            s_cost.peak = s_live;
+        }
+    }
+    return ptr;
+}
+
+void *__wrap_malloc(size_t size)
+{
+    return perf_count_alloc(__real_malloc(size), size);
+}
+
+void *__wrap_calloc(size_t nmemb, size_t size)
+{
+    return perf_count_alloc(__real_calloc(nmemb, size), nmemb * size);
+}
+
+char *__wrap_strdup(const char *s)
+{
+    char *p = __real_strdup(s);
+    return perf_count_alloc(p, p ? strlen(p) + 1 : 0);
+}
+
+char *__wrap_strndup(const char *s, size_t n)
+{
+    char *p = __real_strndup(s, n);
+    return perf_count_alloc(p, p ? strlen(p) + 1 : 0);
+}
+
+void __wrap_free(void *ptr)
+{
+    if (s_counting && ptr) {
+        s_live -= malloc_usable_size(ptr);
+    }
+    __real_free(ptr);
+}
+
+static uint64_t perf_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+//
+// Stack usage, the packet is parsed on a stack filled with a pattern, the bytes overwritten are counted
+static uint8_t s_stack[PERF_STACK_SIZE];
+static ucontext_t s_main_ctx;
+static ucontext_t s_stack_ctx;
+static const uint8_t *s_stack_data;
+static size_t s_stack_len;
+
+static void perf_stack_entry(void)
+{
+    mdns_test_parse(s_stack_data, s_stack_len);
+    mdns_test_send_tx_queue();
+}
+
+/**
+ * @brief  Returns the stack high-water mark of parsing the packet and building the answers it queued
+ *         (the stack grows down, from the end of s_stack)
+ */
+static uint32_t perf_stack_used(const uint8_t *data, size_t len)
+{
+    s_stack_data = data;
+    s_stack_len = len;
+    memset(s_stack, PERF_STACK_FILL, sizeof(s_stack));
+    getcontext(&s_stack_ctx);
+    s_stack_ctx.uc_stack.ss_sp = s_stack;
+    s_stack_ctx.uc_stack.ss_size = sizeof(s_stack);
+    s_stack_ctx.uc_link = &s_main_ctx;
+    makecontext(&s_stack_ctx, perf_stack_entry, 0);
+    if (swapcontext(&s_main_ctx, &s_stack_ctx) != 0) {
+        abort();
+    }
+    size_t untouched = 0;
+    while (untouched < sizeof(s_stack) && s_stack[untouched] == PERF_STACK_FILL) {
+        untouched++;
+    }
+    return sizeof(s_stack) - untouched;
+}
+
+/**
+ * @brief  Parses the packet `repeat` times; allocations are counted on the first parse,
+ *         the time is the fastest parse (answers queued by a parse are dropped before the next one).
+ *         One more parse measures the stack, with the answers queued sent this time.
+ */
+static void perf_measure(const uint8_t *data, size_t len, int repeat, perf_cost_t *cost)
+{
+    uint64_t best = UINT64_MAX;
+
+    memset(&s_cost, 0, sizeof(s_cost));
+    s_live = 0;
+    for (int i = 0; i < repeat; i++) {
+        s_counting = (i == 0);
+        uint64_t start = perf_now_ns();
+        mdns_test_parse(data, len);
+        uint64_t ns = perf_now_ns() - start;
+        s_counting = false;
+        mdns_test_clear_tx_queue();
+        if (ns < best) {
+            best = ns;
+        }
+    }
+    *cost = s_cost;
+    cost->ns = best;
+    cost->stack = perf_stack_used(data, len);
+    mdns_test_clear_tx_queue();
+}
+
+static bool perf_over_budget(const perf_cost_t *cost, const perf_budget_t *budget)
+{
+    return cost->ns > budget->max_us * 1000ULL || cost->allocs > budget->max_allocs || cost->peak > budget->max_peak ||
+           cost->stack > budget->max_stack;
+}
+
+#ifndef INSTR_IS_OFF
+extern uint8_t *__afl_area_ptr;
+
+#define PERF_MAP_SIZE   65536
+#define PERF_MAP_BASE   (PERF_MAP_SIZE - 4 * 32)
+
+static void perf_feedback_level(int metric, uint64_t value)
+{
+    int level = 0;
+    while (value) {
+        value >>= 1;
+        level++;
+    }
+    __afl_area_ptr[PERF_MAP_BASE + metric * 32 + (level & 31)] = 1;
+}
+
+/**
+ * @brief  Reports the cost in power of two steps as extra coverage, so AFL keeps every input
+ *         reaching a new cost level in its queue and mutates it further (cost objective)
+ */
+static void perf_feedback(const perf_cost_t *cost)
+{
+    perf_feedback_level(0, cost->ns / 1024);
+    perf_feedback_level(1, cost->allocs);
+    perf_feedback_level(2, cost->peak);
+    perf_feedback_level(3, cost->stack);
+}
+#endif
+
+/**
+ * @brief  Measures one file in a child process, returns true if it is over budget (or crashed)
+ */
+static bool perf_run_file(const char *path, const perf_budget_t *budget)
+{
+    uint8_t buf[PERF_PACKET_MAX];
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        printf("%-32s cannot open\n", path);
+        return true;
+    }
+    size_t len = fread(buf, 1, sizeof(buf), file);
+    fclose(file);
+
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0) {
+        perf_cost_t cost;
+        perf_measure(buf, len, budget->repeat, &cost);
+        bool over = perf_over_budget(&cost, budget);
+        printf("%-32s %8.1f us %5u allocs %7u bytes %7u peak %6u stack%s\n", path, cost.ns / 1000.0,
+               cost.allocs, cost.bytes, cost.peak, cost.stack, over ? "  OVER BUDGET" : "");
+        exit(over ? 1 : 0);
+    }
+    int status;
+    if (pid < 0 || waitpid(pid, &status, 0) != pid) {
+        abort();
+    }
+    if (WIFSIGNALED(status)) {
+        printf("%-32s crashed (signal %d)\n", path, WTERMSIG(status));
+        return true;
+    }
+    return WEXITSTATUS(status) != 0;
+}
+
+int main(int argc, char **argv)
+{
+    perf_budget_t budget = {
+        .max_us = PERF_MAX_US_DEFAULT,
+        .max_allocs = PERF_MAX_ALLOCS_DEFAULT,
+        .max_peak = PERF_MAX_PEAK_DEFAULT,
+        .max_stack = PERF_MAX_STACK_DEFAULT,
+        .repeat = PERF_REPEAT_DEFAULT,
+    };
+    int opt;
+
+    while ((opt = getopt(argc, argv, "t:a:m:s:r:")) != -1) {
+        switch (opt) {
+        case 't':
+            budget.max_us = strtoul(optarg, NULL, 0);
+            break;
+        case 'a':
+            budget.max_allocs = strtoul(optarg, NULL, 0);
+            break;
+        case 'm':
+            budget.max_peak = strtoul(optarg, NULL, 0);
+            break;
+        case 's':
+            budget.max_stack = strtoul(optarg, NULL, 0);
+            break;
+        case 'r':
+            budget.repeat = atoi(optarg) > 0 ? atoi(optarg) : 1;
+            break;
+        default:
+            printf("usage: %s [-t max_us] [-a max_allocs] [-m max_peak_bytes] [-s max_stack_bytes] [-r repeat] [packet files]\n"
+                   "Without files, one packet is read from stdin (AFL)\n", argv[0]);
+            return 2;
+        }
+    }
+
+    mdns_test_setup();
+    mdns_test_queries();
+    // Service names are built on first use, which should not count to the first packet measured
+    mdns_test_build_service_names();
+
+    if (optind < argc) {
+        int failed = 0;
+        for (int i = optind; i < argc; i++) {
+            failed += perf_run_file(argv[i], &budget);
+        }
+        printf("%d of %d inputs over budget (%u us, %u allocs, %u bytes peak, %u bytes stack)\n", failed, argc - optind,
+               budget.max_us, budget.max_allocs, budget.max_peak, budget.max_stack);
+        return failed ? 1 : 0;
+    }
+
+#ifndef INSTR_IS_OFF
+    __AFL_INIT();
+#endif
+    uint8_t buf[PERF_PACKET_MAX];
+    ssize_t len = read(0, buf, sizeof(buf));
+    if (len <= 0) {
+        return 0;
+    }
+    perf_cost_t cost;
+    perf_measure(buf, len, budget.repeat, &cost);
+#ifndef INSTR_IS_OFF
+    perf_feedback(&cost);
+#endif
+    if (perf_over_budget(&cost, &budget)) {
+        abort();
+    }
+    return 0;
+}
@@ -0,0 +1,286 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/*
+ * Service heap harness -- heap held by services with many TXT items, and allocations made by updates
+ *
+ * SERVICES_COUNT services with SERVICES_TXT_ITEMS TXT items each are added to a host without other
+ * services, and the heap blocks and bytes they hold are counted once their names are built. The TXT
+ * item of one service is then updated SERVICES_UPDATES times and the allocations are counted.
+ * The sockets are not marked running meanwhile, so nothing is probed or announced.
+ *
+ * Once they are, PTR queries for two of the services are parsed in turn, and the CPU time spent
+ * building and sending each answer is measured (the queries alternate, so that no answer is the
+ * same as the packet sent before it). The TXT item is then updated again, and the CPU time spent
+ * sending the announcements each update queues on every interface and protocol is measured.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <malloc.h>
+
+#include "esp32_mock.h"
+#include "mdns.h"
+#include "mdns_private.h"
+
+#define SERVICES_COUNT      20      // CONFIG_MDNS_MAX_SERVICES is 25 in sdkconfig.h
+#define SERVICES_TXT_ITEMS  10
+#define SERVICES_UPDATES    100
+#define SERVICES_BATCHES    20
+#define SERVICES_BATCH      1000    // answers timed together
+#define SERVICES_FANOUTS    1000    // updates announced per batch
+
+//
+// Dependency injected functions (mdns_di.h)
+void mdns_test_init_di(void);
+void mdns_test_execute_action(void *action);
+void mdns_test_build_service_names(void);
+void mdns_test_parse(const uint8_t *data, size_t len);
+void mdns_test_clear_tx_queue(void);
+void mdns_test_send_tx_queue(void);
+extern mdns_server_t *_mdns_server;
+
+//
+// Heap counting, malloc() and friends are wrapped at link time (-Wl,--wrap)
+static bool s_counting;
+static uint32_t s_allocs;
+static int64_t s_blocks;
+static int64_t s_bytes;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t nmemb, size_t size);
+char *__real_strdup(const char *s);
+char *__real_strndup(const char *s, size_t n);
+void __real_free(void *ptr);
+
+static void *count_alloc(void *ptr)
+{
+    if (s_counting && ptr) {
+        s_allocs++;
+        s_blocks++;
+        s_bytes += malloc_usable_size(ptr);
+    }
+    return ptr;
+}
+
+void *__wrap_malloc(size_t size)
+{
+    return count_alloc(__real_malloc(size));
+}
+
+void *__wrap_calloc(size_t nmemb, size_t size)
+{
+    return count_alloc(__real_calloc(nmemb, size));
+}
+
+char *__wrap_strdup(const char *s)
+{
+    return count_alloc(__real_strdup(s));
+}
+
+char *__wrap_strndup(const char *s, size_t n)
+{
+    return count_alloc(__real_strndup(s, n));
+}
+
+void __wrap_free(void *ptr)
+{
+    if (s_counting && ptr) {
+        s_blocks--;
+        s_bytes -= malloc_usable_size(ptr);
+    }
+    __real_free(ptr);
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void execute_last_action(void)
+{
+    mdns_action_t *a = NULL;
+    GetLastItem(&a);
+    mdns_test_execute_action(a);
+}
+
+static void add_services(void)
+{
+    char keys[SERVICES_TXT_ITEMS][8];
+    char values[SERVICES_TXT_ITEMS][24];
+    mdns_txt_item_t txt[SERVICES_TXT_ITEMS];
+
+    for (int i = 0; i < SERVICES_TXT_ITEMS; i++) {
+        snprintf(keys[i], sizeof(keys[i]), "key%d", i);
+        snprintf(values[i], sizeof(values[i]), "value-of-item-%d", i);
+        txt[i].key = keys[i];
+        txt[i].value = values[i];
+    }
+    for (int i = 0; i < SERVICES_COUNT; i++) {
+        char instance[16];
+        char service[16];
+
+        snprintf(instance, sizeof(instance), "Device %d", i);
+        snprintf(service, sizeof(service), "_svc%d", i);
+        // Fails as the service task is not running, the action is executed here
+        mdns_service_add(instance, service, "_tcp", 8000 + i, txt, SERVICES_TXT_ITEMS);
+        execute_last_action();
+    }
+    mdns_test_build_service_names();
+}
+
+static void update_txt(void)
+{
+    for (int i = 0; i < SERVICES_UPDATES; i++) {
+        char value[24];
+
+        snprintf(value, sizeof(value), "updated-value-%d", i);
+        mdns_service_txt_item_set("_svc0", "_tcp", "key5", value);
+        execute_last_action();
+    }
+}
+
+/* Sockets are never opened here, a placeholder marks them open */
+static void set_pcbs_running(bool running)
+{
+    static char placeholder;
+
+    for (int i = 0; i < MDNS_MAX_INTERFACES; i++) {
+        for (int j = 0; j < MDNS_IP_PROTOCOL_MAX; j++) {
+            _mdns_server->interfaces[i].pcbs[j].state = running ? PCB_RUNNING : PCB_OFF;
+            _mdns_server->interfaces[i].pcbs[j].pcb = running ? (struct udp_pcb *)&placeholder : NULL;
+        }
+    }
+}
+
+static int count_tx_queue(void)
+{
+    int count = 0;
+
+    for (mdns_tx_packet_t *p = _mdns_server->tx_queue_head; p; p = p->next) {
+        count++;
+    }
+    return count;
+}
+
+static size_t put_ptr_query(uint8_t *p, const char *service)
+{
+    const char *labels[] = { service, "_tcp", "local" };
+    size_t len = MDNS_HEAD_LEN;
+
+    memset(p, 0, MDNS_HEAD_LEN);
+    p[MDNS_HEAD_QUESTIONS_OFFSET + 1] = 1;
+    for (int i = 0; i < 3; i++) {
+        p[len++] = strlen(labels[i]);
+        memcpy(p + len, labels[i], strlen(labels[i]));
+        len += strlen(labels[i]);
+    }
+    p[len++] = 0;
+    p[len++] = 0;
+    p[len++] = MDNS_TYPE_PTR;
+    p[len++] = 0;
+    p[len++] = MDNS_CLASS_IN;
+    return len;
+}
+
+static void time_answers(void)
+{
+    uint8_t queries[2][64];
+    size_t lens[2] = { put_ptr_query(queries[0], "_svc0"), put_ptr_query(queries[1], "_svc1") };
+    uint64_t best = UINT64_MAX;
+    int sent = 0;
+
+    set_pcbs_running(true);
+    for (int batch = 0; batch < SERVICES_BATCHES; batch++) {
+        uint64_t ns = 0;
+        int batch_sent = 0;
+
+        for (int i = 0; i < SERVICES_BATCH; i++) {
+            mdns_test_parse(queries[i & 1], lens[i & 1]);
+            batch_sent += count_tx_queue();
+            uint64_t start = now_ns();
+            mdns_test_send_tx_queue();
+            ns += now_ns() - start;
+            mdns_test_clear_tx_queue();
+        }
+        sent += batch_sent;
+        if (batch_sent && ns / batch_sent < best) {
+            best = ns / batch_sent;
+        }
+    }
+    printf("%d PTR queries: %d answers sent, %.2f us to build and send each (best of %d batches)\n",
+           SERVICES_BATCHES * SERVICES_BATCH, sent, best / 1000.0, SERVICES_BATCHES);
+}
+
+static void time_fanouts(void)
+{
+    uint64_t best = UINT64_MAX;
+    int packets = 0;
+
+    for (int batch = 0; batch < SERVICES_BATCHES; batch++) {
+        uint64_t ns = 0;
+        int batch_packets = 0;
+
+        for (int i = 0; i < SERVICES_FANOUTS; i++) {
+            char value[24];
+
+            // Announcing moves the sockets on from running, they would only amend queued packets
+            set_pcbs_running(true);
+            snprintf(value, sizeof(value), "announced-value-%d", i);
+            mdns_service_txt_item_set("_svc0", "_tcp", "key5", value);
+            execute_last_action();
+            batch_packets += count_tx_queue();
+            uint64_t start = now_ns();
+            mdns_test_send_tx_queue();
+            ns += now_ns() - start;
+            mdns_test_clear_tx_queue();
+        }
+        packets += batch_packets;
+        if (ns / SERVICES_FANOUTS < best) {
+            best = ns / SERVICES_FANOUTS;
+        }
+    }
+    printf("%d TXT item updates: %.1f packets announced per update, %.2f us to build and send them (best of %d batches)\n",
+           SERVICES_BATCHES * SERVICES_FANOUTS, (double)packets / (SERVICES_BATCHES * SERVICES_FANOUTS),
+           best / 1000.0, SERVICES_BATCHES);
+}
+
+int main(void)
+{
+    mdns_test_init_di();
+    if (mdns_init() || mdns_hostname_set("minifritz")) {
+        abort();
+    }
+    execute_last_action();
+
+    s_counting = true;
+    add_services();
+    s_counting = false;
+    printf("%d services with %d TXT items: %lld blocks, %lld bytes held, %.1f blocks and %.0f bytes per service\n",
+           SERVICES_COUNT, SERVICES_TXT_ITEMS, (long long)s_blocks, (long long)s_bytes,
+           (double)s_blocks / SERVICES_COUNT, (double)s_bytes / SERVICES_COUNT);
+
+    s_allocs = 0;
+    s_counting = true;
+    update_txt();
+    s_counting = false;
+    printf("%d TXT item updates: %.1f allocations per update\n", SERVICES_UPDATES, (double)s_allocs / SERVICES_UPDATES);
+
+    time_answers();
+    time_fanouts();
+    set_pcbs_running(false);
+
+    mdns_service_remove_all();
+    execute_last_action();
+    ForceTaskDelete();
+    mdns_free();
+    return 0;
+}
@@ -138,11 +138,10 @@ static void mdns_test_query_free(void)
 void mdns_parse_packet(mdns_rx_packet_t *packet);
 
 //
-// Test starts here
+// Test setup shared with the performance harness (perf.c)
 //
-int main(int argc, char **argv)
+void mdns_test_setup(void)
 {
-    int i;
     const char *mdns_hostname = "minifritz";
     const char *mdns_instance = "Hristo's Time Capsule";
     mdns_txt_item_t arduTxtData[4] = {
@@ -154,7 +153,6 @@ int main(int argc, char **argv)
 
     const uint8_t mac[6] = {0xDE, 0xAD, 0xBE, 0xEF, 0x00, 0x32};
 
-    uint8_t buf[1460];
     char winstance[21 + strlen(mdns_hostname)];
 
     sprintf(winstance, "%s [%02x:%02x:%02x:%02x:%02x:%02x]", mdns_hostname, mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
@@ -228,9 +226,50 @@ int main(int argc, char **argv)
         abort();
     }
 #endif
-    mdns_result_t *results = NULL;
+}
+
+void mdns_test_queries(void)
+{
+    mdns_test_query("minifritz", "_fritz", "_tcp", MDNS_TYPE_ANY);
+    mdns_test_query(NULL, "_fritz", "_tcp", MDNS_TYPE_PTR);
+    mdns_test_query(NULL, "_afpovertcp", "_tcp", MDNS_TYPE_PTR);
+}
+
+void mdns_test_parse(const uint8_t *data, size_t len)
+{
+    mypbuf.payload = malloc(len);
+    memcpy(mypbuf.payload, data, len);
+    mypbuf.len = len;
+    g_packet.pb = &mypbuf;
+    g_packet.multicast = 1;     // unicast packets need a local-link source, unknown to the mock netif
+    g_packet.src_port = MDNS_SERVICE_PORT;  // responses from other ports are dropped
+    mdns_parse_packet(&g_packet);
+    free(mypbuf.payload);
+}
+
+void mdns_test_teardown(void)
+{
+#ifndef MDNS_NO_SERVICES
+    mdns_service_remove_all();
+    mdns_action_t *a = NULL;
+    GetLastItem(&a);
+    mdns_test_execute_action(a);
+#endif
+    ForceTaskDelete();
+    mdns_free();
+}
+
+#ifndef MDNS_TEST_NO_MAIN
+//
+// Test starts here
+//
+int main(int argc, char **argv)
+{
+    int i;
+    uint8_t buf[1460];
     FILE *file;
-    size_t nread;
+
+    mdns_test_setup();
 
 #ifdef INSTR_IS_OFF
     size_t len = 1460;
@@ -254,23 +293,10 @@ int main(int argc, char **argv)
         memset(buf, 0, 1460);
         size_t len = read(0, buf, 1460);
 #endif
-        mypbuf.payload = malloc(len);
-        memcpy(mypbuf.payload, buf, len);
-        mypbuf.len = len;
-        g_packet.pb = &mypbuf;
-        mdns_test_query("minifritz", "_fritz", "_tcp", MDNS_TYPE_ANY);
-        mdns_test_query(NULL, "_fritz", "_tcp", MDNS_TYPE_PTR);
-        mdns_test_query(NULL, "_afpovertcp", "_tcp", MDNS_TYPE_PTR);
-        mdns_parse_packet(&g_packet);
-        free(mypbuf.payload);
+        mdns_test_queries();
+        mdns_test_parse(buf, len);
     }
-#ifndef MDNS_NO_SERVICES
-    mdns_service_remove_all();
-    mdns_action_t *a = NULL;
-    GetLastItem(&a);
-    mdns_test_execute_action(a);
-#endif
-    ForceTaskDelete();
-    mdns_free();
+    mdns_test_teardown();
     return 0;
 }
+#endif
@@ -0,0 +1,53 @@
+/* Button debounce state machine
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+#include "button_fsm.h"
+
+void button_fsm_init(button_fsm_t *fsm, uint32_t long_press_ms, bool pressed)
+{
+    fsm->long_press_ms = long_press_ms;
+    fsm->pressed = pressed;
+    fsm->long_sent = true;
+    fsm->press_ms = 0;
+    fsm->timeout_ms = 0;
+}
+
+// Arm the long press timer for the time left, or report it if already due
+static button_event_type_t check_long_press(button_fsm_t *fsm, uint32_t now_ms)
+{
+    uint32_t held = now_ms - fsm->press_ms;
+
+    if (!fsm->pressed || fsm->long_sent || fsm->long_press_ms == 0) {
+        return BUTTON_EVENT_NONE;
+    }
+    if (held >= fsm->long_press_ms) {
+        fsm->long_sent = true;
+        return BUTTON_EVENT_LONG_PRESS;
+    }
+    fsm->timeout_ms = fsm->long_press_ms - held;
+    return BUTTON_EVENT_NONE;
+}
+
+button_event_type_t button_fsm_update(button_fsm_t *fsm, bool edge, bool pressed, uint32_t now_ms)
+{
+    fsm->timeout_ms = 0;
+
+    if (edge && pressed != fsm->pressed) {
+        fsm->pressed = pressed;
+        if (!pressed) {
+            return BUTTON_EVENT_RELEASE;
+        }
+        fsm->press_ms = now_ms;
+        fsm->long_sent = false;
+        fsm->timeout_ms = fsm->long_press_ms;
+        return BUTTON_EVENT_PRESS;
+    }
+
+    // Long press timer, or a glitch that settled back to the same level
+    return check_long_press(fsm, now_ms);
+}
@@ -0,0 +1,25 @@
+/* Draining of the UDP command socket
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "cmd_dispatch.h"
+
+/* Handles one datagram; text replies are appended to reply */
+typedef void (*udp_drain_handler_t)(const uint8_t *data, int len, cmd_reply_t *reply);
+
+/* Block until a datagram arrives on sock, then handle it and every datagram
+ * already queued behind it without blocking. Replies are sent back to the
+ * sender of each datagram.
+ * Returns the number of datagrams handled, or -1 if the socket failed
+ * (errno tells why). */
+int udp_drain(int sock, udp_drain_handler_t handler, uint8_t *rx_buffer, size_t rx_size,
+              char *tx_buffer, size_t tx_size);
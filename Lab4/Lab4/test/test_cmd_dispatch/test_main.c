@@ -0,0 +1,126 @@
+/* Host tests of the command tables and of cmd_dispatch() parsing
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+
+   Run on the host with: pio test -e native
+*/
+#include <string.h>
+#include <unity.h>
+
+#include "cmd_dispatch.h"
+#include "gpio_cmd.h"
+
+static cmd_args_t s_last;
+static int s_calls;
+
+static int record(void *ctx, const cmd_args_t *args, cmd_reply_t *reply)
+{
+    (void)ctx;
+    (void)reply;
+    s_last = *args;
+    s_calls++;
+    return 0;
+}
+
+static int fail(void *ctx, const cmd_args_t *args, cmd_reply_t *reply)
+{
+    (void)ctx;
+    (void)args;
+    (void)reply;
+    return CMD_ERR_ARG;
+}
+
+static const cmd_entry_t test_table[CMD_TABLE_SIZE] = {
+    CMD_ENTRY('S', 'T', "SET", CMD_OP_SET, record),
+    CMD_ENTRY('S', 'T', "SET", CMD_OP_GET, record),
+    CMD_ENTRY('R', 'N', "RUN", CMD_OP_NONE, record),
+    CMD_ENTRY('F', 'L', "FAIL", CMD_OP_NONE, fail),
+    CMD_ENTRY('A', 'B', "A_LONG_KEY_AB", CMD_OP_SET, record),
+};
+
+static int dispatch(const char *text)
+{
+    return cmd_dispatch(test_table, NULL, text, strlen(text), NULL);
+}
+
+void setUp(void)
+{
+    memset(&s_last, 0, sizeof(s_last));
+    s_calls = 0;
+}
+
+void tearDown(void)
+{
+}
+
+static void test_tables_are_consistent(void)
+{
+    TEST_ASSERT_EQUAL_INT(-1, cmd_table_check(gpio_cmd_table));
+    TEST_ASSERT_EQUAL_INT(-1, cmd_table_check(test_table));
+}
+
+static void test_table_check_finds_wrong_characters(void)
+{
+    /* 'P', 'O' instead of 'P', 'G' for "PING" */
+    static const cmd_entry_t bad_last[CMD_TABLE_SIZE] = {
+        CMD_ENTRY('G', 'O', "GPIO", CMD_OP_SET, record),
+        CMD_ENTRY('P', 'O', "PING", CMD_OP_SET, record),
+    };
+    static const cmd_entry_t bad_length[CMD_TABLE_SIZE] = {
+        [CMD_HASH('G', 'O', 4, CMD_OP_SET)] = { "GPIO", 3, CMD_OP_SET, record },
+    };
+
+    TEST_ASSERT_EQUAL_INT(CMD_HASH('P', 'O', 4, CMD_OP_SET), cmd_table_check(bad_last));
+    TEST_ASSERT_EQUAL_INT(CMD_HASH('G', 'O', 4, CMD_OP_SET), cmd_table_check(bad_length));
+}
+
+static void test_parse(void)
+{
+    TEST_ASSERT_EQUAL_INT(1, dispatch("SET12=-34"));
+    TEST_ASSERT_TRUE(s_last.has_index);
+    TEST_ASSERT_EQUAL_INT(12, s_last.index);
+    TEST_ASSERT_TRUE(s_last.has_value);
+    TEST_ASSERT_EQUAL_INT(-34, s_last.value);
+
+    TEST_ASSERT_EQUAL_INT(1, dispatch("SET=on"));
+    TEST_ASSERT_FALSE(s_last.has_index);
+    TEST_ASSERT_FALSE(s_last.has_value);
+    TEST_ASSERT_EQUAL_INT(2, s_last.arg_len);
+    TEST_ASSERT_TRUE(memcmp(s_last.arg, "on", 2) == 0);
+
+    TEST_ASSERT_EQUAL_INT(1, dispatch("A_LONG_KEY_AB=1\r\n"));
+    TEST_ASSERT_EQUAL_INT(3, dispatch("RUN;SET?;SET7=1"));
+    TEST_ASSERT_EQUAL_INT(7, s_last.index);
+}
+
+static void test_rejected_messages_run_nothing(void)
+{
+    TEST_ASSERT_EQUAL_INT(CMD_ERR_SYNTAX, dispatch(""));
+    TEST_ASSERT_EQUAL_INT(CMD_ERR_SYNTAX, dispatch("\r\n"));
+    TEST_ASSERT_EQUAL_INT(CMD_ERR_SYNTAX, dispatch("RUN;"));
+    TEST_ASSERT_EQUAL_INT(CMD_ERR_SYNTAX, dispatch("SET1234567890=1"));
+    TEST_ASSERT_EQUAL_INT(CMD_ERR_SYNTAX, dispatch("SET?1"));
+    TEST_ASSERT_EQUAL_INT(CMD_ERR_SYNTAX, dispatch("SET!"));
+    TEST_ASSERT_EQUAL_INT(CMD_ERR_SYNTAX, dispatch("SIXTEEN_CHAR_KEY=1"));
+    TEST_ASSERT_EQUAL_INT(CMD_ERR_UNKNOWN, dispatch("RUN;RUN?"));
+    TEST_ASSERT_EQUAL_INT(CMD_ERR_UNKNOWN, dispatch("SAT=1"));
+    TEST_ASSERT_EQUAL_INT(0, s_calls);
+
+    /* Handlers up to the failing one have run */
+    TEST_ASSERT_EQUAL_INT(CMD_ERR_ARG, dispatch("RUN;FAIL;RUN"));
+    TEST_ASSERT_EQUAL_INT(1, s_calls);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_tables_are_consistent);
+    RUN_TEST(test_table_check_finds_wrong_characters);
+    RUN_TEST(test_parse);
+    RUN_TEST(test_rejected_messages_run_nothing);
+    return UNITY_END();
+}
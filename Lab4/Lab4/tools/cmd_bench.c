@@ -0,0 +1,82 @@
+/* Host micro-benchmark of the UDP command decoding
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+
+   Runs gpio_cmd_handle() on the message mix of udp_bench.py, with the pins
+   kept in memory, and prints the messages decoded per second:
+
+     cc -O2 -Isrc tools/cmd_bench.c src/gpio_cmd.c src/cmd_dispatch.c -o cmd_bench
+     ./cmd_bench [iterations]
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "gpio_cmd.h"
+
+static uint64_t s_levels;
+
+static void set_level(void *ctx, uint8_t pin, uint8_t level)
+{
+    (void)ctx;
+    s_levels = (s_levels & ~(1ULL << pin)) | ((uint64_t)level << pin);
+}
+
+static uint8_t get_level(void *ctx, uint8_t pin)
+{
+    (void)ctx;
+    return (s_levels >> pin) & 1;
+}
+
+static const gpio_cmd_port_t port = {
+    .pin_mask = 1ULL << 4,
+    .set_level = set_level,
+    .get_level = get_level,
+};
+
+static const char *const messages[] = {
+    "GPIO4=1;PING=0.1",
+    "GPIO4=0;PING=0.2",
+    "GPIO4?;PING=1.17",
+    "TOGGLE4;PING=2.9",
+    "LEVELS?;PING=3.1024",
+    "PING=0.3",
+    "\xA5\x01\x01\x04\x01",
+};
+
+int main(int argc, char **argv)
+{
+    long iterations = argc > 1 ? atol(argv[1]) : 2000000;
+    size_t count = sizeof(messages) / sizeof(messages[0]);
+    size_t lengths[sizeof(messages) / sizeof(messages[0])];
+    char tx_buffer[128];
+    struct timespec start, end;
+    long failures = 0;
+    double seconds;
+
+    for (size_t i = 0; i < count; i++) {
+        lengths[i] = strlen(messages[i]);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (long n = 0; n < iterations; n++) {
+        for (size_t i = 0; i < count; i++) {
+            cmd_reply_t reply = { .buf = tx_buffer, .size = sizeof(tx_buffer), .len = 0 };
+            if (gpio_cmd_handle(&port, (const uint8_t *)messages[i], lengths[i], &reply) < 0) {
+                failures++;
+            }
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    seconds = (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+    printf("%ld messages in %.3f s: %.1f M messages/s, %.0f ns/message\n",
+           iterations * (long)count, seconds,
+           (double)iterations * (double)count / seconds / 1e6,
+           seconds * 1e9 / ((double)iterations * (double)count));
+    return failures != 0;
+}
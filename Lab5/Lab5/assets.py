@@ -0,0 +1,15 @@
+# Gzip the files in assets/ before the build, so the web server can embed
+# and send them precompressed (see board_build.embed_files)
+import glob
+import gzip
+import os
+
+for path in glob.glob('assets/*'):
+    if path.endswith('.gz'):
+        continue
+    with open(path, 'rb') as f:
+        data = f.read()
+    # mtime=0 keeps the output identical between builds
+    with open(path + '.gz', 'wb') as f:
+        f.write(gzip.compress(data, compresslevel=9, mtime=0))
+    print('{}: {} -> {} bytes'.format(path, len(data), os.path.getsize(path + '.gz')))
@@ -0,0 +1,53 @@
+/*  Streaming application/x-www-form-urlencoded parser
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+#ifndef _FORM_PARSER_H_
+#define _FORM_PARSER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Longest decoded key and value. Longer fields fail with FORM_ERR_TOO_LONG,
+ * so the parser never needs more than its own struct. */
+#define FORM_MAX_KEY    16
+#define FORM_MAX_VALUE  64
+
+typedef enum {
+    FORM_OK = 0,
+    FORM_ERR_TOO_LONG = -1,
+    FORM_ERR_FORMAT = -2,       /* bad %XX escape, body ends inside one, or %00 in a key */
+    FORM_ERR_ABORTED = -3,      /* the callback returned nonzero */
+} form_err_t;
+
+/* Called for each field, with key and value decoded and NUL terminated.
+ * value points into the chunk passed to form_parser_feed() when the field
+ * fits in it, so it is only valid during the call. */
+typedef int (*form_field_cb_t)(void *ctx, const char *key, const char *value, size_t value_len);
+
+typedef struct {
+    form_field_cb_t on_field;
+    void *ctx;
+    int error;
+    uint8_t in_value;           /* past the '=' of the current field */
+    uint8_t escape;             /* %XX digits still expected */
+    uint8_t hex;
+    uint8_t partial;            /* the current token started in an earlier chunk */
+    size_t key_len;
+    size_t carry_len;
+    char key[FORM_MAX_KEY + 1];
+    char carry[FORM_MAX_VALUE + 1];     /* token split across chunks */
+} form_parser_t;
+
+void form_parser_init(form_parser_t *parser, form_field_cb_t on_field, void *ctx);
+/* Parse the next chunk of the body. The chunk is decoded in place, so its
+ * contents are changed. Errors are sticky. */
+form_err_t form_parser_feed(form_parser_t *parser, char *data, size_t len);
+/* End of body: report the last field */
+form_err_t form_parser_finish(form_parser_t *parser);
+
+#endif
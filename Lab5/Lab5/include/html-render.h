@@ -0,0 +1,48 @@
+/*  Streaming HTML rendering
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+#ifndef _HTML_RENDER_H_
+#define _HTML_RENDER_H_
+
+#include <stddef.h>
+
+/* Output is collected here and handed to the sink whenever it fills up, so
+ * the RAM used does not depend on the size of the page */
+#define HTML_RENDER_BUFFER_SIZE 512
+
+/* Receives each full buffer, e.g. httpd_resp_send_chunk(). Nonzero stops the
+ * rendering; later writes are dropped and html_render_end() reports it. */
+typedef int (*html_sink_t)(void *ctx, const char *data, size_t len);
+
+typedef struct {
+    html_sink_t sink;
+    void *ctx;
+    int error;
+    size_t len;
+    char buffer[HTML_RENDER_BUFFER_SIZE];
+} html_writer_t;
+
+typedef struct html_slot {
+    const char *name;           /* placeholder is #name# in the template */
+    void (*render)(html_writer_t *writer, void *arg);
+    void *arg;
+} html_slot_t;
+
+void html_writer_init(html_writer_t *writer, html_sink_t sink, void *ctx);
+void html_write(html_writer_t *writer, const char *data, size_t len);
+void html_write_str(html_writer_t *writer, const char *str);
+/* Write text with &, <, >, " and ' escaped, for element text and attribute
+ * values. Stops at len or at a NUL byte, whichever comes first. */
+void html_write_escaped(html_writer_t *writer, const char *text, size_t len);
+/* Write tpl, replacing each #name# with the output of the matching slot.
+ * A '#' that does not start a known placeholder is copied as is. */
+void html_render_template(html_writer_t *writer, const char *tpl, const html_slot_t *slots, size_t slot_count);
+/* Flush what is left; returns the first sink error, or 0 */
+int html_render_end(html_writer_t *writer);
+
+#endif
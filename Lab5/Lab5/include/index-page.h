@@ -0,0 +1,22 @@
+/*  Provisioning page
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+#ifndef _INDEX_PAGE_H_
+#define _INDEX_PAGE_H_
+
+#include "html-render.h"
+#include "wifi-scan.h"
+
+/* At most this many networks are listed, strongest first */
+#define INDEX_PAGE_MAX_OPTIONS 32
+
+/* Render the page listing the networks of scan, one <option> per SSID.
+ * Returns the first sink error, or 0. */
+int index_page_render(const wifi_scan_result_t *scan, html_sink_t sink, void *ctx);
+
+#endif
@@ -0,0 +1,36 @@
+/*  Background Wi-Fi scan service
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+#ifndef _WIFI_SCAN_H_
+#define _WIFI_SCAN_H_
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_wifi.h"
+
+#define WIFI_SCAN_MAX_APS       32
+#define WIFI_SCAN_REFRESH_MS    60000   /* scheduled rescan period */
+#define WIFI_SCAN_MAX_AGE_MS    15000   /* older results are refreshed on read */
+
+typedef struct {
+    int64_t timestamp_us;       /* esp_timer time of the scan, 0 if none yet */
+    uint16_t count;
+    wifi_ap_record_t records[WIFI_SCAN_MAX_APS];
+} wifi_scan_result_t;
+
+/* Start scanning in the background. Wi-Fi must be started in APSTA mode;
+ * this returns at once and the first results arrive a few seconds later. */
+esp_err_t wifi_scan_start(void);
+/* Start a scan now unless one is running. Never blocks. */
+esp_err_t wifi_scan_request(void);
+/* Latest complete results, never NULL. The table is not modified until it is
+ * released, so it can be read without locks, e.g. while a page is sent. */
+const wifi_scan_result_t *wifi_scan_acquire(void);
+void wifi_scan_release(const wifi_scan_result_t *result);
+
+#endif
@@ -5,6 +5,7 @@
  */
 
 #include <string.h>
+#include <ctype.h>
 #include <sys/param.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
@@ -51,7 +52,7 @@ static volatile TaskHandle_t _mdns_service_task_handle = NULL;
 static SemaphoreHandle_t _mdns_service_semaphore = NULL;
 
 static void _mdns_search_finish_done(void);
-static mdns_search_once_t *_mdns_search_find_from(mdns_search_once_t *search, mdns_name_t *name, uint16_t type, mdns_if_t tcpip_if, mdns_ip_protocol_t ip_protocol);
+static mdns_search_once_t *_mdns_search_find_all(mdns_name_t *name, uint16_t type, mdns_if_t tcpip_if, mdns_ip_protocol_t ip_protocol);
 static void _mdns_search_result_add_ip(mdns_search_once_t *search, const char *hostname, esp_ip_addr_t *ip,
                                        mdns_if_t tcpip_if, mdns_ip_protocol_t ip_protocol, uint32_t ttl);
 static void _mdns_search_result_add_srv(mdns_search_once_t *search, const char *hostname, uint16_t port,
@@ -62,6 +63,8 @@ static void _mdns_search_result_add_txt(mdns_search_once_t *search, mdns_txt_ite
 static mdns_result_t *_mdns_search_result_add_ptr(mdns_search_once_t *search, const char *instance,
         const char *service_type, const char *proto, mdns_if_t tcpip_if,
         mdns_ip_protocol_t ip_protocol, uint32_t ttl);
+static mdns_result_t *_mdns_search_result_find_ptr(mdns_search_once_t *search, mdns_name_t *name,
+        mdns_if_t tcpip_if, mdns_ip_protocol_t ip_protocol, uint32_t ttl);
 static bool _mdns_append_host_list_in_services(mdns_out_answer_t **destination, mdns_srv_item_t *services[], size_t services_len, bool flush, bool bye);
 static bool _mdns_append_host_list(mdns_out_answer_t **destination, bool flush, bool bye);
 static void _mdns_remap_self_service_hostname(const char *old_hostname, const char *new_hostname);
@@ -416,6 +419,7 @@ static const uint8_t *_mdns_read_fqdn(const uint8_t *packet, const uint8_t *star
 {
     size_t index = 0;
     const uint8_t *packet_end = packet + packet_len;
+    const uint8_t *next = NULL;     // after the first compression pointer, where the name ends in the packet
     while (start + index < packet_end && start[index]) {
         if (name->parts == 4) {
             name->invalid = true;
@@ -426,6 +430,11 @@ static const uint8_t *_mdns_read_fqdn(const uint8_t *packet, const uint8_t *star
                 //length can not be more than 63
                 return NULL;
             }
+            name->wire_len += len + 1;
+            if (name->wire_len >= MDNS_NAME_WIRE_LIMIT) {
+                //name too long, labels reached through chained pointers included
+                return NULL;
+            }
             uint8_t i;
             for (i = 0; i < len; i++) {
                 if (start + index >= packet_end) {
@@ -456,13 +465,15 @@ static const uint8_t *_mdns_read_fqdn(const uint8_t *packet, const uint8_t *star
                 //reference address can not be after where we are
                 return NULL;
             }
-            if (_mdns_read_fqdn(packet, packet + address, name, buf, packet_len)) {
-                return start + index;
+            // followed in this loop, pointers to pointers would otherwise nest a call per hop
+            if (!next) {
+                next = start + index;
             }
-            return NULL;
+            start = packet + address;
+            index = 0;
         }
     }
-    return start + index + 1;
+    return next ? next : start + index + 1;
 }
 
 /**
@@ -593,58 +604,6 @@ static inline uint8_t _mdns_append_string_with_len(uint8_t *packet, uint16_t *in
     return len + 1;
 }
 
-/**
- * @brief  appends single string to a packet, incrementing the index
- *
- * @param  packet       MDNS packet
- * @param  index        offset in the packet
- * @param  string       the string to append
- *
- * @return length of added data: 0 on error or length of the string + 1 on success
- */
-static inline uint8_t _mdns_append_string(uint8_t *packet, uint16_t *index, const char *string)
-{
-    uint8_t len = strlen(string);
-    if ((*index + len + 1) >= MDNS_MAX_PACKET_SIZE) {
-        return 0;
-    }
-    _mdns_append_u8(packet, index, len);
-    memcpy(packet + *index, string, len);
-    *index += len;
-    return len + 1;
-}
-
-/**
- * @brief  appends one TXT record ("key=value" or "key")
- *
- * @param  packet       MDNS packet
- * @param  index        offset in the packet
- * @param  txt          one txt record
- *
- * @return length of added data: length of the added txt value + 1 on success
- *         0  if data won't fit the packet
- *         -1 if invalid TXT entry
- */
-static inline int append_one_txt_record_entry(uint8_t *packet, uint16_t *index, mdns_txt_linked_item_t *txt)
-{
-    if (txt == NULL || txt->key == NULL) {
-        return -1;
-    }
-    size_t key_len = strlen(txt->key);
-    size_t len = key_len + txt->value_len + (txt->value ? 1 : 0);
-    if ((*index + len + 1) >= MDNS_MAX_PACKET_SIZE) {
-        return 0;
-    }
-    _mdns_append_u8(packet, index, len);
-    memcpy(packet + *index, txt->key, key_len);
-    if (txt->value) {
-        packet[*index + key_len] = '=';
-        memcpy(packet + *index + key_len + 1, txt->value, txt->value_len);
-    }
-    *index += len;
-    return len + 1;
-}
-
 #ifdef CONFIG_MDNS_RESPOND_REVERSE_QUERIES
 static inline int append_single_str(uint8_t *packet, uint16_t *index, const char *str, int len)
 {
@@ -699,119 +658,381 @@ static uint16_t append_fqdn_dots(uint8_t *packet, uint16_t *index, const char *n
 }
 #endif /* CONFIG_MDNS_RESPOND_REVERSE_QUERIES */
 
+#ifndef CONFIG_MDNS_SMALL_FOOTPRINT
+/*
+ * Names already written to the packet being built, by offset, for name compression.
+ * Every label of a name is a possible target: it starts the suffix of that name.
+ * */
+static struct {
+    const uint8_t *packet;
+    uint8_t count;
+    struct {
+        uint16_t offset;
+        uint16_t hash;              /*!< hash of the (suffix) name at offset, to skip most comparisons */
+    } names[MDNS_NAME_TABLE_LEN];
+} s_name_table;
+#endif
+
 /**
- * @brief  appends FQDN to a packet, incrementing the index and
- *         compressing the output if previous occurrence of the string (or part of it) has been found
+ * @brief  starts a new packet: nothing can be pointed to yet
+ */
+static void _mdns_name_table_reset(const uint8_t *packet)
+{
+#ifndef CONFIG_MDNS_SMALL_FOOTPRINT
+    s_name_table.packet = packet;
+    s_name_table.count = 0;
+#endif
+}
+
+/*
+ * The last packet built by _mdns_dispatch_tx_packet(), kept to send the same content on the other
+ * interfaces and IP protocols without building it again. Only the addresses of this host differ
+ * between interfaces, the offsets of their rdata are kept to rewrite them in place.
+ * */
+static struct {
+    uint64_t fingerprint;           /*!< of the content the packet was built from, 0 if none kept */
+    uint16_t len;
+    uint8_t count;                  /*!< A/AAAA answers of this host in the packet */
+    bool recording;                 /*!< a packet is being built, note its answers of this host */
+    bool overflow;                  /*!< more of these answers than slots, the packet cannot be reused */
+    struct {
+        uint16_t type;
+        uint8_t num;                /*!< records written, for the interface and its duplicate */
+        uint16_t offset[2];         /*!< of their rdata */
+    } addrs[MDNS_TX_SELF_ADDR_ANSWERS];
+} s_tx_last;
+
+/**
+ * @brief  drops the last packet built, called when the data it was built from may have changed
+ */
+static void _mdns_tx_last_forget(void)
+{
+    s_tx_last.fingerprint = 0;
+}
+
+#ifndef CONFIG_MDNS_SMALL_FOOTPRINT
+/**
+ * @brief  hash of one label followed by a name with the given hash, case insensitive
+ */
+static uint16_t _mdns_name_hash(const uint8_t *label, uint16_t next_hash)
+{
+    uint32_t hash = 2166136261U ^ next_hash;
+    for (uint8_t i = 0; i <= label[0]; i++) {
+        hash = (hash ^ tolower(label[i])) * 16777619U;
+    }
+    return hash ^ (hash >> 16);
+}
+#endif
+
+/**
+ * @brief  compares the name at offset in the packet, following compression pointers,
+ *         with an uncompressed name
+ */
+static bool _mdns_name_equals(const uint8_t *packet, uint16_t offset, uint16_t end, const uint8_t *name)
+{
+    uint8_t jumps = 0;
+    while (offset < end) {
+        uint8_t len = packet[offset];
+        if ((len & 0xC0) == 0xC0) {
+            if (offset + 1 >= end || ++jumps > 8) {
+                return false;
+            }
+            offset = ((len & 0x3F) << 8) | packet[offset + 1];
+            continue;
+        }
+        if (len != name[0] || offset + 1 + len > end) {
+            return false;
+        }
+        if (len == 0) {
+            return true;
+        }
+        for (uint8_t i = 1; i <= len; i++) {
+            if (tolower(packet[offset + i]) != tolower(name[i])) {
+                return false;
+            }
+        }
+        offset += 1 + len;
+        name += 1 + len;
+    }
+    return false;
+}
+
+/**
+ * @brief  length of a name in wire format, including the root label
+ */
+static uint16_t _mdns_name_len(const uint8_t *name)
+{
+    uint16_t len = 0;
+    while (name[len]) {
+        len += 1 + name[len];
+    }
+    return len + 1;
+}
+
+/**
+ * @brief  finds a name already written to the packet, as a whole name or as the suffix of one
+ *
+ * @param  packet       MDNS packet
+ * @param  end          offset the packet is written up to
+ * @param  name         the name in wire format
+ * @param  hash         hash of the name, see _mdns_name_hash()
+ * @param  offset       where the name was found
+ *
+ * @return true if found
+ */
+static bool _mdns_name_find(const uint8_t *packet, uint16_t end, const uint8_t *name, uint16_t hash, uint16_t *offset)
+{
+#ifdef CONFIG_MDNS_SMALL_FOOTPRINT
+    // No table of the names written: any byte that starts the same labels can be pointed to
+    (void)hash;
+    const uint8_t *p = packet + MDNS_HEAD_LEN;
+    while (p < packet + end && (p = memchr(p, name[0], end - (p - packet))) != NULL) {
+        if (_mdns_name_equals(packet, p - packet, end, name)) {
+            *offset = p - packet;
+            return true;
+        }
+        p++;
+    }
+#else
+    for (uint8_t j = 0; j < s_name_table.count; j++) {
+        if (s_name_table.names[j].hash == hash && s_name_table.names[j].offset < end &&
+                _mdns_name_equals(packet, s_name_table.names[j].offset, end, name)) {
+            *offset = s_name_table.names[j].offset;
+            return true;
+        }
+    }
+#endif
+    return false;
+}
+
+/**
+ * @brief  appends a name given in wire format (uncompressed labels) to a packet, incrementing the index and
+ *         pointing to a previous occurrence of the name (or its longest suffix) instead of repeating it
  *
  * @param  packet       MDNS packet
  * @param  index        offset in the packet
- * @param  strings      string array containing the parts of the FQDN
- * @param  count        number of strings in the array
+ * @param  name         the name in wire format, may already be at the index (written in place)
  *
  * @return length of added data: 0 on error or length on success
  */
-static uint16_t _mdns_append_fqdn(uint8_t *packet, uint16_t *index, const char *strings[], uint8_t count, size_t packet_len)
-{
-    if (!count) {
-        //empty string so terminate
-        return _mdns_append_u8(packet, index, 0);
+static uint16_t _mdns_append_name(uint8_t *packet, uint16_t *index, const uint8_t *name)
+{
+    uint16_t labels[MDNS_NAME_MAX_LABELS];
+    uint16_t hashes[MDNS_NAME_MAX_LABELS] = {0};   // only looked up in the name table
+    uint8_t count = 0;
+    uint16_t len = 0;
+    while (name[len]) {
+        if (count < MDNS_NAME_MAX_LABELS) {
+            labels[count] = len;
+        }
+        count++;
+        len += 1 + name[len];
+    }
+    len++;  // root label
+    if (count > MDNS_NAME_MAX_LABELS) {
+        // none of the names we write has that many labels, not worth compressing
+        if ((*index + len) >= MDNS_MAX_PACKET_SIZE) {
+            return 0;
+        }
+        memmove(packet + *index, name, len);
+        *index += len;
+        return len;
     }
-    mdns_name_t name;
-    static char buf[MDNS_NAME_BUF_LEN];
-    uint8_t len = strlen(strings[0]);
-    //try to find first the string length in the packet (if it exists)
-    uint8_t *len_location = (uint8_t *)memchr(packet, (char)len, *index);
-    while (len_location) {
-        //check if the string after len_location is the string that we are looking for
-        if (memcmp(len_location + 1, strings[0], len)) { //not continuing with our string
-search_next:
-            //try and find the length byte further in the packet
-            len_location = (uint8_t *)memchr(len_location + 1, (char)len, *index - (len_location + 1 - packet));
-            continue;
+#ifndef CONFIG_MDNS_SMALL_FOOTPRINT
+    uint16_t hash = 0;
+    for (uint8_t i = count; i > 0; i--) {
+        hash = _mdns_name_hash(&name[labels[i - 1]], hash);
+        hashes[i - 1] = hash;
+    }
+    if (s_name_table.packet != packet) {
+        _mdns_name_table_reset(packet);
+    }
+#endif
+
+    // Longest suffix already in the packet
+    uint16_t prefix_len = len;
+    uint16_t target = 0;
+    for (uint8_t i = 0; i < count && prefix_len == len; i++) {
+        if (_mdns_name_find(packet, *index, &name[labels[i]], hashes[i], &target)) {
+            prefix_len = labels[i];
         }
-        //seems that we might have found the string that we are looking for
-        //read the destination into name and compare
-        name.parts = 0;
-        name.sub = 0;
-        name.invalid = false;
-        name.host[0] = 0;
-        name.service[0] = 0;
-        name.proto[0] = 0;
-        name.domain[0] = 0;
-        const uint8_t *content = _mdns_read_fqdn(packet, len_location, &name, buf, packet_len);
-        if (!content) {
-            //not a readable fqdn?
-            goto search_next; // could be our unfinished fqdn, continue searching
-        }
-        if (name.parts == count) {
-            uint8_t i;
-            for (i = 0; i < count; i++) {
-                if (strcasecmp(strings[i], (const char *)&name + (i * (MDNS_NAME_BUF_LEN)))) {
-                    //not our string! let's search more
-                    goto search_next;
-                }
-            }
-            //we actually have found the string
-            break;
-        } else {
-            goto search_next;
+    }
+
+    uint16_t written = prefix_len == len ? len : prefix_len + 2;
+    if ((*index + written) >= MDNS_MAX_PACKET_SIZE) {
+        return 0;
+    }
+#ifndef CONFIG_MDNS_SMALL_FOOTPRINT
+    for (uint8_t i = 0; i < count && labels[i] < prefix_len; i++) {
+        uint16_t offset = *index + labels[i];
+        if (s_name_table.count < MDNS_NAME_TABLE_LEN && offset < MDNS_NAME_REF) {
+            s_name_table.names[s_name_table.count].offset = offset;
+            s_name_table.names[s_name_table.count].hash = hashes[i];
+            s_name_table.count++;
         }
     }
-    //string is not yet in the packet, so let's add it
-    if (!len_location) {
-        uint8_t written = _mdns_append_string(packet, index, strings[0]);
-        if (!written) {
+#endif
+    if (prefix_len == len) {
+        memmove(packet + *index, name, len);
+        *index += len;
+    } else {
+        memmove(packet + *index, name, prefix_len);
+        *index += prefix_len;
+        _mdns_append_u16(packet, index, MDNS_NAME_REF | target);
+    }
+    return written;
+}
+
+/**
+ * @brief  length of the parts of a name in wire format
+ *
+ * @param  strings      string array containing the parts of the FQDN
+ * @param  count        number of strings in the array
+ *
+ * @return length of the encoded name or 0 if it is longer than MDNS_NAME_WIRE_MAX_LEN
+ */
+static uint16_t _mdns_encoded_name_len(const char *strings[], uint8_t count)
+{
+    uint16_t len = 1;   // root label
+    for (uint8_t i = 0; i < count; i++) {
+        size_t part_len = strlen(strings[i]);
+        if (part_len > UINT8_MAX || len + 1 + part_len > MDNS_NAME_WIRE_MAX_LEN) {
             return 0;
         }
-        //run the same for the other strings in the name
-        return written + _mdns_append_fqdn(packet, index, &strings[1], count - 1, packet_len);
+        len += 1 + part_len;
     }
+    return len;
+}
 
-    //we have found the string so let's insert a pointer to it instead
-    uint16_t offset = len_location - packet;
-    offset |= MDNS_NAME_REF;
-    return _mdns_append_u16(packet, index, offset);
+/**
+ * @brief  encodes the parts of a name in wire format
+ *
+ * @param  name         output buffer, MDNS_NAME_WIRE_MAX_LEN bytes
+ * @param  strings      string array containing the parts of the FQDN
+ * @param  count        number of strings in the array
+ *
+ * @return length of the encoded name or 0 if it doesn't fit
+ */
+static uint16_t _mdns_encode_name(uint8_t *name, const char *strings[], uint8_t count)
+{
+    uint16_t len = 0;
+    if (!_mdns_encoded_name_len(strings, count)) {
+        return 0;
+    }
+    for (uint8_t i = 0; i < count; i++) {
+        size_t part_len = strlen(strings[i]);
+        name[len++] = part_len;
+        memcpy(name + len, strings[i], part_len);
+        len += part_len;
+    }
+    name[len++] = 0;
+    return len;
 }
 
 /**
- * @brief  appends PTR record for service to a packet, incrementing the index
+ * @brief  appends FQDN to a packet, incrementing the index and
+ *         compressing the output if previous occurrence of the string (or part of it) has been found
  *
  * @param  packet       MDNS packet
  * @param  index        offset in the packet
- * @param  server       the server that is hosting the service
- * @param  service      the service to add record for
+ * @param  strings      string array containing the parts of the FQDN
+ * @param  count        number of strings in the array
  *
  * @return length of added data: 0 on error or length on success
  */
-static uint16_t _mdns_append_ptr_record(uint8_t *packet, uint16_t *index, const char *instance, const char *service, const char *proto, bool flush, bool bye)
+static uint16_t _mdns_append_fqdn(uint8_t *packet, uint16_t *index, const char *strings[], uint8_t count)
 {
-    const char *str[4];
-    uint16_t record_length = 0;
-    uint8_t part_length;
-
-    if (service == NULL) {
+    // Encoded in place, where the name is written if no suffix of it can be pointed to,
+    // as far as MDNS_TX_BUFFER_LEN: past MDNS_MAX_PACKET_SIZE except in the small footprint profile
+    uint16_t len = _mdns_encoded_name_len(strings, count);
+    if (!len || *index >= MDNS_MAX_PACKET_SIZE || *index + len > MDNS_TX_BUFFER_LEN) {
         return 0;
     }
+    _mdns_encode_name(packet + *index, strings, count);
+    return _mdns_append_name(packet, index, packet + *index);
+}
 
-    str[0] = instance;
-    str[1] = service;
-    str[2] = proto;
-    str[3] = MDNS_DEFAULT_DOMAIN;
+/**
+ * @brief  wire format names of a service, built when first needed after a change
+ *
+ * @return the names or NULL if the service has no instance name yet, or out of memory
+ */
+static mdns_service_names_t *_mdns_get_service_names(mdns_service_t *service)
+{
+    if (service->names) {
+        return service->names;
+    }
+    const char *hostname = service->hostname ? service->hostname : _mdns_server->hostname;
+    const char *instance_str[4] = {_mdns_get_service_instance_name(service), service->service, service->proto, MDNS_DEFAULT_DOMAIN};
+    const char *host_str[2] = {hostname, MDNS_DEFAULT_DOMAIN};
+    if (!instance_str[0] || !service->service || !service->proto) {
+        return NULL;
+    }
+    uint16_t instance_len = _mdns_encoded_name_len(instance_str, 4);
+    uint16_t host_len = _str_null_or_empty(hostname) ? 0 : _mdns_encoded_name_len(host_str, 2);
+    if (!instance_len) {
+        return NULL;
+    }
+    mdns_service_names_t *names = (mdns_service_names_t *)malloc(sizeof(mdns_service_names_t) + instance_len + host_len);
+    if (!names) {
+        HOOK_MALLOC_FAILED;
+        return NULL;
+    }
+    _mdns_encode_name(names->name, instance_str, 4);
+    if (host_len) {
+        _mdns_encode_name(names->name + instance_len, host_str, 2);
+    }
+    names->service_offset = 1 + names->name[0];
+    names->host_offset = host_len ? instance_len : 0;
+    service->names = names;
+    return names;
+}
+
+/**
+ * @brief  drops the names of a service, or of all services if NULL, after their instance or host name changed
+ */
+static void _mdns_invalidate_service_names(mdns_service_t *service)
+{
+    _mdns_tx_last_forget();
+    if (service) {
+        free(service->names);
+        service->names = NULL;
+        return;
+    }
+    for (mdns_srv_item_t *s = _mdns_server->services; s; s = s->next) {
+        _mdns_invalidate_service_names(s->service);
+    }
+}
 
-    part_length = _mdns_append_fqdn(packet, index, str + 1, 3, MDNS_MAX_PACKET_SIZE);
+/**
+ * @brief  appends PTR record with names in wire format to a packet, incrementing the index
+ *
+ * @param  packet       MDNS packet
+ * @param  index        offset in the packet
+ * @param  name         the record name
+ * @param  target       the name it points to
+ *
+ * @return length of added data: 0 on error or length on success
+ */
+static uint16_t _mdns_append_ptr_name_record(uint8_t *packet, uint16_t *index, const uint8_t *name, const uint8_t *target, bool flush, uint32_t ttl)
+{
+    uint16_t record_length = 0;
+    uint16_t part_length;
+
+    part_length = _mdns_append_name(packet, index, name);
     if (!part_length) {
         return 0;
     }
     record_length += part_length;
 
-    part_length = _mdns_append_type(packet, index, MDNS_ANSWER_PTR, false, bye ? 0 : MDNS_ANSWER_PTR_TTL);
+    part_length = _mdns_append_type(packet, index, MDNS_ANSWER_PTR, flush, ttl);
     if (!part_length) {
         return 0;
     }
     record_length += part_length;
 
     uint16_t data_len_location = *index - 2;
-    part_length = _mdns_append_fqdn(packet, index, str, 4, MDNS_MAX_PACKET_SIZE);
+    part_length = _mdns_append_name(packet, index, target);
     if (!part_length) {
         return 0;
     }
@@ -821,51 +1042,63 @@ static uint16_t _mdns_append_ptr_record(uint8_t *packet, uint16_t *index, const
 }
 
 /**
- * @brief  appends PTR record for a subtype to a packet, incrementing the index
+ * @brief  appends PTR record for service to a packet, incrementing the index
  *
  * @param  packet       MDNS packet
  * @param  index        offset in the packet
- * @param  instance     the service instance name
- * @param  subtype      the service subtype
- * @param  proto        the service protocol
- * @param  flush        whether to set the flush flag
- * @param  bye          whether to set the bye flag
+ * @param  server       the server that is hosting the service
+ * @param  service      the service to add record for
  *
  * @return length of added data: 0 on error or length on success
  */
-static uint16_t _mdns_append_subtype_ptr_record(uint8_t *packet, uint16_t *index, const char *instance,
-        const char *subtype, const char *service, const char *proto, bool flush,
-        bool bye)
+static uint16_t _mdns_append_ptr_record(uint8_t *packet, uint16_t *index, const char *instance, const char *service, const char *proto, bool flush, bool bye)
 {
-    const char *subtype_str[5] = {subtype, MDNS_SUB_STR, service, proto, MDNS_DEFAULT_DOMAIN};
-    const char *instance_str[4] = {instance, service, proto, MDNS_DEFAULT_DOMAIN};
-    uint16_t record_length = 0;
-    uint8_t part_length;
+    const char *str[4];
+    uint8_t name[MDNS_NAME_WIRE_MAX_LEN];
 
     if (service == NULL) {
         return 0;
     }
 
-    part_length = _mdns_append_fqdn(packet, index, subtype_str, ARRAY_SIZE(subtype_str), MDNS_MAX_PACKET_SIZE);
-    if (!part_length) {
-        return 0;
-    }
-    record_length += part_length;
+    str[0] = instance;
+    str[1] = service;
+    str[2] = proto;
+    str[3] = MDNS_DEFAULT_DOMAIN;
 
-    part_length = _mdns_append_type(packet, index, MDNS_ANSWER_PTR, false, bye ? 0 : MDNS_ANSWER_PTR_TTL);
-    if (!part_length) {
+    // The instance name ends with the service name
+    if (!_mdns_encode_name(name, str, 4)) {
         return 0;
     }
-    record_length += part_length;
+    return _mdns_append_ptr_name_record(packet, index, name + 1 + name[0], name, false, bye ? 0 : MDNS_ANSWER_PTR_TTL);
+}
 
-    uint16_t data_len_location = *index - 2;
-    part_length = _mdns_append_fqdn(packet, index, instance_str, ARRAY_SIZE(instance_str), MDNS_MAX_PACKET_SIZE);
-    if (!part_length) {
+/**
+ * @brief  appends PTR record for a subtype to a packet, incrementing the index
+ *
+ * @param  packet       MDNS packet
+ * @param  index        offset in the packet
+ * @param  names        names of the service
+ * @param  subtype      the service subtype
+ * @param  flush        whether to set the flush flag
+ * @param  bye          whether to set the bye flag
+ *
+ * @return length of added data: 0 on error or length on success
+ */
+static uint16_t _mdns_append_subtype_ptr_record(uint8_t *packet, uint16_t *index, const mdns_service_names_t *names,
+        const char *subtype, bool flush, bool bye)
+{
+    const char *subtype_str[2] = {subtype, MDNS_SUB_STR};
+    const uint8_t *service_name = names->name + names->service_offset;
+    uint8_t name[MDNS_NAME_WIRE_MAX_LEN];
+
+    // "subtype._sub" followed by the service name
+    uint16_t len = _mdns_encode_name(name, subtype_str, ARRAY_SIZE(subtype_str));
+    uint16_t service_len = _mdns_name_len(service_name);
+    if (!len || len - 1 + service_len > MDNS_NAME_WIRE_MAX_LEN) {
         return 0;
     }
-    _mdns_set_u16(packet, data_len_location, part_length);
-    record_length += part_length;
-    return record_length;
+    memcpy(name + len - 1, service_name, service_len);
+    return _mdns_append_ptr_name_record(packet, index, name, names->name, false, bye ? 0 : MDNS_ANSWER_PTR_TTL);
 }
 
 /**
@@ -880,42 +1113,17 @@ static uint16_t _mdns_append_subtype_ptr_record(uint8_t *packet, uint16_t *index
  */
 static uint16_t _mdns_append_sdptr_record(uint8_t *packet, uint16_t *index, mdns_service_t *service, bool flush, bool bye)
 {
-    const char *str[3];
-    const char *sd_str[4];
-    uint16_t record_length = 0;
-    uint8_t part_length;
+    static const uint8_t sd_name[] = "\x09_services\x07_dns-sd\x04_udp\x05local";
 
     if (service == NULL) {
         return 0;
     }
 
-    sd_str[0] = (char *)"_services";
-    sd_str[1] = (char *)"_dns-sd";
-    sd_str[2] = (char *)"_udp";
-    sd_str[3] = MDNS_DEFAULT_DOMAIN;
-
-    str[0] = service->service;
-    str[1] = service->proto;
-    str[2] = MDNS_DEFAULT_DOMAIN;
-
-    part_length = _mdns_append_fqdn(packet, index, sd_str, 4, MDNS_MAX_PACKET_SIZE);
-
-    record_length += part_length;
-
-    part_length = _mdns_append_type(packet, index, MDNS_ANSWER_PTR, flush, MDNS_ANSWER_PTR_TTL);
-    if (!part_length) {
+    mdns_service_names_t *names = _mdns_get_service_names(service);
+    if (!names) {
         return 0;
     }
-    record_length += part_length;
-
-    uint16_t data_len_location = *index - 2;
-    part_length = _mdns_append_fqdn(packet, index, str, 3, MDNS_MAX_PACKET_SIZE);
-    if (!part_length) {
-        return 0;
-    }
-    _mdns_set_u16(packet, data_len_location, part_length);
-    record_length += part_length;
-    return record_length;
+    return _mdns_append_ptr_name_record(packet, index, sd_name, names->name + names->service_offset, flush, MDNS_ANSWER_PTR_TTL);
 }
 
 /**
@@ -930,24 +1138,19 @@ static uint16_t _mdns_append_sdptr_record(uint8_t *packet, uint16_t *index, mdns
  */
 static uint16_t _mdns_append_txt_record(uint8_t *packet, uint16_t *index, mdns_service_t *service, bool flush, bool bye)
 {
-    const char *str[4];
     uint16_t record_length = 0;
-    uint8_t part_length;
+    uint16_t part_length;
 
     if (service == NULL) {
         return 0;
     }
 
-    str[0] = _mdns_get_service_instance_name(service);
-    str[1] = service->service;
-    str[2] = service->proto;
-    str[3] = MDNS_DEFAULT_DOMAIN;
-
-    if (!str[0]) {
+    mdns_service_names_t *names = _mdns_get_service_names(service);
+    if (!names) {
         return 0;
     }
 
-    part_length = _mdns_append_fqdn(packet, index, str, 4, MDNS_MAX_PACKET_SIZE);
+    part_length = _mdns_append_name(packet, index, names->name);
     if (!part_length) {
         return 0;
     }
@@ -960,20 +1163,17 @@ static uint16_t _mdns_append_txt_record(uint8_t *packet, uint16_t *index, mdns_s
     record_length += part_length;
 
     uint16_t data_len_location = *index - 2;
-    uint16_t data_len = 0;
-
-    mdns_txt_linked_item_t *txt = service->txt;
-    while (txt) {
-        int l = append_one_txt_record_entry(packet, index, txt);
-        if (l > 0) {
-            data_len += l;
-        } else if (l == 0) { // TXT entry won't fit into the mdns packet
+    uint16_t data_len = 1;
+
+    if (service->txt) {
+        // Kept in wire format
+        data_len = service->txt->len;
+        if ((*index + data_len) >= MDNS_MAX_PACKET_SIZE) {
             return 0;
         }
-        txt = txt->next;
-    }
-    if (!data_len) {
-        data_len = 1;
+        memcpy(packet + *index, service->txt->data, data_len);
+        *index += data_len;
+    } else {
         packet[*index] = 0;
         *index = *index + 1;
     }
@@ -994,24 +1194,19 @@ static uint16_t _mdns_append_txt_record(uint8_t *packet, uint16_t *index, mdns_s
  */
 static uint16_t _mdns_append_srv_record(uint8_t *packet, uint16_t *index, mdns_service_t *service, bool flush, bool bye)
 {
-    const char *str[4];
     uint16_t record_length = 0;
-    uint8_t part_length;
+    uint16_t part_length;
 
     if (service == NULL) {
         return 0;
     }
 
-    str[0] = _mdns_get_service_instance_name(service);
-    str[1] = service->service;
-    str[2] = service->proto;
-    str[3] = MDNS_DEFAULT_DOMAIN;
-
-    if (!str[0]) {
+    mdns_service_names_t *names = _mdns_get_service_names(service);
+    if (!names || !names->host_offset) {
         return 0;
     }
 
-    part_length = _mdns_append_fqdn(packet, index, str, 4, MDNS_MAX_PACKET_SIZE);
+    part_length = _mdns_append_name(packet, index, names->name);
     if (!part_length) {
         return 0;
     }
@@ -1033,18 +1228,7 @@ static uint16_t _mdns_append_srv_record(uint8_t *packet, uint16_t *index, mdns_s
         return 0;
     }
 
-    if (service->hostname) {
-        str[0] = service->hostname;
-    } else {
-        str[0] = _mdns_server->hostname;
-    }
-    str[1] = MDNS_DEFAULT_DOMAIN;
-
-    if (_str_null_or_empty(str[0])) {
-        return 0;
-    }
-
-    part_length = _mdns_append_fqdn(packet, index, str, 2, MDNS_MAX_PACKET_SIZE);
+    part_length = _mdns_append_name(packet, index, names->name + names->host_offset);
     if (!part_length) {
         return 0;
     }
@@ -1077,7 +1261,7 @@ static uint16_t _mdns_append_a_record(uint8_t *packet, uint16_t *index, const ch
         return 0;
     }
 
-    part_length = _mdns_append_fqdn(packet, index, str, 2, MDNS_MAX_PACKET_SIZE);
+    part_length = _mdns_append_fqdn(packet, index, str, 2);
     if (!part_length) {
         return 0;
     }
@@ -1129,7 +1313,7 @@ static uint16_t _mdns_append_aaaa_record(uint8_t *packet, uint16_t *index, const
     }
 
 
-    part_length = _mdns_append_fqdn(packet, index, str, 2, MDNS_MAX_PACKET_SIZE);
+    part_length = _mdns_append_fqdn(packet, index, str, 2);
     if (!part_length) {
         return 0;
     }
@@ -1185,7 +1369,7 @@ static uint16_t _mdns_append_question(uint8_t *packet, uint16_t *index, mdns_out
         if (q->domain) {
             str[str_index++] = q->domain;
         }
-        part_length = _mdns_append_fqdn(packet, index, str, str_index, MDNS_MAX_PACKET_SIZE);
+        part_length = _mdns_append_fqdn(packet, index, str, str_index);
         if (!part_length) {
             return 0;
         }
@@ -1244,6 +1428,54 @@ static bool _ipv6_address_is_zero(esp_ip6_addr_t ip6)
 }
 #endif
 
+/**
+ * @brief  Get the IPv4 address (type A) or the IPv6 link local address (type AAAA) of an interface
+ */
+static bool _mdns_get_if_addr(mdns_if_t tcpip_if, uint16_t type, esp_ip_addr_t *addr)
+{
+    if (type == MDNS_TYPE_A) {
+        esp_netif_ip_info_t if_ip_info;
+        if (esp_netif_get_ip_info(_mdns_get_esp_netif(tcpip_if), &if_ip_info)) {
+            return false;
+        }
+        addr->type = ESP_IPADDR_TYPE_V4;
+        addr->u_addr.ip4 = if_ip_info.ip;
+        return true;
+    }
+#if CONFIG_LWIP_IPV6
+    addr->type = ESP_IPADDR_TYPE_V6;
+    return esp_netif_get_ip6_linklocal(_mdns_get_esp_netif(tcpip_if), &addr->u_addr.ip6) == ESP_OK;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief  Get the addresses this host answers A or AAAA questions with on an interface: its own
+ *         and, if the interface is a duplicate (two interfaces on the same subnet), the other one's
+ *
+ * @return number of addresses, 0 if the interface has no address of this type
+ */
+static uint8_t _mdns_get_self_addrs(mdns_if_t tcpip_if, uint16_t type, esp_ip_addr_t addrs[2])
+{
+    mdns_pcb_t *pcb = &_mdns_server->interfaces[tcpip_if].pcbs[type == MDNS_TYPE_A ? MDNS_IP_PROTOCOL_V4 : MDNS_IP_PROTOCOL_V6];
+    if (!pcb->pcb && pcb->state != PCB_DUP) {
+        return 0;
+    }
+    if (!_mdns_get_if_addr(tcpip_if, type, &addrs[0])) {
+        return 0;
+    }
+#if CONFIG_LWIP_IPV6
+    if (type == MDNS_TYPE_AAAA && _ipv6_address_is_zero(addrs[0].u_addr.ip6)) {
+        return 0;
+    }
+#endif
+    if (!_mdns_if_is_dup(tcpip_if) || !_mdns_get_if_addr(_mdns_get_other_if(tcpip_if), type, &addrs[1])) {
+        return 1;
+    }
+    return 2;
+}
+
 static uint8_t _mdns_append_host_answer(uint8_t *packet, uint16_t *index, mdns_host_item_t *host,
                                         uint8_t address_type, bool flush, bool bye)
 {
@@ -1291,7 +1523,7 @@ static uint8_t _mdns_append_reverse_ptr_record(uint8_t *packet, uint16_t *index,
     uint16_t data_len_location = *index - 2; /* store the position of size (2=16bis) of this record */
     const char *str[2] = { _mdns_self_host.hostname, MDNS_DEFAULT_DOMAIN };
 
-    int part_length = _mdns_append_fqdn(packet, index, str, 2, MDNS_MAX_PACKET_SIZE);
+    int part_length = _mdns_append_fqdn(packet, index, str, 2);
     if (!part_length) {
         return 0;
     }
@@ -1310,9 +1542,10 @@ static uint8_t _mdns_append_service_ptr_answers(uint8_t *packet, uint16_t *index
         bool bye)
 {
     uint8_t appended_answers = 0;
+    mdns_service_names_t *names = _mdns_get_service_names(service);
 
-    if (_mdns_append_ptr_record(packet, index, _mdns_get_service_instance_name(service), service->service,
-                                service->proto, flush, bye) <= 0) {
+    if (!names || _mdns_append_ptr_name_record(packet, index, names->name + names->service_offset, names->name,
+            false, bye ? 0 : MDNS_ANSWER_PTR_TTL) <= 0) {
         return appended_answers;
     }
     appended_answers++;
@@ -1320,8 +1553,7 @@ static uint8_t _mdns_append_service_ptr_answers(uint8_t *packet, uint16_t *index
     mdns_subtype_t *subtype = service->subtype;
     while (subtype) {
         appended_answers +=
-            (_mdns_append_subtype_ptr_record(packet, index, _mdns_get_service_instance_name(service), subtype->subtype,
-                                             service->service, service->proto, flush, bye) > 0);
+            (_mdns_append_subtype_ptr_record(packet, index, names, subtype->subtype, flush, bye) > 0);
         subtype = subtype->next;
     }
 
@@ -1329,6 +1561,48 @@ static uint8_t _mdns_append_service_ptr_answers(uint8_t *packet, uint16_t *index
 }
 
 
+/**
+ * @brief  Append A or AAAA answer with the addresses of this host on the interface
+ *         (see _mdns_get_self_addrs()), noting where they are if the packet is kept for reuse
+ *
+ *  @return number of answers added to the packet
+ */
+static uint8_t _mdns_append_self_addr_answer(uint8_t *packet, uint16_t *index, mdns_out_answer_t *answer, mdns_if_t tcpip_if)
+{
+    esp_ip_addr_t addrs[2];
+    uint16_t offset[2] = { 0 };
+    uint8_t num = _mdns_get_self_addrs(tcpip_if, answer->type, addrs);
+    uint8_t i;
+
+    for (i = 0; i < num; i++) {
+        if (answer->type == MDNS_TYPE_A) {
+            if (_mdns_append_a_record(packet, index, _mdns_server->hostname, addrs[i].u_addr.ip4.addr, answer->flush, answer->bye) <= 0) {
+                break;
+            }
+            offset[i] = *index - sizeof(uint32_t);
+        }
+#if CONFIG_LWIP_IPV6
+        else {
+            if (_mdns_append_aaaa_record(packet, index, _mdns_server->hostname, (uint8_t *)addrs[i].u_addr.ip6.addr, answer->flush, answer->bye) <= 0) {
+                break;
+            }
+            offset[i] = *index - MDNS_ANSWER_AAAA_SIZE;
+        }
+#endif
+    }
+    if (s_tx_last.recording) {
+        if (s_tx_last.count == MDNS_TX_SELF_ADDR_ANSWERS) {
+            s_tx_last.overflow = true;
+        } else {
+            s_tx_last.addrs[s_tx_last.count].type = answer->type;
+            s_tx_last.addrs[s_tx_last.count].num = i;
+            memcpy(s_tx_last.addrs[s_tx_last.count].offset, offset, sizeof(offset));
+            s_tx_last.count++;
+        }
+    }
+    return i;
+}
+
 /**
  * @brief  Append answer to packet
  *
@@ -1357,27 +1631,7 @@ static uint8_t _mdns_append_answer(uint8_t *packet, uint16_t *index, mdns_out_an
         return _mdns_append_sdptr_record(packet, index, answer->service, answer->flush, answer->bye) > 0;
     } else if (answer->type == MDNS_TYPE_A) {
         if (answer->host == &_mdns_self_host) {
-            esp_netif_ip_info_t if_ip_info;
-            if (!_mdns_server->interfaces[tcpip_if].pcbs[MDNS_IP_PROTOCOL_V4].pcb && _mdns_server->interfaces[tcpip_if].pcbs[MDNS_IP_PROTOCOL_V4].state != PCB_DUP) {
-                return 0;
-            }
-            if (esp_netif_get_ip_info(_mdns_get_esp_netif(tcpip_if), &if_ip_info)) {
-                return 0;
-            }
-            if (_mdns_append_a_record(packet, index, _mdns_server->hostname, if_ip_info.ip.addr, answer->flush, answer->bye) <= 0) {
-                return 0;
-            }
-            if (!_mdns_if_is_dup(tcpip_if)) {
-                return 1;
-            }
-            mdns_if_t other_if = _mdns_get_other_if (tcpip_if);
-            if (esp_netif_get_ip_info(_mdns_get_esp_netif(other_if), &if_ip_info)) {
-                return 1;
-            }
-            if (_mdns_append_a_record(packet, index, _mdns_server->hostname, if_ip_info.ip.addr, answer->flush, answer->bye) > 0) {
-                return 2;
-            }
-            return 1;
+            return _mdns_append_self_addr_answer(packet, index, answer, tcpip_if);
         } else if (answer->host != NULL) {
             return _mdns_append_host_answer(packet, index, answer->host, ESP_IPADDR_TYPE_V4, answer->flush, answer->bye);
         }
@@ -1385,30 +1639,7 @@ static uint8_t _mdns_append_answer(uint8_t *packet, uint16_t *index, mdns_out_an
 #if CONFIG_LWIP_IPV6
     else if (answer->type == MDNS_TYPE_AAAA) {
         if (answer->host == &_mdns_self_host) {
-            struct esp_ip6_addr if_ip6;
-            if (!_mdns_server->interfaces[tcpip_if].pcbs[MDNS_IP_PROTOCOL_V6].pcb && _mdns_server->interfaces[tcpip_if].pcbs[MDNS_IP_PROTOCOL_V6].state != PCB_DUP) {
-                return 0;
-            }
-            if (esp_netif_get_ip6_linklocal(_mdns_get_esp_netif(tcpip_if), &if_ip6)) {
-                return 0;
-            }
-            if (_ipv6_address_is_zero(if_ip6)) {
-                return 0;
-            }
-            if (_mdns_append_aaaa_record(packet, index, _mdns_server->hostname, (uint8_t *)if_ip6.addr, answer->flush, answer->bye) <= 0) {
-                return 0;
-            }
-            if (!_mdns_if_is_dup(tcpip_if)) {
-                return 1;
-            }
-            mdns_if_t other_if = _mdns_get_other_if (tcpip_if);
-            if (esp_netif_get_ip6_linklocal(_mdns_get_esp_netif(other_if), &if_ip6)) {
-                return 1;
-            }
-            if (_mdns_append_aaaa_record(packet, index, _mdns_server->hostname, (uint8_t *)if_ip6.addr, answer->flush, answer->bye) > 0) {
-                return 2;
-            }
-            return 1;
+            return _mdns_append_self_addr_answer(packet, index, answer, tcpip_if);
         } else if (answer->host != NULL) {
             return _mdns_append_host_answer(packet, index, answer->host, ESP_IPADDR_TYPE_V6, answer->flush, answer->bye);
         }
@@ -1418,19 +1649,119 @@ static uint8_t _mdns_append_answer(uint8_t *packet, uint16_t *index, mdns_out_an
 }
 
 /**
- * @brief  sends a packet
+ * @brief  FNV-1a hash of data, continuing from hash
+ */
+static uint64_t _mdns_fingerprint_add(uint64_t hash, const void *data, size_t len)
+{
+    const uint8_t *bytes = (const uint8_t *)data;
+    for (size_t i = 0; i < len; i++) {
+        hash = (hash ^ bytes[i]) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+static uint64_t _mdns_fingerprint_str(uint64_t hash, const char *str)
+{
+    if (!str) {
+        return _mdns_fingerprint_add(hash, "\xff", 1);
+    }
+    return _mdns_fingerprint_add(hash, str, strlen(str) + 1);
+}
+
+static uint64_t _mdns_fingerprint_answers(uint64_t hash, mdns_out_answer_t *a)
+{
+    while (a) {
+        hash = _mdns_fingerprint_add(hash, &a->type, sizeof(a->type));
+        hash = _mdns_fingerprint_add(hash, &a->bye, sizeof(a->bye));
+        hash = _mdns_fingerprint_add(hash, &a->flush, sizeof(a->flush));
+        hash = _mdns_fingerprint_add(hash, &a->service, sizeof(a->service));
+        hash = _mdns_fingerprint_add(hash, &a->host, sizeof(a->host));
+        if (a->type == MDNS_TYPE_PTR && !a->service && !a->host) {
+            // only set (and read) for known answers of searches
+            hash = _mdns_fingerprint_str(hash, a->custom_instance);
+            hash = _mdns_fingerprint_str(hash, a->custom_service);
+            hash = _mdns_fingerprint_str(hash, a->custom_proto);
+        }
+        a = a->next;
+    }
+    return _mdns_fingerprint_add(hash, "\xfe", 1);
+}
+
+/**
+ * @brief  Fingerprint of everything a packet is built from, except the addresses of this host:
+ *         packets with the same fingerprint are the same on every interface apart from these
+ *
+ *  Services and hosts are taken by reference, changing them goes through _mdns_tx_last_forget()
+ */
+static uint64_t _mdns_tx_fingerprint(mdns_tx_packet_t *p)
+{
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    hash = _mdns_fingerprint_add(hash, &p->flags, sizeof(p->flags));
+    hash = _mdns_fingerprint_add(hash, &p->id, sizeof(p->id));
+    hash = _mdns_fingerprint_str(hash, _mdns_server->hostname);
+    hash = _mdns_fingerprint_str(hash, _mdns_server->instance);
+    for (mdns_out_question_t *q = p->questions; q; q = q->next) {
+        hash = _mdns_fingerprint_add(hash, &q->type, sizeof(q->type));
+        hash = _mdns_fingerprint_add(hash, &q->unicast, sizeof(q->unicast));
+        hash = _mdns_fingerprint_str(hash, q->host);
+        hash = _mdns_fingerprint_str(hash, q->service);
+        hash = _mdns_fingerprint_str(hash, q->proto);
+        hash = _mdns_fingerprint_str(hash, q->domain);
+    }
+    hash = _mdns_fingerprint_add(hash, "\xfe", 1);
+    hash = _mdns_fingerprint_answers(hash, p->answers);
+    hash = _mdns_fingerprint_answers(hash, p->servers);
+    hash = _mdns_fingerprint_answers(hash, p->additional);
+    return hash ? hash : 1;
+}
+
+/**
+ * @brief  Rewrites the addresses of this host in the last packet built for another interface
  *
+ * @return false if the interface has a different number of addresses, the packet must be built again
+ */
+static bool _mdns_tx_last_patch(uint8_t *packet, mdns_if_t tcpip_if)
+{
+    for (uint8_t i = 0; i < s_tx_last.count; i++) {
+        esp_ip_addr_t addrs[2];
+        if (_mdns_get_self_addrs(tcpip_if, s_tx_last.addrs[i].type, addrs) != s_tx_last.addrs[i].num) {
+            return false;
+        }
+        for (uint8_t j = 0; j < s_tx_last.addrs[i].num; j++) {
+            uint8_t *rdata = packet + s_tx_last.addrs[i].offset[j];
+            if (s_tx_last.addrs[i].type == MDNS_TYPE_A) {
+                // same byte order as _mdns_append_a_record()
+                uint32_t ip = addrs[j].u_addr.ip4.addr;
+                rdata[0] = ip & 0xFF;
+                rdata[1] = (ip >> 8) & 0xFF;
+                rdata[2] = (ip >> 16) & 0xFF;
+                rdata[3] = (ip >> 24) & 0xFF;
+            } else {
+                memcpy(rdata, addrs[j].u_addr.ip6.addr, MDNS_ANSWER_AAAA_SIZE);
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief  builds a packet
+ *
+ * @param  packet  buffer of MDNS_TX_BUFFER_LEN bytes
  * @param  p       the packet
+ *
+ * @return length of the packet
  */
-static void _mdns_dispatch_tx_packet(mdns_tx_packet_t *p)
+static uint16_t _mdns_build_tx_packet(uint8_t *packet, mdns_tx_packet_t *p)
 {
-    static uint8_t packet[MDNS_MAX_PACKET_SIZE];
     uint16_t index = MDNS_HEAD_LEN;
     memset(packet, 0, MDNS_HEAD_LEN);
     mdns_out_question_t *q;
     mdns_out_answer_t *a;
     uint8_t count;
 
+    _mdns_name_table_reset(packet);
+
     _mdns_set_u16(packet, MDNS_HEAD_FLAGS_OFFSET, p->flags);
     _mdns_set_u16(packet, MDNS_HEAD_ID_OFFSET, p->id);
 
@@ -1467,6 +1798,41 @@ static void _mdns_dispatch_tx_packet(mdns_tx_packet_t *p)
         a = a->next;
     }
     _mdns_set_u16(packet, MDNS_HEAD_ADDITIONAL_OFFSET, count);
+    return index;
+}
+
+/**
+ * @brief  sends a packet
+ *
+ *  Multicast packets usually go out on every interface and IP protocol with the same content
+ *  (announcements, probes, answers to shared questions), the last one built is reused
+ *  if only the addresses of this host differ.
+ *
+ * @param  p       the packet
+ */
+static void _mdns_dispatch_tx_packet(mdns_tx_packet_t *p)
+{
+    static uint8_t packet[MDNS_TX_BUFFER_LEN];    // names are encoded in place, see _mdns_append_fqdn()
+    uint16_t index;
+    uint64_t fingerprint = 0;
+
+    if (p->port == MDNS_SERVICE_PORT) {
+        fingerprint = _mdns_tx_fingerprint(p);
+    }
+    if (fingerprint && fingerprint == s_tx_last.fingerprint && _mdns_tx_last_patch(packet, p->tcpip_if)) {
+        index = s_tx_last.len;
+    } else {
+        s_tx_last.fingerprint = 0;
+        s_tx_last.count = 0;
+        s_tx_last.overflow = false;
+        s_tx_last.recording = true;
+        index = _mdns_build_tx_packet(packet, p);
+        s_tx_last.recording = false;
+        if (!s_tx_last.overflow) {
+            s_tx_last.fingerprint = fingerprint;
+            s_tx_last.len = index;
+        }
+    }
 
 #ifdef MDNS_ENABLE_DEBUG
     _mdns_dbg_printf("\nTX[%u][%u]: ", p->tcpip_if, p->ip_protocol);
@@ -1872,7 +2238,8 @@ static void _mdns_create_answer_from_parsed_packet(mdns_parsed_packet_t *parsed_
         }
         q = q->next;
     }
-    if (unicast || !send_flush) {
+    // Answer by unicast the "QU" questions, legacy queries and queries sent to us directly (RFC 6762, 5.4, 6.7 and 5.5)
+    if (unicast || !send_flush || !parsed_packet->multicast) {
         memcpy(&packet->dst, &parsed_packet->src, sizeof(esp_ip_addr_t));
         packet->port = parsed_packet->src_port;
     }
@@ -2459,56 +2826,143 @@ static void _mdns_restart_all_pcbs(void)
 
 
 /**
- * @brief  creates/allocates new text item list
+ * @brief  length of one TXT item in wire format ("key=value" or "key" with its length byte)
+ *
+ * @return the length or 0 if the item is too long
+ */
+static size_t _mdns_txt_item_len(const char *key, const char *value, size_t value_len)
+{
+    size_t len = strlen(key) + (value ? 1 + value_len : 0);
+    return len <= UINT8_MAX ? 1 + len : 0;
+}
+
+/**
+ * @brief  writes one TXT item in wire format
+ *
+ * @return pointer past the written item
+ */
+static uint8_t *_mdns_txt_put_item(uint8_t *dst, const char *key, const char *value, size_t value_len)
+{
+    size_t key_len = strlen(key);
+    *dst++ = key_len + (value ? 1 + value_len : 0);
+    memcpy(dst, key, key_len);
+    dst += key_len;
+    if (value) {
+        *dst++ = '=';
+        memcpy(dst, value, value_len);
+        dst += value_len;
+    }
+    return dst;
+}
+
+/**
+ * @brief  finds the item with the given key in TXT rdata
+ *
+ * @return offset of the item's length byte or -1 if not found
+ */
+static int _mdns_txt_find_item(const mdns_txt_rdata_t *txt, const char *key)
+{
+    size_t key_len = strlen(key);
+    for (size_t i = 0; txt && i < txt->len; i += 1 + txt->data[i]) {
+        const uint8_t *item = &txt->data[i + 1];
+        size_t item_len = txt->data[i];
+        if (item_len >= key_len && memcmp(item, key, key_len) == 0 &&
+                (item_len == key_len || item[key_len] == '=')) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief  creates TXT rdata, a single allocation, from the given items
+ *
  * @param  num_items     service number of txt items or 0
  * @param  txt           service txt items array or NULL
  *
- * @return pointer to the linked txt item list or NULL
+ * @return pointer to the TXT rdata or NULL (no items, an item longer than 255 bytes, more than MDNS_TXT_MAX_LEN bytes
+ *         or no memory)
  */
-static mdns_txt_linked_item_t *_mdns_allocate_txt(size_t num_items, mdns_txt_item_t txt[])
+static mdns_txt_rdata_t *_mdns_allocate_txt(size_t num_items, mdns_txt_item_t txt[])
 {
-    mdns_txt_linked_item_t *new_txt = NULL;
-    size_t i = 0;
-    if (num_items) {
-        for (i = 0; i < num_items; i++) {
-            mdns_txt_linked_item_t *new_item = (mdns_txt_linked_item_t *)malloc(sizeof(mdns_txt_linked_item_t));
-            if (!new_item) {
-                HOOK_MALLOC_FAILED;
-                break;
-            }
-            new_item->key = strdup(txt[i].key);
-            if (!new_item->key) {
-                free(new_item);
-                break;
-            }
-            new_item->value = strdup(txt[i].value);
-            if (!new_item->value) {
-                free((char *)new_item->key);
-                free(new_item);
-                break;
-            }
-            new_item->value_len = strlen(new_item->value);
-            new_item->next = new_txt;
-            new_txt = new_item;
+    size_t len = 0;
+    for (size_t i = 0; i < num_items; i++) {
+        size_t item_len = _mdns_txt_item_len(txt[i].key, txt[i].value, txt[i].value ? strlen(txt[i].value) : 0);
+        if (!item_len) {
+            return NULL;
         }
+        len += item_len;
+    }
+    if (!len || len > MDNS_TXT_MAX_LEN) {
+        return NULL;
+    }
+    mdns_txt_rdata_t *new_txt = (mdns_txt_rdata_t *)malloc(sizeof(mdns_txt_rdata_t) + len);
+    if (!new_txt) {
+        HOOK_MALLOC_FAILED;
+        return NULL;
+    }
+    new_txt->len = len;
+    uint8_t *dst = new_txt->data;
+    // Last item first, as the items were always announced in this order
+    for (size_t i = num_items; i > 0; i--) {
+        const char *value = txt[i - 1].value;
+        dst = _mdns_txt_put_item(dst, txt[i - 1].key, value, value ? strlen(value) : 0);
     }
     return new_txt;
 }
 
 /**
- * @brief Deallocate the txt linked list
- * @param txt pointer to the txt pointer to free, noop if txt==NULL
+ * @brief  sets one TXT item: replaces the value of an existing key or puts the new item first
+ *
+ * @return ESP_OK, ESP_ERR_INVALID_ARG if the item or the TXT data would be too long or ESP_ERR_NO_MEM
+ */
+static esp_err_t _mdns_txt_set_item(mdns_txt_rdata_t **txt, const char *key, const char *value, size_t value_len)
+{
+    mdns_txt_rdata_t *old_txt = *txt;
+    size_t old_len = old_txt ? old_txt->len : 0;
+    size_t item_len = _mdns_txt_item_len(key, value, value_len);
+    int pos = _mdns_txt_find_item(old_txt, key);
+    size_t replaced_len = pos < 0 ? 0 : 1 + old_txt->data[pos];
+    size_t len = old_len - replaced_len + item_len;
+    if (!item_len || len > MDNS_TXT_MAX_LEN) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    mdns_txt_rdata_t *new_txt = (mdns_txt_rdata_t *)malloc(sizeof(mdns_txt_rdata_t) + len);
+    if (!new_txt) {
+        HOOK_MALLOC_FAILED;
+        return ESP_ERR_NO_MEM;
+    }
+    new_txt->len = len;
+    size_t head = pos < 0 ? 0 : pos;
+    if (head) {
+        memcpy(new_txt->data, old_txt->data, head);
+    }
+    uint8_t *dst = _mdns_txt_put_item(new_txt->data + head, key, value, value_len);
+    if (old_len > head + replaced_len) {
+        memcpy(dst, old_txt->data + head + replaced_len, old_len - head - replaced_len);
+    }
+    free(old_txt);
+    *txt = new_txt;
+    return ESP_OK;
+}
+
+/**
+ * @brief  removes one TXT item in place, frees the rdata once empty
  */
-static void _mdns_free_linked_txt(mdns_txt_linked_item_t *txt)
+static void _mdns_txt_remove_item(mdns_txt_rdata_t **txt, const char *key)
 {
-    mdns_txt_linked_item_t *t;
-    while (txt) {
-        t = txt;
-        txt = txt->next;
-        free((char *)t->value);
-        free((char *)t->key);
-        free(t);
+    int pos = _mdns_txt_find_item(*txt, key);
+    if (pos < 0) {
+        return;
+    }
+    size_t item_len = 1 + (*txt)->data[pos];
+    (*txt)->len -= item_len;
+    if (!(*txt)->len) {
+        free(*txt);
+        *txt = NULL;
+        return;
     }
+    memmove((*txt)->data + pos, (*txt)->data + pos + item_len, (*txt)->len - pos);
 }
 
 /**
@@ -2527,13 +2981,21 @@ static mdns_service_t *_mdns_create_service(const char *service, const char *pro
         uint16_t port, const char *instance, size_t num_items,
         mdns_txt_item_t txt[])
 {
-    mdns_service_t *s = (mdns_service_t *)calloc(1, sizeof(mdns_service_t));
+    // The service and proto never change, so they share the allocation of the service
+    size_t service_len = strnlen(service, MDNS_NAME_BUF_LEN - 1);
+    size_t proto_len = strnlen(proto, MDNS_NAME_BUF_LEN - 1);
+    mdns_service_t *s = (mdns_service_t *)calloc(1, sizeof(mdns_service_t) + service_len + 1 + proto_len + 1);
     if (!s) {
         HOOK_MALLOC_FAILED;
         return NULL;
     }
+    char *strings = (char *)(s + 1);
+    memcpy(strings, service, service_len);
+    s->service = strings;
+    memcpy(strings + service_len + 1, proto, proto_len);
+    s->proto = strings + service_len + 1;
 
-    mdns_txt_linked_item_t *new_txt = _mdns_allocate_txt(num_items, txt);
+    mdns_txt_rdata_t *new_txt = _mdns_allocate_txt(num_items, txt);
     if (num_items && new_txt == NULL) {
         goto fail;
     }
@@ -2553,23 +3015,11 @@ static mdns_service_t *_mdns_create_service(const char *service, const char *pro
     } else {
         s->hostname = NULL;
     }
-
-    s->service = strndup(service, MDNS_NAME_BUF_LEN - 1);
-    if (!s->service) {
-        goto fail;
-    }
-
-    s->proto = strndup(proto, MDNS_NAME_BUF_LEN - 1);
-    if (!s->proto) {
-        goto fail;
-    }
     return s;
 
 fail:
-    _mdns_free_linked_txt(s->txt);
+    free(s->txt);
     free((char *)s->instance);
-    free((char *)s->service);
-    free((char *)s->proto);
     free((char *)s->hostname);
     free(s);
 
@@ -2696,19 +3146,11 @@ static void _mdns_free_service(mdns_service_t *service)
         return;
     }
     free((char *)service->instance);
-    free((char *)service->service);
-    free((char *)service->proto);
     free((char *)service->hostname);
-    while (service->txt) {
-        mdns_txt_linked_item_t *s = service->txt;
-        service->txt = service->txt->next;
-        free((char *)s->key);
-        free((char *)s->value);
-        free(s);
-    }
+    free(service->txt);
+    free(service->names);
     while (service->subtype) {
         mdns_subtype_t *next = service->subtype->next;
-        free((char *)service->subtype->subtype);
         free(service->subtype);
         service->subtype = next;
     }
@@ -2782,7 +3224,6 @@ static int _mdns_check_srv_collision(mdns_service_t *service, uint16_t priority,
  */
 static int _mdns_check_txt_collision(mdns_service_t *service, const uint8_t *data, size_t len)
 {
-    size_t data_len = 0;
     if (len == 1 && service->txt) {
         return -1;//we win
     } else if (len > 1 && !service->txt) {
@@ -2791,28 +3232,14 @@ static int _mdns_check_txt_collision(mdns_service_t *service, const uint8_t *dat
         return 0;//same
     }
 
-    mdns_txt_linked_item_t *txt = service->txt;
-    while (txt) {
-        data_len += 1 /* record-len */ + strlen(txt->key) + txt->value_len + (txt->value ? 1 : 0 /* "=" */);
-        txt = txt->next;
-    }
-
+    size_t data_len = service->txt->len;
     if (len > data_len) {
         return 1;//they win
     } else if (len < data_len) {
         return -1;//we win
     }
 
-    uint8_t ours[len];
-    uint16_t index = 0;
-
-    txt = service->txt;
-    while (txt) {
-        append_one_txt_record_entry(ours, &index, txt);
-        txt = txt->next;
-    }
-
-    int ret = memcmp(ours, data, len);
+    int ret = memcmp(service->txt->data, data, len);
     if (ret > 0) {
         return -1;//we win
     } else if (ret < 0) {
@@ -3186,6 +3613,7 @@ static const uint8_t *_mdns_parse_fqdn(const uint8_t *packet, const uint8_t *sta
     name->proto[0] = 0;
     name->domain[0] = 0;
     name->invalid = false;
+    name->wire_len = 0;
 
     static char buf[MDNS_NAME_BUF_LEN];
 
@@ -3427,6 +3855,23 @@ static esp_err_t _mdns_strdup_check(char **out, char *in)
     return ESP_OK;
 }
 
+/**
+ * @brief  Check if the packet came from the link of the interface it arrived on
+ */
+static bool _mdns_packet_is_from_local_link(mdns_rx_packet_t *packet)
+{
+    if (packet->src.type == ESP_IPADDR_TYPE_V4) {
+        esp_netif_ip_info_t if_ip_info = { 0 };
+        if (esp_netif_get_ip_info(_mdns_get_esp_netif(packet->tcpip_if), &if_ip_info) != ESP_OK) {
+            return false;
+        }
+        return (packet->src.u_addr.ip4.addr & if_ip_info.netmask.addr) == (if_ip_info.ip.addr & if_ip_info.netmask.addr);
+    }
+    // IPv6: only link-local sources (fe80::/10)
+    const uint8_t *src = (const uint8_t *)packet->src.u_addr.ip6.addr;
+    return src[0] == 0xfe && (src[1] & 0xc0) == 0x80;
+}
+
 /**
  * @brief  main packet parser
  *
@@ -3476,6 +3921,11 @@ void mdns_parse_packet(mdns_rx_packet_t *packet)
         return;
     }
 
+    // Unicast packets are accepted only from the local link (RFC 6762, 11)
+    if (!packet->multicast && !_mdns_packet_is_from_local_link(packet)) {
+        return;
+    }
+
     mdns_parsed_packet_t *parsed_packet = (mdns_parsed_packet_t *)malloc(sizeof(mdns_parsed_packet_t));
     if (!parsed_packet) {
         HOOK_MALLOC_FAILED;
@@ -3648,7 +4098,7 @@ void mdns_parse_packet(mdns_rx_packet_t *packet)
                     //skip this record
                     continue;
                 }
-                search_result = _mdns_search_find_from(_mdns_server->search_once, name, type, packet->tcpip_if, packet->ip_protocol);
+                search_result = _mdns_search_find_all(name, type, packet->tcpip_if, packet->ip_protocol);
             }
 
             if (type == MDNS_TYPE_PTR) {
@@ -3656,8 +4106,10 @@ void mdns_parse_packet(mdns_rx_packet_t *packet)
                     continue;//error
                 }
                 if (search_result) {
-                    _mdns_search_result_add_ptr(search_result, name->host, name->service, name->proto,
-                                                packet->tcpip_if, packet->ip_protocol, ttl);
+                    for (mdns_search_once_t *s = search_result; s; s = s->match_next) {
+                        _mdns_search_result_add_ptr(s, name->host, name->service, name->proto,
+                                                    packet->tcpip_if, packet->ip_protocol, ttl);
+                    }
                 } else if ((discovery || ours) && !name->sub && _mdns_name_is_ours(name)) {
                     if (discovery && (service = _mdns_get_service_item(name->service, name->proto, NULL))) {
                         _mdns_remove_parsed_question(parsed_packet, MDNS_TYPE_SDPTR, service);
@@ -3671,23 +4123,10 @@ void mdns_parse_packet(mdns_rx_packet_t *packet)
                     }
                 }
             } else if (type == MDNS_TYPE_SRV) {
-                mdns_result_t *result = NULL;
-                if (search_result && search_result->type == MDNS_TYPE_PTR) {
-                    result = search_result->result;
-                    while (result) {
-                        if (_mdns_get_esp_netif(packet->tcpip_if) == result->esp_netif
-                                && packet->ip_protocol == result->ip_protocol
-                                && result->instance_name && !strcmp(name->host, result->instance_name)) {
-                            break;
-                        }
-                        result = result->next;
-                    }
-                    if (!result) {
-                        result = _mdns_search_result_add_ptr(search_result, name->host, name->service, name->proto,
-                                                             packet->tcpip_if, packet->ip_protocol, ttl);
-                        if (!result) {
-                            continue;//error
-                        }
+                // the instance found by PTR searches, before the name is replaced by the SRV target
+                for (mdns_search_once_t *s = search_result; s; s = s->match_next) {
+                    if (s->type == MDNS_TYPE_PTR) {
+                        s->match_result = _mdns_search_result_find_ptr(s, name, packet->tcpip_if, packet->ip_protocol, ttl);
                     }
                 }
                 bool is_selfhosted = _mdns_name_is_selfhosted(name);
@@ -3702,13 +4141,16 @@ void mdns_parse_packet(mdns_rx_packet_t *packet)
                 uint16_t port = _mdns_read_u16(data_ptr, MDNS_SRV_PORT_OFFSET);
 
                 if (search_result) {
-                    if (search_result->type == MDNS_TYPE_PTR) {
-                        if (!result->hostname) { // assign host/port for this entry only if not previously set
-                            result->port = port;
-                            result->hostname = strdup(name->host);
+                    for (mdns_search_once_t *s = search_result; s; s = s->match_next) {
+                        if (s->type == MDNS_TYPE_PTR) {
+                            mdns_result_t *result = s->match_result;
+                            if (result && !result->hostname) { // assign host/port for this entry only if not previously set
+                                result->port = port;
+                                result->hostname = strdup(name->host);
+                            }
+                        } else {
+                            _mdns_search_result_add_srv(s, name->host, port, packet->tcpip_if, packet->ip_protocol, ttl);
                         }
-                    } else {
-                        _mdns_search_result_add_srv(search_result, name->host, port, packet->tcpip_if, packet->ip_protocol, ttl);
                     }
                 } else if (ours) {
                     if (parsed_packet->questions && !parsed_packet->probe) {
@@ -3740,6 +4182,7 @@ void mdns_parse_packet(mdns_rx_packet_t *packet)
                                     if (new_instance) {
                                         free((char *)service->service->instance);
                                         service->service->instance = new_instance;
+                                        _mdns_invalidate_service_names(service->service);
                                     }
                                     _mdns_probe_all_pcbs(&service, 1, false, false);
                                 } else if (!_str_null_or_empty(_mdns_server->instance)) {
@@ -3747,6 +4190,7 @@ void mdns_parse_packet(mdns_rx_packet_t *packet)
                                     if (new_instance) {
                                         free((char *)_mdns_server->instance);
                                         _mdns_server->instance = new_instance;
+                                        _mdns_invalidate_service_names(NULL);
                                     }
                                     _mdns_restart_all_pcbs_no_instance();
                                 } else {
@@ -3769,30 +4213,15 @@ void mdns_parse_packet(mdns_rx_packet_t *packet)
                     }
                 }
             } else if (type == MDNS_TYPE_TXT) {
-                if (search_result) {
+                // every search gets its own copy of the items, TXT data longer than ours can be is not kept
+                for (mdns_search_once_t *s = search_result; s && data_len <= MDNS_TXT_MAX_LEN; s = s->match_next) {
                     mdns_txt_item_t *txt = NULL;
                     uint8_t *txt_value_len = NULL;
                     size_t txt_count = 0;
 
-                    mdns_result_t *result = NULL;
-                    if (search_result->type == MDNS_TYPE_PTR) {
-                        result = search_result->result;
-                        while (result) {
-                            if (_mdns_get_esp_netif(packet->tcpip_if) == result->esp_netif
-                                    && packet->ip_protocol == result->ip_protocol
-                                    && result->instance_name && !strcmp(name->host, result->instance_name)) {
-                                break;
-                            }
-                            result = result->next;
-                        }
-                        if (!result) {
-                            result = _mdns_search_result_add_ptr(search_result, name->host, name->service, name->proto,
-                                                                 packet->tcpip_if, packet->ip_protocol, ttl);
-                            if (!result) {
-                                continue;//error
-                            }
-                        }
-                        if (!result->txt) {
+                    if (s->type == MDNS_TYPE_PTR) {
+                        mdns_result_t *result = _mdns_search_result_find_ptr(s, name, packet->tcpip_if, packet->ip_protocol, ttl);
+                        if (result && !result->txt) {
                             _mdns_result_txt_create(data_ptr, data_len, &txt, &txt_value_len, &txt_count);
                             if (txt_count) {
                                 result->txt = txt;
@@ -3803,10 +4232,11 @@ void mdns_parse_packet(mdns_rx_packet_t *packet)
                     } else {
                         _mdns_result_txt_create(data_ptr, data_len, &txt, &txt_value_len, &txt_count);
                         if (txt_count) {
-                            _mdns_search_result_add_txt(search_result, txt, txt_value_len, txt_count, packet->tcpip_if, packet->ip_protocol, ttl);
+                            _mdns_search_result_add_txt(s, txt, txt_value_len, txt_count, packet->tcpip_if, packet->ip_protocol, ttl);
                         }
                     }
-                } else if (ours) {
+                }
+                if (!search_result && ours) {
                     if (parsed_packet->questions && !parsed_packet->probe && service) {
                         _mdns_remove_parsed_question(parsed_packet, type, service);
                         continue;
@@ -3838,10 +4268,9 @@ void mdns_parse_packet(mdns_rx_packet_t *packet)
                 ip6.type = ESP_IPADDR_TYPE_V6;
                 memcpy(ip6.u_addr.ip6.addr, data_ptr, MDNS_ANSWER_AAAA_SIZE);
                 if (search_result) {
-                    //check for more applicable searches (PTR & A/AAAA at the same time)
-                    while (search_result) {
-                        _mdns_search_result_add_ip(search_result, name->host, &ip6, packet->tcpip_if, packet->ip_protocol, ttl);
-                        search_result = _mdns_search_find_from(search_result->next, name, type, packet->tcpip_if, packet->ip_protocol);
+                    //every applicable search (PTR & A/AAAA at the same time)
+                    for (mdns_search_once_t *s = search_result; s; s = s->match_next) {
+                        _mdns_search_result_add_ip(s, name->host, &ip6, packet->tcpip_if, packet->ip_protocol, ttl);
                     }
                 } else if (ours) {
                     if (parsed_packet->questions && !parsed_packet->probe) {
@@ -3891,10 +4320,9 @@ void mdns_parse_packet(mdns_rx_packet_t *packet)
                 ip.type = ESP_IPADDR_TYPE_V4;
                 memcpy(&(ip.u_addr.ip4.addr), data_ptr, 4);
                 if (search_result) {
-                    //check for more applicable searches (PTR & A/AAAA at the same time)
-                    while (search_result) {
-                        _mdns_search_result_add_ip(search_result, name->host, &ip, packet->tcpip_if, packet->ip_protocol, ttl);
-                        search_result = _mdns_search_find_from(search_result->next, name, type, packet->tcpip_if, packet->ip_protocol);
+                    //every applicable search (PTR & A/AAAA at the same time)
+                    for (mdns_search_once_t *s = search_result; s; s = s->match_next) {
+                        _mdns_search_result_add_ip(s, name->host, &ip, packet->tcpip_if, packet->ip_protocol, ttl);
                     }
                 } else if (ours) {
                     if (parsed_packet->questions && !parsed_packet->probe) {
@@ -4252,6 +4680,43 @@ static mdns_search_once_t *_mdns_search_init(const char *name, const char *servi
     return search;
 }
 
+/**
+ * @brief  Searches for a host are found by the name of A/AAAA records, the others by the
+ *         service and proto of PTR/SRV/TXT records
+ */
+static inline bool _mdns_search_is_host(mdns_search_once_t *search)
+{
+    return search->type == MDNS_TYPE_A || search->type == MDNS_TYPE_AAAA
+           || (search->type == MDNS_TYPE_ANY && search->service == NULL);
+}
+
+/**
+ * @brief  Bucket of the search index for a name, case insensitive
+ */
+static uint8_t _mdns_search_key(const char *first, const char *second)
+{
+    uint32_t hash = 2166136261U;
+    const char *str[2] = { first, second };
+    for (int i = 0; i < 2; i++) {
+        for (const char *c = str[i]; c && *c; c++) {
+            hash = (hash ^ tolower((unsigned char)*c)) * 16777619U;
+        }
+        hash = (hash ^ '.') * 16777619U;
+    }
+    return hash % MDNS_SEARCH_INDEX_LEN;
+}
+
+/**
+ * @brief  Check if two searches ask the same question
+ */
+static bool _mdns_search_same_question(mdns_search_once_t *a, mdns_search_once_t *b)
+{
+    return a->type == b->type && a->unicast == b->unicast
+           && (a->instance == NULL) == (b->instance == NULL) && (!a->instance || !strcasecmp(a->instance, b->instance))
+           && (a->service == NULL) == (b->service == NULL) && (!a->service || !strcasecmp(a->service, b->service))
+           && (a->proto == NULL) == (b->proto == NULL) && (!a->proto || !strcasecmp(a->proto, b->proto));
+}
+
 /**
  * @brief  Mark search as finished and remove it from search chain
  */
@@ -4259,6 +4724,18 @@ static void _mdns_search_finish(mdns_search_once_t *search)
 {
     search->state = SEARCH_OFF;
     queueDetach(mdns_search_once_t, _mdns_server->search_once, search);
+    for (mdns_search_once_t **s = &_mdns_server->search_index[search->key]; *s; s = &(*s)->index_next) {
+        if (*s == search) {
+            *s = search->index_next;
+            break;
+        }
+    }
+    for (mdns_search_once_t **s = &_mdns_server->search_resolve; *s; s = &(*s)->resolve_next) {
+        if (*s == search) {
+            *s = search->resolve_next;
+            break;
+        }
+    }
     if (search->notifier) {
         search->notifier(search);
     }
@@ -4266,12 +4743,23 @@ static void _mdns_search_finish(mdns_search_once_t *search)
 }
 
 /**
- * @brief  Add new search to the search chain
+ * @brief  Add new search to the search chain and to the index used to route received records
  */
 static void _mdns_search_add(mdns_search_once_t *search)
 {
     search->next = _mdns_server->search_once;
     _mdns_server->search_once = search;
+    if (_mdns_search_is_host(search)) {
+        search->key = _mdns_search_key(search->instance, NULL);
+    } else {
+        search->key = _mdns_search_key(search->service, search->proto);
+    }
+    search->index_next = _mdns_server->search_index[search->key];
+    _mdns_server->search_index[search->key] = search;
+    if (search->type == MDNS_TYPE_PTR || search->type == MDNS_TYPE_SRV) {
+        search->resolve_next = _mdns_server->search_resolve;
+        _mdns_server->search_resolve = search;
+    }
 }
 
 /**
@@ -4440,6 +4928,24 @@ static mdns_result_t *_mdns_search_result_add_ptr(mdns_search_once_t *search, co
     return NULL;
 }
 
+/**
+ * @brief  Called from parser to find the PTR search result of a SRV or TXT record instance, adds it if missing
+ */
+static mdns_result_t *_mdns_search_result_find_ptr(mdns_search_once_t *search, mdns_name_t *name,
+        mdns_if_t tcpip_if, mdns_ip_protocol_t ip_protocol, uint32_t ttl)
+{
+    mdns_result_t *result = search->result;
+    while (result) {
+        if (_mdns_get_esp_netif(tcpip_if) == result->esp_netif
+                && ip_protocol == result->ip_protocol
+                && result->instance_name && !strcmp(name->host, result->instance_name)) {
+            return result;
+        }
+        result = result->next;
+    }
+    return _mdns_search_result_add_ptr(search, name->host, name->service, name->proto, tcpip_if, ip_protocol, ttl);
+}
+
 /**
  * @brief  Called from parser to add SRV data to search result
  */
@@ -4520,8 +5026,8 @@ static void _mdns_search_result_add_txt(mdns_search_once_t *search, mdns_txt_ite
         r->next = search->result;
         search->result = r;
         search->num_results++;
+        return;
     }
-    return;
 
 free_txt:
     for (size_t i = 0; i < txt_count; i++) {
@@ -4529,91 +5035,120 @@ free_txt:
         free((char *)(txt[i].value));
     }
     free(txt);
+    free(txt_value_len);
 }
 
 /**
- * @brief  Called from packet parser to find matching running search
+ * @brief  Check if a received record answers a running search
  */
-static mdns_search_once_t *_mdns_search_find_from(mdns_search_once_t *s, mdns_name_t *name, uint16_t type, mdns_if_t tcpip_if, mdns_ip_protocol_t ip_protocol)
+static bool _mdns_search_matches(mdns_search_once_t *s, mdns_name_t *name, uint16_t type, mdns_if_t tcpip_if, mdns_ip_protocol_t ip_protocol)
 {
     mdns_result_t *r = NULL;
-    while (s) {
-        if (s->state == SEARCH_OFF) {
-            s = s->next;
-            continue;
-        }
+    if (s->state == SEARCH_OFF) {
+        return false;
+    }
 
-        if (type == MDNS_TYPE_A || type == MDNS_TYPE_AAAA) {
-            if ((s->type == MDNS_TYPE_ANY && s->service != NULL)
-                    || (s->type != MDNS_TYPE_ANY && s->type != type && s->type != MDNS_TYPE_PTR && s->type != MDNS_TYPE_SRV)) {
-                s = s->next;
-                continue;
-            }
-            if (s->type != MDNS_TYPE_PTR && s->type != MDNS_TYPE_SRV) {
-                if (!strcasecmp(name->host, s->instance)) {
-                    return s;
-                }
-                s = s->next;
-                continue;
-            }
-            r = s->result;
-            while (r) {
-                if (r->esp_netif == _mdns_get_esp_netif(tcpip_if) && r->ip_protocol == ip_protocol && !_str_null_or_empty(r->hostname) && !strcasecmp(name->host, r->hostname)) {
-                    return s;
-                }
-                r = r->next;
-            }
-            s = s->next;
-            continue;
+    if (type == MDNS_TYPE_A || type == MDNS_TYPE_AAAA) {
+        if ((s->type == MDNS_TYPE_ANY && s->service != NULL)
+                || (s->type != MDNS_TYPE_ANY && s->type != type && s->type != MDNS_TYPE_PTR && s->type != MDNS_TYPE_SRV)) {
+            return false;
         }
-
-        if (type == MDNS_TYPE_SRV || type == MDNS_TYPE_TXT) {
-            if ((s->type == MDNS_TYPE_ANY && s->service == NULL)
-                    || (s->type != MDNS_TYPE_ANY && s->type != type && s->type != MDNS_TYPE_PTR)) {
-                s = s->next;
-                continue;
-            }
-            if (strcasecmp(name->service, s->service)
-                    || strcasecmp(name->proto, s->proto)) {
-                s = s->next;
-                continue;
-            }
-            if (s->type != MDNS_TYPE_PTR) {
-                if (s->instance && strcasecmp(name->host, s->instance) == 0) {
-                    return s;
-                }
-                s = s->next;
-                continue;
+        if (s->type != MDNS_TYPE_PTR && s->type != MDNS_TYPE_SRV) {
+            return !strcasecmp(name->host, s->instance);
+        }
+        r = s->result;
+        while (r) {
+            if (r->esp_netif == _mdns_get_esp_netif(tcpip_if) && r->ip_protocol == ip_protocol && !_str_null_or_empty(r->hostname) && !strcasecmp(name->host, r->hostname)) {
+                return true;
             }
-            return s;
+            r = r->next;
         }
+        return false;
+    }
 
-        if (type == MDNS_TYPE_PTR && type == s->type && !strcasecmp(name->service, s->service) && !strcasecmp(name->proto, s->proto)) {
-            return s;
+    if (type == MDNS_TYPE_SRV || type == MDNS_TYPE_TXT) {
+        if ((s->type == MDNS_TYPE_ANY && s->service == NULL)
+                || (s->type != MDNS_TYPE_ANY && s->type != type && s->type != MDNS_TYPE_PTR)) {
+            return false;
         }
-
-        s = s->next;
+        if (strcasecmp(name->service, s->service)
+                || strcasecmp(name->proto, s->proto)) {
+            return false;
+        }
+        if (s->type != MDNS_TYPE_PTR) {
+            return s->instance && strcasecmp(name->host, s->instance) == 0;
+        }
+        return true;
     }
 
-    return NULL;
+    return type == MDNS_TYPE_PTR && type == s->type && !strcasecmp(name->service, s->service) && !strcasecmp(name->proto, s->proto);
 }
 
 /**
- * @brief  Create search packet for particular interface
+ * @brief  Called from packet parser to find all running searches a record answers
+ *
+ *  Searches asking the same question all get the record. Only the searches in the bucket of the
+ *  record name are checked, and for addresses, the PTR and SRV searches looking for their hosts.
+ *
+ * @return the first search, the others are chained through match_next
  */
-static mdns_tx_packet_t *_mdns_create_search_packet(mdns_search_once_t *search, mdns_if_t tcpip_if, mdns_ip_protocol_t ip_protocol)
+static mdns_search_once_t *_mdns_search_find_all(mdns_name_t *name, uint16_t type, mdns_if_t tcpip_if, mdns_ip_protocol_t ip_protocol)
 {
-    mdns_result_t *r = NULL;
-    mdns_tx_packet_t *packet = _mdns_alloc_packet_default(tcpip_if, ip_protocol);
-    if (!packet) {
-        return NULL;
+    mdns_search_once_t *matches = NULL;
+    mdns_search_once_t **tail = &matches;
+    mdns_search_once_t *s;
+    bool address = (type == MDNS_TYPE_A || type == MDNS_TYPE_AAAA);
+
+    s = _mdns_server->search_index[address ? _mdns_search_key(name->host, NULL) : _mdns_search_key(name->service, name->proto)];
+    for (; s; s = s->index_next) {
+        // PTR and SRV searches in the bucket by chance are checked below, with the other ones
+        if (address && !_mdns_search_is_host(s)) {
+            continue;
+        }
+        if (_mdns_search_matches(s, name, type, tcpip_if, ip_protocol)) {
+            *tail = s;
+            tail = &s->match_next;
+        }
+    }
+    if (address) {
+        for (s = _mdns_server->search_resolve; s; s = s->resolve_next) {
+            if (_mdns_search_matches(s, name, type, tcpip_if, ip_protocol)) {
+                *tail = s;
+                tail = &s->match_next;
+            }
+        }
+    }
+    *tail = NULL;
+    return matches;
+}
+
+/**
+ * @brief  Check if a search has a result as complete as the one given, to use it as a known answer
+ */
+static bool _mdns_search_knows_result(mdns_search_once_t *search, mdns_result_t *result)
+{
+    for (mdns_result_t *r = search->result; r; r = r->next) {
+        if (r->esp_netif == result->esp_netif && r->ip_protocol == result->ip_protocol
+                && r->instance_name && r->hostname && r->addr && !strcasecmp(r->instance_name, result->instance_name)) {
+            return true;
+        }
     }
+    return false;
+}
 
+/**
+ * @brief  Add the question of a search to a search packet, with its results as known answers
+ *
+ *  Other searches with the same question wait for the answers to this one, so only the results
+ *  known to all of them are given as known answers
+ */
+static bool _mdns_search_packet_add(mdns_tx_packet_t *packet, mdns_search_once_t *search)
+{
+    mdns_result_t *r = NULL;
     mdns_out_question_t *q = (mdns_out_question_t *)malloc(sizeof(mdns_out_question_t));
     if (!q) {
         HOOK_MALLOC_FAILED;
-        _mdns_free_tx_packet(packet);
-        return NULL;
+        return false;
     }
     q->next = NULL;
     q->unicast = search->unicast;
@@ -4629,18 +5164,28 @@ static mdns_tx_packet_t *_mdns_create_search_packet(mdns_search_once_t *search,
         r = search->result;
         while (r) {
             //full record on the same interface is available
-            if (r->esp_netif != _mdns_get_esp_netif(tcpip_if) || r->ip_protocol != ip_protocol || r->instance_name == NULL || r->hostname == NULL || r->addr == NULL) {
+            if (r->esp_netif != _mdns_get_esp_netif(packet->tcpip_if) || r->ip_protocol != packet->ip_protocol || r->instance_name == NULL || r->hostname == NULL || r->addr == NULL) {
+                r = r->next;
+                continue;
+            }
+            mdns_search_once_t *other = _mdns_server->search_once;
+            while (other && (other == search || other->state == SEARCH_OFF || !_mdns_search_same_question(other, search)
+                             || _mdns_search_knows_result(other, r))) {
+                other = other->next;
+            }
+            if (other) {
+                // unknown to another search asking the same
                 r = r->next;
                 continue;
             }
             mdns_out_answer_t *a = (mdns_out_answer_t *)malloc(sizeof(mdns_out_answer_t));
             if (!a) {
                 HOOK_MALLOC_FAILED;
-                _mdns_free_tx_packet(packet);
-                return NULL;
+                return false;
             }
             a->type = MDNS_TYPE_PTR;
             a->service = NULL;
+            a->host = NULL;
             a->custom_instance = r->instance_name;
             a->custom_service = search->service;
             a->custom_proto = search->proto;
@@ -4651,18 +5196,36 @@ static mdns_tx_packet_t *_mdns_create_search_packet(mdns_search_once_t *search,
             r = r->next;
         }
     }
+    return true;
+}
+
+/**
+ * @brief  Create search packet for particular interface, asking the questions of all searches due
+ */
+static mdns_tx_packet_t *_mdns_create_search_packet(mdns_if_t tcpip_if, mdns_ip_protocol_t ip_protocol)
+{
+    mdns_tx_packet_t *packet = _mdns_alloc_packet_default(tcpip_if, ip_protocol);
+    if (!packet) {
+        return NULL;
+    }
 
+    for (mdns_search_once_t *search = _mdns_server->search_once; search; search = search->next) {
+        if (search->send_pending && search->state != SEARCH_OFF && !_mdns_search_packet_add(packet, search)) {
+            _mdns_free_tx_packet(packet);
+            return NULL;
+        }
+    }
     return packet;
 }
 
 /**
  * @brief  Send search packet to particular interface
  */
-static void _mdns_search_send_pcb(mdns_search_once_t *search, mdns_if_t tcpip_if, mdns_ip_protocol_t ip_protocol)
+static void _mdns_search_send_pcb(mdns_if_t tcpip_if, mdns_ip_protocol_t ip_protocol)
 {
     mdns_tx_packet_t *packet = NULL;
     if (_mdns_server->interfaces[tcpip_if].pcbs[ip_protocol].pcb && _mdns_server->interfaces[tcpip_if].pcbs[ip_protocol].state > PCB_INIT) {
-        packet = _mdns_create_search_packet(search, tcpip_if, ip_protocol);
+        packet = _mdns_create_search_packet(tcpip_if, ip_protocol);
         if (!packet) {
             return;
         }
@@ -4672,32 +5235,29 @@ static void _mdns_search_send_pcb(mdns_search_once_t *search, mdns_if_t tcpip_if
 }
 
 /**
- * @brief  Send search packet to all available interfaces
+ * @brief  Send the searches due (see _mdns_search_run()) to all available interfaces, one packet
+ *         with all their questions
  */
-static void _mdns_search_send(mdns_search_once_t *search)
+static void _mdns_search_send(void)
 {
-    mdns_search_once_t *queue = _mdns_server->search_once;
-    bool found = false;
-    // looking for this search in active searches
-    while (queue) {
-        if (queue == search) {
-            found = true;
-            break;
-        }
-        queue = queue->next;
+    mdns_search_once_t *search = _mdns_server->search_once;
+    while (search && !(search->send_pending && search->state != SEARCH_OFF)) {
+        search = search->next;
     }
-
-    if (!found) {
-        // no longer active -> skip sending this search
+    if (!search) {
+        // no longer active -> skip sending
         return;
     }
 
     uint8_t i, j;
     for (i = 0; i < MDNS_MAX_INTERFACES; i++) {
         for (j = 0; j < MDNS_IP_PROTOCOL_MAX; j++) {
-            _mdns_search_send_pcb(search, (mdns_if_t)i, (mdns_ip_protocol_t)j);
+            _mdns_search_send_pcb((mdns_if_t)i, (mdns_ip_protocol_t)j);
         }
     }
+    for (search = _mdns_server->search_once; search; search = search->next) {
+        search->send_pending = false;
+    }
 }
 
 static void _mdns_tx_handle_packet(mdns_tx_packet_t *p)
@@ -4769,6 +5329,8 @@ static void _mdns_remap_self_service_hostname(const char *old_hostname, const ch
         }
         service = service->next;
     }
+    // The default instance name and SRV target may follow the hostname
+    _mdns_invalidate_service_names(NULL);
 }
 
 /**
@@ -4791,7 +5353,7 @@ static void _mdns_free_action(mdns_action_t *action)
         free(action->data.srv_instance.instance);
         break;
     case ACTION_SERVICE_TXT_REPLACE:
-        _mdns_free_linked_txt(action->data.srv_txt_replace.txt);
+        free(action->data.srv_txt_replace.txt);
         break;
     case ACTION_SERVICE_TXT_SET:
         free(action->data.srv_txt_set.key);
@@ -4805,8 +5367,6 @@ static void _mdns_free_action(mdns_action_t *action)
         break;
     case ACTION_SEARCH_ADD:
     //fallthrough
-    case ACTION_SEARCH_SEND:
-    //fallthrough
     case ACTION_SEARCH_END:
         _mdns_search_free(action->data.search_add.search);
         break;
@@ -4838,9 +5398,7 @@ static void _mdns_execute_action(mdns_action_t *action)
     mdns_service_t *service;
     char *key;
     char *value;
-    char *subtype;
     mdns_subtype_t *subtype_item;
-    mdns_txt_linked_item_t *txt, * t;
 
     switch (action->type) {
     case ACTION_SYSTEM_EVENT:
@@ -4859,6 +5417,7 @@ static void _mdns_execute_action(mdns_action_t *action)
         _mdns_send_bye_all_pcbs_no_instance(false);
         free((char *)_mdns_server->instance);
         _mdns_server->instance = action->data.instance;
+        _mdns_invalidate_service_names(NULL);
         _mdns_restart_all_pcbs_no_instance();
 
         break;
@@ -4873,6 +5432,7 @@ static void _mdns_execute_action(mdns_action_t *action)
             free((char *)action->data.srv_instance.service->service->instance);
         }
         action->data.srv_instance.service->service->instance = action->data.srv_instance.instance;
+        _mdns_invalidate_service_names(action->data.srv_instance.service->service);
         _mdns_probe_all_pcbs(&action->data.srv_instance.service, 1, false, false);
 
         break;
@@ -4883,9 +5443,7 @@ static void _mdns_execute_action(mdns_action_t *action)
         break;
     case ACTION_SERVICE_TXT_REPLACE:
         service = action->data.srv_txt_replace.service->service;
-        txt = service->txt;
-        service->txt = NULL;
-        _mdns_free_linked_txt(txt);
+        free(service->txt);
         service->txt = action->data.srv_txt_replace.txt;
         _mdns_announce_all_pcbs(&action->data.srv_txt_replace.service, 1, false);
 
@@ -4894,30 +5452,12 @@ static void _mdns_execute_action(mdns_action_t *action)
         service = action->data.srv_txt_set.service->service;
         key = action->data.srv_txt_set.key;
         value = action->data.srv_txt_set.value;
-        txt = service->txt;
-        while (txt) {
-            if (strcmp(txt->key, key) == 0) {
-                free((char *)txt->value);
-                free(key);
-                txt->value = value;
-                txt->value_len = action->data.srv_txt_set.value_len;
-                break;
-            }
-            txt = txt->next;
-        }
-        if (!txt) {
-            txt = (mdns_txt_linked_item_t *)malloc(sizeof(mdns_txt_linked_item_t));
-            if (!txt) {
-                HOOK_MALLOC_FAILED;
-                _mdns_free_action(action);
-                return;
-            }
-            txt->key = key;
-            txt->value = value;
-            txt->value_len = action->data.srv_txt_set.value_len;
-            txt->next = service->txt;
-            service->txt = txt;
+        if (_mdns_txt_set_item(&service->txt, key, value, action->data.srv_txt_set.value_len) != ESP_OK) {
+            _mdns_free_action(action);
+            return;
         }
+        free(key);
+        free(value);
 
         _mdns_announce_all_pcbs(&action->data.srv_txt_set.service, 1, false);
 
@@ -4925,29 +5465,7 @@ static void _mdns_execute_action(mdns_action_t *action)
     case ACTION_SERVICE_TXT_DEL:
         service = action->data.srv_txt_del.service->service;
         key = action->data.srv_txt_del.key;
-        txt = service->txt;
-        if (!txt) {
-            break;
-        }
-        if (strcmp(txt->key, key) == 0) {
-            service->txt = txt->next;
-            free((char *)txt->key);
-            free((char *)txt->value);
-            free(txt);
-        } else {
-            while (txt->next) {
-                if (strcmp(txt->next->key, key) == 0) {
-                    t = txt->next;
-                    txt->next = t->next;
-                    free((char *)t->key);
-                    free((char *)t->value);
-                    free(t);
-                    break;
-                } else {
-                    txt = txt->next;
-                }
-            }
-        }
+        _mdns_txt_remove_item(&service->txt, key);
         free(key);
 
         _mdns_announce_all_pcbs(&action->data.srv_txt_set.service, 1, false);
@@ -4955,14 +5473,7 @@ static void _mdns_execute_action(mdns_action_t *action)
         break;
     case ACTION_SERVICE_SUBTYPE_ADD:
         service = action->data.srv_subtype_add.service->service;
-        subtype = action->data.srv_subtype_add.subtype;
-        subtype_item = (mdns_subtype_t *)malloc(sizeof(mdns_subtype_t));
-        if (!subtype_item) {
-            HOOK_MALLOC_FAILED;
-            _mdns_free_action(action);
-            return;
-        }
-        subtype_item->subtype = subtype;
+        subtype_item = action->data.srv_subtype_add.subtype;
         subtype_item->next = service->subtype;
         service->subtype = subtype_item;
         break;
@@ -5008,7 +5519,7 @@ static void _mdns_execute_action(mdns_action_t *action)
         _mdns_search_add(action->data.search_add.search);
         break;
     case ACTION_SEARCH_SEND:
-        _mdns_search_send(action->data.search_add.search);
+        _mdns_search_send();
         break;
     case ACTION_SEARCH_END:
         _mdns_search_finish(action->data.search_add.search);
@@ -5043,6 +5554,12 @@ static void _mdns_execute_action(mdns_action_t *action)
     default:
         break;
     }
+    // Sending, receiving and searching leave what the last packet was built from as it was,
+    // except for renames on conflicts which are handled where they happen
+    if (action->type != ACTION_TX_HANDLE && action->type != ACTION_RX_HANDLE && action->type != ACTION_SEARCH_ADD
+            && action->type != ACTION_SEARCH_SEND && action->type != ACTION_SEARCH_END) {
+        _mdns_tx_last_forget();
+    }
     free(action);
 }
 
@@ -5109,12 +5626,17 @@ static void _mdns_scheduler_run(void)
 
 /**
  * @brief  Called from timer task to run active searches
+ *
+ *  The searches due are sent together, in one packet. A search asking the same question as
+ *  another one already sent follows its schedule instead of sending the question again: a new
+ *  search joins it if it was sent in the last MDNS_SEARCH_JOIN_MS, the results are given to both.
  */
 static void _mdns_search_run(void)
 {
     MDNS_SERVICE_LOCK();
     mdns_search_once_t *s = _mdns_server->search_once;
     uint32_t now = xTaskGetTickCount() * portTICK_PERIOD_MS;
+    bool send = false;
     if (!s) {
         MDNS_SERVICE_UNLOCK();
         return;
@@ -5127,15 +5649,32 @@ static void _mdns_search_run(void)
                     s->state = SEARCH_RUNNING;
                 }
             } else if (s->state == SEARCH_INIT || (now - s->sent_at) > 1000) {
+                uint32_t window = s->state == SEARCH_INIT ? MDNS_SEARCH_JOIN_MS : 1000;
+                mdns_search_once_t *same = _mdns_server->search_once;
+                while (same && (same == s || same->state != SEARCH_RUNNING || (now - same->sent_at) > window
+                                || !_mdns_search_same_question(same, s))) {
+                    same = same->next;
+                }
                 s->state = SEARCH_RUNNING;
-                s->sent_at = now;
-                if (_mdns_send_search_action(ACTION_SEARCH_SEND, s) != ESP_OK) {
-                    s->sent_at -= 1000;
+                if (same) {
+                    s->sent_at = same->sent_at;
+                } else {
+                    s->sent_at = now;
+                    s->send_pending = true;
+                    send = true;
                 }
             }
         }
         s = s->next;
     }
+    if (send && _mdns_send_search_action(ACTION_SEARCH_SEND, NULL) != ESP_OK) {
+        for (s = _mdns_server->search_once; s; s = s->next) {
+            if (s->send_pending) {
+                s->send_pending = false;
+                s->sent_at -= 1000;
+            }
+        }
+    }
     MDNS_SERVICE_UNLOCK();
 }
 
@@ -5503,6 +6042,7 @@ void mdns_free(void)
     vSemaphoreDelete(_mdns_server->action_sema);
     free(_mdns_server);
     _mdns_server = NULL;
+    _mdns_tx_last_forget();
 }
 
 esp_err_t mdns_hostname_set(const char *hostname)
@@ -5756,7 +6296,7 @@ esp_err_t mdns_service_txt_set_for_host(const char *instance, const char *servic
         return ESP_ERR_NOT_FOUND;
     }
 
-    mdns_txt_linked_item_t *new_txt = NULL;
+    mdns_txt_rdata_t *new_txt = NULL;
     if (num_items) {
         new_txt = _mdns_allocate_txt(num_items, txt);
         if (!new_txt) {
@@ -5767,7 +6307,7 @@ esp_err_t mdns_service_txt_set_for_host(const char *instance, const char *servic
     mdns_action_t *action = (mdns_action_t *)malloc(sizeof(mdns_action_t));
     if (!action) {
         HOOK_MALLOC_FAILED;
-        _mdns_free_linked_txt(new_txt);
+        free(new_txt);
         return ESP_ERR_NO_MEM;
     }
     action->type = ACTION_SERVICE_TXT_REPLACE;
@@ -5775,7 +6315,7 @@ esp_err_t mdns_service_txt_set_for_host(const char *instance, const char *servic
     action->data.srv_txt_replace.txt = new_txt;
 
     if (xQueueSend(_mdns_server->action_queue, &action, (TickType_t)0) != pdPASS) {
-        _mdns_free_linked_txt(new_txt);
+        free(new_txt);
         free(action);
         return ESP_ERR_NO_MEM;
     }
@@ -5922,12 +6462,16 @@ esp_err_t mdns_service_subtype_add_for_host(const char *instance_name, const cha
 
     action->type = ACTION_SERVICE_SUBTYPE_ADD;
     action->data.srv_subtype_add.service = s;
-    action->data.srv_subtype_add.subtype = strdup(subtype);
+    // The item and its name in one allocation
+    size_t subtype_len = strlen(subtype);
+    action->data.srv_subtype_add.subtype = (mdns_subtype_t *)malloc(sizeof(mdns_subtype_t) + subtype_len + 1);
 
     if (!action->data.srv_subtype_add.subtype) {
+        HOOK_MALLOC_FAILED;
         free(action);
         return ESP_ERR_NO_MEM;
     }
+    memcpy(action->data.srv_subtype_add.subtype->subtype, subtype, subtype_len + 1);
     if (xQueueSend(_mdns_server->action_queue, &action, (TickType_t)0) != pdPASS) {
         free(action->data.srv_subtype_add.subtype);
         free(action);
@@ -8,7 +8,11 @@
  * @brief MDNS Server Networking module implemented using BSD sockets
  */
 
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE     // recvmmsg()
+#endif
 #include <string.h>
+#include <stdatomic.h>
 #include "esp_event.h"
 #include "mdns_networking.h"
 #include <sys/types.h>
@@ -31,6 +35,7 @@ extern mdns_server_t *_mdns_server;
 
 static const char *TAG = "mdns_networking";
 static bool s_run_sock_recv_task = false;
+static int s_ctrl_sock = -1;
 static int create_socket(esp_netif_t *netif);
 static int join_mdns_multicast_group(int sock, esp_netif_t *netif, mdns_ip_protocol_t ip_protocol);
 
@@ -47,6 +52,70 @@ struct pbuf  {
 #define s6_addr32 un.u32_addr
 #endif // CONFIG_IDF_TARGET_LINUX
 
+#define MDNS_RX_BATCH   8   // datagrams read by one recvmmsg() call
+
+// Room for the destination address and interface of a datagram (IP_PKTINFO/IPV6_PKTINFO)
+#if defined(IPV6_RECVPKTINFO)
+#define MDNS_RX_CMSG_SIZE   (CMSG_SPACE(sizeof(struct in_pktinfo)) + CMSG_SPACE(sizeof(struct in6_pktinfo)))
+#elif defined(IP_PKTINFO)
+#define MDNS_RX_CMSG_SIZE   CMSG_SPACE(sizeof(struct in_pktinfo))
+#else
+#define MDNS_RX_CMSG_SIZE   sizeof(struct cmsghdr)
+#endif
+
+/**
+ * @brief Receive buffer, handed to the engine as the mdns_rx_packet_t itself
+ *
+ * Buffers come from a fixed pool, so receiving needs no allocation and no copy.
+ * The pool is a lock-free stack: any task may return a buffer, only the
+ * receive task takes them, which keeps it free of the ABA problem.
+ */
+typedef struct mdns_rx_slot {
+    mdns_rx_packet_t packet;    // must stay first, see _mdns_packet_free()
+    struct pbuf pb;
+    struct mdns_rx_slot *next_free;
+    uint8_t data[MDNS_MAX_PACKET_SIZE];
+} mdns_rx_slot_t;
+
+static mdns_rx_slot_t s_rx_pool[CONFIG_MDNS_SOCKET_RX_POOL_SIZE];
+static _Atomic(mdns_rx_slot_t *) s_rx_free;
+static bool s_rx_pool_ready = false;
+
+/**
+ * @brief Wake the receive task from select(), to rebuild its socket set, stop,
+ *        or resume reading once a buffer is back in the pool
+ */
+static void wake_recv_task(void)
+{
+    if (s_ctrl_sock >= 0) {
+        uint8_t byte = 0;
+        send(s_ctrl_sock, &byte, sizeof(byte), MSG_DONTWAIT);
+    }
+}
+
+/**
+ * @brief Return a buffer to the pool; returns true if the pool was empty
+ */
+static bool rx_slot_give(mdns_rx_slot_t *slot)
+{
+    mdns_rx_slot_t *head = atomic_load(&s_rx_free);
+    do {
+        slot->next_free = head;
+    } while (!atomic_compare_exchange_weak(&s_rx_free, &head, slot));
+    return head == NULL;
+}
+
+/**
+ * @brief Take a buffer from the pool, NULL if none is left (receive task only)
+ */
+static mdns_rx_slot_t *rx_slot_take(void)
+{
+    mdns_rx_slot_t *head = atomic_load(&s_rx_free);
+    while (head && !atomic_compare_exchange_weak(&s_rx_free, &head, head->next_free)) {
+    }
+    return head;
+}
+
 static void delete_socket(int sock)
 {
     close(sock);
@@ -83,9 +152,10 @@ size_t _mdns_get_packet_len(mdns_rx_packet_t *packet)
 
 void _mdns_packet_free(mdns_rx_packet_t *packet)
 {
-    free(packet->pb->payload);
-    free(packet->pb);
-    free(packet);
+    if (rx_slot_give((mdns_rx_slot_t *)packet)) {
+        // The receive task may be waiting for a buffer
+        wake_recv_task();
+    }
 }
 
 esp_err_t _mdns_pcb_deinit(mdns_if_t tcpip_if, mdns_ip_protocol_t ip_protocol)
@@ -98,6 +168,7 @@ esp_err_t _mdns_pcb_deinit(mdns_if_t tcpip_if, mdns_ip_protocol_t ip_protocol)
         int sock = pcb_to_sock(pcb);
         if (sock >= 0) {
             delete_socket(sock);
+            wake_recv_task();   // drop it from the select() set
         }
     }
 
@@ -113,6 +184,7 @@ esp_err_t _mdns_pcb_deinit(mdns_if_t tcpip_if, mdns_ip_protocol_t ip_protocol)
 
     // no interface alive, stop the rx task
     s_run_sock_recv_task = false;
+    wake_recv_task();
     vTaskDelay(pdMS_TO_TICKS(500));
     return ESP_OK;
 }
@@ -239,17 +311,208 @@ static inline void inet_to_espaddr(const struct sockaddr_storage *in_addr, esp_i
 #endif // CONFIG_LWIP_IPV6
 }
 
+/**
+ * @brief Read the destination address and arrival interface from the ancillary data
+ *
+ * @return true if the datagram carried them
+ */
+static bool get_packet_info(struct msghdr *msg, esp_ip_addr_t *dest, int *ifindex)
+{
+    for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(msg); cmsg; cmsg = CMSG_NXTHDR(msg, cmsg)) {
+#if defined(IP_PKTINFO)
+        if (cmsg->cmsg_level == IPPROTO_IP && cmsg->cmsg_type == IP_PKTINFO) {
+            struct in_pktinfo info;
+            memcpy(&info, CMSG_DATA(cmsg), sizeof(info));
+            dest->type = ESP_IPADDR_TYPE_V4;
+            dest->u_addr.ip4.addr = info.ipi_addr.s_addr;
+            *ifindex = info.ipi_ifindex;
+            return true;
+        }
+#endif
+#if defined(IPV6_RECVPKTINFO)
+        if (cmsg->cmsg_level == IPPROTO_IPV6 && cmsg->cmsg_type == IPV6_PKTINFO) {
+            struct in6_pktinfo info;
+            memcpy(&info, CMSG_DATA(cmsg), sizeof(info));
+            uint32_t *u32_addr = (uint32_t *)&info.ipi6_addr;
+            if (u32_addr[0] == 0 && u32_addr[1] == 0 && u32_addr[2] == esp_netif_htonl(0x0000FFFFUL)) {
+                dest->type = ESP_IPADDR_TYPE_V4;
+                dest->u_addr.ip4.addr = u32_addr[3];
+            } else {
+                dest->type = ESP_IPADDR_TYPE_V6;
+                memcpy(dest->u_addr.ip6.addr, u32_addr, sizeof(dest->u_addr.ip6.addr));
+            }
+            *ifindex = info.ipi6_ifindex;
+            return true;
+        }
+#endif
+    }
+    return false;
+}
+
+/**
+ * @brief Find the interface a datagram arrived on, the socket's one if it's not ours
+ */
+static mdns_if_t ifindex_to_tcpip_if(int ifindex, mdns_if_t tcpip_if)
+{
+    for (int i = 0; i < MDNS_MAX_INTERFACES; i++) {
+        esp_netif_t *netif = _mdns_get_esp_netif(i);
+        if (netif && esp_netif_get_netif_impl_index(netif) == ifindex &&
+                (_mdns_server->interfaces[i].pcbs[MDNS_IP_PROTOCOL_V4].pcb ||
+                 _mdns_server->interfaces[i].pcbs[MDNS_IP_PROTOCOL_V6].pcb)) {
+            return i;
+        }
+    }
+    return tcpip_if;
+}
+
+/**
+ * @brief Pass a received datagram to the engine, or back to the pool on failure
+ */
+static void deliver_packet(mdns_rx_slot_t *slot, size_t len, struct msghdr *msg, mdns_if_t tcpip_if)
+{
+    mdns_rx_packet_t *packet = &slot->packet;
+    uint16_t port = 0;
+    esp_ip_addr_t addr = {0};
+    int ifindex = 0;
+
+    ESP_LOGD(TAG, "Received from IP:%s", get_string_address(msg->msg_name));
+    ESP_LOG_BUFFER_HEXDUMP(TAG, slot->data, len, ESP_LOG_VERBOSE);
+    inet_to_espaddr(msg->msg_name, &addr, &port);
+
+    memset(packet, 0, sizeof(*packet));
+    slot->pb.next = NULL;
+    slot->pb.payload = slot->data;
+    slot->pb.tot_len = len;
+    slot->pb.len = len;
+    packet->pb = &slot->pb;
+    packet->src_port = ntohs(port);
+    memcpy(&packet->src, &addr, sizeof(esp_ip_addr_t));
+    packet->ip_protocol =
+        packet->src.type == ESP_IPADDR_TYPE_V4 ? MDNS_IP_PROTOCOL_V4 : MDNS_IP_PROTOCOL_V6;
+    if (get_packet_info(msg, &packet->dest, &ifindex)) {
+        packet->tcpip_if = ifindex_to_tcpip_if(ifindex, tcpip_if);
+        packet->multicast = packet->dest.type == ESP_IPADDR_TYPE_V4 ?
+                            IN_MULTICAST(ntohl(packet->dest.u_addr.ip4.addr)) :
+                            ((uint8_t *)packet->dest.u_addr.ip6.addr)[0] == 0xff;
+    } else {
+        // No ancillary data (e.g. IP_PKTINFO not supported by the stack):
+        // assume multicast, the engine still tells legacy queries by the source port
+        packet->tcpip_if = tcpip_if;
+        packet->multicast = 1;
+        packet->dest.type = packet->src.type;
+    }
+    if (!_mdns_server || !_mdns_server->action_queue || _mdns_send_rx_action(packet) != ESP_OK) {
+        ESP_LOGE(TAG, "_mdns_send_rx_action failed!");
+        rx_slot_give(slot);
+    }
+}
+
+#if defined(CONFIG_IDF_TARGET_LINUX)
+/**
+ * @brief Read every queued datagram of a socket, MDNS_RX_BATCH per syscall
+ *
+ * @return buffer for the next read, NULL if the pool ran out
+ */
+static mdns_rx_slot_t *drain_socket(int sock, mdns_if_t tcpip_if, mdns_rx_slot_t *slot)
+{
+    mdns_rx_slot_t *batch[MDNS_RX_BATCH];
+    struct mmsghdr msgs[MDNS_RX_BATCH];
+    struct iovec iov[MDNS_RX_BATCH];
+    struct sockaddr_storage raddr[MDNS_RX_BATCH];
+    union {
+        struct cmsghdr align;
+        uint8_t buf[MDNS_RX_CMSG_SIZE];
+    } control[MDNS_RX_BATCH];
+
+    while (slot) {
+        int count = 0;
+        batch[count++] = slot;
+        while (count < MDNS_RX_BATCH && (batch[count] = rx_slot_take()) != NULL) {
+            count++;
+        }
+        memset(msgs, 0, sizeof(msgs[0]) * count);
+        for (int i = 0; i < count; i++) {
+            iov[i].iov_base = batch[i]->data;
+            iov[i].iov_len = sizeof(batch[i]->data);
+            msgs[i].msg_hdr.msg_iov = &iov[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+            msgs[i].msg_hdr.msg_name = &raddr[i];
+            msgs[i].msg_hdr.msg_namelen = sizeof(raddr[i]);
+            msgs[i].msg_hdr.msg_control = control[i].buf;
+            msgs[i].msg_hdr.msg_controllen = sizeof(control[i].buf);
+        }
+        int received = recvmmsg(sock, msgs, count, MSG_DONTWAIT, NULL);
+        if (received < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                ESP_LOGE(TAG, "[sock=%d]: recvmmsg failed. errno=%d: %s", sock, errno, strerror(errno));
+            }
+            received = 0;
+        }
+        for (int i = 0; i < received; i++) {
+            deliver_packet(batch[i], msgs[i].msg_len, &msgs[i].msg_hdr, tcpip_if);
+        }
+        // Keep one unused buffer for the next read, return the rest
+        slot = received < count ? batch[received] : rx_slot_take();
+        for (int i = received + 1; i < count; i++) {
+            rx_slot_give(batch[i]);
+        }
+        if (received < count) {
+            break;  // socket drained
+        }
+    }
+    return slot;
+}
+#else
+/**
+ * @brief Read every queued datagram of a socket
+ *
+ * @return buffer for the next read, NULL if the pool ran out
+ */
+static mdns_rx_slot_t *drain_socket(int sock, mdns_if_t tcpip_if, mdns_rx_slot_t *slot)
+{
+    while (slot) {
+        struct sockaddr_storage raddr; // Large enough for both IPv4 or IPv6
+        union {
+            struct cmsghdr align;
+            uint8_t buf[MDNS_RX_CMSG_SIZE];
+        } control;
+        struct iovec iov = { .iov_base = slot->data, .iov_len = sizeof(slot->data) };
+        struct msghdr msg = {
+            .msg_name = &raddr,
+            .msg_namelen = sizeof(raddr),
+            .msg_iov = &iov,
+            .msg_iovlen = 1,
+            .msg_control = control.buf,
+            .msg_controllen = sizeof(control.buf),
+        };
+        int len = recvmsg(sock, &msg, MSG_DONTWAIT);
+        if (len < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                ESP_LOGE(TAG, "[sock=%d]: multicast recvmsg failed. errno=%d: %s", sock, errno, strerror(errno));
+            }
+            break;
+        }
+        deliver_packet(slot, len, &msg, tcpip_if);
+        slot = rx_slot_take();
+    }
+    return slot;
+}
+#endif // CONFIG_IDF_TARGET_LINUX
+
 void sock_recv_task(void *arg)
 {
+    mdns_rx_slot_t *slot = NULL;
+
     while (s_run_sock_recv_task) {
-        struct timeval tv = {
-            .tv_sec = 1,
-            .tv_usec = 0,
-        };
         fd_set rfds;
         FD_ZERO(&rfds);
-        int max_sock = -1;
-        for (int i = 0; i < MDNS_MAX_INTERFACES; i++) {
+        FD_SET(s_ctrl_sock, &rfds);
+        int max_sock = s_ctrl_sock;
+        if (slot == NULL) {
+            slot = rx_slot_take();
+        }
+        // Without a free buffer only wait for one to be returned
+        for (int i = 0; slot && i < MDNS_MAX_INTERFACES; i++) {
             for (int j = 0; j < MDNS_IP_PROTOCOL_MAX; j++) {
                 int sock = pcb_to_sock(_mdns_server->interfaces[i].pcbs[j].pcb);
                 if (sock >= 0) {
@@ -258,89 +521,81 @@ void sock_recv_task(void *arg)
                 }
             }
         }
-        if (max_sock < 0) {
-            vTaskDelay(pdMS_TO_TICKS(1000));
-            ESP_LOGI(TAG, "No sock!");
-            continue;
-        }
 
-        int s = select(max_sock + 1, &rfds, NULL, NULL, &tv);
+        // No timeout: changes to the socket set and returned buffers wake us
+        int s = select(max_sock + 1, &rfds, NULL, NULL, NULL);
         if (s < 0) {
+            if (errno == EINTR || errno == EBADF) {
+                continue;   // a socket was closed meanwhile, rebuild the set
+            }
             ESP_LOGE(TAG, "Select failed. errno=%d: %s", errno, strerror(errno));
             break;
-        } else if (s > 0) {
-            for (int tcpip_if = 0; tcpip_if < MDNS_MAX_INTERFACES; tcpip_if++) {
-                // Both protocols share once socket
-                int sock = pcb_to_sock(_mdns_server->interfaces[tcpip_if].pcbs[MDNS_IP_PROTOCOL_V4].pcb);
-                if (sock < 0) {
-                    sock = pcb_to_sock(_mdns_server->interfaces[tcpip_if].pcbs[MDNS_IP_PROTOCOL_V6].pcb);
-                }
-                if (sock < 0) {
-                    continue;
-                }
-                if (FD_ISSET(sock, &rfds)) {
-                    static char recvbuf[MDNS_MAX_PACKET_SIZE];
-                    uint16_t port = 0;
-
-                    struct sockaddr_storage raddr; // Large enough for both IPv4 or IPv6
-                    socklen_t socklen = sizeof(struct sockaddr_storage);
-                    esp_ip_addr_t addr = {0};
-                    int len = recvfrom(sock, recvbuf, sizeof(recvbuf), 0,
-                                       (struct sockaddr *) &raddr, &socklen);
-                    if (len < 0) {
-                        ESP_LOGE(TAG, "multicast recvfrom failed. errno=%d: %s", errno, strerror(errno));
-                        break;
-                    }
-                    ESP_LOGD(TAG, "[sock=%d]: Received from IP:%s", sock, get_string_address(&raddr));
-                    ESP_LOG_BUFFER_HEXDUMP(TAG, recvbuf, len, ESP_LOG_VERBOSE);
-                    inet_to_espaddr(&raddr, &addr, &port);
-
-                    // Allocate the packet structure and pass it to the mdns main engine
-                    mdns_rx_packet_t *packet = (mdns_rx_packet_t *) calloc(1, sizeof(mdns_rx_packet_t));
-                    struct pbuf *packet_pbuf = calloc(1, sizeof(struct pbuf));
-                    uint8_t *buf = malloc(len);
-                    if (packet == NULL || packet_pbuf == NULL || buf == NULL ) {
-                        free(buf);
-                        free(packet_pbuf);
-                        free(packet);
-                        HOOK_MALLOC_FAILED;
-                        ESP_LOGE(TAG, "Failed to allocate the mdns packet");
-                        continue;
-                    }
-                    memcpy(buf, recvbuf, len);
-                    packet_pbuf->next = NULL;
-                    packet_pbuf->payload = buf;
-                    packet_pbuf->tot_len = len;
-                    packet_pbuf->len = len;
-                    packet->tcpip_if = tcpip_if;
-                    packet->pb = packet_pbuf;
-                    packet->src_port = ntohs(port);
-                    memcpy(&packet->src, &addr, sizeof(esp_ip_addr_t));
-                    // TODO(IDF-3651): Add the correct dest addr -- for mdns to decide multicast/unicast
-                    // Currently it's enough to assume the packet is multicast and mdns to check the source port of the packet
-                    memset(&packet->dest, 0, sizeof(esp_ip_addr_t));
-                    packet->multicast = 1;
-                    packet->dest.type = packet->src.type;
-                    packet->ip_protocol =
-                        packet->src.type == ESP_IPADDR_TYPE_V4 ? MDNS_IP_PROTOCOL_V4 : MDNS_IP_PROTOCOL_V6;
-                    if (!_mdns_server || !_mdns_server->action_queue || _mdns_send_rx_action(packet) != ESP_OK) {
-                        ESP_LOGE(TAG, "_mdns_send_rx_action failed!");
-                        free(packet->pb->payload);
-                        free(packet->pb);
-                        free(packet);
-                    }
-                }
+        }
+        if (FD_ISSET(s_ctrl_sock, &rfds)) {
+            uint8_t wake[16];
+            while (recv(s_ctrl_sock, wake, sizeof(wake), MSG_DONTWAIT) > 0) {
+            }
+        }
+        for (int tcpip_if = 0; slot && tcpip_if < MDNS_MAX_INTERFACES; tcpip_if++) {
+            // Both protocols share once socket
+            int sock = pcb_to_sock(_mdns_server->interfaces[tcpip_if].pcbs[MDNS_IP_PROTOCOL_V4].pcb);
+            if (sock < 0) {
+                sock = pcb_to_sock(_mdns_server->interfaces[tcpip_if].pcbs[MDNS_IP_PROTOCOL_V6].pcb);
+            }
+            if (sock >= 0 && FD_ISSET(sock, &rfds)) {
+                slot = drain_socket(sock, tcpip_if, slot);
             }
         }
     }
+    if (slot) {
+        rx_slot_give(slot);
+    }
     vTaskDelete(NULL);
 }
 
+/**
+ * @brief Loopback socket connected to itself, used by wake_recv_task()
+ */
+static int create_ctrl_socket(void)
+{
+    struct sockaddr_in addr = { 0 };
+    socklen_t addr_len = sizeof(addr);
+    int sock = socket(PF_INET, SOCK_DGRAM, 0);
+    if (sock < 0) {
+        return -1;
+    }
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+            getsockname(sock, (struct sockaddr *)&addr, &addr_len) < 0 ||
+            connect(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        ESP_LOGE(TAG, "Failed to create the control socket. errno=%d: %s", errno, strerror(errno));
+        close(sock);
+        return -1;
+    }
+    return sock;
+}
+
 static void mdns_networking_init(void)
 {
+    if (!s_rx_pool_ready) {
+        for (int i = 0; i < CONFIG_MDNS_SOCKET_RX_POOL_SIZE; i++) {
+            rx_slot_give(&s_rx_pool[i]);
+        }
+        s_rx_pool_ready = true;
+    }
+    // Kept open for good, buffers in flight may still wake the task after it stops
+    if (s_ctrl_sock < 0) {
+        s_ctrl_sock = create_ctrl_socket();
+        if (s_ctrl_sock < 0) {
+            return;
+        }
+    }
     if (s_run_sock_recv_task == false) {
         s_run_sock_recv_task = true;
         xTaskCreate( sock_recv_task, "mdns recv task", 3 * 1024, NULL, 5, NULL );
+    } else {
+        wake_recv_task();   // pick up the new socket
     }
 }
 
@@ -398,6 +653,18 @@ static int create_socket(esp_netif_t *netif)
     if (setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on) ) < 0) {
         ESP_LOGE(TAG, "Failed setsockopt() to set SO_REUSEADDR. errno=%d: %s\n", errno, strerror(errno));
     }
+    // Ask for the destination address and interface of each datagram, to tell unicast queries
+    // (Not fatal: without them every datagram is treated as multicast)
+#if defined(IP_PKTINFO)
+    if (setsockopt(sock, IPPROTO_IP, IP_PKTINFO, &on, sizeof(on)) < 0) {
+        ESP_LOGD(TAG, "Failed setsockopt() to set IP_PKTINFO. errno=%d: %s", errno, strerror(errno));
+    }
+#endif
+#if CONFIG_LWIP_IPV6 && defined(IPV6_RECVPKTINFO)
+    if (setsockopt(sock, IPPROTO_IPV6, IPV6_RECVPKTINFO, &on, sizeof(on)) < 0) {
+        ESP_LOGD(TAG, "Failed setsockopt() to set IPV6_RECVPKTINFO. errno=%d: %s", errno, strerror(errno));
+    }
+#endif
     // Bind the socket to any address
 #if CONFIG_LWIP_IPV6
     struct sockaddr_in6 saddr = { INADDR_ANY };
@@ -56,6 +56,17 @@
 #define MDNS_FLAGS_DISTRIBUTED      0x0200
 
 #define MDNS_NAME_REF               0xC000
+#define MDNS_NAME_WIRE_LIMIT        255                     // Longest encoded name accepted from a packet (RFC 1035, 3.1)
+#ifdef CONFIG_MDNS_SMALL_FOOTPRINT
+#define MDNS_NAME_WIRE_MAX_LEN      MDNS_NAME_WIRE_LIMIT    // Longest encoded name we write, longer ones are invalid anyway
+#else
+#define MDNS_NAME_WIRE_MAX_LEN      (5 * (MDNS_NAME_BUF_LEN) + 1) // Longest encoded name we write: subtype._sub.service.proto.domain
+#define MDNS_NAME_TABLE_LEN         96                      // Names (and their suffixes) a packet being built can point to
+#endif
+#define MDNS_NAME_MAX_LABELS        8                       // Labels of a name written with compression, names with more are written whole
+#define MDNS_TX_SELF_ADDR_ANSWERS   8                       // A/AAAA answers of this host a sent packet can be reused with
+#define MDNS_SEARCH_INDEX_LEN       16                      // Buckets of running searches, by the name received records must have
+#define MDNS_SEARCH_JOIN_MS         100                     // A new search joins a same question sent this recently, instead of sending it again
 
 //custom type! only used by this implementation
 //to help manage service discovery handling
@@ -87,8 +98,8 @@
 #define MDNS_SERVICE_ADD_TIMEOUT_MS CONFIG_MDNS_SERVICE_ADD_TIMEOUT_MS
 
 #define MDNS_PACKET_QUEUE_LEN       16                      // Maximum packets that can be queued for parsing
-#define MDNS_ACTION_QUEUE_LEN       16                      // Maximum actions pending to the server
-#define MDNS_TXT_MAX_LEN            1024                    // Maximum string length of text data in TXT record
+#define MDNS_ACTION_QUEUE_LEN       CONFIG_MDNS_ACTION_QUEUE_LEN // Maximum actions pending to the server
+#define MDNS_TXT_MAX_LEN            CONFIG_MDNS_TXT_MAX_LEN // Maximum length of text data in TXT record
 #if defined(CONFIG_LWIP_IPV6) && defined(CONFIG_MDNS_RESPOND_REVERSE_QUERIES)
 #define MDNS_NAME_MAX_LEN           (64+4)                  // Need to account for IPv6 reverse queries (64 char address  + ".ip6" )
 #else
@@ -96,6 +107,11 @@
 #endif
 #define MDNS_NAME_BUF_LEN           (MDNS_NAME_MAX_LEN+1)   // Maximum char buffer size to hold hostname, instance, service or proto
 #define MDNS_MAX_PACKET_SIZE        1460                    // Maximum size of mDNS  outgoing packet
+#ifdef CONFIG_MDNS_SMALL_FOOTPRINT
+#define MDNS_TX_BUFFER_LEN          MDNS_MAX_PACKET_SIZE    // Names are encoded in place only where they fit whole
+#else
+#define MDNS_TX_BUFFER_LEN          (MDNS_MAX_PACKET_SIZE + MDNS_NAME_WIRE_MAX_LEN) // Room to encode a name in place past the end
+#endif
 
 #define MDNS_HEAD_LEN               12
 #define MDNS_HEAD_ID_OFFSET         0
@@ -211,6 +227,7 @@ typedef struct {
     uint8_t parts;
     uint8_t sub;
     bool    invalid;
+    uint16_t wire_len;  // encoded length read so far, bounds the compression pointers followed
 } mdns_name_t;
 
 typedef struct mdns_parsed_question_s {
@@ -264,28 +281,33 @@ typedef struct {
     uint8_t multicast;
 } mdns_rx_packet_t;
 
-typedef struct mdns_txt_linked_item_s {
-    const char *key;                        /*!< item key name */
-    char *value;                            /*!< item value string */
-    uint8_t value_len;                      /*!< item value length */
-    struct mdns_txt_linked_item_s *next;    /*!< next result, or NULL for the last result in the list */
-} mdns_txt_linked_item_t;
+typedef struct {
+    uint16_t len;                           /*!< length of data, never 0 */
+    uint8_t data[];                         /*!< TXT rdata in wire format: length prefixed "key=value" or "key" items */
+} mdns_txt_rdata_t;
+
+typedef struct {
+    uint16_t service_offset;                /*!< offset of "_service._proto.local" in name */
+    uint16_t host_offset;                   /*!< offset of the SRV target "hostname.local" in name, 0 without a hostname */
+    uint8_t name[];                         /*!< "instance._service._proto.local", then "hostname.local", in wire format */
+} mdns_service_names_t;
 
 typedef struct mdns_subtype_s {
-    const char *subtype;                    /*!< subtype */
     struct mdns_subtype_s *next;            /*!< next result, or NULL for the last result in the list */
+    char subtype[];                         /*!< subtype, allocated together with the item */
 } mdns_subtype_t;
 
 typedef struct {
     const char *instance;
-    const char *service;
-    const char *proto;
+    const char *service;                    /*!< allocated together with the service */
+    const char *proto;                      /*!< allocated together with the service */
     const char *hostname;
     uint16_t priority;
     uint16_t weight;
     uint16_t port;
-    mdns_txt_linked_item_t *txt;
+    mdns_txt_rdata_t *txt;                  /*!< NULL if the service has no TXT items */
     mdns_subtype_t *subtype;
+    mdns_service_names_t *names;            /*!< wire format names, built on first use, NULL when outdated */
 } mdns_service_t;
 
 typedef struct mdns_srv_item_s {
@@ -373,6 +395,12 @@ typedef struct mdns_search_once_s {
     char *service;
     char *proto;
     mdns_result_t *result;
+    bool send_pending;                          /*!< due to be sent with the next search packet */
+    uint8_t key;                                /*!< bucket of the search index */
+    struct mdns_search_once_s *index_next;      /*!< in its bucket of the search index */
+    struct mdns_search_once_s *resolve_next;    /*!< PTR and SRV searches, receiving addresses of the hosts found */
+    struct mdns_search_once_s *match_next;      /*!< searches the record being parsed goes to */
+    mdns_result_t *match_result;                /*!< result the record being parsed updates */
 } mdns_search_once_t;
 
 typedef struct mdns_server_s {
@@ -386,6 +414,8 @@ typedef struct mdns_server_s {
     SemaphoreHandle_t action_sema;
     mdns_tx_packet_t *tx_queue_head;
     mdns_search_once_t *search_once;
+    mdns_search_once_t *search_index[MDNS_SEARCH_INDEX_LEN];
+    mdns_search_once_t *search_resolve;
     esp_timer_handle_t timer_handle;
 } mdns_server_t;
 
@@ -416,7 +446,7 @@ typedef struct {
         } srv_port;
         struct {
             mdns_srv_item_t *service;
-            mdns_txt_linked_item_t *txt;
+            mdns_txt_rdata_t *txt;
         } srv_txt_replace;
         struct {
             mdns_srv_item_t *service;
@@ -430,7 +460,7 @@ typedef struct {
         } srv_txt_del;
         struct {
             mdns_srv_item_t *service;
-            char *subtype;
+            mdns_subtype_t *subtype;
         } srv_subtype_add;
         struct {
             mdns_search_once_t *search;
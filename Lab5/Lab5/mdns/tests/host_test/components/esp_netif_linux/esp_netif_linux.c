@@ -51,6 +51,9 @@ esp_err_t esp_netif_get_ip_info(esp_netif_t *esp_netif, esp_netif_ip_info_t *ip_
             inet_ntop(AF_INET, &pAddr->sin_addr, addr, sizeof(addr) );
             if (strcmp(esp_netif->if_desc, tmp->ifa_name) == 0) {
                 memcpy(&ip_info->ip.addr, &pAddr->sin_addr, 4);
+                if (tmp->ifa_netmask) {
+                    memcpy(&ip_info->netmask.addr, &((struct sockaddr_in *) tmp->ifa_netmask)->sin_addr, 4);
+                }
             }
         }
         tmp = tmp->ifa_next;
@@ -295,6 +295,13 @@
 #define CONFIG_MDNS_TASK_AFFINITY 0x0
 #define CONFIG_MDNS_SERVICE_ADD_TIMEOUT_MS 1
 #define CONFIG_MDNS_TIMER_PERIOD_MS 100
+#ifdef CONFIG_MDNS_SMALL_FOOTPRINT  // make MDNS_SMALL_FOOTPRINT=on
+#define CONFIG_MDNS_ACTION_QUEUE_LEN 8
+#define CONFIG_MDNS_TXT_MAX_LEN 256
+#else
+#define CONFIG_MDNS_ACTION_QUEUE_LEN 16
+#define CONFIG_MDNS_TXT_MAX_LEN 1024
+#endif
 #define CONFIG_MQTT_PROTOCOL_311 1
 #define CONFIG_MQTT_TRANSPORT_SSL 1
 #define CONFIG_MQTT_TRANSPORT_WEBSOCKET 1
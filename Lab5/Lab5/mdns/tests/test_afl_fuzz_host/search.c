@@ -0,0 +1,282 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/*
+ * Search coalescing test -- identical searches share the question on the wire, but each keeps
+ * its own results and its own lifetime
+ *
+ * Two identical PTR searches and a distinct A search are started, one response is injected and
+ * the results of each search are checked. One of the identical searches then times out and is
+ * deleted, and the other must still be indexed, resent on its own schedule and fed by later
+ * responses. Build with SANITIZE=on to catch uses of what the deleted search freed.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "esp32_mock.h"
+#include "mdns.h"
+#include "mdns_private.h"
+
+//
+// Test setup and dependency injected functions (test.c, mdns_di.h)
+void mdns_test_setup(void);
+void mdns_test_parse(const uint8_t *data, size_t len);
+void mdns_test_teardown(void);
+void mdns_test_execute_action(void *action);
+mdns_search_once_t *mdns_test_search_init(const char *name, const char *service, const char *proto, uint16_t type, uint32_t timeout, uint8_t max_results);
+esp_err_t mdns_test_send_search_action(mdns_action_type_t type, mdns_search_once_t *search);
+void mdns_test_search_run(void);
+extern mdns_server_t *_mdns_server;
+
+static int s_checks;
+static int s_failures;
+static int s_questions;     // searches asked by the last send
+
+#define CHECK(cond) check((cond), #cond, __LINE__)
+
+static void check(bool ok, const char *what, int line)
+{
+    s_checks++;
+    if (!ok) {
+        s_failures++;
+        printf("search.c:%d: FAILED %s\n", line, what);
+    }
+}
+
+//
+// Response builder
+static size_t put_name(uint8_t *p, const char *first, const char *rest)
+{
+    const char *parts[2] = { first, rest };
+    size_t len = 0;
+    for (int i = 0; i < 2; i++) {
+        for (const char *label = parts[i]; label && *label;) {
+            const char *dot = strchr(label, '.');
+            size_t n = dot ? (size_t)(dot - label) : strlen(label);
+            p[len++] = n;
+            memcpy(p + len, label, n);
+            len += n;
+            label += n + (dot != NULL);
+        }
+    }
+    p[len++] = 0;
+    return len;
+}
+
+static size_t put_record_head(uint8_t *p, uint16_t type, uint16_t class, uint16_t rdlen)
+{
+    const uint8_t head[] = { type >> 8, type, class >> 8, class, 0, 0, 0, 120, rdlen >> 8, rdlen };
+    memcpy(p, head, sizeof(head));
+    return sizeof(head);
+}
+
+/**
+ * @brief  Response of host "host.local" (10.0.0.7) announcing "<instance>._http._tcp.local" on
+ *         port 80, with TXT "a=one" "b=2"
+ */
+static size_t build_response(uint8_t *p, const char *instance)
+{
+    static const uint8_t header[] = { 0, 0, 0x84, 0, 0, 0, 0, 4, 0, 0, 0, 0 };
+    static const uint8_t txt[] = { 5, 'a', '=', 'o', 'n', 'e', 3, 'b', '=', '2' };
+    static const uint8_t srv[] = { 0, 0, 0, 0, 0, 80 };
+    static const uint8_t addr[] = { 10, 0, 0, 7 };
+    uint8_t rdata[MDNS_NAME_BUF_LEN * 4];
+    size_t len = sizeof(header);
+    size_t n;
+
+    memcpy(p, header, sizeof(header));
+    len += put_name(p + len, "_http._tcp.local", NULL);
+    n = put_name(rdata, instance, "_http._tcp.local");
+    len += put_record_head(p + len, MDNS_TYPE_PTR, 0x0001, n);
+    memcpy(p + len, rdata, n);
+    len += n;
+
+    len += put_name(p + len, instance, "_http._tcp.local");
+    n = put_name(rdata + sizeof(srv), "host.local", NULL);
+    memcpy(rdata, srv, sizeof(srv));
+    len += put_record_head(p + len, MDNS_TYPE_SRV, 0x8001, sizeof(srv) + n);
+    memcpy(p + len, rdata, sizeof(srv) + n);
+    len += sizeof(srv) + n;
+
+    len += put_name(p + len, instance, "_http._tcp.local");
+    len += put_record_head(p + len, MDNS_TYPE_TXT, 0x8001, sizeof(txt));
+    memcpy(p + len, txt, sizeof(txt));
+    len += sizeof(txt);
+
+    len += put_name(p + len, "host.local", NULL);
+    len += put_record_head(p + len, MDNS_TYPE_A, 0x8001, sizeof(addr));
+    memcpy(p + len, addr, sizeof(addr));
+    len += sizeof(addr);
+    return len;
+}
+
+//
+// Search helpers, running the actions the service task would run
+static mdns_search_once_t *start_search(const char *name, const char *service, const char *proto, uint16_t type,
+                                        uint32_t timeout, uint8_t max_results)
+{
+    mdns_search_once_t *search = mdns_test_search_init(name, service, proto, type, timeout, max_results);
+    mdns_action_t *a = NULL;
+    if (!search || mdns_test_send_search_action(ACTION_SEARCH_ADD, search)) {
+        abort();
+    }
+    GetLastItem(&a);
+    mdns_test_execute_action(a);
+    return search;
+}
+
+/**
+ * @brief  One tick of the search timer, the action it posts (send or end of a search) is run
+ *
+ * @return type of the action posted, ACTION_MAX if none
+ */
+static mdns_action_type_t search_tick(void)
+{
+    mdns_action_t *a = NULL;
+    xQueueSend(_mdns_server->action_queue, &a, 0);  // the mock queue keeps the last item only
+    mdns_test_search_run();
+    GetLastItem(&a);
+    if (!a) {
+        return ACTION_MAX;
+    }
+    s_questions = 0;
+    for (mdns_search_once_t *s = _mdns_server->search_once; s; s = s->next) {
+        s_questions += s->send_pending;
+    }
+    mdns_action_type_t type = a->type;
+    mdns_test_execute_action(a);
+    return type;
+}
+
+static bool is_searching(mdns_search_once_t *search)
+{
+    for (mdns_search_once_t *s = _mdns_server->search_once; s; s = s->next) {
+        if (s == search) {
+            return search->state != SEARCH_OFF;
+        }
+    }
+    return false;
+}
+
+static bool is_indexed(mdns_search_once_t *search)
+{
+    for (mdns_search_once_t *s = _mdns_server->search_index[search->key]; s; s = s->index_next) {
+        if (s == search) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static mdns_result_t *find_result(mdns_search_once_t *search, const char *instance)
+{
+    for (mdns_result_t *r = search->result; r; r = r->next) {
+        if (r->instance_name && !strcmp(r->instance_name, instance)) {
+            return r;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief  Delete a finished search like an application would, freeing the results it handed over
+ */
+static esp_err_t delete_search(mdns_search_once_t *search)
+{
+    mdns_result_t *results = NULL;
+    if (!mdns_query_async_get_results(search, 0, &results, NULL)) {
+        return ESP_ERR_TIMEOUT;
+    }
+    mdns_query_results_free(results);
+    return mdns_query_async_delete(search);
+}
+
+static bool is_full_result(mdns_result_t *r)
+{
+    return r && r->hostname && !strcmp(r->hostname, "host") && r->port == 80
+           && r->txt_count == 2 && !strcmp(r->txt[0].key, "a") && !strcmp(r->txt[0].value, "one")
+           && !strcmp(r->txt[1].key, "b") && !strcmp(r->txt[1].value, "2")
+           && r->addr && r->addr->addr.type == ESP_IPADDR_TYPE_V4 && r->addr->addr.u_addr.ip4.addr == 0x0700000a;
+}
+
+int main(void)
+{
+    uint8_t packet[512];
+    size_t len;
+
+    mdns_test_setup();
+    // search packets are only built for interfaces with a pcb
+    _mdns_server->interfaces[0].pcbs[MDNS_IP_PROTOCOL_V4].pcb = (struct udp_pcb *)1;
+
+    // Added in this order, the search list is: distinct, second, first
+    mdns_search_once_t *first = start_search(NULL, "_http", "_tcp", MDNS_TYPE_PTR, 6000, 10);
+    mdns_search_once_t *second = start_search(NULL, "_http", "_tcp", MDNS_TYPE_PTR, 1500, 10);
+    mdns_search_once_t *distinct = start_search("host", NULL, NULL, MDNS_TYPE_A, 6000, 1);
+
+    // One send for the three searches, the question of the identical ones is asked once
+    CHECK(search_tick() == ACTION_SEARCH_SEND);
+    CHECK(s_questions == 2);
+    CHECK(second->state == SEARCH_RUNNING && first->state == SEARCH_RUNNING);
+    CHECK(first->sent_at == second->sent_at);
+    CHECK(!first->send_pending && !second->send_pending && !distinct->send_pending);
+    CHECK(search_tick() == ACTION_MAX);
+
+    len = build_response(packet, "inst");
+    mdns_test_parse(packet, len);
+
+    // Both identical searches have the full result, each in its own copy
+    mdns_result_t *r1 = find_result(first, "inst");
+    mdns_result_t *r2 = find_result(second, "inst");
+    CHECK(first->num_results == 1 && second->num_results == 1);
+    CHECK(is_full_result(r1));
+    CHECK(is_full_result(r2));
+    CHECK(r1 != r2 && r1 && r2 && r1->txt != r2->txt && r1->addr != r2->addr);
+    // The distinct search got its address and is done, the others carry on
+    CHECK(distinct->state == SEARCH_OFF && !is_searching(distinct));
+    CHECK(distinct->num_results == 1 && distinct->result && distinct->result->addr
+          && distinct->result->addr->addr.u_addr.ip4.addr == 0x0700000a);
+    CHECK(is_searching(first) && is_searching(second));
+    CHECK(delete_search(distinct) == ESP_OK);
+
+    // A second later, one packet asks again for both
+    ForceTickAdvance(1100);
+    CHECK(search_tick() == ACTION_SEARCH_SEND);
+    CHECK(s_questions == 1);
+    CHECK(first->sent_at == second->sent_at);
+
+    // The second search times out before the first one is due again: it ends alone and is deleted
+    ForceTickAdvance(450);
+    CHECK(search_tick() == ACTION_SEARCH_END);
+    CHECK(second->state == SEARCH_OFF && !is_searching(second) && !is_indexed(second));
+    CHECK(is_searching(first) && is_indexed(first));
+    CHECK(delete_search(second) == ESP_OK);
+
+    // What the first search holds is its own, and it is still sent and fed
+    CHECK(is_full_result(find_result(first, "inst")));
+    uint32_t sent_at = first->sent_at;
+    ForceTickAdvance(1000);
+    CHECK(search_tick() == ACTION_SEARCH_SEND);
+    CHECK(s_questions == 1);
+    CHECK(first->sent_at > sent_at && !first->send_pending);
+    len = build_response(packet, "other");
+    mdns_test_parse(packet, len);
+    CHECK(first->num_results == 2 && is_full_result(find_result(first, "other")));
+    CHECK(is_full_result(find_result(first, "inst")));
+
+    // ... until its own timeout
+    ForceTickAdvance(6000);
+    CHECK(search_tick() == ACTION_SEARCH_END);
+    CHECK(!is_searching(first) && !is_indexed(first) && _mdns_server->search_once == NULL);
+    CHECK(delete_search(first) == ESP_OK);
+
+    _mdns_server->interfaces[0].pcbs[MDNS_IP_PROTOCOL_V4].pcb = NULL;
+    mdns_test_teardown();
+    printf("search: %d checks, %d failed\n", s_checks, s_failures);
+    return s_failures != 0;
+}
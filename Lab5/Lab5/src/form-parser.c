@@ -0,0 +1,155 @@
+/*  Streaming application/x-www-form-urlencoded parser
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+#include <stdbool.h>
+#include <string.h>
+
+#include "form-parser.h"
+
+static int hex_value(char c)
+{
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    c |= 0x20;
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    return -1;
+}
+
+// Keep the decoded start of a token that continues in the next chunk
+static form_err_t carry(form_parser_t *parser, const char *token, size_t len)
+{
+    size_t limit = parser->in_value ? FORM_MAX_VALUE : FORM_MAX_KEY;
+
+    if (len > limit - parser->carry_len) {
+        return FORM_ERR_TOO_LONG;
+    }
+    memcpy(parser->carry + parser->carry_len, token, len);
+    parser->carry_len += len;
+    parser->partial = 1;
+    return FORM_OK;
+}
+
+/* The token [token, token + len) was decoded in place and ends at a delimiter,
+ * so token[len] may be overwritten */
+static form_err_t end_token(form_parser_t *parser, char *token, size_t len, bool field_end)
+{
+    form_err_t err;
+
+    if (parser->partial) {
+        err = carry(parser, token, len);
+        if (err != FORM_OK) {
+            return err;
+        }
+        token = parser->carry;
+        len = parser->carry_len;
+    } else if (len > (parser->in_value ? FORM_MAX_VALUE : FORM_MAX_KEY)) {
+        return FORM_ERR_TOO_LONG;
+    }
+    token[len] = '\0';
+    parser->partial = 0;
+    parser->carry_len = 0;
+
+    if (!parser->in_value) {
+        memcpy(parser->key, token, len + 1);
+        parser->key_len = len;
+        if (!field_end) {
+            parser->in_value = 1;
+            return FORM_OK;
+        }
+        // "key" without '=' is a field with an empty value; "&&" is nothing
+        if (len == 0) {
+            return FORM_OK;
+        }
+        token = "";
+        len = 0;
+    }
+    parser->in_value = 0;
+    if (parser->on_field(parser->ctx, parser->key, token, len) != 0) {
+        return FORM_ERR_ABORTED;
+    }
+    return FORM_OK;
+}
+
+void form_parser_init(form_parser_t *parser, form_field_cb_t on_field, void *ctx)
+{
+    memset(parser, 0, sizeof(*parser));
+    parser->on_field = on_field;
+    parser->ctx = ctx;
+}
+
+form_err_t form_parser_feed(form_parser_t *parser, char *data, size_t len)
+{
+    const char *end = data + len;
+    const char *in = data;
+    char *token = data;
+    char *out = data;           // decoding never outruns the input
+
+    while (in < end && parser->error == FORM_OK) {
+        char c = *in++;
+
+        if (parser->escape > 0) {
+            int digit = hex_value(c);
+            if (digit < 0) {
+                parser->error = FORM_ERR_FORMAT;
+                break;
+            }
+            if (--parser->escape == 1) {
+                parser->hex = digit;
+            } else if (!parser->in_value && parser->hex == 0 && digit == 0) {
+                // Keys are handed over NUL terminated: "ssid%00x" would read as "ssid"
+                parser->error = FORM_ERR_FORMAT;
+                break;
+            } else {
+                *out++ = (char)(parser->hex << 4 | digit);
+            }
+            continue;
+        }
+        switch (c) {
+        case '%':
+            parser->escape = 2;
+            break;
+        case '+':
+            *out++ = ' ';
+            break;
+        case '=':
+            if (parser->in_value) {
+                *out++ = c;     // only the first '=' separates key and value
+                break;
+            }
+            /* fall through */
+        case '&':
+            parser->error = end_token(parser, token, out - token, c == '&');
+            token = out = (char *)in;
+            break;
+        default:
+            *out++ = c;
+            break;
+        }
+    }
+
+    if (parser->error == FORM_OK && out > token) {
+        parser->error = carry(parser, token, out - token);
+    }
+    return parser->error;
+}
+
+form_err_t form_parser_finish(form_parser_t *parser)
+{
+    if (parser->error != FORM_OK) {
+        return parser->error;
+    }
+    if (parser->escape > 0) {
+        parser->error = FORM_ERR_FORMAT;
+    } else if (parser->partial || parser->in_value) {
+        parser->error = end_token(parser, parser->carry + parser->carry_len, 0, true);
+    }
+    return parser->error;
+}
@@ -0,0 +1,107 @@
+/*  Streaming HTML rendering
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+#include <string.h>
+
+#include "html-render.h"
+
+static void flush(html_writer_t *writer)
+{
+    if (writer->len > 0 && writer->error == 0) {
+        writer->error = writer->sink(writer->ctx, writer->buffer, writer->len);
+    }
+    writer->len = 0;
+}
+
+void html_writer_init(html_writer_t *writer, html_sink_t sink, void *ctx)
+{
+    writer->sink = sink;
+    writer->ctx = ctx;
+    writer->error = 0;
+    writer->len = 0;
+}
+
+void html_write(html_writer_t *writer, const char *data, size_t len)
+{
+    while (len > 0) {
+        size_t n = sizeof(writer->buffer) - writer->len;
+        if (n > len) {
+            n = len;
+        }
+        memcpy(writer->buffer + writer->len, data, n);
+        writer->len += n;
+        data += n;
+        len -= n;
+        if (writer->len == sizeof(writer->buffer)) {
+            flush(writer);
+        }
+    }
+}
+
+void html_write_str(html_writer_t *writer, const char *str)
+{
+    html_write(writer, str, strlen(str));
+}
+
+void html_write_escaped(html_writer_t *writer, const char *text, size_t len)
+{
+    const char *end = text + len;
+    const char *run = text;
+
+    // Copy runs of plain characters in one go, replace the rest
+    for (; text < end && *text != '\0'; text++) {
+        const char *entity;
+        switch (*text) {
+        case '&':  entity = "&amp;";  break;
+        case '<':  entity = "&lt;";   break;
+        case '>':  entity = "&gt;";   break;
+        case '"':  entity = "&quot;"; break;
+        case '\'': entity = "&#39;";  break;
+        default:   continue;
+        }
+        html_write(writer, run, text - run);
+        html_write_str(writer, entity);
+        run = text + 1;
+    }
+    html_write(writer, run, text - run);
+}
+
+void html_render_template(html_writer_t *writer, const char *tpl, const html_slot_t *slots, size_t slot_count)
+{
+    const char *mark;
+
+    while ((mark = strchr(tpl, '#')) != NULL) {
+        const char *close = strchr(mark + 1, '#');
+        const html_slot_t *slot = NULL;
+
+        if (close != NULL) {
+            for (size_t i = 0; i < slot_count; i++) {
+                size_t len = close - mark - 1;
+                if (strncmp(slots[i].name, mark + 1, len) == 0 && slots[i].name[len] == '\0') {
+                    slot = &slots[i];
+                    break;
+                }
+            }
+        }
+        if (slot == NULL) {
+            html_write(writer, tpl, mark + 1 - tpl);
+            tpl = mark + 1;
+            continue;
+        }
+        html_write(writer, tpl, mark - tpl);
+        slot->render(writer, slot->arg);
+        tpl = close + 1;
+    }
+    html_write_str(writer, tpl);
+}
+
+int html_render_end(html_writer_t *writer)
+{
+    flush(writer);
+    return writer->error;
+}
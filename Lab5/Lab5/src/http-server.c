@@ -16,54 +16,138 @@
 
 #include "esp_log.h"
 
-wifi_ap_record_t* ap_records;
-uint16_t ap_count;
+#include "form-parser.h"
+#include "html-render.h"
+#include "index-page.h"
+#include "wifi-scan.h"
 
-const char indexPage[] = "<html><body><form action=\"/results.html\" target=\"_blank\" method=\"post\"><label for=\"fname\">Networks found:</label><br><select name=\"ssid\">#OPTIONS#</select><br><label for=\"ipass\">Security key:</label><br><input type=\"password\" name=\"ipass\"><br><input type=\"submit\" value=\"Submit\"></form></body></html>";
+/* Longest accepted form body; it is parsed in chunks of RECV_CHUNK bytes */
+#define MAX_FORM_BODY 1024
+#define RECV_CHUNK 128
 
-const char optionTemplate[] = "<option value=\"%s\">%s</option>";
+static const char *TAG = "http server";
+
+/* Static files, gzipped by assets.py and embedded at build time */
+extern const uint8_t style_css_gz_start[] asm("_binary_style_css_gz_start");
+extern const uint8_t style_css_gz_end[] asm("_binary_style_css_gz_end");
+
+typedef struct {
+    const char *type;
+    const uint8_t *start;
+    const uint8_t *end;
+} static_asset_t;
+
+static const static_asset_t style_css = { "text/css", style_css_gz_start, style_css_gz_end };
+
+static int send_chunk(void *ctx, const char *data, size_t len)
+{
+    return httpd_resp_send_chunk((httpd_req_t *)ctx, data, len) == ESP_OK ? 0 : -1;
+}
 
 /* Our URI handler function to be called during GET /uri request */
 esp_err_t get_handler(httpd_req_t *req)
 {
-    /* Send a simple response */
-    // read the results.html file and send it as a response 
-        
-    httpd_resp_send(req, indexPage, HTTPD_RESP_USE_STRLEN);  // TODO: Trimitere sir de caractere ce contine pagina web prezentata in laborator (lista populata cu rezultatele scanarii)
-    return ESP_OK;
+    const wifi_scan_result_t *scan = wifi_scan_acquire();
+    int err;
+
+    /* The page goes out in chunks through a fixed buffer, whatever the
+     * number of networks found */
+    httpd_resp_set_type(req, "text/html");
+    err = index_page_render(scan, send_chunk, req);
+    wifi_scan_release(scan);
+    if (err != 0) {
+        return ESP_FAIL;
+    }
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+esp_err_t asset_handler(httpd_req_t *req)
+{
+    const static_asset_t *asset = req->user_ctx;
+
+    httpd_resp_set_type(req, asset->type);
+    httpd_resp_set_hdr(req, "Content-Encoding", "gzip");
+    httpd_resp_set_hdr(req, "Cache-Control", "max-age=86400");
+    return httpd_resp_send(req, (const char *)asset->start, asset->end - asset->start);
+}
+
+typedef struct {
+    char ssid[33];
+    char pass[65];
+} credentials_t;
+
+static int on_form_field(void *ctx, const char *key, const char *value, size_t value_len)
+{
+    credentials_t *credentials = ctx;
+    char *dest;
+    size_t size;
+
+    if (strcmp(key, "ssid") == 0) {
+        dest = credentials->ssid;
+        size = sizeof(credentials->ssid);
+    } else if (strcmp(key, "ipass") == 0) {
+        dest = credentials->pass;
+        size = sizeof(credentials->pass);
+    } else {
+        return 0;   // other fields are ignored
+    }
+    if (value_len >= size) {
+        return -1;
+    }
+    memcpy(dest, value, value_len + 1);
+    return 0;
 }
 
 /* Our URI handler function to be called during POST /uri request */
 esp_err_t post_handler(httpd_req_t *req)
 {
-    /* Destination buffer for content of HTTP POST request.
-     * httpd_req_recv() accepts char* only, but content could
-     * as well be any binary data (needs type casting).
-     * In case of string data, null termination will be absent, and
-     * content length would give length of string */
-    char content[100];
-
-    /* Truncate if content length larger than the buffer */
-    size_t recv_size = MIN(req->content_len, sizeof(content));
-
-    int ret = httpd_req_recv(req, content, recv_size);
-    if (ret <= 0) {  /* 0 return value indicates connection closed */
-        /* Check if timeout occurred */
-        if (ret == HTTPD_SOCK_ERR_TIMEOUT) {
-            /* In case of timeout one can choose to retry calling
-             * httpd_req_recv(), but to keep it simple, here we
-             * respond with an HTTP 408 (Request Timeout) error */
-            httpd_resp_send_408(req);
-        }
-        /* In case of error, returning ESP_FAIL will
-         * ensure that the underlying socket is closed */
+    /* The body is parsed as it arrives, so it may be split across any
+     * number of TCP segments and only RECV_CHUNK bytes are buffered */
+    char content[RECV_CHUNK];
+    size_t remaining = req->content_len;
+    credentials_t credentials = { 0 };
+    form_parser_t parser;
+    html_writer_t writer;
+
+    if (remaining > MAX_FORM_BODY) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Form too large");
         return ESP_FAIL;
     }
 
-    /* Send a simple response */
-    const char resp[] = "URI POST Response";
-    httpd_resp_send(req, resp, HTTPD_RESP_USE_STRLEN);  // TODO: Inlocuire cu un sir de caractere ce contine SSID selectat & parola introdusa
-    return ESP_OK;
+    form_parser_init(&parser, on_form_field, &credentials);
+    while (remaining > 0) {
+        int ret = httpd_req_recv(req, content, MIN(remaining, sizeof(content)));
+        if (ret <= 0) {  /* 0 return value indicates connection closed */
+            /* Retry if timeout occurred */
+            if (ret == HTTPD_SOCK_ERR_TIMEOUT) {
+                continue;
+            }
+            /* In case of error, returning ESP_FAIL will
+             * ensure that the underlying socket is closed */
+            return ESP_FAIL;
+        }
+        remaining -= ret;
+        if (form_parser_feed(&parser, content, ret) != FORM_OK) {
+            break;
+        }
+    }
+    if (form_parser_finish(&parser) != FORM_OK || credentials.ssid[0] == '\0') {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid form");
+        return ESP_FAIL;
+    }
+    ESP_LOGI(TAG, "Credentials received for SSID %s", credentials.ssid);
+
+    httpd_resp_set_type(req, "text/html");
+    html_writer_init(&writer, send_chunk, req);
+    html_write_str(&writer, "<html><body>SSID: ");
+    html_write_escaped(&writer, credentials.ssid, sizeof(credentials.ssid));
+    html_write_str(&writer, "<br>Security key: ");
+    html_write_escaped(&writer, credentials.pass, sizeof(credentials.pass));
+    html_write_str(&writer, "</body></html>");
+    if (html_render_end(&writer) != 0) {
+        return ESP_FAIL;
+    }
+    return httpd_resp_send_chunk(req, NULL, 0);
 }
 
 /* URI handler structure for GET /uri */
@@ -74,6 +158,13 @@ httpd_uri_t uri_get = {
     .user_ctx = NULL
 };
 
+httpd_uri_t uri_style = {
+    .uri      = "/style.css",
+    .method   = HTTP_GET,
+    .handler  = asset_handler,
+    .user_ctx = (void *)&style_css
+};
+
 /* URI handler structure for POST /uri */
 httpd_uri_t uri_post = {
     .uri      = "/results.html",
@@ -97,6 +188,7 @@ httpd_handle_t start_webserver()
         /* Register URI handlers */
         httpd_register_uri_handler(server, &uri_get);
         httpd_register_uri_handler(server, &uri_post);
+        httpd_register_uri_handler(server, &uri_style);
     }
     /* If server failed to start, handle will be NULL */
     return server;
@@ -0,0 +1,81 @@
+/*  Provisioning page
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+#include <stdint.h>
+#include <string.h>
+
+#include "index-page.h"
+
+static const char indexPage[] = "<html><head><link rel=\"stylesheet\" href=\"/style.css\"></head><body><form action=\"/results.html\" target=\"_blank\" method=\"post\"><label for=\"fname\">Networks found:</label><br><select name=\"ssid\">#OPTIONS#</select><br><label for=\"ipass\">Security key:</label><br><input type=\"password\" name=\"ipass\"><br><input type=\"submit\" value=\"Submit\"></form></body></html>";
+
+/* One <option> per SSID, strongest first. Only indexes are sorted, so the
+ * records are not copied and the page is written as it is rendered. */
+static void render_options(html_writer_t *writer, void *arg)
+{
+    const wifi_scan_result_t *scan = arg;
+    const wifi_ap_record_t *ap_records = scan->records;
+    uint16_t order[INDEX_PAGE_MAX_OPTIONS];
+    size_t count = 0;
+
+    for (uint16_t i = 0; i < scan->count; i++) {
+        const wifi_ap_record_t *ap = &ap_records[i];
+        size_t pos;
+
+        if (ap->ssid[0] == '\0') {
+            continue;       // hidden network
+        }
+        // An SSID seen on several APs is listed once, with the best RSSI
+        for (pos = 0; pos < count; pos++) {
+            if (strncmp((const char *)ap_records[order[pos]].ssid, (const char *)ap->ssid, sizeof(ap->ssid)) == 0) {
+                break;
+            }
+        }
+        if (pos < count) {
+            if (ap_records[order[pos]].rssi >= ap->rssi) {
+                continue;
+            }
+            memmove(&order[pos], &order[pos + 1], (count - pos - 1) * sizeof(order[0]));
+            count--;
+        }
+        // Insertion sort; past INDEX_PAGE_MAX_OPTIONS the weakest network drops out
+        pos = count;
+        while (pos > 0 && ap_records[order[pos - 1]].rssi < ap->rssi) {
+            pos--;
+        }
+        if (pos == INDEX_PAGE_MAX_OPTIONS) {
+            continue;
+        }
+        if (count == INDEX_PAGE_MAX_OPTIONS) {
+            count--;
+        }
+        memmove(&order[pos + 1], &order[pos], (count - pos) * sizeof(order[0]));
+        order[pos] = i;
+        count++;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        const char *ssid = (const char *)ap_records[order[i]].ssid;
+        html_write_str(writer, "<option value=\"");
+        html_write_escaped(writer, ssid, sizeof(ap_records[0].ssid));
+        html_write_str(writer, "\">");
+        html_write_escaped(writer, ssid, sizeof(ap_records[0].ssid));
+        html_write_str(writer, "</option>");
+    }
+}
+
+int index_page_render(const wifi_scan_result_t *scan, html_sink_t sink, void *ctx)
+{
+    const html_slot_t slots[] = {
+        { "OPTIONS", render_options, (void *)scan },
+    };
+    html_writer_t writer;
+
+    html_writer_init(&writer, sink, ctx);
+    html_render_template(&writer, indexPage, slots, sizeof(slots) / sizeof(slots[0]));
+    return html_render_end(&writer);
+}
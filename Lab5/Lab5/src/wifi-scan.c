@@ -0,0 +1,124 @@
+/*  Background Wi-Fi scan service
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+#include <stdatomic.h>
+#include <stdbool.h>
+#include "esp_event.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "wifi-scan.h"
+
+static const char *TAG = "WIFI_SCAN";
+
+/* Two tables: readers use the published one while a finished scan is copied
+ * into the other, which is then published in a single store */
+static wifi_scan_result_t s_results[2];
+static atomic_int s_published;
+static atomic_int s_readers[2];
+static atomic_bool s_scanning;
+static esp_timer_handle_t s_refresh_timer;
+
+static void scan_done(const wifi_event_sta_scan_done_t *event)
+{
+    int next = !atomic_load(&s_published);
+    wifi_scan_result_t *result = &s_results[next];
+    uint16_t count = WIFI_SCAN_MAX_APS;
+
+    atomic_store(&s_scanning, false);
+    if (event->status != 0) {
+        // Failed scan, keep the last good results
+        esp_wifi_clear_ap_list();
+        return;
+    }
+    if (atomic_load(&s_readers[next]) != 0) {
+        // Still read from before the last swap; keep the current results
+        esp_wifi_clear_ap_list();
+        ESP_LOGD(TAG, "Results dropped, table busy");
+        return;
+    }
+    // Copies at most WIFI_SCAN_MAX_APS records and frees the driver's list
+    if (esp_wifi_scan_get_ap_records(&count, result->records) != ESP_OK) {
+        return;
+    }
+    result->count = count;
+    result->timestamp_us = esp_timer_get_time();
+    atomic_store(&s_published, next);
+    ESP_LOGI(TAG, "Found %d access points", count);
+}
+
+static void scan_event_handler(void *arg, esp_event_base_t event_base, int32_t event_id, void *event_data)
+{
+    if (event_id == WIFI_EVENT_SCAN_DONE) {
+        scan_done(event_data);
+    }
+}
+
+static void refresh_timer_cb(void *arg)
+{
+    wifi_scan_request();
+}
+
+esp_err_t wifi_scan_request(void)
+{
+    const wifi_scan_config_t scan_config = {
+        .show_hidden = true,
+    };
+
+    if (atomic_exchange(&s_scanning, true)) {
+        return ESP_OK;
+    }
+    esp_err_t err = esp_wifi_scan_start(&scan_config, false);
+    if (err != ESP_OK) {
+        atomic_store(&s_scanning, false);
+        ESP_LOGW(TAG, "Scan not started: %s", esp_err_to_name(err));
+    }
+    return err;
+}
+
+esp_err_t wifi_scan_start(void)
+{
+    const esp_timer_create_args_t timer_args = {
+        .callback = refresh_timer_cb,
+        .name = "wifi_scan",
+    };
+
+    ESP_ERROR_CHECK(esp_event_handler_instance_register(WIFI_EVENT, WIFI_EVENT_SCAN_DONE,
+                                                        &scan_event_handler, NULL, NULL));
+    ESP_ERROR_CHECK(esp_timer_create(&timer_args, &s_refresh_timer));
+    ESP_ERROR_CHECK(esp_timer_start_periodic(s_refresh_timer, WIFI_SCAN_REFRESH_MS * 1000ULL));
+    return wifi_scan_request();
+}
+
+const wifi_scan_result_t *wifi_scan_acquire(void)
+{
+    const wifi_scan_result_t *result;
+    int index;
+
+    // Pin the published table; if it changed meanwhile, pin the new one
+    do {
+        index = atomic_load(&s_published);
+        atomic_fetch_add(&s_readers[index], 1);
+        if (atomic_load(&s_published) == index) {
+            break;
+        }
+        atomic_fetch_sub(&s_readers[index], 1);
+    } while (true);
+    result = &s_results[index];
+
+    if (result->timestamp_us == 0 ||
+        esp_timer_get_time() - result->timestamp_us > WIFI_SCAN_MAX_AGE_MS * 1000LL) {
+        wifi_scan_request();
+    }
+    return result;
+}
+
+void wifi_scan_release(const wifi_scan_result_t *result)
+{
+    atomic_fetch_sub(&s_readers[result - s_results], 1);
+}
@@ -0,0 +1,84 @@
+/*  Host benchmark of the streaming form parser
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+
+   Parses typical provisioning bodies in the 128 byte chunks post_handler()
+   receives, and prints the throughput of each:
+
+     make INSTR=off bench
+     ./bench [iterations]
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "form-parser.h"
+
+/* Same as RECV_CHUNK in http-server.c */
+#define RECV_CHUNK  128
+
+static const char *const bodies[] = {
+    "ssid=HomeNetwork&ipass=hunter2",
+    "ssid=Caf%C3%A9+Wi-Fi&ipass=p%40ss%26word%3D1",
+    "ssid=Office+Guest+Network+5GHz&ipass=correct+horse+battery+staple+%21%21&submit=Connect",
+    "ssid=%E5%AE%B6%E5%BA%AD%E7%BD%91%E7%BB%9C&ipass=0123456789abcdef0123456789abcdef0123456789abcdef"
+    "&remember=on&hidden=off&channel=6&country=CN&timezone=Asia%2FShanghai",
+};
+
+static size_t s_fields;
+
+static int on_field(void *ctx, const char *key, const char *value, size_t value_len)
+{
+    (void)ctx;
+    (void)key;
+    (void)value;
+    s_fields += value_len > 0;
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    long iterations = argc > 1 ? atol(argv[1]) : 1000000;
+    char chunk[RECV_CHUNK];
+
+    for (size_t i = 0; i < sizeof(bodies) / sizeof(bodies[0]); i++) {
+        size_t len = strlen(bodies[i]);
+        struct timespec start, end;
+        double seconds;
+        int failures = 0;
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (long n = 0; n < iterations; n++) {
+            form_parser_t parser;
+            form_err_t err = FORM_OK;
+
+            form_parser_init(&parser, on_field, NULL);
+            for (size_t pos = 0; pos < len && err == FORM_OK; pos += RECV_CHUNK) {
+                size_t chunk_len = len - pos < RECV_CHUNK ? len - pos : RECV_CHUNK;
+
+                // The parser decodes in place, like httpd_req_recv() into its buffer
+                memcpy(chunk, bodies[i] + pos, chunk_len);
+                err = form_parser_feed(&parser, chunk, chunk_len);
+            }
+            if (err != FORM_OK || form_parser_finish(&parser) != FORM_OK) {
+                failures++;
+            }
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+
+        seconds = (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+        printf("%4u byte body: %6.0f ns/body, %6.1f MB/s%s\n", (unsigned)len,
+               seconds * 1e9 / (double)iterations,
+               (double)len * (double)iterations / seconds / 1e6,
+               failures ? " FAILED" : "");
+        if (failures) {
+            return 1;
+        }
+    }
+    return 0;
+}
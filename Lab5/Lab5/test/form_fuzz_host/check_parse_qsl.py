@@ -0,0 +1,90 @@
+"""Compare the form parser with Python's urllib.parse.parse_qsl.
+
+Generates random bodies of valid escapes, '+', '&' and '=' and runs each
+through "test_sim -p", which prints the decoded fields in hex and the result. A
+field whose decoded key is longer than FORM_MAX_KEY or whose value is longer
+than FORM_MAX_VALUE must fail with FORM_ERR_TOO_LONG, and a key with a %00
+in it with FORM_ERR_FORMAT.
+
+    python3 check_parse_qsl.py [-n COUNT] ./test_sim
+"""
+import argparse
+import random
+import subprocess
+import sys
+from urllib.parse import parse_qsl
+
+# Same values as include/form-parser.h
+FORM_MAX_KEY = 16
+FORM_MAX_VALUE = 64
+FORM_ERR_TOO_LONG = -1
+FORM_ERR_FORMAT = -2
+MAX_FORM_BODY = 1024
+
+ALPHABET = b'abcXYZ019-_.~ +&=%'
+
+
+def random_body(rng):
+    out = bytearray()
+    for _ in range(rng.randrange(0, 120)):
+        c = rng.choice(ALPHABET)
+        if c == ord('%'):
+            out += b'%%%02X' % rng.randrange(256)
+        else:
+            out.append(c)
+    # A few long fields, around the limits
+    if rng.random() < 0.2:
+        out += b'&' + b'k' * rng.randrange(FORM_MAX_KEY - 1, FORM_MAX_KEY + 2)
+        out += b'=' + b'%41' * rng.randrange(FORM_MAX_VALUE - 1, FORM_MAX_VALUE + 2)
+    assert len(out) <= MAX_FORM_BODY
+    return bytes(out)
+
+
+def expected(body):
+    fields = parse_qsl(body.decode('latin-1'), keep_blank_values=True, encoding='latin-1')
+    for key, value in fields:
+        if '\0' in key:
+            return FORM_ERR_FORMAT
+        if len(key) > FORM_MAX_KEY or len(value) > FORM_MAX_VALUE:
+            return FORM_ERR_TOO_LONG
+    return fields
+
+
+def parse(binary, body):
+    out = subprocess.run([binary, '-p'], input=body, stdout=subprocess.PIPE, check=True).stdout
+    lines = out.decode('latin-1').splitlines()
+    err = int(lines[-1].split()[1])
+    fields = []
+    for line in lines[:-1]:
+        key, value = line.split('\t')
+        fields.append((bytes.fromhex(key).decode('latin-1'), bytes.fromhex(value).decode('latin-1')))
+    return err, fields
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('-n', type=int, default=3000, help='number of bodies')
+    parser.add_argument('--seed', type=int, default=1)
+    parser.add_argument('binary')
+    args = parser.parse_args()
+
+    rng = random.Random(args.seed)
+    failures = 0
+    for _ in range(args.n):
+        body = random_body(rng)
+        want = expected(body)
+        err, fields = parse(args.binary, body)
+        if isinstance(want, int):
+            ok = err == want
+        else:
+            ok = err == 0 and fields == want
+        if not ok:
+            failures += 1
+            if failures <= 5:
+                print('MISMATCH {!r}: got {} {!r}, expected {!r}'.format(body, err, fields, want))
+    print('{} bodies, {} mismatches'.format(args.n, failures))
+    return 1 if failures else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,170 @@
+/*  AFL target for the streaming form parser
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+
+   The first byte of an input selects how the rest, the form body, is split
+   into chunks. The body is parsed in one chunk and in the split chunks; both
+   must succeed with the same fields or both fail, and every field must
+   respect the limits of form-parser.h. Any difference aborts, which AFL reports as a
+   crash. Each chunk is a separate allocation, so ASan catches reads past it.
+*/
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "form-parser.h"
+
+/* Same limit as post_handler() */
+#define MAX_FORM_BODY   1024
+#define MAX_CHUNK       128
+
+typedef struct {
+    char text[8 * MAX_FORM_BODY];
+    size_t len;
+    int fields;
+    FILE *print;
+} transcript_t;
+
+static void append(transcript_t *t, const void *data, size_t len)
+{
+    if (len > sizeof(t->text) - t->len) {
+        abort();
+    }
+    memcpy(t->text + t->len, data, len);
+    t->len += len;
+}
+
+static int on_field(void *ctx, const char *key, const char *value, size_t value_len)
+{
+    transcript_t *t = ctx;
+    size_t key_len = strlen(key);
+
+    if (key_len > FORM_MAX_KEY || value_len > FORM_MAX_VALUE || value[value_len] != '\0') {
+        abort();
+    }
+    append(t, key, key_len + 1);
+    append(t, &value_len, sizeof(value_len));
+    append(t, value, value_len);
+    t->fields++;
+    if (t->print != NULL) {
+        for (size_t i = 0; i < key_len; i++) {
+            fprintf(t->print, "%02x", (unsigned char)key[i]);
+        }
+        fprintf(t->print, "\t");
+        for (size_t i = 0; i < value_len; i++) {
+            fprintf(t->print, "%02x", (unsigned char)value[i]);
+        }
+        fprintf(t->print, "\n");
+    }
+    return 0;
+}
+
+/* Parse body in chunks of 1 to MAX_CHUNK bytes drawn from seed, or in one
+ * chunk when seed is 0 */
+static form_err_t parse(const char *body, size_t len, unsigned seed, transcript_t *t)
+{
+    form_parser_t parser;
+    form_err_t err = FORM_OK;
+    size_t pos = 0;
+
+    memset(t, 0, offsetof(transcript_t, print));
+    form_parser_init(&parser, on_field, t);
+    while (pos < len && err == FORM_OK) {
+        size_t chunk_len = len - pos;
+        char *chunk;
+
+        if (seed != 0) {
+            seed = seed * 1103515245u + 12345u;
+            chunk_len = 1 + (seed >> 16) % MAX_CHUNK;
+            if (chunk_len > len - pos) {
+                chunk_len = len - pos;
+            }
+        }
+        chunk = malloc(chunk_len);
+        memcpy(chunk, body + pos, chunk_len);
+        err = form_parser_feed(&parser, chunk, chunk_len);
+        free(chunk);
+        pos += chunk_len;
+    }
+    if (err == FORM_OK) {
+        err = form_parser_finish(&parser);
+    }
+    return err;
+}
+
+static void check(const uint8_t *input, size_t len)
+{
+    static transcript_t whole, split;
+    form_err_t whole_err, split_err;
+    size_t shortest;
+
+    if (len == 0) {
+        return;
+    }
+    whole_err = parse((const char *)input + 1, len - 1, 0, &whole);
+    split_err = parse((const char *)input + 1, len - 1, 1u + input[0], &split);
+    if ((whole_err == FORM_OK) != (split_err == FORM_OK)) {
+        abort();
+    }
+    /* A chunk boundary can reveal an over-long token before a bad escape
+     * further into it, so after an error the code and where it was found
+     * may differ. The fields reported before it are the same. */
+    shortest = whole.len < split.len ? whole.len : split.len;
+    if ((whole_err == FORM_OK && whole.len != split.len)
+            || memcmp(whole.text, split.text, shortest) != 0) {
+        abort();
+    }
+}
+
+int main(int argc, char **argv)
+{
+    static uint8_t buf[1 + MAX_FORM_BODY];
+    size_t len;
+
+#ifdef INSTR_IS_OFF
+    // -p: print the fields of the body on stdin, for check_parse_qsl.py
+    if (argc == 2 && strcmp(argv[1], "-p") == 0) {
+        static transcript_t t;
+        form_err_t err;
+
+        len = fread(buf, 1, MAX_FORM_BODY, stdin);
+        t.print = stdout;
+        err = parse((const char *)buf, len, 0, &t);
+        printf("ERR %d\n", err);
+        return 0;
+    }
+    if (argc < 2) {
+        printf("Non-instrumentation mode: please supply the files created by AFL to reproduce a crash\n");
+        return 1;
+    }
+    for (int i = 1; i < argc; i++) {
+        FILE *file = fopen(argv[i], "rb");
+
+        if (file == NULL) {
+            perror(argv[i]);
+            return 1;
+        }
+        len = fread(buf, 1, sizeof(buf), file);
+        fclose(file);
+        check(buf, len);
+    }
+    printf("%d inputs OK\n", argc - 1);
+#else
+    (void)argc;
+    (void)argv;
+    while (__AFL_LOOP(1000)) {
+        ssize_t ret = read(0, buf, sizeof(buf));
+
+        len = ret > 0 ? (size_t)ret : 0;
+        check(buf, len);
+    }
+#endif
+    return 0;
+}
@@ -0,0 +1,149 @@
+/*  Host benchmark of the provisioning page
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+
+   Renders the page get_handler() sends over a few scan tables, each flush
+   copied out as httpd_resp_send_chunk() would, and prints the throughput
+   of each:
+
+     make bench
+     ./render_bench [iterations]
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "index-page.h"
+
+#define PAGE_MAX    16384
+
+typedef struct {
+    char data[PAGE_MAX + 1];        /* NUL terminated for the check */
+    size_t len;
+    size_t chunks;
+} page_t;
+
+typedef struct {
+    const char *name;
+    wifi_scan_result_t scan;
+    size_t options;             /* expected in the page */
+} table_t;
+
+static int copy_chunk(void *ctx, const char *data, size_t len)
+{
+    page_t *page = ctx;
+
+    if (page->len + len > PAGE_MAX) {
+        return -1;
+    }
+    memcpy(page->data + page->len, data, len);
+    page->len += len;
+    page->chunks++;
+    return 0;
+}
+
+static void add_ap(wifi_scan_result_t *scan, const char *ssid, int8_t rssi)
+{
+    wifi_ap_record_t *ap = &scan->records[scan->count++];
+    size_t len = strlen(ssid);
+
+    memset(ap, 0, sizeof(*ap));
+    memcpy(ap->ssid, ssid, len < sizeof(ap->ssid) ? len : sizeof(ap->ssid) - 1);
+    ap->rssi = rssi;
+}
+
+/* Nothing found yet: the page without options */
+static void fill_empty(table_t *table)
+{
+    table->name = "no networks";
+    table->options = 0;
+}
+
+/* A dozen APs, one of them hidden and two SSIDs seen twice */
+static void fill_typical(table_t *table)
+{
+    static const char *const ssids[] = {
+        "HomeNetwork", "HomeNetwork", "NETGEAR42", "Office Guest", "eduroam", "",
+        "TP-Link_5G_A1B2", "Vodafone-3F2C", "eduroam", "DIRECT-7a-HP Printer",
+        "Cafe & Bar", "iPhone de Marie",
+    };
+
+    table->name = "typical";
+    for (size_t i = 0; i < sizeof(ssids) / sizeof(ssids[0]); i++) {
+        add_ap(&table->scan, ssids[i], (int8_t)(-40 - 5 * (int)i));
+    }
+    table->options = 9;
+}
+
+/* As many APs as a scan keeps, each a different 32 character SSID to escape */
+static void fill_full(table_t *table)
+{
+    table->name = "full, escaped";
+    for (int i = 0; i < WIFI_SCAN_MAX_APS; i++) {
+        char ssid[33];
+
+        snprintf(ssid, sizeof(ssid), "Net %02d <5GHz> \"Tom & Jerry's\" x", i);
+        add_ap(&table->scan, ssid, (int8_t)(-30 - (i * 37) % 60));
+    }
+    table->options = INDEX_PAGE_MAX_OPTIONS;
+}
+
+static int check_page(const table_t *table, const page_t *page)
+{
+    size_t options = 0;
+    const char *p = page->data;
+
+    while ((p = strstr(p, "<option ")) != NULL) {
+        options++;
+        p++;
+    }
+    return page->len > 13 && memcmp(page->data, "<html>", 6) == 0
+        && memcmp(page->data + page->len - 7, "</html>", 7) == 0 && options == table->options;
+}
+
+int main(int argc, char **argv)
+{
+    long iterations = argc > 1 ? atol(argv[1]) : 200000;
+    static table_t tables[3];
+    static page_t page;
+
+    fill_empty(&tables[0]);
+    fill_typical(&tables[1]);
+    fill_full(&tables[2]);
+
+    for (size_t i = 0; i < sizeof(tables) / sizeof(tables[0]); i++) {
+        struct timespec start, end;
+        double seconds;
+        int failures = 0;
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (long n = 0; n < iterations; n++) {
+            page.len = 0;
+            page.chunks = 0;
+            if (index_page_render(&tables[i].scan, copy_chunk, &page) != 0) {
+                failures++;
+            }
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        page.data[page.len] = '\0';
+        if (!check_page(&tables[i], &page)) {
+            failures++;
+        }
+
+        seconds = (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+        printf("%-14s %2u APs: %5u byte page in %u chunks, %6.0f ns/page, %7.1f MB/s%s\n",
+               tables[i].name, (unsigned)tables[i].scan.count, (unsigned)page.len,
+               (unsigned)page.chunks, seconds * 1e9 / (double)iterations,
+               (double)page.len * (double)iterations / seconds / 1e6,
+               failures ? " FAILED" : "");
+        if (failures) {
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,11 @@
+/* Host stand-in for the ESP-IDF header: the fields of a scan record the page reads */
+#pragma once
+
+#include <stdint.h>
+
+typedef struct {
+    uint8_t bssid[6];
+    uint8_t ssid[33];
+    uint8_t primary;
+    int8_t rssi;
+} wifi_ap_record_t;
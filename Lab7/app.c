@@ -30,11 +30,22 @@
 #include "sl_common.h"
 #include "sl_bt_api.h"
 #include "app_assert.h"
+#include "app_log.h"
+#include "sl_bt_scanner_filter.h"
 #include "app.h"
 
 // The advertising set handle allocated from Bluetooth stack.
 static uint8_t advertising_set_handle = 0xff;
 
+// Advertisement reports forwarded to the log.
+static const sl_bt_scanner_filter_rule_t scanner_rules[] = {
+  {
+    .match = SL_BT_SCANNER_FILTER_MATCH_MANUFACTURER,
+    .rssi_min = -90,
+    .manufacturer_id = 0x004c, // iBeacon
+  },
+};
+
 // Application Init.
 SL_WEAK void app_init(void)
 {
@@ -66,29 +77,7 @@ void sl_bt_on_event(sl_bt_msg_t *evt)
 {
   sl_status_t sc;
 
-  uint8_t *p, *pend;
-  uint8_t ad_len, ad_type;
-
   switch (SL_BT_MSG_ID(evt->header)) {
-    case sl_bt_evt_scanner_legacy_advertisement_report_id:
-      p = evt->data.evt_scanner_legacy_advertisement_report.data.data;
-      pend = p + evt->data.evt_scanner_legacy_advertisement_report.data.len;
-
-      ad_len = *p;
-      while(p < pend){
-          if(!ad_len)
-            break;
-          if(p + ad_len > pend)
-            break;
-          ad_type = *(p+1);
-          if(ad_len == 26 && ad_type == 0xff){
-              app_log_hexdump_info(p+2,25);
-              app_log("\r\n");
-          }
-          p += ad_len;
-      }
-
-      break;
     // -------------------------------
     // This event indicates the device has started and the radio is ready.
     // Do not call any stack command before receiving this boot event!
@@ -115,7 +104,15 @@ void sl_bt_on_event(sl_bt_msg_t *evt)
                                          sl_bt_legacy_advertiser_connectable);
       app_assert_status(sc);
 
-      sl_bt_scanner_start(sl_bt_scanner_scan_phy_coded, sl_bt_scanner_discover_observation);
+      sl_bt_scanner_filter_init(scanner_rules,
+                                sizeof(scanner_rules) / sizeof(scanner_rules[0]));
+      // Scanning is not essential to the peripheral role: keep advertising
+      // if it cannot be started.
+      sc = sl_bt_scanner_start(sl_bt_scanner_scan_phy_coded,
+                               sl_bt_scanner_discover_observation);
+      if (sc != SL_STATUS_OK) {
+        app_log_warning("Scanner start failed: 0x%04lx\r\n", (unsigned long)sc);
+      }
       break;
 
     // -------------------------------
@@ -147,3 +144,27 @@ void sl_bt_on_event(sl_bt_msg_t *evt)
       break;
   }
 }
+
+/**************************************************************************//**
+ * Matched advertisement reports.
+ * This overrides the dummy weak implementation.
+ *
+ * @param[in] reports Reports matching the scanner rules.
+ * @param[in] count Number of reports.
+ *****************************************************************************/
+void sl_bt_scanner_filter_on_batch(const sl_bt_scanner_filter_report_t *reports,
+                                   uint8_t count)
+{
+  for (uint8_t i = 0; i < count; i++) {
+    app_log_info("%02x:%02x:%02x:%02x:%02x:%02x %d dBm: ",
+                 reports[i].address.addr[5],
+                 reports[i].address.addr[4],
+                 reports[i].address.addr[3],
+                 reports[i].address.addr[2],
+                 reports[i].address.addr[1],
+                 reports[i].address.addr[0],
+                 reports[i].rssi);
+    app_log_hexdump_info(reports[i].data, reports[i].len);
+    app_log("\r\n");
+  }
+}
@@ -35,6 +35,7 @@
 #include "sl_component_catalog.h"
 #include "sl_bt_in_place_ota_dfu.h"
 #include "sl_gatt_service_device_information.h"
+#include "sl_bt_scanner_filter.h"
 /**
  * Internal stack function to start the Bluetooth stack.
  *
@@ -68,6 +69,7 @@ void sl_bt_process_event(sl_bt_msg_t *evt)
 {
   sl_bt_in_place_ota_dfu_on_event(evt);
   sl_gatt_service_device_information_on_event(evt);
+  sl_bt_scanner_filter_on_event(evt);
   sl_bt_on_event(evt);
 }
 
@@ -13,6 +13,7 @@
 #define SL_CATALOG_BLUETOOTH_FEATURE_CONNECTION_PRESENT
 #define SL_CATALOG_BLUETOOTH_FEATURE_CONNECTION_ROLE_CENTRAL_PRESENT
 #define SL_CATALOG_BLUETOOTH_FEATURE_CONNECTION_ROLE_PERIPHERAL_PRESENT
+#define SL_CATALOG_BLUETOOTH_FEATURE_EXTENDED_SCANNER_PRESENT
 #define SL_CATALOG_BLUETOOTH_FEATURE_GAP_PRESENT
 #define SL_CATALOG_BLUETOOTH_FEATURE_GATT_PRESENT
 #define SL_CATALOG_BLUETOOTH_FEATURE_GATT_SERVER_PRESENT
@@ -47,6 +48,7 @@
 #define SL_CATALOG_PSA_CRYPTO_PRESENT
 #define SL_CATALOG_RAIL_LIB_PRESENT
 #define SL_CATALOG_RAIL_UTIL_PTI_PRESENT
+#define SL_CATALOG_SCANNER_FILTER_PRESENT
 #define SL_CATALOG_SE_MANAGER_PRESENT
 #define SL_CATALOG_SL_CORE_PRESENT
 #define SL_CATALOG_SLEEPTIMER_PRESENT
@@ -0,0 +1,75 @@
+/***************************************************************************//**
+ * @file
+ * @brief Filtered Scanner Configuration
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2025 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef SL_BT_SCANNER_FILTER_CONFIG_H
+#define SL_BT_SCANNER_FILTER_CONFIG_H
+
+/***********************************************************************************************//**
+ * @addtogroup scanner_filter
+ * @{
+ **************************************************************************************************/
+
+// <<< Use Configuration Wizard in Context Menu >>>
+
+// <h> Duplicate Suppression
+
+// <o SL_BT_SCANNER_FILTER_DUPLICATE_CACHE_SIZE> Number of cached address/payload hashes <1-256>
+// <i> Must be a power of two.
+// <i> Default: 32
+#define SL_BT_SCANNER_FILTER_DUPLICATE_CACHE_SIZE     32
+
+// <o SL_BT_SCANNER_FILTER_DUPLICATE_WINDOW_MS> Time a report is considered a duplicate [msec] <0-60000>
+// <i> 0 disables duplicate suppression.
+// <i> Default: 1000
+#define SL_BT_SCANNER_FILTER_DUPLICATE_WINDOW_MS      1000
+
+// </h>
+
+// <h> Forwarding
+
+// <o SL_BT_SCANNER_FILTER_BATCH_SIZE> Number of matched reports forwarded at once <1-64>
+// <i> Default: 8
+#define SL_BT_SCANNER_FILTER_BATCH_SIZE               8
+
+// <o SL_BT_SCANNER_FILTER_BATCH_TIMEOUT_MS> Maximum time a matched report waits for the batch [msec] <1-10000>
+// <i> Default: 100
+#define SL_BT_SCANNER_FILTER_BATCH_TIMEOUT_MS         100
+
+// <o SL_BT_SCANNER_FILTER_MAX_DATA_LEN> Advertising data kept per report [bytes] <31-253>
+// <i> Longer extended advertising data is truncated.
+// <i> Default: 31
+#define SL_BT_SCANNER_FILTER_MAX_DATA_LEN             31
+
+// </h>
+
+// <<< end of configuration section >>>
+
+/** @} (end addtogroup scanner_filter) */
+#endif // SL_BT_SCANNER_FILTER_CONFIG_H
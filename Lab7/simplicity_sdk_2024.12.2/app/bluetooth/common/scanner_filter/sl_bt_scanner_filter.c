@@ -0,0 +1,370 @@
+/***************************************************************************//**
+ * @file
+ * @brief Filtered Scanner
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2025 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#include <string.h>
+#include "sl_common.h"
+#include "sl_sleeptimer.h"
+#include "app_timer.h"
+#include "sl_bt_scanner_filter.h"
+
+#if (SL_BT_SCANNER_FILTER_DUPLICATE_CACHE_SIZE & (SL_BT_SCANNER_FILTER_DUPLICATE_CACHE_SIZE - 1)) != 0
+#error "SL_BT_SCANNER_FILTER_DUPLICATE_CACHE_SIZE must be a power of two."
+#endif
+
+#define FNV_OFFSET_BASIS  2166136261UL
+#define FNV_PRIME         16777619UL
+
+// Duplicate cache entry
+typedef struct {
+  uint32_t hash;
+  uint32_t tick;
+  bool used;
+} duplicate_entry_t;
+
+// What one pass over the AD structures found in a report
+typedef struct {
+  bool has_manufacturer;
+  uint16_t manufacturer_id;
+  uint8_t uuid16_count;
+  const uint8_t *uuid16;
+  uint8_t uuid128_count;
+  const uint8_t *uuid128;
+} ad_summary_t;
+
+static const sl_bt_scanner_filter_rule_t *filter_rules = NULL;
+static uint8_t filter_rule_count = 0;
+// Lowest RSSI any rule accepts; used to drop reports before parsing.
+static int8_t filter_rssi_floor = INT8_MIN;
+
+static duplicate_entry_t duplicate_cache[SL_BT_SCANNER_FILTER_DUPLICATE_CACHE_SIZE];
+static uint32_t duplicate_window_tick = 0;
+
+static sl_bt_scanner_filter_report_t batch[SL_BT_SCANNER_FILTER_BATCH_SIZE];
+static uint8_t batch_count = 0;
+static app_timer_t batch_timer;
+
+static sl_bt_scanner_filter_stats_t stats;
+
+static bool summarize(const uint8_t *data, uint8_t len, ad_summary_t *summary);
+static int16_t match_rules(int8_t rssi, const ad_summary_t *summary);
+static bool match_rule(const sl_bt_scanner_filter_rule_t *rule,
+                       const ad_summary_t *summary);
+static uint32_t report_hash(const bd_addr *address,
+                            uint8_t address_type,
+                            const uint8_t *data,
+                            uint8_t len);
+static bool is_duplicate(uint32_t hash);
+static void batch_timer_cb(app_timer_t *handle, void *data);
+
+// -----------------------------------------------------------------------------
+// Public functions
+
+void sl_bt_scanner_filter_init(const sl_bt_scanner_filter_rule_t *rules,
+                               uint8_t rule_count)
+{
+  filter_rules = rules;
+  filter_rule_count = (rules != NULL) ? rule_count : 0;
+  filter_rssi_floor = INT8_MAX;
+  for (uint8_t i = 0; i < filter_rule_count; i++) {
+    if (filter_rules[i].rssi_min < filter_rssi_floor) {
+      filter_rssi_floor = filter_rules[i].rssi_min;
+    }
+  }
+  if (filter_rule_count == 0) {
+    filter_rssi_floor = INT8_MIN;
+  }
+
+  memset(duplicate_cache, 0, sizeof(duplicate_cache));
+  duplicate_window_tick =
+    sl_sleeptimer_ms_to_tick(SL_BT_SCANNER_FILTER_DUPLICATE_WINDOW_MS);
+
+  (void)app_timer_stop(&batch_timer);
+  batch_count = 0;
+  memset(&stats, 0, sizeof(stats));
+}
+
+void sl_bt_scanner_filter_on_event(sl_bt_msg_t *evt)
+{
+  switch (SL_BT_MSG_ID(evt->header)) {
+    case sl_bt_evt_scanner_legacy_advertisement_report_id:
+    {
+      sl_bt_evt_scanner_legacy_advertisement_report_t *report =
+        &evt->data.evt_scanner_legacy_advertisement_report;
+      (void)sl_bt_scanner_filter_process(&report->address,
+                                         report->address_type,
+                                         report->rssi,
+                                         report->data.data,
+                                         report->data.len);
+      break;
+    }
+
+    case sl_bt_evt_scanner_extended_advertisement_report_id:
+    {
+      sl_bt_evt_scanner_extended_advertisement_report_t *report =
+        &evt->data.evt_scanner_extended_advertisement_report;
+      // Partial chains cannot be filtered reliably.
+      if (report->data_completeness == sl_bt_scanner_data_status_complete) {
+        (void)sl_bt_scanner_filter_process(&report->address,
+                                           report->address_type,
+                                           report->rssi,
+                                           report->data.data,
+                                           report->data.len);
+      }
+      break;
+    }
+
+    default:
+      break;
+  }
+}
+
+bool sl_bt_scanner_filter_process(const bd_addr *address,
+                                  uint8_t address_type,
+                                  int8_t rssi,
+                                  const uint8_t *data,
+                                  uint8_t len)
+{
+  ad_summary_t summary;
+  int16_t rule;
+  uint32_t hash;
+  sl_bt_scanner_filter_report_t *entry;
+
+  stats.received++;
+
+  // Cheapest checks first: nothing is parsed or copied for reports that
+  // cannot match any rule.
+  if (rssi < filter_rssi_floor) {
+    stats.rssi_rejected++;
+    return false;
+  }
+
+  if (!summarize(data, len, &summary)) {
+    stats.malformed++;
+    return false;
+  }
+
+  rule = match_rules(rssi, &summary);
+  if (rule < 0) {
+    stats.rule_rejected++;
+    return false;
+  }
+
+  hash = report_hash(address, address_type, data, len);
+  if (is_duplicate(hash)) {
+    stats.duplicates++;
+    return false;
+  }
+
+  entry = &batch[batch_count];
+  entry->address = *address;
+  entry->address_type = address_type;
+  entry->rssi = rssi;
+  entry->rule = (uint8_t)rule;
+  entry->len = SL_MIN(len, SL_BT_SCANNER_FILTER_MAX_DATA_LEN);
+  memcpy(entry->data, data, entry->len);
+  batch_count++;
+  stats.forwarded++;
+
+  if (batch_count >= SL_BT_SCANNER_FILTER_BATCH_SIZE) {
+    sl_bt_scanner_filter_flush();
+  } else if (batch_count == 1) {
+    (void)app_timer_start(&batch_timer,
+                          SL_BT_SCANNER_FILTER_BATCH_TIMEOUT_MS,
+                          batch_timer_cb,
+                          NULL,
+                          false);
+  }
+  return true;
+}
+
+void sl_bt_scanner_filter_flush(void)
+{
+  uint8_t count = batch_count;
+
+  (void)app_timer_stop(&batch_timer);
+  if (count == 0) {
+    return;
+  }
+  batch_count = 0;
+  stats.batches++;
+  sl_bt_scanner_filter_on_batch(batch, count);
+}
+
+void sl_bt_scanner_filter_get_stats(sl_bt_scanner_filter_stats_t *out)
+{
+  *out = stats;
+}
+
+SL_WEAK void sl_bt_scanner_filter_on_batch(const sl_bt_scanner_filter_report_t *reports,
+                                           uint8_t count)
+{
+  (void)reports;
+  (void)count;
+}
+
+// -----------------------------------------------------------------------------
+// Private functions
+
+// Walk the AD structures once and keep references to the fields used by
+// the rules. Returns false if the data is malformed.
+static bool summarize(const uint8_t *data, uint8_t len, ad_summary_t *summary)
+{
+  sl_bt_ad_iterator_t it;
+  sl_bt_ad_element_t element;
+
+  memset(summary, 0, sizeof(*summary));
+  sl_bt_ad_iterator_init(&it, data, len);
+  while (sl_bt_ad_iterator_next(&it, &element)) {
+    switch (element.type) {
+      case SL_BT_AD_TYPE_MANUFACTURER_DATA:
+        if (element.len >= 2 && !summary->has_manufacturer) {
+          summary->has_manufacturer = true;
+          summary->manufacturer_id = (uint16_t)(element.value[0]
+                                                | (element.value[1] << 8));
+        }
+        break;
+
+      case SL_BT_AD_TYPE_UUID16_INCOMPLETE:
+      case SL_BT_AD_TYPE_UUID16_COMPLETE:
+        if (summary->uuid16 == NULL) {
+          summary->uuid16 = element.value;
+          summary->uuid16_count = element.len / 2;
+        }
+        break;
+
+      case SL_BT_AD_TYPE_UUID128_INCOMPLETE:
+      case SL_BT_AD_TYPE_UUID128_COMPLETE:
+        if (summary->uuid128 == NULL) {
+          summary->uuid128 = element.value;
+          summary->uuid128_count = element.len / 16;
+        }
+        break;
+
+      default:
+        break;
+    }
+  }
+  return !it.malformed;
+}
+
+// Returns the index of the first matching rule, or -1.
+static int16_t match_rules(int8_t rssi, const ad_summary_t *summary)
+{
+  if (filter_rule_count == 0) {
+    return 0;
+  }
+  for (uint8_t i = 0; i < filter_rule_count; i++) {
+    if (rssi >= filter_rules[i].rssi_min
+        && match_rule(&filter_rules[i], summary)) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+static bool match_rule(const sl_bt_scanner_filter_rule_t *rule,
+                       const ad_summary_t *summary)
+{
+  bool found;
+
+  if (rule->match & SL_BT_SCANNER_FILTER_MATCH_MANUFACTURER) {
+    if (!summary->has_manufacturer
+        || summary->manufacturer_id != rule->manufacturer_id) {
+      return false;
+    }
+  }
+  if (rule->match & SL_BT_SCANNER_FILTER_MATCH_UUID16) {
+    found = false;
+    for (uint8_t i = 0; i < summary->uuid16_count && !found; i++) {
+      found = (uint16_t)(summary->uuid16[2 * i]
+                         | (summary->uuid16[2 * i + 1] << 8)) == rule->uuid16;
+    }
+    if (!found) {
+      return false;
+    }
+  }
+  if (rule->match & SL_BT_SCANNER_FILTER_MATCH_UUID128) {
+    found = false;
+    for (uint8_t i = 0; i < summary->uuid128_count && !found; i++) {
+      found = memcmp(&summary->uuid128[16 * i], rule->uuid128, 16) == 0;
+    }
+    if (!found) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// FNV-1a over the advertiser identity and payload.
+static uint32_t report_hash(const bd_addr *address,
+                            uint8_t address_type,
+                            const uint8_t *data,
+                            uint8_t len)
+{
+  uint32_t hash = FNV_OFFSET_BASIS;
+
+  for (uint8_t i = 0; i < sizeof(address->addr); i++) {
+    hash = (hash ^ address->addr[i]) * FNV_PRIME;
+  }
+  hash = (hash ^ address_type) * FNV_PRIME;
+  for (uint8_t i = 0; i < len; i++) {
+    hash = (hash ^ data[i]) * FNV_PRIME;
+  }
+  return hash;
+}
+
+// Look the hash up in the direct-mapped cache and record it.
+static bool is_duplicate(uint32_t hash)
+{
+  duplicate_entry_t *entry;
+  uint32_t now;
+
+  if (duplicate_window_tick == 0) {
+    return false;
+  }
+  now = sl_sleeptimer_get_tick_count();
+  entry = &duplicate_cache[hash & (SL_BT_SCANNER_FILTER_DUPLICATE_CACHE_SIZE - 1)];
+  if (entry->used
+      && entry->hash == hash
+      && (uint32_t)(now - entry->tick) < duplicate_window_tick) {
+    return true;
+  }
+  entry->used = true;
+  entry->hash = hash;
+  entry->tick = now;
+  return false;
+}
+
+static void batch_timer_cb(app_timer_t *handle, void *data)
+{
+  (void)handle;
+  (void)data;
+  sl_bt_scanner_filter_flush();
+}
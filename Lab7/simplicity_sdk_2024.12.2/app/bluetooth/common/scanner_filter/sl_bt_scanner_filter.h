@@ -0,0 +1,197 @@
+/***************************************************************************//**
+ * @file
+ * @brief Filtered Scanner
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2025 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef SL_BT_SCANNER_FILTER_H
+#define SL_BT_SCANNER_FILTER_H
+
+/***********************************************************************************************//**
+ * @addtogroup scanner_filter
+ * @{
+ **************************************************************************************************/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "sl_bt_api.h"
+#include "sl_bt_scanner_filter_config.h"
+
+// AD types used by the filter
+#define SL_BT_AD_TYPE_UUID16_INCOMPLETE   0x02
+#define SL_BT_AD_TYPE_UUID16_COMPLETE     0x03
+#define SL_BT_AD_TYPE_UUID128_INCOMPLETE  0x06
+#define SL_BT_AD_TYPE_UUID128_COMPLETE    0x07
+#define SL_BT_AD_TYPE_MANUFACTURER_DATA   0xff
+
+// Fields of a rule that must match
+#define SL_BT_SCANNER_FILTER_MATCH_MANUFACTURER  (1 << 0)
+#define SL_BT_SCANNER_FILTER_MATCH_UUID16        (1 << 1)
+#define SL_BT_SCANNER_FILTER_MATCH_UUID128       (1 << 2)
+
+// One AD structure
+typedef struct {
+  uint8_t type;
+  uint8_t len;               // Length of the value, without the type byte
+  const uint8_t *value;
+} sl_bt_ad_element_t;
+
+// Bounds-checked walk over advertising data
+typedef struct {
+  const uint8_t *pos;
+  const uint8_t *end;
+  bool malformed;            // Set when an element runs past the end of the data
+} sl_bt_ad_iterator_t;
+
+// Filter rule. A report is forwarded if it matches any rule of the table.
+typedef struct {
+  uint8_t match;             // SL_BT_SCANNER_FILTER_MATCH_* flags
+  int8_t rssi_min;           // Reports below this RSSI are dropped [dBm]
+  uint16_t manufacturer_id;  // Company identifier of the manufacturer data
+  uint16_t uuid16;           // Advertised 16-bit service UUID
+  uint8_t uuid128[16];       // Advertised 128-bit service UUID, as sent on air
+} sl_bt_scanner_filter_rule_t;
+
+// Matched report, as forwarded to the application
+typedef struct {
+  bd_addr address;
+  uint8_t address_type;
+  int8_t rssi;
+  uint8_t rule;              // Index of the first matching rule
+  uint8_t len;
+  uint8_t data[SL_BT_SCANNER_FILTER_MAX_DATA_LEN];
+} sl_bt_scanner_filter_report_t;
+
+// Pipeline counters
+typedef struct {
+  uint32_t received;
+  uint32_t rssi_rejected;
+  uint32_t rule_rejected;
+  uint32_t malformed;
+  uint32_t duplicates;
+  uint32_t forwarded;
+  uint32_t batches;
+} sl_bt_scanner_filter_stats_t;
+
+/**************************************************************************//**
+ * Start iterating over advertising data.
+ * @param[out] it Iterator.
+ * @param[in] data Advertising data.
+ * @param[in] len Length of the data.
+ *****************************************************************************/
+static inline void sl_bt_ad_iterator_init(sl_bt_ad_iterator_t *it,
+                                          const uint8_t *data,
+                                          uint8_t len)
+{
+  it->pos = data;
+  it->end = data + len;
+  it->malformed = false;
+}
+
+/**************************************************************************//**
+ * Get the next AD structure.
+ * @param[in,out] it Iterator.
+ * @param[out] element Next element; only valid if true is returned.
+ * @return false at the end of the data, at zero padding or on a malformed
+ *         element (see sl_bt_ad_iterator_t::malformed).
+ *****************************************************************************/
+static inline bool sl_bt_ad_iterator_next(sl_bt_ad_iterator_t *it,
+                                          sl_bt_ad_element_t *element)
+{
+  uint8_t ad_len;
+
+  if (it->pos >= it->end) {
+    return false;
+  }
+  ad_len = it->pos[0];
+  if (ad_len == 0) {
+    // Zero length marks the end of the significant part.
+    return false;
+  }
+  if (ad_len > (it->end - it->pos - 1)) {
+    it->malformed = true;
+    return false;
+  }
+  element->type = it->pos[1];
+  element->len = ad_len - 1;
+  element->value = &it->pos[2];
+  it->pos += ad_len + 1;
+  return true;
+}
+
+/**************************************************************************//**
+ * Set the filter table and clear the duplicate cache and counters.
+ * @param[in] rules Rule table; must stay valid while scanning.
+ * @param[in] rule_count Number of rules. 0 forwards every report.
+ *****************************************************************************/
+void sl_bt_scanner_filter_init(const sl_bt_scanner_filter_rule_t *rules,
+                               uint8_t rule_count);
+
+/**************************************************************************//**
+ * Bluetooth stack event handler.
+ * Handles legacy and complete extended advertisement reports.
+ * @param[in] evt Event coming from the Bluetooth stack.
+ *****************************************************************************/
+void sl_bt_scanner_filter_on_event(sl_bt_msg_t *evt);
+
+/**************************************************************************//**
+ * Run one report through the pipeline.
+ * @param[in] address Advertiser address.
+ * @param[in] address_type Advertiser address type.
+ * @param[in] rssi Signal strength.
+ * @param[in] data Advertising data.
+ * @param[in] len Length of the data.
+ * @return true if the report was queued for forwarding.
+ *****************************************************************************/
+bool sl_bt_scanner_filter_process(const bd_addr *address,
+                                  uint8_t address_type,
+                                  int8_t rssi,
+                                  const uint8_t *data,
+                                  uint8_t len);
+
+/**************************************************************************//**
+ * Forward the queued reports now.
+ *****************************************************************************/
+void sl_bt_scanner_filter_flush(void);
+
+/**************************************************************************//**
+ * Get the pipeline counters.
+ * @param[out] stats Counters.
+ *****************************************************************************/
+void sl_bt_scanner_filter_get_stats(sl_bt_scanner_filter_stats_t *stats);
+
+/**************************************************************************//**
+ * Callback receiving a batch of matched reports.
+ * @param[in] reports Reports, valid during the call only.
+ * @param[in] count Number of reports.
+ * @note To be implemented in user code.
+ *****************************************************************************/
+void sl_bt_scanner_filter_on_batch(const sl_bt_scanner_filter_report_t *reports,
+                                   uint8_t count);
+
+/** @} (end addtogroup scanner_filter) */
+#endif // SL_BT_SCANNER_FILTER_H
@@ -0,0 +1,156 @@
+/***************************************************************************//**
+ * @file
+ * @brief Host benchmark of the scanner filter pipeline
+ *******************************************************************************
+ * Replays recorded advertisement reports through sl_bt_scanner_filter_on_event()
+ * as extended advertisement report events, with the rules of app.c, and
+ * reports the throughput and the pipeline counters:
+ *
+ *   make -C test bench
+ *   ./test/bench_scanner_filter [reports file] [passes]
+ *
+ * Each line of the reports file holds the time in milliseconds, the RSSI,
+ * the address type, the address and the advertising data in hex.
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "sl_bt_scanner_filter.h"
+
+#define MAX_REPORTS  8192
+
+typedef struct {
+  uint32_t time_ms;
+  sl_bt_msg_t evt;
+} recorded_report_t;
+
+uint32_t sl_sleeptimer_tick_count;
+
+// Same table as app.c.
+static const sl_bt_scanner_filter_rule_t scanner_rules[] = {
+  {
+    .match = SL_BT_SCANNER_FILTER_MATCH_MANUFACTURER,
+    .rssi_min = -90,
+    .manufacturer_id = 0x004c, // iBeacon
+  },
+};
+
+static recorded_report_t reports[MAX_REPORTS];
+static uint32_t batched_reports;
+
+void sl_bt_scanner_filter_on_batch(const sl_bt_scanner_filter_report_t *batch,
+                                   uint8_t count)
+{
+  (void)batch;
+  batched_reports += count;
+}
+
+static int parse_hex(const char *hex, uint8_t *out, int max_len)
+{
+  int len = 0;
+
+  while (hex[0] != '\0' && hex[1] != '\0' && len < max_len) {
+    unsigned int byte;
+    if (sscanf(hex, "%2x", &byte) != 1) {
+      return -1;
+    }
+    out[len++] = (uint8_t)byte;
+    hex += 2;
+  }
+  return len;
+}
+
+static int load_reports(const char *path)
+{
+  char line[256];
+  int count = 0;
+  FILE *f = fopen(path, "r");
+
+  if (f == NULL) {
+    perror(path);
+    return -1;
+  }
+  while (fgets(line, sizeof(line), f) != NULL && count < MAX_REPORTS) {
+    recorded_report_t *r = &reports[count];
+    sl_bt_evt_scanner_extended_advertisement_report_t *report =
+      &r->evt.data.evt_scanner_extended_advertisement_report;
+    unsigned int time_ms, address_type, a[6];
+    int rssi, len;
+    char hex[2 * 255 + 1];
+
+    if (line[0] == '#') {
+      continue;
+    }
+    if (sscanf(line, "%u %d %u %x:%x:%x:%x:%x:%x %510s",
+               &time_ms, &rssi, &address_type,
+               &a[5], &a[4], &a[3], &a[2], &a[1], &a[0], hex) != 10) {
+      continue;
+    }
+    memset(r, 0, sizeof(*r));
+    r->time_ms = time_ms;
+    r->evt.header = sl_bt_evt_scanner_extended_advertisement_report_id;
+    for (int i = 0; i < 6; i++) {
+      report->address.addr[i] = (uint8_t)a[i];
+    }
+    report->address_type = (uint8_t)address_type;
+    report->rssi = (int8_t)rssi;
+    report->data_completeness = sl_bt_scanner_data_status_complete;
+    // The data follows the event fields, inside the payload of the message.
+    len = parse_hex(hex, report->data.data, SL_BT_SCANNER_FILTER_MAX_DATA_LEN);
+    if (len < 0) {
+      continue;
+    }
+    report->data.len = (uint8_t)len;
+    count++;
+  }
+  fclose(f);
+  return count;
+}
+
+int main(int argc, char **argv)
+{
+  const char *path = (argc > 1) ? argv[1] : "scan_reports.txt";
+  int passes = (argc > 2) ? atoi(argv[2]) : 2000;
+  sl_bt_scanner_filter_stats_t stats;
+  struct timespec start, end;
+  uint32_t duration_ms;
+  double seconds;
+  int count;
+
+  count = load_reports(path);
+  if (count <= 0) {
+    fprintf(stderr, "%s: no reports\n", path);
+    return 1;
+  }
+  duration_ms = reports[count - 1].time_ms + 1;
+
+  sl_bt_scanner_filter_init(scanner_rules,
+                            sizeof(scanner_rules) / sizeof(scanner_rules[0]));
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (int pass = 0; pass < passes; pass++) {
+    for (int i = 0; i < count; i++) {
+      sl_sleeptimer_tick_count = (uint32_t)pass * duration_ms + reports[i].time_ms;
+      sl_bt_scanner_filter_on_event(&reports[i].evt);
+    }
+  }
+  sl_bt_scanner_filter_flush();
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  seconds = (double)(end.tv_sec - start.tv_sec)
+            + (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+  sl_bt_scanner_filter_get_stats(&stats);
+
+  printf("%d reports x %d passes in %.3f s: %.0f reports/s\n",
+         count, passes, seconds, (double)count * passes / seconds);
+  printf("rssi %lu, malformed %lu, rule %lu, duplicate %lu rejected; "
+         "%lu forwarded in %lu batches\n",
+         (unsigned long)stats.rssi_rejected,
+         (unsigned long)stats.malformed,
+         (unsigned long)stats.rule_rejected,
+         (unsigned long)stats.duplicates,
+         (unsigned long)stats.forwarded,
+         (unsigned long)stats.batches);
+  return (batched_reports == stats.forwarded) ? 0 : 1;
+}
@@ -0,0 +1,34 @@
+/* Host stand-in for app_timer.h. The tests fire the callbacks by hand. */
+#ifndef APP_TIMER_H
+#define APP_TIMER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "sl_status.h"
+
+typedef struct app_timer app_timer_t;
+
+typedef void (*app_timer_callback_t)(app_timer_t *timer, void *data);
+
+struct app_timer {
+  app_timer_callback_t callback;
+  void *callback_data;
+  uint32_t timeout_ms;
+  bool periodic;
+  bool running;
+};
+
+sl_status_t app_timer_start(app_timer_t *timer,
+                            uint32_t timeout_ms,
+                            app_timer_callback_t callback,
+                            void *callback_data,
+                            bool is_periodic);
+
+sl_status_t app_timer_stop(app_timer_t *timer);
+
+// Test helpers: fire every running timer once, as if timeout_ms had elapsed
+// for each of them, and count the running timers.
+void app_timer_fire_all(void);
+int app_timer_running_count(void);
+
+#endif // APP_TIMER_H
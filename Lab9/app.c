@@ -35,6 +35,10 @@
 #include "em_cmu.h"
 #include "em_gpio.h"
 #include "gatt_db.h"
+#include "sl_power_manager_statistics.h"
+#include "sl_bt_adaptive_timing.h"
+#include "sl_bt_notify_scheduler.h"
+#include "sl_bt_ota_pipeline.h"
 #define gattdb_LED_IO 27
 #define gattdb_BUTTON_IO 29
 static bool button_io_notification_enabled = false;
@@ -49,13 +53,12 @@ void GPIO_ODD_IRQHandler(void)
 
   uint8_t button_state = GPIO_PinInGet(gpioPortC, 7) ? 1 : 0;
 
-    // Update GATT attribute value
-    sl_bt_gatt_server_write_attribute_value(gattdb_BUTTON_IO, 0, sizeof(button_state), &button_state);
-
-    // Notify client if enabled
-    if (button_io_notification_enabled) {
-      sl_bt_gatt_server_notify_all(gattdb_BUTTON_IO, sizeof(button_state), &button_state);
-    }
+  // Update GATT attribute value; the scheduler notifies the subscribed
+  // clients from the Bluetooth event loop.
+  sl_bt_notify_scheduler_set_value(gattdb_BUTTON_IO, sizeof(button_state), &button_state);
+  if (button_io_notification_enabled) {
+    sl_bt_adaptive_timing_report_activity();
+  }
 }
 
 /**************************************************************************//**
@@ -68,6 +71,9 @@ SL_WEAK void app_init(void)
   // This is called once during start-up.                                    //
   /////////////////////////////////////////////////////////////////////////////
 
+  sl_status_t sc = sl_bt_notify_scheduler_add(gattdb_BUTTON_IO);
+  app_assert_status(sc);
+
   // Activare ramura clock periferic GPIO
   CMU_ClockEnable(cmuClock_GPIO, true);
   // Configurare GPIOA 04 ca iesire (LED)
@@ -92,6 +98,8 @@ SL_WEAK void app_process_action(void)
   // This is called infinitely.                                              //
   // Do not call blocking functions from here!                               //
   /////////////////////////////////////////////////////////////////////////////
+  sl_power_manager_statistics_process_action();
+  sl_bt_ota_pipeline_gatt_process_action();
 }
 
 /**************************************************************************//**
@@ -118,17 +126,9 @@ void sl_bt_on_event(sl_bt_msg_t *evt)
                                                  sl_bt_advertiser_general_discoverable);
       app_assert_status(sc);
 
-      // Set advertising interval to 100ms.
-      sc = sl_bt_advertiser_set_timing(
-        advertising_set_handle,
-        160, // min. adv. interval (milliseconds * 1.6)
-        160, // max. adv. interval (milliseconds * 1.6)
-        0,   // adv. duration
-        0);  // max. num. adv. events
-      app_assert_status(sc);
-      // Start advertising and enable connections.
-      sc = sl_bt_legacy_advertiser_start(advertising_set_handle,
-                                         sl_bt_advertiser_connectable_scannable);
+      // Start fast advertising and enable connections; the adaptive timing
+      // component backs off to the slow interval when nobody connects.
+      sc = sl_bt_adaptive_timing_start_advertising(advertising_set_handle);
       app_assert_status(sc);
       break;
 
@@ -146,8 +146,7 @@ void sl_bt_on_event(sl_bt_msg_t *evt)
       app_assert_status(sc);
 
       // Restart advertising after client has disconnected.
-      sc = sl_bt_legacy_advertiser_start(advertising_set_handle,
-                                         sl_bt_advertiser_connectable_scannable);
+      sc = sl_bt_adaptive_timing_start_advertising(advertising_set_handle);
       app_assert_status(sc);
       break;
 
@@ -30,6 +30,12 @@ GATT_DATA(const uint8_t gattdb_uuidtable_128_map[]) =
   0xbb, 0xbb, 0xbb, 0xbb, 0xbb, 0xbb, 0xbb, 0xbb, 0xbb, 0xbb, 0xbb, 0xbb, 0xbb, 0xbb, 0xbb, 0xbb, 
   0xcc, 0xcc, 0xcc, 0xcc, 0xcc, 0xcc, 0xcc, 0xcc, 0xcc, 0xcc, 0xcc, 0xcc, 0xcc, 0xcc, 0xcc, 0xcc, 
   0x63, 0x60, 0x32, 0xe0, 0x37, 0x5e, 0xa4, 0x88, 0x53, 0x4e, 0x6d, 0xfb, 0x64, 0x35, 0xbf, 0xf7, 
+  0x1f, 0x0e, 0x9d, 0x8c, 0x6a, 0x3b, 0x5f, 0x9e, 0x1d, 0x4c, 0x0b, 0x5a, 0x02, 0x00, 0x2e, 0x7d, 
+  0x1f, 0x0e, 0x9d, 0x8c, 0x6a, 0x3b, 0x5f, 0x9e, 0x1d, 0x4c, 0x0b, 0x5a, 0x03, 0x00, 0x2e, 0x7d, 
+};
+GATT_DATA(const sli_bt_gattdb_value_t gattdb_attribute_field_33) = {
+  .len = 16,
+  .data = { 0x1f, 0x0e, 0x9d, 0x8c, 0x6a, 0x3b, 0x5f, 0x9e, 0x1d, 0x4c, 0x0b, 0x5a, 0x01, 0x00, 0x2e, 0x7d, }
 };
 GATT_DATA(const sli_bt_gattdb_value_t gattdb_attribute_field_30) = {
   .len = 16,
@@ -144,18 +150,23 @@ GATT_DATA(const sli_bt_gattdb_attribute_t gattdb_attributes_map[]) = {
   { .handle = 0x1f, .uuid = 0x0000, .permissions = 0x801, .caps = 0xffff, .state = 0x00, .datatype = 0x00, .constdata = &gattdb_attribute_field_30 },
   { .handle = 0x20, .uuid = 0x0002, .permissions = 0x801, .caps = 0xffff, .state = 0x00, .datatype = 0x05, .characteristic = { .properties = 0x08, .char_uuid = 0x8002 } },
   { .handle = 0x21, .uuid = 0x8002, .permissions = 0x802, .caps = 0xffff, .state = 0x00, .datatype = 0x07, .dynamicdata = NULL },
+  { .handle = 0x22, .uuid = 0x0000, .permissions = 0x801, .caps = 0xffff, .state = 0x00, .datatype = 0x00, .constdata = &gattdb_attribute_field_33 },
+  { .handle = 0x23, .uuid = 0x0002, .permissions = 0x801, .caps = 0xffff, .state = 0x00, .datatype = 0x05, .characteristic = { .properties = 0x08, .char_uuid = 0x8003 } },
+  { .handle = 0x24, .uuid = 0x8003, .permissions = 0x802, .caps = 0xffff, .state = 0x00, .datatype = 0x07, .dynamicdata = NULL },
+  { .handle = 0x25, .uuid = 0x0002, .permissions = 0x801, .caps = 0xffff, .state = 0x00, .datatype = 0x05, .characteristic = { .properties = 0x0c, .char_uuid = 0x8004 } },
+  { .handle = 0x26, .uuid = 0x8004, .permissions = 0x802, .caps = 0xffff, .state = 0x00, .datatype = 0x07, .dynamicdata = NULL },
 };
 
 GATT_HEADER(const sli_bt_gattdb_t gattdb) = {
   .attributes = gattdb_attributes_map,
-  .attribute_table_size = 33,
-  .attribute_num = 33,
+  .attribute_table_size = 38,
+  .attribute_num = 38,
   .uuid16 = gattdb_uuidtable_16_map,
   .uuid16_table_size = 14,
   .uuid16_num = 14,
   .uuid128 = gattdb_uuidtable_128_map,
-  .uuid128_table_size = 3,
-  .uuid128_num = 3,
+  .uuid128_table_size = 5,
+  .uuid128_num = 5,
   .num_ccfg = 2,
   .caps_mask = 0xffff,
   .enabled_caps = 0xffff,
@@ -24,6 +24,9 @@ extern const sli_bt_gattdb_t gattdb;
 #define gattdb_BUTTON_IO                      29
 #define gattdb_ota                            31
 #define gattdb_ota_control                    33
+#define gattdb_ota_pipeline                   34
+#define gattdb_ota_pipeline_control           36
+#define gattdb_ota_pipeline_data              38
 
 
 #endif // __GATT_DB_H
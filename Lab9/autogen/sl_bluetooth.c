@@ -34,6 +34,9 @@
 #include "sl_bt_stack_init.h"
 #include "sl_component_catalog.h"
 #include "sl_bt_in_place_ota_dfu.h"
+#include "sl_bt_adaptive_timing.h"
+#include "sl_bt_notify_scheduler.h"
+#include "sl_bt_ota_pipeline.h"
 #include "sl_gatt_service_device_information.h"
 /**
  * Internal stack function to start the Bluetooth stack.
@@ -67,6 +70,9 @@ SL_WEAK void sl_bt_on_event(sl_bt_msg_t* evt)
 void sl_bt_process_event(sl_bt_msg_t *evt)
 {
   sl_bt_in_place_ota_dfu_on_event(evt);
+  sl_bt_adaptive_timing_on_event(evt);
+  sl_bt_notify_scheduler_on_event(evt);
+  sl_bt_ota_pipeline_on_event(evt);
   sl_gatt_service_device_information_on_event(evt);
   sl_bt_on_event(evt);
 }
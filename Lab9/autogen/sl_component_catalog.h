@@ -2,6 +2,7 @@
 #define SL_COMPONENT_CATALOG_H
 
 // APIs present in project
+#define SL_CATALOG_ADAPTIVE_TIMING_PRESENT
 #define SL_CATALOG_APP_ASSERT_PRESENT
 #define SL_CATALOG_APP_LOG_PRESENT
 #define SL_CATALOG_APP_TIMER_PRESENT
@@ -41,7 +42,9 @@
 #define SL_CATALOG_MEMORY_MANAGER_PRESENT
 #define SL_CATALOG_MEMORY_PROFILER_API_PRESENT
 #define SL_CATALOG_MPU_PRESENT
+#define SL_CATALOG_NOTIFY_SCHEDULER_PRESENT
 #define SL_CATALOG_NVM3_PRESENT
+#define SL_CATALOG_OTA_PIPELINE_PRESENT
 #define SL_CATALOG_POWER_MANAGER_PRESENT
 #define SL_CATALOG_POWER_MANAGER_DEEPSLEEP_BLOCKING_HFXO_RESTORE_PRESENT
 #define SL_CATALOG_PSA_CRYPTO_PRESENT
@@ -0,0 +1,113 @@
+/***************************************************************************//**
+ * @file
+ * @brief Adaptive Advertising and Connection Timing Configuration
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2025 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef SL_BT_ADAPTIVE_TIMING_CONFIG_H
+#define SL_BT_ADAPTIVE_TIMING_CONFIG_H
+
+/***********************************************************************************************//**
+ * @addtogroup adaptive_timing
+ * @{
+ **************************************************************************************************/
+
+// <<< Use Configuration Wizard in Context Menu >>>
+
+// <h> Advertising
+
+// <o SL_BT_ADAPTIVE_TIMING_FAST_ADV_INTERVAL> Fast advertising interval [0.625 ms] <32-16384>
+// <i> Used right after boot and after a disconnection.
+// <i> Default: 48 (30 ms)
+#define SL_BT_ADAPTIVE_TIMING_FAST_ADV_INTERVAL          48
+
+// <o SL_BT_ADAPTIVE_TIMING_FAST_ADV_TIMEOUT_MS> Fast advertising duration [msec] <0-600000>
+// <i> Time after which advertising backs off to the slow interval.
+// <i> Default: 30000
+#define SL_BT_ADAPTIVE_TIMING_FAST_ADV_TIMEOUT_MS        30000
+
+// <o SL_BT_ADAPTIVE_TIMING_SLOW_ADV_INTERVAL> Slow advertising interval [0.625 ms] <32-16384>
+// <i> Default: 1600 (1 s)
+#define SL_BT_ADAPTIVE_TIMING_SLOW_ADV_INTERVAL          1600
+
+// </h>
+
+// <h> Connection
+
+// <o SL_BT_ADAPTIVE_TIMING_ACTIVE_MIN_INTERVAL> Active minimum connection interval [1.25 ms] <6-3200>
+// <i> Default: 24 (30 ms)
+#define SL_BT_ADAPTIVE_TIMING_ACTIVE_MIN_INTERVAL        24
+
+// <o SL_BT_ADAPTIVE_TIMING_ACTIVE_MAX_INTERVAL> Active maximum connection interval [1.25 ms] <6-3200>
+// <i> Default: 40 (50 ms)
+#define SL_BT_ADAPTIVE_TIMING_ACTIVE_MAX_INTERVAL        40
+
+// <o SL_BT_ADAPTIVE_TIMING_ACTIVE_LATENCY> Active peripheral latency <0-499>
+// <i> Default: 0
+#define SL_BT_ADAPTIVE_TIMING_ACTIVE_LATENCY             0
+
+// <o SL_BT_ADAPTIVE_TIMING_IDLE_MIN_INTERVAL> Idle minimum connection interval [1.25 ms] <6-3200>
+// <i> Default: 80 (100 ms)
+#define SL_BT_ADAPTIVE_TIMING_IDLE_MIN_INTERVAL          80
+
+// <o SL_BT_ADAPTIVE_TIMING_IDLE_MAX_INTERVAL> Idle maximum connection interval [1.25 ms] <6-3200>
+// <i> Default: 120 (150 ms)
+#define SL_BT_ADAPTIVE_TIMING_IDLE_MAX_INTERVAL          120
+
+// <o SL_BT_ADAPTIVE_TIMING_IDLE_LATENCY> Idle peripheral latency <0-499>
+// <i> Notifications are not delayed by the latency, only the listening is.
+// <i> Default: 4
+#define SL_BT_ADAPTIVE_TIMING_IDLE_LATENCY               4
+
+// <o SL_BT_ADAPTIVE_TIMING_SUPERVISION_TIMEOUT> Supervision timeout [10 ms] <10-3200>
+// <i> Must be larger than (1 + latency) x max interval x 2 for both profiles.
+// <i> Default: 400 (4 s)
+#define SL_BT_ADAPTIVE_TIMING_SUPERVISION_TIMEOUT        400
+
+// </h>
+
+// <h> Activity
+
+// <o SL_BT_ADAPTIVE_TIMING_EVAL_PERIOD_MS> Activity evaluation period [msec] <100-60000>
+// <i> Default: 1000
+#define SL_BT_ADAPTIVE_TIMING_EVAL_PERIOD_MS             1000
+
+// <o SL_BT_ADAPTIVE_TIMING_ACTIVE_THRESHOLD> Events per period to switch to the active profile <1-1000>
+// <i> Notifications reported by the application and writes from the client both count.
+// <i> Default: 1
+#define SL_BT_ADAPTIVE_TIMING_ACTIVE_THRESHOLD           1
+
+// <o SL_BT_ADAPTIVE_TIMING_IDLE_TIMEOUT_MS> Inactivity before switching to the idle profile [msec] <0-600000>
+// <i> Default: 5000
+#define SL_BT_ADAPTIVE_TIMING_IDLE_TIMEOUT_MS            5000
+
+// </h>
+
+// <<< end of configuration section >>>
+
+/** @} (end addtogroup adaptive_timing) */
+#endif // SL_BT_ADAPTIVE_TIMING_CONFIG_H
@@ -57,6 +57,22 @@
 #define SL_POWER_MANAGER_DEBUG_POOL_SIZE  10
 // </e>
 
+// <e SL_POWER_MANAGER_STATISTICS> Enable energy mode statistics
+// <i> Enable or disable the time accounting per energy mode and the wake-up source counters.
+// <i> Default: 0
+#define SL_POWER_MANAGER_STATISTICS  0
+
+// <o SL_POWER_MANAGER_STATISTICS_EM1_OWNER_TABLE_SIZE> Maximum numbers of EM1 requirement owners that can be tracked
+// <i> Owners are only known when the debugging feature is enabled.
+// <i> Default: 8
+#define SL_POWER_MANAGER_STATISTICS_EM1_OWNER_TABLE_SIZE  8
+
+// <o SL_POWER_MANAGER_STATISTICS_PRINT_PERIOD_MS> Period of the statistics report in milliseconds
+// <i> The report is printed from sl_power_manager_statistics_process_action(). 0 disables it.
+// <i> Default: 0
+#define SL_POWER_MANAGER_STATISTICS_PRINT_PERIOD_MS  0
+// </e>
+
 // <o SL_POWER_MANAGER_INIT_EMU_EM4_PIN_RETENTION_MODE> Pin retention mode
 // <i>
 // <EMU_EM4CTRL_EM4IORETMODE_DISABLE=> No retention
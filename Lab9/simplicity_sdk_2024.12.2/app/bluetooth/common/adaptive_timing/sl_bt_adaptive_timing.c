@@ -0,0 +1,353 @@
+/***************************************************************************//**
+ * @file
+ * @brief Adaptive Advertising and Connection Timing
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2025 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "sl_common.h"
+#include "sl_core.h"
+#include "app_assert.h"
+#include "app_timer.h"
+#include "sl_bt_adaptive_timing.h"
+#include "sl_bt_adaptive_timing_config.h"
+
+// Connection event length range left to the stack.
+#define CE_LENGTH_MIN  0
+#define CE_LENGTH_MAX  0xffff
+
+static sl_bt_adaptive_timing_policy_t policy = {
+  .fast_adv_interval = SL_BT_ADAPTIVE_TIMING_FAST_ADV_INTERVAL,
+  .fast_adv_timeout_ms = SL_BT_ADAPTIVE_TIMING_FAST_ADV_TIMEOUT_MS,
+  .slow_adv_interval = SL_BT_ADAPTIVE_TIMING_SLOW_ADV_INTERVAL,
+  .active_min_interval = SL_BT_ADAPTIVE_TIMING_ACTIVE_MIN_INTERVAL,
+  .active_max_interval = SL_BT_ADAPTIVE_TIMING_ACTIVE_MAX_INTERVAL,
+  .active_latency = SL_BT_ADAPTIVE_TIMING_ACTIVE_LATENCY,
+  .idle_min_interval = SL_BT_ADAPTIVE_TIMING_IDLE_MIN_INTERVAL,
+  .idle_max_interval = SL_BT_ADAPTIVE_TIMING_IDLE_MAX_INTERVAL,
+  .idle_latency = SL_BT_ADAPTIVE_TIMING_IDLE_LATENCY,
+  .supervision_timeout = SL_BT_ADAPTIVE_TIMING_SUPERVISION_TIMEOUT,
+  .active_threshold = SL_BT_ADAPTIVE_TIMING_ACTIVE_THRESHOLD,
+  .idle_timeout_ms = SL_BT_ADAPTIVE_TIMING_IDLE_TIMEOUT_MS,
+};
+
+static sl_bt_adaptive_timing_status_t status = {
+  .state = SL_BT_ADAPTIVE_TIMING_STATE_STOPPED,
+  .advertising_set = 0xff,
+  .connection = SL_BT_INVALID_CONNECTION_HANDLE,
+};
+
+// Activity reported since the last evaluation; may be written from ISRs.
+static volatile uint16_t pending_activity = 0;
+
+static app_timer_t eval_timer;
+static bool eval_timer_running = false;
+
+static void enter_state(sl_bt_adaptive_timing_state_t state);
+static void on_activity(uint16_t count);
+static void eval_timer_cb(app_timer_t *handle, void *data);
+static sl_status_t apply_advertising(uint32_t interval);
+static void apply_connection_parameters(bool active);
+
+/**************************************************************************//**
+ * Bluetooth stack event handler.
+ *****************************************************************************/
+void sl_bt_adaptive_timing_on_event(sl_bt_msg_t *evt)
+{
+  switch (SL_BT_MSG_ID(evt->header)) {
+    // -------------------------------
+    // A central connected; start responsive and back off once idle.
+    case sl_bt_evt_connection_opened_id:
+      status.connection = evt->data.evt_connection_opened.connection;
+      enter_state(SL_BT_ADAPTIVE_TIMING_STATE_CONNECTED_ACTIVE);
+      break;
+
+    // -------------------------------
+    // Parameters actually in use, whoever requested them.
+    case sl_bt_evt_connection_parameters_id:
+      if (evt->data.evt_connection_parameters.connection == status.connection) {
+        status.conn_interval = evt->data.evt_connection_parameters.interval;
+        status.conn_latency = evt->data.evt_connection_parameters.latency;
+      }
+      break;
+
+    // -------------------------------
+    // The application restarts advertising through
+    // sl_bt_adaptive_timing_start_advertising().
+    case sl_bt_evt_connection_closed_id:
+      if (evt->data.evt_connection_closed.connection == status.connection) {
+        status.connection = SL_BT_INVALID_CONNECTION_HANDLE;
+        status.conn_interval = 0;
+        status.conn_latency = 0;
+        enter_state(SL_BT_ADAPTIVE_TIMING_STATE_STOPPED);
+      }
+      break;
+
+    // -------------------------------
+    // Writes from the client are activity; react at once so that the
+    // following writes are not slowed down by the idle profile.
+    case sl_bt_evt_gatt_server_attribute_value_id:
+    case sl_bt_evt_gatt_server_user_write_request_id:
+      on_activity(1);
+      break;
+
+    default:
+      break;
+  }
+}
+
+/**************************************************************************//**
+ * Start connectable advertising with the fast interval.
+ *****************************************************************************/
+sl_status_t sl_bt_adaptive_timing_start_advertising(uint8_t advertising_set)
+{
+  sl_status_t sc;
+
+  status.advertising_set = advertising_set;
+  sc = apply_advertising(policy.fast_adv_interval);
+  if (sc == SL_STATUS_OK) {
+    enter_state(SL_BT_ADAPTIVE_TIMING_STATE_FAST_ADVERTISING);
+  }
+  return sc;
+}
+
+/**************************************************************************//**
+ * Report an application activity event.
+ *****************************************************************************/
+void sl_bt_adaptive_timing_report_activity(void)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_ATOMIC();
+  if (pending_activity < UINT16_MAX) {
+    pending_activity++;
+  }
+  CORE_EXIT_ATOMIC();
+}
+
+/**************************************************************************//**
+ * Replace the policy.
+ *****************************************************************************/
+sl_status_t sl_bt_adaptive_timing_set_policy(const sl_bt_adaptive_timing_policy_t *new_policy)
+{
+  if (new_policy == NULL) {
+    return SL_STATUS_NULL_POINTER;
+  }
+  if ((new_policy->active_min_interval > new_policy->active_max_interval)
+      || (new_policy->idle_min_interval > new_policy->idle_max_interval)
+      || (new_policy->active_threshold == 0)) {
+    return SL_STATUS_INVALID_PARAMETER;
+  }
+  policy = *new_policy;
+  return SL_STATUS_OK;
+}
+
+/**************************************************************************//**
+ * Get the policy in use.
+ *****************************************************************************/
+void sl_bt_adaptive_timing_get_policy(sl_bt_adaptive_timing_policy_t *current_policy)
+{
+  if (current_policy != NULL) {
+    *current_policy = policy;
+  }
+}
+
+/**************************************************************************//**
+ * Get the controller state.
+ *****************************************************************************/
+void sl_bt_adaptive_timing_get_status(sl_bt_adaptive_timing_status_t *current_status)
+{
+  if (current_status != NULL) {
+    *current_status = status;
+  }
+}
+
+/**************************************************************************//**
+ * Switch state, apply the matching timing and run the evaluation timer only
+ * in the states that can still change by themselves.
+ *****************************************************************************/
+static void enter_state(sl_bt_adaptive_timing_state_t state)
+{
+  sl_status_t sc;
+  bool needs_timer;
+
+  switch (state) {
+    case SL_BT_ADAPTIVE_TIMING_STATE_SLOW_ADVERTISING:
+      sc = apply_advertising(policy.slow_adv_interval);
+      app_assert_status(sc);
+      break;
+
+    case SL_BT_ADAPTIVE_TIMING_STATE_CONNECTED_ACTIVE:
+      apply_connection_parameters(true);
+      break;
+
+    case SL_BT_ADAPTIVE_TIMING_STATE_CONNECTED_IDLE:
+      apply_connection_parameters(false);
+      break;
+
+    default:
+      // Fast advertising is applied by the caller; nothing to do when stopped.
+      break;
+  }
+
+  status.state = state;
+  status.state_time_ms = 0;
+  status.idle_time_ms = 0;
+  status.activity_count = 0;
+
+  needs_timer = (state == SL_BT_ADAPTIVE_TIMING_STATE_CONNECTED_ACTIVE)
+                || (state == SL_BT_ADAPTIVE_TIMING_STATE_CONNECTED_IDLE)
+                || ((state == SL_BT_ADAPTIVE_TIMING_STATE_FAST_ADVERTISING)
+                    && (policy.fast_adv_timeout_ms != 0));
+
+  if (needs_timer && !eval_timer_running) {
+    sc = app_timer_start(&eval_timer,
+                         SL_BT_ADAPTIVE_TIMING_EVAL_PERIOD_MS,
+                         eval_timer_cb,
+                         NULL,
+                         true);
+    app_assert_status(sc);
+    eval_timer_running = true;
+  } else if (!needs_timer && eval_timer_running) {
+    (void)app_timer_stop(&eval_timer);
+    eval_timer_running = false;
+  }
+}
+
+/**************************************************************************//**
+ * Count activity and leave the idle profile once the threshold is reached.
+ *****************************************************************************/
+static void on_activity(uint16_t count)
+{
+  if (count == 0) {
+    return;
+  }
+
+  status.idle_time_ms = 0;
+  status.activity_count = (status.activity_count > (UINT16_MAX - count))
+                          ? UINT16_MAX : (uint16_t)(status.activity_count + count);
+
+  if ((status.state == SL_BT_ADAPTIVE_TIMING_STATE_CONNECTED_IDLE)
+      && (status.activity_count >= policy.active_threshold)) {
+    enter_state(SL_BT_ADAPTIVE_TIMING_STATE_CONNECTED_ACTIVE);
+  }
+}
+
+/**************************************************************************//**
+ * Periodic policy evaluation.
+ *****************************************************************************/
+static void eval_timer_cb(app_timer_t *handle, void *data)
+{
+  CORE_DECLARE_IRQ_STATE;
+  uint16_t activity;
+  (void)handle;
+  (void)data;
+
+  CORE_ENTER_ATOMIC();
+  activity = pending_activity;
+  pending_activity = 0;
+  CORE_EXIT_ATOMIC();
+
+  on_activity(activity);
+  if (activity == 0) {
+    status.idle_time_ms += SL_BT_ADAPTIVE_TIMING_EVAL_PERIOD_MS;
+  }
+  status.state_time_ms += SL_BT_ADAPTIVE_TIMING_EVAL_PERIOD_MS;
+
+  switch (status.state) {
+    case SL_BT_ADAPTIVE_TIMING_STATE_FAST_ADVERTISING:
+      if (status.state_time_ms >= policy.fast_adv_timeout_ms) {
+        enter_state(SL_BT_ADAPTIVE_TIMING_STATE_SLOW_ADVERTISING);
+      }
+      return;
+
+    case SL_BT_ADAPTIVE_TIMING_STATE_CONNECTED_ACTIVE:
+      if (status.idle_time_ms >= policy.idle_timeout_ms) {
+        enter_state(SL_BT_ADAPTIVE_TIMING_STATE_CONNECTED_IDLE);
+        return;
+      }
+      break;
+
+    default:
+      break;
+  }
+
+  // The activity count is per evaluation period.
+  status.activity_count = 0;
+}
+
+/**************************************************************************//**
+ * Restart advertising on the application's set with a new interval.
+ * The interval of a running set only changes on restart.
+ *****************************************************************************/
+static sl_status_t apply_advertising(uint32_t interval)
+{
+  sl_status_t sc;
+
+  (void)sl_bt_advertiser_stop(status.advertising_set);
+
+  sc = sl_bt_advertiser_set_timing(status.advertising_set,
+                                   interval, // min. adv. interval (milliseconds * 1.6)
+                                   interval, // max. adv. interval (milliseconds * 1.6)
+                                   0,        // adv. duration
+                                   0);       // max. num. adv. events
+  if (sc != SL_STATUS_OK) {
+    return sc;
+  }
+
+  sc = sl_bt_legacy_advertiser_start(status.advertising_set,
+                                     sl_bt_advertiser_connectable_scannable);
+  if (sc == SL_STATUS_OK) {
+    status.adv_interval = interval;
+  }
+  return sc;
+}
+
+/**************************************************************************//**
+ * Request the active or idle connection parameters. The central may refuse;
+ * sl_bt_evt_connection_parameters reports what is actually used.
+ *****************************************************************************/
+static void apply_connection_parameters(bool active)
+{
+  sl_status_t sc;
+
+  if (status.connection == SL_BT_INVALID_CONNECTION_HANDLE) {
+    return;
+  }
+
+  sc = sl_bt_connection_set_parameters(status.connection,
+                                       active ? policy.active_min_interval : policy.idle_min_interval,
+                                       active ? policy.active_max_interval : policy.idle_max_interval,
+                                       active ? policy.active_latency : policy.idle_latency,
+                                       policy.supervision_timeout,
+                                       CE_LENGTH_MIN,
+                                       CE_LENGTH_MAX);
+  if (sc == SL_STATUS_OK) {
+    status.parameter_update_count++;
+  }
+}
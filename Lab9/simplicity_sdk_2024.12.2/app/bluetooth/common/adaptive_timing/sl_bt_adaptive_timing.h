@@ -0,0 +1,124 @@
+/***************************************************************************//**
+ * @file
+ * @brief Adaptive Advertising and Connection Timing
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2025 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef SL_BT_ADAPTIVE_TIMING_H
+#define SL_BT_ADAPTIVE_TIMING_H
+
+/***********************************************************************************************//**
+ * @addtogroup adaptive_timing
+ * @{
+ **************************************************************************************************/
+
+#include <stdint.h>
+#include "sl_status.h"
+#include "sl_bt_api.h"
+#include "sl_bt_adaptive_timing_config.h"
+
+// Timing profile currently applied
+typedef enum {
+  SL_BT_ADAPTIVE_TIMING_STATE_STOPPED = 0,    // Neither advertising nor connected
+  SL_BT_ADAPTIVE_TIMING_STATE_FAST_ADVERTISING,
+  SL_BT_ADAPTIVE_TIMING_STATE_SLOW_ADVERTISING,
+  SL_BT_ADAPTIVE_TIMING_STATE_CONNECTED_ACTIVE,
+  SL_BT_ADAPTIVE_TIMING_STATE_CONNECTED_IDLE
+} sl_bt_adaptive_timing_state_t;
+
+// Policy parameters. Intervals use the units of the Bluetooth API.
+typedef struct {
+  uint32_t fast_adv_interval;       // Advertising interval after boot or disconnect [0.625 ms]
+  uint32_t fast_adv_timeout_ms;     // Time spent advertising fast before backing off
+  uint32_t slow_adv_interval;       // Advertising interval after the back-off [0.625 ms]
+  uint16_t active_min_interval;     // Connection interval range while active [1.25 ms]
+  uint16_t active_max_interval;
+  uint16_t active_latency;          // Peripheral latency while active
+  uint16_t idle_min_interval;       // Connection interval range while idle [1.25 ms]
+  uint16_t idle_max_interval;
+  uint16_t idle_latency;            // Peripheral latency while idle
+  uint16_t supervision_timeout;     // Supervision timeout for both profiles [10 ms]
+  uint16_t active_threshold;        // Activity events per evaluation period to become active
+  uint32_t idle_timeout_ms;         // Inactivity before becoming idle
+} sl_bt_adaptive_timing_policy_t;
+
+// Snapshot of the controller state
+typedef struct {
+  sl_bt_adaptive_timing_state_t state;
+  uint8_t advertising_set;          // Set handed over by the application
+  uint8_t connection;               // SL_BT_INVALID_CONNECTION_HANDLE if not connected
+  uint32_t adv_interval;            // Advertising interval last requested [0.625 ms]
+  uint16_t conn_interval;           // Connection interval reported by the stack [1.25 ms]
+  uint16_t conn_latency;            // Peripheral latency reported by the stack
+  uint16_t activity_count;          // Activity events in the current evaluation period
+  uint32_t idle_time_ms;            // Time since the last activity event
+  uint32_t state_time_ms;           // Time spent in the current state
+  uint32_t parameter_update_count;  // Connection parameter requests sent
+} sl_bt_adaptive_timing_status_t;
+
+/**************************************************************************//**
+ * Bluetooth stack event handler.
+ * @param[in] evt Event coming from the Bluetooth stack.
+ *****************************************************************************/
+void sl_bt_adaptive_timing_on_event(sl_bt_msg_t *evt);
+
+/**************************************************************************//**
+ * Start connectable advertising on the given set with the fast interval.
+ * Replaces the sl_bt_advertiser_set_timing() and sl_bt_legacy_advertiser_start()
+ * calls of the application. The advertising data must already be set.
+ * @param[in] advertising_set Advertising set handle.
+ * @return Status of the Bluetooth API calls.
+ *****************************************************************************/
+sl_status_t sl_bt_adaptive_timing_start_advertising(uint8_t advertising_set);
+
+/**************************************************************************//**
+ * Report an application activity event, such as a notification sent.
+ * @note Can be called from interrupt context.
+ *****************************************************************************/
+void sl_bt_adaptive_timing_report_activity(void);
+
+/**************************************************************************//**
+ * Replace the policy. Takes effect at the next state change.
+ * @param[in] policy New policy.
+ * @return SL_STATUS_INVALID_PARAMETER if an interval range is empty.
+ *****************************************************************************/
+sl_status_t sl_bt_adaptive_timing_set_policy(const sl_bt_adaptive_timing_policy_t *policy);
+
+/**************************************************************************//**
+ * Get the policy in use.
+ * @param[out] policy Current policy.
+ *****************************************************************************/
+void sl_bt_adaptive_timing_get_policy(sl_bt_adaptive_timing_policy_t *policy);
+
+/**************************************************************************//**
+ * Get the controller state.
+ * @param[out] status Current state.
+ *****************************************************************************/
+void sl_bt_adaptive_timing_get_status(sl_bt_adaptive_timing_status_t *status);
+
+/** @} (end addtogroup adaptive_timing) */
+#endif // SL_BT_ADAPTIVE_TIMING_H
@@ -0,0 +1,67 @@
+/***************************************************************************//**
+ * @file
+ * @brief Notification Scheduler Configuration
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2025 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef SL_BT_NOTIFY_SCHEDULER_CONFIG_H
+#define SL_BT_NOTIFY_SCHEDULER_CONFIG_H
+
+/***********************************************************************************************//**
+ * @addtogroup notify_scheduler
+ * @{
+ **************************************************************************************************/
+
+// <<< Use Configuration Wizard in Context Menu >>>
+
+// <o SL_BT_NOTIFY_SCHEDULER_MAX_CHARACTERISTICS> Number of scheduled characteristics <1-32>
+// <i> Default: 4
+#define SL_BT_NOTIFY_SCHEDULER_MAX_CHARACTERISTICS     4
+
+// <o SL_BT_NOTIFY_SCHEDULER_MAX_VALUE_LEN> Maximum characteristic value length [bytes] <1-244>
+// <i> Default: 20
+#define SL_BT_NOTIFY_SCHEDULER_MAX_VALUE_LEN           20
+
+// <o SL_BT_NOTIFY_SCHEDULER_TX_CREDITS> Notifications per connection and credit period <1-32>
+// <i> Default: 4
+#define SL_BT_NOTIFY_SCHEDULER_TX_CREDITS              4
+
+// <o SL_BT_NOTIFY_SCHEDULER_CREDIT_PERIOD_MS> Credit period [msec] <5-1000>
+// <i> Credits are given back once per period. Should be close to the
+// <i> connection interval.
+// <i> Default: 30
+#define SL_BT_NOTIFY_SCHEDULER_CREDIT_PERIOD_MS        30
+
+// <o SL_BT_NOTIFY_SCHEDULER_SIGNAL> External signal used to wake up the scheduler <f.h>
+// <i> Must not be used by any other part of the application.
+// <i> Default: 0x80000000
+#define SL_BT_NOTIFY_SCHEDULER_SIGNAL                  0x80000000
+
+// <<< end of configuration section >>>
+
+/** @} (end addtogroup notify_scheduler) */
+#endif // SL_BT_NOTIFY_SCHEDULER_CONFIG_H
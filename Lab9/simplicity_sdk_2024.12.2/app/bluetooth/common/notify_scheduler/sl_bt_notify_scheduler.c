@@ -0,0 +1,340 @@
+/***************************************************************************//**
+ * @file
+ * @brief Notification Scheduler
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2025 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#include <stdbool.h>
+#include <string.h>
+#include "sl_common.h"
+#include "sl_core.h"
+#include "app_timer.h"
+#include "sl_bluetooth_connection_config.h"
+#include "sl_bt_notify_scheduler.h"
+#include "sl_bt_notify_scheduler_config.h"
+
+// Latest value of a scheduled characteristic
+typedef struct {
+  uint16_t characteristic;
+  uint8_t len;
+  bool db_dirty;                // GATT database not updated yet
+  uint8_t value[SL_BT_NOTIFY_SCHEDULER_MAX_VALUE_LEN];
+} characteristic_entry_t;
+
+// Per-connection state; one bit per characteristic in the masks.
+typedef struct {
+  bool in_use;
+  uint8_t connection;
+  uint8_t credits;
+  uint32_t subscribed;
+  uint32_t dirty;               // Latest value not sent on this connection
+} connection_entry_t;
+
+static characteristic_entry_t characteristics[SL_BT_NOTIFY_SCHEDULER_MAX_CHARACTERISTICS];
+static uint8_t characteristic_count = 0;
+
+// Written from set_value, which may run in interrupt context.
+static connection_entry_t connections[SL_BT_CONFIG_MAX_CONNECTIONS];
+static sl_bt_notify_scheduler_stats_t stats;
+
+// Connection served first on the next pass, for fairness.
+static uint8_t next_connection = 0;
+
+static app_timer_t credit_timer;
+static bool credit_timer_running = false;
+
+static int find_characteristic(uint16_t characteristic);
+static connection_entry_t *find_connection(uint8_t connection);
+static void process(void);
+static bool send_pending(connection_entry_t *entry);
+static void credit_timer_cb(app_timer_t *handle, void *data);
+
+// -----------------------------------------------------------------------------
+// Public functions
+
+sl_status_t sl_bt_notify_scheduler_add(uint16_t characteristic)
+{
+  if (find_characteristic(characteristic) >= 0) {
+    return SL_STATUS_OK;
+  }
+  if (characteristic_count >= SL_BT_NOTIFY_SCHEDULER_MAX_CHARACTERISTICS) {
+    return SL_STATUS_NO_MORE_RESOURCE;
+  }
+  characteristics[characteristic_count].characteristic = characteristic;
+  characteristics[characteristic_count].len = 0;
+  characteristics[characteristic_count].db_dirty = false;
+  characteristic_count++;
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_notify_scheduler_set_value(uint16_t characteristic,
+                                             size_t value_len,
+                                             const uint8_t *value)
+{
+  CORE_DECLARE_IRQ_STATE;
+  int index = find_characteristic(characteristic);
+  uint32_t mask;
+
+  if (index < 0) {
+    return SL_STATUS_NOT_FOUND;
+  }
+  if (value_len > SL_BT_NOTIFY_SCHEDULER_MAX_VALUE_LEN) {
+    return SL_STATUS_INVALID_PARAMETER;
+  }
+  mask = 1UL << index;
+
+  CORE_ENTER_ATOMIC();
+  memcpy(characteristics[index].value, value, value_len);
+  characteristics[index].len = (uint8_t)value_len;
+  characteristics[index].db_dirty = true;
+  stats.updates++;
+  for (uint8_t i = 0; i < SL_BT_CONFIG_MAX_CONNECTIONS; i++) {
+    if (!connections[i].in_use || !(connections[i].subscribed & mask)) {
+      continue;
+    }
+    if (connections[i].dirty & mask) {
+      stats.merged++;
+    }
+    connections[i].dirty |= mask;
+  }
+  CORE_EXIT_ATOMIC();
+
+  // Stack calls are not allowed here; continue in the event loop.
+  (void)sl_bt_external_signal(SL_BT_NOTIFY_SCHEDULER_SIGNAL);
+  return SL_STATUS_OK;
+}
+
+void sl_bt_notify_scheduler_get_stats(sl_bt_notify_scheduler_stats_t *out)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_ATOMIC();
+  *out = stats;
+  CORE_EXIT_ATOMIC();
+}
+
+void sl_bt_notify_scheduler_on_event(sl_bt_msg_t *evt)
+{
+  CORE_DECLARE_IRQ_STATE;
+  connection_entry_t *entry;
+
+  switch (SL_BT_MSG_ID(evt->header)) {
+    case sl_bt_evt_connection_opened_id:
+      entry = find_connection(SL_BT_INVALID_CONNECTION_HANDLE);
+      if (entry != NULL) {
+        CORE_ENTER_ATOMIC();
+        entry->connection = evt->data.evt_connection_opened.connection;
+        entry->credits = SL_BT_NOTIFY_SCHEDULER_TX_CREDITS;
+        entry->subscribed = 0;
+        entry->dirty = 0;
+        entry->in_use = true;
+        CORE_EXIT_ATOMIC();
+      }
+      break;
+
+    case sl_bt_evt_connection_closed_id:
+      entry = find_connection(evt->data.evt_connection_closed.connection);
+      if (entry != NULL) {
+        CORE_ENTER_ATOMIC();
+        stats.dropped += SL_POPCOUNT32(entry->dirty);
+        entry->in_use = false;
+        entry->subscribed = 0;
+        entry->dirty = 0;
+        CORE_EXIT_ATOMIC();
+      }
+      break;
+
+    case sl_bt_evt_gatt_server_characteristic_status_id:
+    {
+      sl_bt_evt_gatt_server_characteristic_status_t *status =
+        &evt->data.evt_gatt_server_characteristic_status;
+      int index = find_characteristic(status->characteristic);
+
+      entry = find_connection(status->connection);
+      if (index < 0 || entry == NULL
+          || status->status_flags != sl_bt_gatt_server_client_config) {
+        break;
+      }
+      CORE_ENTER_ATOMIC();
+      if (status->client_config_flags & sl_bt_gatt_notification) {
+        entry->subscribed |= 1UL << index;
+      } else {
+        entry->subscribed &= ~(1UL << index);
+        if (entry->dirty & (1UL << index)) {
+          stats.dropped++;
+          entry->dirty &= ~(1UL << index);
+        }
+      }
+      CORE_EXIT_ATOMIC();
+      break;
+    }
+
+    case sl_bt_evt_system_external_signal_id:
+      if (evt->data.evt_system_external_signal.extsignals
+          & SL_BT_NOTIFY_SCHEDULER_SIGNAL) {
+        process();
+      }
+      break;
+
+    default:
+      break;
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Private functions
+
+static int find_characteristic(uint16_t characteristic)
+{
+  for (uint8_t i = 0; i < characteristic_count; i++) {
+    if (characteristics[i].characteristic == characteristic) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+// Pass SL_BT_INVALID_CONNECTION_HANDLE to get a free entry.
+static connection_entry_t *find_connection(uint8_t connection)
+{
+  for (uint8_t i = 0; i < SL_BT_CONFIG_MAX_CONNECTIONS; i++) {
+    if (connection == SL_BT_INVALID_CONNECTION_HANDLE) {
+      if (!connections[i].in_use) {
+        return &connections[i];
+      }
+    } else if (connections[i].in_use
+               && connections[i].connection == connection) {
+      return &connections[i];
+    }
+  }
+  return NULL;
+}
+
+// Update the GATT database once per value, then send the pending values on
+// every connection that still has credits.
+static void process(void)
+{
+  CORE_DECLARE_IRQ_STATE;
+  uint8_t value[SL_BT_NOTIFY_SCHEDULER_MAX_VALUE_LEN];
+  uint8_t len;
+  bool db_dirty;
+  bool timer_needed = false;
+
+  for (uint8_t i = 0; i < characteristic_count; i++) {
+    CORE_ENTER_ATOMIC();
+    db_dirty = characteristics[i].db_dirty;
+    characteristics[i].db_dirty = false;
+    len = characteristics[i].len;
+    memcpy(value, characteristics[i].value, len);
+    CORE_EXIT_ATOMIC();
+    if (db_dirty) {
+      (void)sl_bt_gatt_server_write_attribute_value(characteristics[i].characteristic,
+                                                    0,
+                                                    len,
+                                                    value);
+    }
+  }
+
+  for (uint8_t n = 0; n < SL_BT_CONFIG_MAX_CONNECTIONS; n++) {
+    connection_entry_t *entry =
+      &connections[(next_connection + n) % SL_BT_CONFIG_MAX_CONNECTIONS];
+    if (!entry->in_use) {
+      continue;
+    }
+    if (send_pending(entry)
+        || entry->credits < SL_BT_NOTIFY_SCHEDULER_TX_CREDITS) {
+      timer_needed = true;
+    }
+  }
+  next_connection = (next_connection + 1) % SL_BT_CONFIG_MAX_CONNECTIONS;
+
+  // The timer only runs while credits are being given back.
+  if (timer_needed && !credit_timer_running) {
+    credit_timer_running = (app_timer_start(&credit_timer,
+                                            SL_BT_NOTIFY_SCHEDULER_CREDIT_PERIOD_MS,
+                                            credit_timer_cb,
+                                            NULL,
+                                            true) == SL_STATUS_OK);
+  } else if (!timer_needed && credit_timer_running) {
+    (void)app_timer_stop(&credit_timer);
+    credit_timer_running = false;
+  }
+}
+
+// Send the latest values pending on a connection. Returns true if values
+// are left for a later pass.
+static bool send_pending(connection_entry_t *entry)
+{
+  CORE_DECLARE_IRQ_STATE;
+  uint8_t value[SL_BT_NOTIFY_SCHEDULER_MAX_VALUE_LEN];
+  uint8_t len;
+  uint32_t mask;
+  uint8_t index;
+  sl_status_t sc;
+
+  while (entry->dirty != 0 && entry->credits > 0) {
+    CORE_ENTER_ATOMIC();
+    index = (uint8_t)SL_CTZ(entry->dirty);
+    mask = 1UL << index;
+    entry->dirty &= ~mask;
+    len = characteristics[index].len;
+    memcpy(value, characteristics[index].value, len);
+    CORE_EXIT_ATOMIC();
+
+    sc = sl_bt_gatt_server_send_notification(entry->connection,
+                                             characteristics[index].characteristic,
+                                             len,
+                                             value);
+    if (sc == SL_STATUS_OK) {
+      entry->credits--;
+      stats.sent++;
+    } else if (sc == SL_STATUS_NO_MORE_RESOURCE) {
+      // TX queue full: keep the value, unless a newer one arrived meanwhile.
+      CORE_ENTER_ATOMIC();
+      entry->dirty |= mask;
+      stats.deferred++;
+      CORE_EXIT_ATOMIC();
+      entry->credits = 0;
+    } else {
+      CORE_ENTER_ATOMIC();
+      stats.dropped++;
+      CORE_EXIT_ATOMIC();
+    }
+  }
+  return entry->dirty != 0;
+}
+
+static void credit_timer_cb(app_timer_t *handle, void *data)
+{
+  (void)handle;
+  (void)data;
+
+  for (uint8_t i = 0; i < SL_BT_CONFIG_MAX_CONNECTIONS; i++) {
+    connections[i].credits = SL_BT_NOTIFY_SCHEDULER_TX_CREDITS;
+  }
+  process();
+}
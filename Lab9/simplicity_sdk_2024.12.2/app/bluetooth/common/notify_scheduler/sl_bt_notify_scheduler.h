@@ -0,0 +1,93 @@
+/***************************************************************************//**
+ * @file
+ * @brief Notification Scheduler
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2025 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef SL_BT_NOTIFY_SCHEDULER_H
+#define SL_BT_NOTIFY_SCHEDULER_H
+
+/***********************************************************************************************//**
+ * @addtogroup notify_scheduler
+ * @{
+ **************************************************************************************************/
+
+#include <stddef.h>
+#include <stdint.h>
+#include "sl_status.h"
+#include "sl_bt_api.h"
+
+// Scheduler counters
+typedef struct {
+  uint32_t updates;   // Values set by the application
+  uint32_t sent;      // Notifications accepted by the stack
+  uint32_t merged;    // Values replaced before they reached a connection
+  uint32_t deferred;  // Sends postponed because the TX queue was full
+  uint32_t dropped;   // Pending values lost on unsubscribe, disconnect or error
+} sl_bt_notify_scheduler_stats_t;
+
+/**************************************************************************//**
+ * Register a characteristic to be notified through the scheduler.
+ * @param[in] characteristic GATT database handle of the characteristic.
+ * @retval SL_STATUS_OK Characteristic registered or already registered.
+ * @retval SL_STATUS_NO_MORE_RESOURCE Characteristic table is full.
+ *****************************************************************************/
+sl_status_t sl_bt_notify_scheduler_add(uint16_t characteristic);
+
+/**************************************************************************//**
+ * Update the value of a characteristic.
+ *
+ * The value is written to the GATT database and notified to every
+ * subscribed connection from the Bluetooth event loop. If the previous value
+ * has not been sent to a connection yet, only the latest one is sent.
+ *
+ * @param[in] characteristic GATT database handle of the characteristic.
+ * @param[in] value_len Length of the value.
+ * @param[in] value New value.
+ * @retval SL_STATUS_OK Value queued.
+ * @retval SL_STATUS_NOT_FOUND Characteristic is not registered.
+ * @retval SL_STATUS_INVALID_PARAMETER Value is too long.
+ * @note Can be called from interrupt context.
+ *****************************************************************************/
+sl_status_t sl_bt_notify_scheduler_set_value(uint16_t characteristic,
+                                             size_t value_len,
+                                             const uint8_t *value);
+
+/**************************************************************************//**
+ * Get the scheduler counters.
+ * @param[out] stats Counters.
+ *****************************************************************************/
+void sl_bt_notify_scheduler_get_stats(sl_bt_notify_scheduler_stats_t *stats);
+
+/**************************************************************************//**
+ * Bluetooth stack event handler.
+ * @param[in] evt Event coming from the Bluetooth stack.
+ *****************************************************************************/
+void sl_bt_notify_scheduler_on_event(sl_bt_msg_t *evt);
+
+/** @} (end addtogroup notify_scheduler) */
+#endif // SL_BT_NOTIFY_SCHEDULER_H
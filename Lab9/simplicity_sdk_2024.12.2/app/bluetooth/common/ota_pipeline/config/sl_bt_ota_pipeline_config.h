@@ -0,0 +1,61 @@
+/***************************************************************************//**
+ * @file
+ * @brief OTA Receive Pipeline Configuration
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2025 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef SL_BT_OTA_PIPELINE_CONFIG_H
+#define SL_BT_OTA_PIPELINE_CONFIG_H
+
+/***********************************************************************************************//**
+ * @addtogroup ota_pipeline
+ * @{
+ **************************************************************************************************/
+
+// <<< Use Configuration Wizard in Context Menu >>>
+
+// <o SL_BT_OTA_PIPELINE_SLOT_ID> Bootloader storage slot receiving the image <0-7>
+// <i> Default: 0
+#define SL_BT_OTA_PIPELINE_SLOT_ID          0
+
+// <o SL_BT_OTA_PIPELINE_BUFFER_SIZE> Size of each of the two receive buffers [bytes] <64-4096:4>
+// <i> Must be a multiple of the flash word size. Larger buffers mean fewer
+// <i> flash write calls but longer stalls when both buffers are full.
+// <i> Default: 512
+#define SL_BT_OTA_PIPELINE_BUFFER_SIZE      512
+
+// <o SL_BT_OTA_PIPELINE_REBOOT_DELAY_MS> Delay before closing the connection to install an image [ms] <100-5000>
+// <i> Leaves time for the response to the finish command to reach the
+// <i> client. The device then resets into the bootloader, which installs
+// <i> the image.
+// <i> Default: 500
+#define SL_BT_OTA_PIPELINE_REBOOT_DELAY_MS  500
+
+// <<< end of configuration section >>>
+
+/** @} (end addtogroup ota_pipeline) */
+#endif // SL_BT_OTA_PIPELINE_CONFIG_H
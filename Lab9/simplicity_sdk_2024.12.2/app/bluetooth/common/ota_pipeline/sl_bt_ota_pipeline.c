@@ -0,0 +1,470 @@
+/***************************************************************************//**
+ * @file
+ * @brief OTA Receive Pipeline
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2025 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#include <stdbool.h>
+#include <string.h>
+#include "sl_common.h"
+#include "sl_sleeptimer.h"
+#include "psa/crypto.h"
+#include "btl_interface.h"
+#include "sl_bt_ota_pipeline.h"
+#include "sl_bt_ota_pipeline_config.h"
+
+#if (SL_BT_OTA_PIPELINE_BUFFER_SIZE % 4) != 0
+#error "SL_BT_OTA_PIPELINE_BUFFER_SIZE must be a multiple of 4."
+#endif
+
+#define FLASH_WORD_SIZE  4
+#define NO_BUFFER        0xff
+
+static sl_bt_ota_pipeline_state_t state = SL_BT_OTA_PIPELINE_IDLE;
+static const sl_bt_ota_pipeline_storage_t *storage = NULL;
+
+static uint32_t image_size;
+static uint32_t page_size;
+static uint32_t received;
+static uint32_t written;
+static uint32_t erased;
+
+// Two receive buffers: one is filled from the transport while the other
+// waits for, or is being written to, flash.
+static uint8_t buffers[2][SL_BT_OTA_PIPELINE_BUFFER_SIZE] SL_ATTRIBUTE_ALIGN(4);
+static uint32_t buffer_offset[2];
+static bool buffer_ready[2];
+static uint8_t fill = NO_BUFFER;
+static uint32_t fill_len;
+static uint8_t flush;
+
+static psa_hash_operation_t hash_operation = PSA_HASH_OPERATION_INIT;
+static uint8_t expected_digest[SL_BT_OTA_PIPELINE_DIGEST_SIZE];
+
+static uint32_t start_tick;
+static uint32_t end_tick;
+static uint32_t stall_tick;
+static uint32_t stall_start_tick;
+static bool stalled = false;
+
+static BootloaderEraseStatus_t erase_status;
+
+static void start_filling(uint8_t index);
+static sl_status_t step(void);
+static void stall_begin(void);
+static void stall_end(void);
+static void fail(void);
+static int32_t bootloader_begin(void *context, uint32_t *page, uint32_t *slot);
+static int32_t bootloader_erase_next(void *context);
+static int32_t bootloader_write(void *context, uint32_t offset, uint8_t *data, size_t len);
+static int32_t bootloader_install(void *context);
+static int32_t ram_begin(void *context, uint32_t *page, uint32_t *slot);
+static int32_t ram_erase_next(void *context);
+static int32_t ram_write(void *context, uint32_t offset, uint8_t *data, size_t len);
+
+static const sl_bt_ota_pipeline_storage_t bootloader_storage = {
+  .begin = bootloader_begin,
+  .erase_next = bootloader_erase_next,
+  .write = bootloader_write,
+  .install = bootloader_install,
+  .context = &erase_status,
+};
+
+// -----------------------------------------------------------------------------
+// Public functions
+
+const sl_bt_ota_pipeline_storage_t *sl_bt_ota_pipeline_bootloader_storage(void)
+{
+  return &bootloader_storage;
+}
+
+const sl_bt_ota_pipeline_storage_t *sl_bt_ota_pipeline_ram_storage_init(sl_bt_ota_pipeline_ram_storage_t *ram,
+                                                                        uint8_t *memory,
+                                                                        uint32_t size,
+                                                                        uint32_t page_size)
+{
+  ram->storage.begin = ram_begin;
+  ram->storage.erase_next = ram_erase_next;
+  ram->storage.write = ram_write;
+  ram->storage.install = NULL;
+  ram->storage.context = ram;
+  ram->memory = memory;
+  ram->size = size;
+  ram->page_size = page_size;
+  ram->erase_offset = 0;
+  return &ram->storage;
+}
+
+sl_status_t sl_bt_ota_pipeline_begin(const sl_bt_ota_pipeline_storage_t *backend,
+                                     uint32_t size,
+                                     const uint8_t digest[SL_BT_OTA_PIPELINE_DIGEST_SIZE])
+{
+  uint32_t slot_size = 0;
+
+  sl_bt_ota_pipeline_abort();
+
+  if (backend->begin(backend->context, &page_size, &slot_size) != BOOTLOADER_OK
+      || page_size == 0) {
+    return SL_STATUS_FAIL;
+  }
+  if (size == 0 || size > slot_size) {
+    return SL_STATUS_INVALID_PARAMETER;
+  }
+  if (psa_hash_setup(&hash_operation, PSA_ALG_SHA_256) != PSA_SUCCESS) {
+    return SL_STATUS_FAIL;
+  }
+
+  storage = backend;
+  image_size = size;
+  received = 0;
+  written = 0;
+  erased = 0;
+  buffer_ready[0] = false;
+  buffer_ready[1] = false;
+  flush = 0;
+  start_filling(0);
+  memcpy(expected_digest, digest, sizeof(expected_digest));
+  start_tick = sl_sleeptimer_get_tick_count();
+  stall_tick = 0;
+  stalled = false;
+  state = SL_BT_OTA_PIPELINE_RECEIVING;
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_ota_pipeline_write(const uint8_t *data, size_t len)
+{
+  uint32_t available;
+  uint32_t chunk;
+
+  if (state != SL_BT_OTA_PIPELINE_RECEIVING) {
+    return SL_STATUS_INVALID_STATE;
+  }
+  if (len > image_size - received) {
+    return SL_STATUS_INVALID_PARAMETER;
+  }
+
+  // Accept all or nothing, so the transport can simply retry the packet.
+  available = 0;
+  if (fill != NO_BUFFER) {
+    available = SL_BT_OTA_PIPELINE_BUFFER_SIZE - fill_len;
+    if (!buffer_ready[1 - fill]) {
+      available += SL_BT_OTA_PIPELINE_BUFFER_SIZE;
+    }
+  }
+  if (len > available) {
+    stall_begin();
+    return SL_STATUS_WOULD_BLOCK;
+  }
+  stall_end();
+
+  if (psa_hash_update(&hash_operation, data, len) != PSA_SUCCESS) {
+    fail();
+    return SL_STATUS_FAIL;
+  }
+
+  // A buffer started partway through the packet begins at the image offset
+  // reached so far, so advance it chunk by chunk.
+  while (len > 0) {
+    chunk = SL_MIN(len, SL_BT_OTA_PIPELINE_BUFFER_SIZE - fill_len);
+    memcpy(&buffers[fill][fill_len], data, chunk);
+    fill_len += chunk;
+    received += chunk;
+    data += chunk;
+    len -= chunk;
+    if (fill_len == SL_BT_OTA_PIPELINE_BUFFER_SIZE) {
+      buffer_ready[fill] = true;
+      if (buffer_ready[1 - fill]) {
+        fill = NO_BUFFER;
+      } else {
+        start_filling(1 - fill);
+      }
+    }
+  }
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_ota_pipeline_finish(void)
+{
+  sl_status_t sc;
+  uint32_t len;
+  psa_status_t ps;
+  int32_t ret;
+
+  if (state != SL_BT_OTA_PIPELINE_RECEIVING || received != image_size) {
+    return SL_STATUS_INVALID_STATE;
+  }
+
+  // Drain the full buffers; the last one is only partially filled.
+  stall_begin();
+  while (buffer_ready[0] || buffer_ready[1]) {
+    sc = step();
+    if (sc != SL_STATUS_OK) {
+      return sc;
+    }
+  }
+  if (fill != NO_BUFFER && fill_len > 0) {
+    len = (fill_len + FLASH_WORD_SIZE - 1) & ~(FLASH_WORD_SIZE - 1);
+    memset(&buffers[fill][fill_len], 0xff, len - fill_len);
+    while (erased < buffer_offset[fill] + len) {
+      sc = step();
+      if (sc != SL_STATUS_OK) {
+        return sc;
+      }
+    }
+    if (storage->write(storage->context, buffer_offset[fill], buffers[fill], len)
+        != BOOTLOADER_OK) {
+      fail();
+      return SL_STATUS_FAIL;
+    }
+    written += fill_len;
+    fill_len = 0;
+  }
+  stall_end();
+
+  ps = psa_hash_verify(&hash_operation, expected_digest, sizeof(expected_digest));
+  end_tick = sl_sleeptimer_get_tick_count();
+  if (ps != PSA_SUCCESS) {
+    state = SL_BT_OTA_PIPELINE_FAILED;
+    (void)psa_hash_abort(&hash_operation);
+    return (ps == PSA_ERROR_INVALID_SIGNATURE) ? SL_STATUS_INVALID_SIGNATURE : SL_STATUS_FAIL;
+  }
+  state = SL_BT_OTA_PIPELINE_DONE;
+
+  if (storage->install != NULL) {
+    ret = storage->install(storage->context);
+    if (ret != BOOTLOADER_OK) {
+      state = SL_BT_OTA_PIPELINE_FAILED;
+      return (ret == BOOTLOADER_ERROR_STORAGE_BOOTLOAD)
+             ? SL_STATUS_FAIL : SL_STATUS_SECURITY_IMAGE_CHECKSUM_ERROR;
+    }
+    state = SL_BT_OTA_PIPELINE_INSTALLED;
+  }
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_ota_pipeline_reboot(void)
+{
+  if (state != SL_BT_OTA_PIPELINE_INSTALLED) {
+    return SL_STATUS_INVALID_STATE;
+  }
+  bootloader_rebootAndInstall();
+  return SL_STATUS_FAIL;
+}
+
+void sl_bt_ota_pipeline_abort(void)
+{
+  (void)psa_hash_abort(&hash_operation);
+  state = SL_BT_OTA_PIPELINE_IDLE;
+}
+
+void sl_bt_ota_pipeline_process_action(void)
+{
+  if (state == SL_BT_OTA_PIPELINE_RECEIVING) {
+    (void)step();
+  }
+}
+
+void sl_bt_ota_pipeline_get_stats(sl_bt_ota_pipeline_stats_t *stats)
+{
+  uint32_t now = (state == SL_BT_OTA_PIPELINE_RECEIVING)
+                 ? sl_sleeptimer_get_tick_count() : end_tick;
+  uint32_t stall = stall_tick;
+
+  if (stalled) {
+    stall += now - stall_start_tick;
+  }
+  stats->state = state;
+  stats->image_size = image_size;
+  stats->received = received;
+  stats->written = written;
+  stats->erased = erased;
+  stats->elapsed_ms = sl_sleeptimer_tick_to_ms(now - start_tick);
+  stats->stall_ms = sl_sleeptimer_tick_to_ms(stall);
+  stats->bytes_per_second = (stats->elapsed_ms > 0)
+                            ? (uint32_t)(((uint64_t)received * 1000) / stats->elapsed_ms)
+                            : 0;
+}
+
+// -----------------------------------------------------------------------------
+// Private functions
+
+static void start_filling(uint8_t index)
+{
+  fill = index;
+  fill_len = 0;
+  buffer_offset[index] = received;
+}
+
+// Perform one flash operation: write the oldest full buffer if its pages
+// are erased, otherwise erase the next page the image needs.
+static sl_status_t step(void)
+{
+  uint8_t index = flush;
+
+  if (buffer_ready[index]
+      && erased >= buffer_offset[index] + SL_BT_OTA_PIPELINE_BUFFER_SIZE) {
+    if (storage->write(storage->context,
+                       buffer_offset[index],
+                       buffers[index],
+                       SL_BT_OTA_PIPELINE_BUFFER_SIZE) != BOOTLOADER_OK) {
+      fail();
+      return SL_STATUS_FAIL;
+    }
+    written += SL_BT_OTA_PIPELINE_BUFFER_SIZE;
+    buffer_ready[index] = false;
+    flush = 1 - index;
+    if (fill == NO_BUFFER) {
+      start_filling(index);
+    }
+    return SL_STATUS_OK;
+  }
+
+  if (erased < image_size) {
+    if (storage->erase_next(storage->context) != BOOTLOADER_OK) {
+      fail();
+      return SL_STATUS_FAIL;
+    }
+    erased += page_size;
+  }
+  return SL_STATUS_OK;
+}
+
+static void stall_begin(void)
+{
+  if (!stalled) {
+    stalled = true;
+    stall_start_tick = sl_sleeptimer_get_tick_count();
+  }
+}
+
+static void stall_end(void)
+{
+  if (stalled) {
+    stalled = false;
+    stall_tick += sl_sleeptimer_get_tick_count() - stall_start_tick;
+  }
+}
+
+static void fail(void)
+{
+  stall_end();
+  end_tick = sl_sleeptimer_get_tick_count();
+  (void)psa_hash_abort(&hash_operation);
+  state = SL_BT_OTA_PIPELINE_FAILED;
+}
+
+// -----------------------------------------------------------------------------
+// Bootloader storage backend
+
+static int32_t bootloader_begin(void *context, uint32_t *page, uint32_t *slot)
+{
+  BootloaderEraseStatus_t *status = (BootloaderEraseStatus_t *)context;
+  int32_t ret = bootloader_initChunkedEraseStorageSlot(SL_BT_OTA_PIPELINE_SLOT_ID, status);
+
+  if (ret == BOOTLOADER_OK) {
+    *page = status->pageSize;
+    *slot = status->storageSlotInfo.length;
+  }
+  return ret;
+}
+
+static int32_t bootloader_erase_next(void *context)
+{
+  int32_t ret = bootloader_chunkedEraseStorageSlot((BootloaderEraseStatus_t *)context);
+
+  return (ret == BOOTLOADER_ERROR_STORAGE_CONTINUE) ? BOOTLOADER_OK : ret;
+}
+
+static int32_t bootloader_write(void *context, uint32_t offset, uint8_t *data, size_t len)
+{
+  (void)context;
+  return bootloader_writeStorage(SL_BT_OTA_PIPELINE_SLOT_ID, offset, data, len);
+}
+
+// The digest only proves the transfer; the bootloader checks that the
+// image is one it can install (and its signature, with secure boot).
+static int32_t bootloader_install(void *context)
+{
+  int32_t ret;
+
+  (void)context;
+#if !defined(SL_TRUSTZONE_NONSECURE)
+  ret = bootloader_verifyImage(SL_BT_OTA_PIPELINE_SLOT_ID, NULL);
+#else
+  ret = bootloader_verifyImage(SL_BT_OTA_PIPELINE_SLOT_ID);
+#endif
+  if (ret != BOOTLOADER_OK) {
+    return ret;
+  }
+  ret = bootloader_setImageToBootload(SL_BT_OTA_PIPELINE_SLOT_ID);
+  // Not an image problem: report it as a storage error.
+  return (ret != BOOTLOADER_OK) ? BOOTLOADER_ERROR_STORAGE_BOOTLOAD : BOOTLOADER_OK;
+}
+
+// -----------------------------------------------------------------------------
+// RAM storage backend
+
+static int32_t ram_begin(void *context, uint32_t *page, uint32_t *slot)
+{
+  sl_bt_ota_pipeline_ram_storage_t *ram = (sl_bt_ota_pipeline_ram_storage_t *)context;
+
+  ram->erase_offset = 0;
+  *page = ram->page_size;
+  *slot = ram->size;
+  return BOOTLOADER_OK;
+}
+
+static int32_t ram_erase_next(void *context)
+{
+  sl_bt_ota_pipeline_ram_storage_t *ram = (sl_bt_ota_pipeline_ram_storage_t *)context;
+
+  if (ram->erase_offset + ram->page_size > ram->size) {
+    return BOOTLOADER_ERROR_STORAGE_INVALID_ADDRESS;
+  }
+  memset(&ram->memory[ram->erase_offset], 0xff, ram->page_size);
+  ram->erase_offset += ram->page_size;
+  return BOOTLOADER_OK;
+}
+
+static int32_t ram_write(void *context, uint32_t offset, uint8_t *data, size_t len)
+{
+  sl_bt_ota_pipeline_ram_storage_t *ram = (sl_bt_ota_pipeline_ram_storage_t *)context;
+
+  if ((offset % FLASH_WORD_SIZE) != 0 || (len % FLASH_WORD_SIZE) != 0) {
+    return BOOTLOADER_ERROR_STORAGE_NEEDS_ALIGN;
+  }
+  if (offset + len > ram->size) {
+    return BOOTLOADER_ERROR_STORAGE_INVALID_ADDRESS;
+  }
+  for (size_t i = 0; i < len; i++) {
+    if (offset + i >= ram->erase_offset || ram->memory[offset + i] != 0xff) {
+      return BOOTLOADER_ERROR_STORAGE_NEEDS_ERASE;
+    }
+  }
+  memcpy(&ram->memory[offset], data, len);
+  return BOOTLOADER_OK;
+}
@@ -0,0 +1,217 @@
+/***************************************************************************//**
+ * @file
+ * @brief OTA Receive Pipeline
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2025 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef SL_BT_OTA_PIPELINE_H
+#define SL_BT_OTA_PIPELINE_H
+
+/***********************************************************************************************//**
+ * @addtogroup ota_pipeline
+ * @{
+ **************************************************************************************************/
+
+#include <stddef.h>
+#include <stdint.h>
+#include "sl_status.h"
+#include "sl_bt_api.h"
+
+// Size of the SHA-256 digest of the image
+#define SL_BT_OTA_PIPELINE_DIGEST_SIZE  32
+
+// Storage backend. The default one writes the bootloader storage slot; a
+// RAM-backed one can be used to run the pipeline on a host.
+// Functions return 0 (BOOTLOADER_OK) on success.
+typedef struct {
+  // Prepare for erasing from the start of the slot; report the page and
+  // slot sizes in bytes.
+  int32_t (*begin)(void *context, uint32_t *page_size, uint32_t *slot_size);
+  // Erase the next page of the slot.
+  int32_t (*erase_next)(void *context);
+  // Write to already erased storage. Offset and length are word-aligned.
+  int32_t (*write)(void *context, uint32_t offset, uint8_t *data, size_t len);
+  // Check the stored image and select it for installation at the next
+  // reset. NULL when the storage cannot be booted from.
+  int32_t (*install)(void *context);
+  void *context;
+} sl_bt_ota_pipeline_storage_t;
+
+// RAM storage backend. Emulates flash: pages read 0xff once erased, and
+// only erased memory can be written. The fields are private.
+typedef struct {
+  sl_bt_ota_pipeline_storage_t storage;
+  uint8_t *memory;
+  uint32_t size;
+  uint32_t page_size;
+  uint32_t erase_offset;
+} sl_bt_ota_pipeline_ram_storage_t;
+
+// Commands written to the OTA pipeline control characteristic
+#define SL_BT_OTA_PIPELINE_CMD_BEGIN    0x01  // Followed by the image size (uint32, LE) and digest
+#define SL_BT_OTA_PIPELINE_CMD_FINISH   0x02
+#define SL_BT_OTA_PIPELINE_CMD_ABORT    0x03
+
+// ATT errors returned to the client
+#define SL_BT_OTA_PIPELINE_ATT_ERR_STATE      0x80  // No transfer, or transfer incomplete
+#define SL_BT_OTA_PIPELINE_ATT_ERR_PARAMETER  0x81  // Bad command, or image does not fit
+#define SL_BT_OTA_PIPELINE_ATT_ERR_DIGEST     0x82  // Digest mismatch
+#define SL_BT_OTA_PIPELINE_ATT_ERR_STORAGE    0x83  // Storage or hash failure
+#define SL_BT_OTA_PIPELINE_ATT_ERR_IMAGE      0x84  // Image rejected by the bootloader
+
+// Pipeline state
+typedef enum {
+  SL_BT_OTA_PIPELINE_IDLE = 0,
+  SL_BT_OTA_PIPELINE_RECEIVING,
+  SL_BT_OTA_PIPELINE_DONE,
+  SL_BT_OTA_PIPELINE_INSTALLED,   // Done, and selected for the next reset
+  SL_BT_OTA_PIPELINE_FAILED
+} sl_bt_ota_pipeline_state_t;
+
+// Transfer statistics
+typedef struct {
+  sl_bt_ota_pipeline_state_t state;
+  uint32_t image_size;
+  uint32_t received;          // Bytes accepted from the transport
+  uint32_t written;           // Bytes written to storage
+  uint32_t erased;            // Bytes of the slot erased so far
+  uint32_t elapsed_ms;        // Time since the transfer started
+  uint32_t stall_ms;          // Time the transport was held back
+  uint32_t bytes_per_second;  // Average throughput of accepted data
+} sl_bt_ota_pipeline_stats_t;
+
+/**************************************************************************//**
+ * Get the storage backend writing the configured bootloader storage slot.
+ *****************************************************************************/
+const sl_bt_ota_pipeline_storage_t *sl_bt_ota_pipeline_bootloader_storage(void);
+
+/**************************************************************************//**
+ * Set up a RAM storage backend.
+ * @param[out] ram Backend state.
+ * @param[in] memory Memory standing for the storage slot.
+ * @param[in] size Size of the memory; a multiple of the page size.
+ * @param[in] page_size Size of an erase page.
+ * @return The backend, to be passed to sl_bt_ota_pipeline_begin().
+ *****************************************************************************/
+const sl_bt_ota_pipeline_storage_t *sl_bt_ota_pipeline_ram_storage_init(sl_bt_ota_pipeline_ram_storage_t *ram,
+                                                                        uint8_t *memory,
+                                                                        uint32_t size,
+                                                                        uint32_t page_size);
+
+/**************************************************************************//**
+ * Start receiving an image.
+ * @param[in] storage Storage backend.
+ * @param[in] image_size Size of the image in bytes.
+ * @param[in] digest Expected SHA-256 digest of the image.
+ * @retval SL_STATUS_OK Transfer started.
+ * @retval SL_STATUS_INVALID_PARAMETER Image does not fit the slot.
+ * @retval SL_STATUS_FAIL Storage or hash initialization failed.
+ *****************************************************************************/
+sl_status_t sl_bt_ota_pipeline_begin(const sl_bt_ota_pipeline_storage_t *storage,
+                                     uint32_t image_size,
+                                     const uint8_t digest[SL_BT_OTA_PIPELINE_DIGEST_SIZE]);
+
+/**************************************************************************//**
+ * Feed the next part of the image.
+ * The data is hashed and copied immediately; flash is erased and written
+ * from sl_bt_ota_pipeline_process_action().
+ * @param[in] data Image data.
+ * @param[in] len Length of the data.
+ * @retval SL_STATUS_OK Data accepted.
+ * @retval SL_STATUS_WOULD_BLOCK Both buffers are full; retry later.
+ * @retval SL_STATUS_INVALID_STATE No transfer in progress.
+ * @retval SL_STATUS_INVALID_PARAMETER Data beyond the announced image size.
+ *****************************************************************************/
+sl_status_t sl_bt_ota_pipeline_write(const uint8_t *data, size_t len);
+
+/**************************************************************************//**
+ * Write the remaining data and check the digest.
+ * Blocks until the last buffer is in flash; verification itself is a
+ * constant-time comparison of the digest computed while receiving. If the
+ * storage can be booted from, the image is then verified by the bootloader
+ * and selected for installation, and the state becomes
+ * SL_BT_OTA_PIPELINE_INSTALLED.
+ * @retval SL_STATUS_OK Image complete and digest matches.
+ * @retval SL_STATUS_INVALID_SIGNATURE Digest mismatch.
+ * @retval SL_STATUS_SECURITY_IMAGE_CHECKSUM_ERROR Image rejected by the
+ *         bootloader.
+ * @retval SL_STATUS_INVALID_STATE Transfer not in progress or incomplete.
+ * @retval SL_STATUS_FAIL Storage error.
+ *****************************************************************************/
+sl_status_t sl_bt_ota_pipeline_finish(void);
+
+/**************************************************************************//**
+ * Abort the transfer in progress.
+ *****************************************************************************/
+void sl_bt_ota_pipeline_abort(void);
+
+/**************************************************************************//**
+ * Reset into the bootloader, which installs the image and starts it.
+ * Does not return if an image was installed by sl_bt_ota_pipeline_finish().
+ * @retval SL_STATUS_INVALID_STATE No image selected for installation.
+ *****************************************************************************/
+sl_status_t sl_bt_ota_pipeline_reboot(void);
+
+/**************************************************************************//**
+ * Erase ahead and write full buffers, one flash operation per call.
+ * To be called from the main loop.
+ *****************************************************************************/
+void sl_bt_ota_pipeline_process_action(void);
+
+/**************************************************************************//**
+ * Get the transfer statistics.
+ * @param[out] stats Statistics.
+ *****************************************************************************/
+void sl_bt_ota_pipeline_get_stats(sl_bt_ota_pipeline_stats_t *stats);
+
+/**************************************************************************//**
+ * Select the storage used for transfers started over GATT.
+ * The bootloader storage is used by default.
+ * @param[in] storage Storage backend.
+ *****************************************************************************/
+void sl_bt_ota_pipeline_gatt_set_storage(const sl_bt_ota_pipeline_storage_t *storage);
+
+/**************************************************************************//**
+ * Bluetooth stack event handler of the OTA pipeline service.
+ * Starts, feeds and finishes transfers from writes to the control and data
+ * characteristics. Data written with write requests is acknowledged once it
+ * is accepted, which paces the client. Data written with write commands
+ * that does not fit aborts the transfer. Once an image is installed, the
+ * connection is closed and the device resets into the new image.
+ * @param[in] evt Event coming from the Bluetooth stack.
+ *****************************************************************************/
+void sl_bt_ota_pipeline_on_event(sl_bt_msg_t *evt);
+
+/**************************************************************************//**
+ * Run the pipeline and acknowledge a held back data write once it fits.
+ * To be called from the main loop instead of
+ * sl_bt_ota_pipeline_process_action().
+ *****************************************************************************/
+void sl_bt_ota_pipeline_gatt_process_action(void);
+
+/** @} (end addtogroup ota_pipeline) */
+#endif // SL_BT_OTA_PIPELINE_H
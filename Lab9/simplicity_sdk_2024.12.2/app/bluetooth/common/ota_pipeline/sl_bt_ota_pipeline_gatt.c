@@ -0,0 +1,264 @@
+/***************************************************************************//**
+ * @file
+ * @brief OTA Receive Pipeline GATT Transport
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2025 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#include <stdbool.h>
+#include <string.h>
+#include "sl_common.h"
+#include "gatt_db.h"
+#include "app_timer.h"
+#include "sl_bt_ota_pipeline.h"
+#include "sl_bt_ota_pipeline_config.h"
+
+// Length of the begin command: opcode, image size and digest
+#define BEGIN_CMD_LEN  (1 + 4 + SL_BT_OTA_PIPELINE_DIGEST_SIZE)
+
+// ATT maximum attribute value length
+#define ATT_VALUE_MAX_LEN  255
+
+static const sl_bt_ota_pipeline_storage_t *gatt_storage = NULL;
+
+// Connection of the transfer in progress
+static uint8_t transfer_connection = SL_BT_INVALID_CONNECTION_HANDLE;
+
+// Data write request waiting for room in the pipeline
+static bool held = false;
+static uint8_t held_len;
+static uint8_t held_data[ATT_VALUE_MAX_LEN];
+
+// Connection to close before resetting into the installed image
+static uint8_t reboot_connection = SL_BT_INVALID_CONNECTION_HANDLE;
+static app_timer_t reboot_delay;
+
+static void on_control(sl_bt_evt_gatt_server_user_write_request_t *req);
+static void on_data(sl_bt_evt_gatt_server_user_write_request_t *req);
+static uint8_t begin_transfer(uint8_t connection, const uint8_t *cmd, uint8_t len);
+static void end_transfer(void);
+static uint8_t att_error(sl_status_t sc);
+static void reboot_delay_cb(app_timer_t *timer, void *data);
+
+// -----------------------------------------------------------------------------
+// Public functions
+
+void sl_bt_ota_pipeline_gatt_set_storage(const sl_bt_ota_pipeline_storage_t *storage)
+{
+  gatt_storage = storage;
+}
+
+void sl_bt_ota_pipeline_on_event(sl_bt_msg_t *evt)
+{
+  switch (SL_BT_MSG_ID(evt->header)) {
+    case sl_bt_evt_gatt_server_user_write_request_id:
+    {
+      sl_bt_evt_gatt_server_user_write_request_t *req =
+        &evt->data.evt_gatt_server_user_write_request;
+      if (req->characteristic == gattdb_ota_pipeline_control) {
+        on_control(req);
+      } else if (req->characteristic == gattdb_ota_pipeline_data) {
+        on_data(req);
+      }
+      break;
+    }
+
+    case sl_bt_evt_connection_closed_id:
+      if (evt->data.evt_connection_closed.connection == transfer_connection) {
+        sl_bt_ota_pipeline_abort();
+        end_transfer();
+      }
+      if (evt->data.evt_connection_closed.connection == reboot_connection) {
+        (void)sl_bt_ota_pipeline_reboot();
+      }
+      break;
+
+    default:
+      break;
+  }
+}
+
+void sl_bt_ota_pipeline_gatt_process_action(void)
+{
+  sl_status_t sc;
+
+  sl_bt_ota_pipeline_process_action();
+  if (!held) {
+    return;
+  }
+  sc = sl_bt_ota_pipeline_write(held_data, held_len);
+  if (sc == SL_STATUS_WOULD_BLOCK) {
+    return;
+  }
+  held = false;
+  (void)sl_bt_gatt_server_send_user_write_response(transfer_connection,
+                                                   gattdb_ota_pipeline_data,
+                                                   att_error(sc));
+}
+
+// -----------------------------------------------------------------------------
+// Private functions
+
+static void on_control(sl_bt_evt_gatt_server_user_write_request_t *req)
+{
+  uint8_t response = SL_BT_OTA_PIPELINE_ATT_ERR_PARAMETER;
+
+  if (req->value.len >= 1) {
+    switch (req->value.data[0]) {
+      case SL_BT_OTA_PIPELINE_CMD_BEGIN:
+        response = begin_transfer(req->connection, req->value.data, req->value.len);
+        break;
+
+      case SL_BT_OTA_PIPELINE_CMD_FINISH:
+        if (req->connection != transfer_connection || held) {
+          response = SL_BT_OTA_PIPELINE_ATT_ERR_STATE;
+        } else {
+          sl_bt_ota_pipeline_stats_t stats;
+          response = att_error(sl_bt_ota_pipeline_finish());
+          end_transfer();
+          sl_bt_ota_pipeline_get_stats(&stats);
+          if (stats.state == SL_BT_OTA_PIPELINE_INSTALLED) {
+            // Give the response time to reach the client, then close the
+            // connection and reset into the new image.
+            reboot_connection = req->connection;
+            (void)app_timer_start(&reboot_delay,
+                                  SL_BT_OTA_PIPELINE_REBOOT_DELAY_MS,
+                                  reboot_delay_cb,
+                                  NULL,
+                                  false);
+          }
+        }
+        break;
+
+      case SL_BT_OTA_PIPELINE_CMD_ABORT:
+        if (req->connection == transfer_connection) {
+          sl_bt_ota_pipeline_abort();
+          end_transfer();
+        }
+        response = 0;
+        break;
+
+      default:
+        break;
+    }
+  }
+  (void)sl_bt_gatt_server_send_user_write_response(req->connection,
+                                                   gattdb_ota_pipeline_control,
+                                                   response);
+}
+
+static void on_data(sl_bt_evt_gatt_server_user_write_request_t *req)
+{
+  bool command = (req->att_opcode == sl_bt_gatt_write_command);
+  sl_status_t sc;
+
+  if (req->connection != transfer_connection || held) {
+    sc = SL_STATUS_INVALID_STATE;
+  } else {
+    sc = sl_bt_ota_pipeline_write(req->value.data, req->value.len);
+  }
+
+  if (sc == SL_STATUS_WOULD_BLOCK) {
+    if (command) {
+      // Nothing can hold the client back; the data is lost.
+      sl_bt_ota_pipeline_abort();
+      end_transfer();
+      return;
+    }
+    // Answer once the data fits, which holds the client back until then.
+    memcpy(held_data, req->value.data, req->value.len);
+    held_len = req->value.len;
+    held = true;
+    return;
+  }
+  if (!command) {
+    (void)sl_bt_gatt_server_send_user_write_response(req->connection,
+                                                     gattdb_ota_pipeline_data,
+                                                     att_error(sc));
+  }
+}
+
+static uint8_t begin_transfer(uint8_t connection, const uint8_t *cmd, uint8_t len)
+{
+  uint32_t image_size;
+  sl_status_t sc;
+
+  if (len != BEGIN_CMD_LEN) {
+    return SL_BT_OTA_PIPELINE_ATT_ERR_PARAMETER;
+  }
+  if (transfer_connection != SL_BT_INVALID_CONNECTION_HANDLE
+      && transfer_connection != connection) {
+    return SL_BT_OTA_PIPELINE_ATT_ERR_STATE;
+  }
+  image_size = (uint32_t)cmd[1]
+               | ((uint32_t)cmd[2] << 8)
+               | ((uint32_t)cmd[3] << 16)
+               | ((uint32_t)cmd[4] << 24);
+  sc = sl_bt_ota_pipeline_begin((gatt_storage != NULL)
+                                ? gatt_storage : sl_bt_ota_pipeline_bootloader_storage(),
+                                image_size,
+                                &cmd[5]);
+  end_transfer();
+  if (sc == SL_STATUS_OK) {
+    transfer_connection = connection;
+  }
+  return att_error(sc);
+}
+
+static void end_transfer(void)
+{
+  transfer_connection = SL_BT_INVALID_CONNECTION_HANDLE;
+  held = false;
+}
+
+static uint8_t att_error(sl_status_t sc)
+{
+  switch (sc) {
+    case SL_STATUS_OK:
+      return 0;
+    case SL_STATUS_INVALID_STATE:
+      return SL_BT_OTA_PIPELINE_ATT_ERR_STATE;
+    case SL_STATUS_INVALID_PARAMETER:
+      return SL_BT_OTA_PIPELINE_ATT_ERR_PARAMETER;
+    case SL_STATUS_INVALID_SIGNATURE:
+      return SL_BT_OTA_PIPELINE_ATT_ERR_DIGEST;
+    case SL_STATUS_SECURITY_IMAGE_CHECKSUM_ERROR:
+      return SL_BT_OTA_PIPELINE_ATT_ERR_IMAGE;
+    default:
+      return SL_BT_OTA_PIPELINE_ATT_ERR_STORAGE;
+  }
+}
+
+static void reboot_delay_cb(app_timer_t *timer, void *data)
+{
+  (void)timer;
+  (void)data;
+  // The reset follows on the connection closed event. If the client has
+  // already gone, reset right away.
+  if (sl_bt_connection_close(reboot_connection) != SL_STATUS_OK) {
+    (void)sl_bt_ota_pipeline_reboot();
+  }
+}
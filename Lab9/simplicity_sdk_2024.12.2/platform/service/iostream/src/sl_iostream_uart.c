@@ -400,6 +400,7 @@ static sl_power_manager_on_isr_exit_t sleep_on_isr_exit(void *context)
   if (wakeup_from_rx(context)) {
     // MCU was woken-up from RX byte, wakeup from sleep.
     uart_context->sleep = SL_POWER_MANAGER_WAKEUP;
+    sli_power_manager_statistics_log_wakeup(SL_POWER_MANAGER_WAKEUP_SOURCE_UART_RX);
   }
 
   if ((uart_context->tx_idle) && (uart_context->sleep == SL_POWER_MANAGER_SLEEP)) {
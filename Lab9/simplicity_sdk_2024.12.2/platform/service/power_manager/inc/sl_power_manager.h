@@ -34,6 +34,9 @@
 #ifndef SL_POWER_MANAGER_DEBUG
 #include "sl_power_manager_config.h"
 #endif
+#ifndef SL_POWER_MANAGER_STATISTICS
+#define SL_POWER_MANAGER_STATISTICS  0
+#endif
 #include "sl_slist.h"
 #include "sl_status.h"
 #include "sl_sleeptimer.h"
@@ -280,6 +283,16 @@ SL_ENUM(sl_power_manager_on_isr_exit_t) {
   SL_POWER_MANAGER_WAKEUP = (1UL << 2UL),     ///< The module was the one that caused the system wakeup and the system MUST NOT go back to sleep
 };
 
+/// Wake-up sources tracked by the statistics feature
+SL_ENUM(sl_power_manager_wakeup_source_t) {
+  SL_POWER_MANAGER_WAKEUP_SOURCE_SLEEPTIMER = 0,  ///< A sleeptimer timer expired
+  SL_POWER_MANAGER_WAKEUP_SOURCE_GPIO,            ///< A GPIO external interrupt was pending
+  SL_POWER_MANAGER_WAKEUP_SOURCE_RADIO,           ///< A radio interrupt was pending
+  SL_POWER_MANAGER_WAKEUP_SOURCE_UART_RX,         ///< A byte was received on an IO Stream UART
+  SL_POWER_MANAGER_WAKEUP_SOURCE_OTHER,           ///< No known source claimed the wake-up
+  SL_POWER_MANAGER_WAKEUP_SOURCE_COUNT,           ///< Number of wake-up sources
+};
+
 // -----------------------------------------------------------------------------
 // Internal Prototypes only to be used by Power Manager module
 SL_CODE_CLASSIFY(SL_CODE_COMPONENT_POWER_MANAGER, SL_CODE_CLASS_TIME_CRITICAL)
@@ -299,6 +312,15 @@ void sli_power_manager_debug_log_em_requirement(sl_power_manager_em_t em,
 #define sli_power_manager_debug_log_em_requirement(em, add, name) /* no-op */
 #endif
 
+// Same approach for the statistics feature: modules that can wake the system
+// report themselves through this hook, which vanishes when the feature is off.
+#if (SL_POWER_MANAGER_STATISTICS == 1)
+SL_CODE_CLASSIFY(SL_CODE_COMPONENT_POWER_MANAGER, SL_CODE_CLASS_TIME_CRITICAL)
+void sli_power_manager_statistics_log_wakeup(sl_power_manager_wakeup_source_t source);
+#else
+#define sli_power_manager_statistics_log_wakeup(source) /* no-op */
+#endif
+
 // -----------------------------------------------------------------------------
 // Prototypes
 
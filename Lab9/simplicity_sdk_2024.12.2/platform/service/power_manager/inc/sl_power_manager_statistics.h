@@ -0,0 +1,121 @@
+/***************************************************************************//**
+ * @file
+ * @brief Power Manager Statistics API definition.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2025 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#ifndef SL_POWER_MANAGER_STATISTICS_H
+#define SL_POWER_MANAGER_STATISTICS_H
+
+#include "sl_power_manager.h"
+#include "sl_status.h"
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/***************************************************************************//**
+ * @addtogroup power_manager
+ * @{
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+// Data Types
+
+/// @brief Energy mode residency and wake-up counters
+typedef struct {
+  uint64_t elapsed_tick;                                        ///< Sleeptimer ticks since init or last reset.
+  uint64_t em_residency_tick[SL_POWER_MANAGER_EM3 + 1];         ///< Sleeptimer ticks spent in EM0 to EM3.
+  uint32_t sleep_count;                                         ///< Number of times the core entered sleep.
+  uint32_t wakeup_count[SL_POWER_MANAGER_WAKEUP_SOURCE_COUNT];  ///< Wake-ups per source.
+} sl_power_manager_statistics_t;
+
+/// @brief Module that held an EM1 requirement while the system slept in EM1
+typedef struct {
+  const char *module_name;  ///< Name given to the debug feature by the module.
+  uint32_t hold_count;      ///< Number of EM1 sleeps during which the requirement was held.
+  uint64_t hold_tick;       ///< Sleeptimer ticks spent in EM1 while the requirement was held.
+} sl_power_manager_statistics_em1_owner_t;
+
+// -----------------------------------------------------------------------------
+// Prototypes
+
+/***************************************************************************//**
+ * Get a snapshot of the energy mode statistics.
+ *
+ * @param[out] statistics  Structure filled with the current counters.
+ *
+ * @return SL_STATUS_OK on success,
+ *         SL_STATUS_NOT_AVAILABLE if SL_POWER_MANAGER_STATISTICS is disabled.
+ ******************************************************************************/
+sl_status_t sl_power_manager_statistics_get(sl_power_manager_statistics_t *statistics);
+
+/***************************************************************************//**
+ * Get the modules that kept the system in EM1.
+ *
+ * @param[out] owners     Table filled with the owners, in the order they were
+ *                        first seen.
+ *
+ * @param[in]  max_count  Number of entries in @p owners.
+ *
+ * @return Number of entries written.
+ *
+ * @note Owner names come from the debugging feature; this function always
+ *       returns 0 unless SL_POWER_MANAGER_DEBUG is also enabled.
+ ******************************************************************************/
+uint32_t sl_power_manager_statistics_get_em1_owners(sl_power_manager_statistics_em1_owner_t *owners,
+                                                    uint32_t                                max_count);
+
+/***************************************************************************//**
+ * Clear all the counters and restart the elapsed time.
+ ******************************************************************************/
+void sl_power_manager_statistics_reset(void);
+
+/***************************************************************************//**
+ * Print a table with the time spent in each energy mode, the wake-up sources
+ * and the EM1 requirement owners.
+ ******************************************************************************/
+void sl_power_manager_statistics_print(void);
+
+/***************************************************************************//**
+ * Print the statistics when the periodic report is due.
+ *
+ * @note Must be called from the application main loop. The report period is
+ *       set by SL_POWER_MANAGER_STATISTICS_PRINT_PERIOD_MS; a period of 0
+ *       disables the periodic report.
+ ******************************************************************************/
+void sl_power_manager_statistics_process_action(void);
+
+/** @} (end addtogroup power_manager) */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
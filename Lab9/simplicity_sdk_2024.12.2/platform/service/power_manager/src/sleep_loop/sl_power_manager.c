@@ -200,6 +200,7 @@ sl_status_t sl_power_manager_init(void)
   #if (SL_POWER_MANAGER_DEBUG == 1)
     sli_power_manager_debug_init();
   #endif
+    sli_power_manager_statistics_init();
     sli_power_manager_em_transition_event_list_init();
 
 #if !defined(SL_CATALOG_POWER_MANAGER_NO_DEEPSLEEP_PRESENT)
@@ -312,7 +313,9 @@ void sl_power_manager_sleep(void)
     }
 
     // Apply lowest reachable energy mode
+    sli_power_manager_statistics_on_sleep(current_em);
     sli_power_manager_apply_em(current_em);
+    sli_power_manager_statistics_on_wakeup();
 
     // In case we are waiting for the restore from an early wake-up,
     // we put back the current EM to the one before the early wake-up to do the next notification correctly.
@@ -353,7 +356,9 @@ void sl_power_manager_sleep(void)
     }
     // If possible, go back to sleep in EM1 while waiting for HF accuracy restore
     while (!sli_power_manager_is_high_freq_accuracy_clk_ready(false)) {
+      sli_power_manager_statistics_on_sleep(SL_POWER_MANAGER_EM1);
       sli_power_manager_apply_em(SL_POWER_MANAGER_EM1);
+      sli_power_manager_statistics_on_wakeup();
       primask_state = yield_critical_with_primask(primask_state);
     }
     sli_power_manager_restore_states();
@@ -383,7 +388,9 @@ void sl_power_manager_sleep(void)
     // Apply EM1 energy mode
     // Lowest EM is passed so that further actions can be taking by the HAL based on the EM requirements
     // but only EM1 sleep will be entered.
+    sli_power_manager_statistics_on_sleep(SL_POWER_MANAGER_EM1);
     sli_power_manager_apply_em(lowest_em);
+    sli_power_manager_statistics_on_wakeup();
 
     primask_state = yield_critical_with_primask(primask_state);
   } while (sl_power_manager_sleep_on_isr_exit() == true);
@@ -398,6 +405,8 @@ void sl_power_manager_sleep(void)
   sli_power_manager_implement_execution_mode_on_wakeup();
 #endif
 
+  sli_power_manager_statistics_on_exit();
+
   // Indicate back to EM0
   sli_power_manager_notify_em_transition(current_em, SL_POWER_MANAGER_EM0);
   current_em = SL_POWER_MANAGER_EM0;
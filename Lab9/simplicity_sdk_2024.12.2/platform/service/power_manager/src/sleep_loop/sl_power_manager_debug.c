@@ -76,6 +76,17 @@ void sl_power_manager_debug_print_em_requirements(void)
   }
 }
 
+/***************************************************************************//**
+ * Get the modules currently holding a requirement on an energy mode.
+ ******************************************************************************/
+sl_slist_node_t *sli_power_manager_debug_get_em_requirement_owners(sl_power_manager_em_t em)
+{
+  if ((em == SL_POWER_MANAGER_EM0) || (em > SLI_POWER_MANAGER_EM_TABLE_SIZE)) {
+    return NULL;
+  }
+  return power_manager_debug_requirement_em_table[em - 1];
+}
+
 /***************************************************************************//**
  * Initialize debugging feature.
  ******************************************************************************/
@@ -0,0 +1,464 @@
+/***************************************************************************//**
+ * @file
+ * @brief Power Manager Statistics API implementation.
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2025 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * SPDX-License-Identifier: Zlib
+ *
+ * The licensor of this software is Silicon Laboratories Inc.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ ******************************************************************************/
+
+#include "sl_power_manager.h"
+#include "sl_power_manager_config.h"
+#include "sl_power_manager_statistics.h"
+#include "sli_power_manager_private.h"
+
+#if (SL_POWER_MANAGER_STATISTICS == 1)
+#include "em_device.h"
+#include "sl_core.h"
+#include "sl_sleeptimer.h"
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifndef SL_POWER_MANAGER_STATISTICS_EM1_OWNER_TABLE_SIZE
+#define SL_POWER_MANAGER_STATISTICS_EM1_OWNER_TABLE_SIZE  8
+#endif
+
+#ifndef SL_POWER_MANAGER_STATISTICS_PRINT_PERIOD_MS
+#define SL_POWER_MANAGER_STATISTICS_PRINT_PERIOD_MS  0
+#endif
+
+// Energy modes a sleep can be accounted to (EM0 to EM3).
+#define STATISTICS_EM_COUNT  (SL_POWER_MANAGER_EM3 + 1)
+
+// Counters; all updated with interrupts disabled.
+static uint64_t em_residency_tick[STATISTICS_EM_COUNT];
+static uint32_t wakeup_count[SL_POWER_MANAGER_WAKEUP_SOURCE_COUNT];
+static uint32_t sleep_count;
+
+// 64-bit tick count at init or at the last reset.
+static uint64_t reset_tick;
+
+// Tick count and energy mode of the sleep in progress.
+static uint32_t sleep_entry_tick;
+static sl_power_manager_em_t sleep_em;
+
+// Set from the wake-up until the next sleep or the exit of the sleep loop.
+// Wake-up sources reported outside of this window are not ours to count.
+static volatile bool is_wakeup_window_open = false;
+static volatile bool is_wakeup_attributed = false;
+
+#if (SL_POWER_MANAGER_DEBUG == 1)
+static sl_power_manager_statistics_em1_owner_t em1_owner_table[SL_POWER_MANAGER_STATISTICS_EM1_OWNER_TABLE_SIZE];
+static uint32_t em1_owner_count;
+static bool em1_owner_table_ran_out_of_entry = false;
+#endif
+
+#if (SL_POWER_MANAGER_STATISTICS_PRINT_PERIOD_MS > 0)
+static sl_sleeptimer_timer_handle_t print_timer_handle;
+static volatile bool is_print_pending = false;
+#endif
+
+static const char *wakeup_source_name[SL_POWER_MANAGER_WAKEUP_SOURCE_COUNT] = {
+  "sleeptimer",
+  "GPIO",
+  "radio",
+  "UART RX",
+  "other",
+};
+
+static void close_wakeup_window(void);
+static void log_pending_irq_wakeups(void);
+#if (SL_POWER_MANAGER_DEBUG == 1)
+static void log_em1_owners(uint32_t tick);
+#endif
+#if (SL_POWER_MANAGER_STATISTICS_PRINT_PERIOD_MS > 0)
+static void on_print_timeout(sl_sleeptimer_timer_handle_t *handle,
+                             void *data);
+#endif
+
+/***************************************************************************//**
+ * Initialize statistics feature.
+ ******************************************************************************/
+void sli_power_manager_statistics_init(void)
+{
+  reset_tick = sl_sleeptimer_get_tick_count64();
+
+#if (SL_POWER_MANAGER_STATISTICS_PRINT_PERIOD_MS > 0)
+  sl_sleeptimer_start_periodic_timer_ms(&print_timer_handle,
+                                        SL_POWER_MANAGER_STATISTICS_PRINT_PERIOD_MS,
+                                        on_print_timeout,
+                                        NULL,
+                                        0,
+                                        0);
+#endif
+}
+
+/***************************************************************************//**
+ * Record the start of a sleep.
+ *
+ * @param em  Energy mode about to be applied.
+ *
+ * @note Must be called with interrupts disabled.
+ ******************************************************************************/
+void sli_power_manager_statistics_on_sleep(sl_power_manager_em_t em)
+{
+  close_wakeup_window();
+
+  sleep_em = em;
+  sleep_count++;
+  sleep_entry_tick = sl_sleeptimer_get_tick_count();
+}
+
+/***************************************************************************//**
+ * Record the end of a sleep.
+ *
+ * @note Must be called with interrupts disabled, before the ISR that woke the
+ *       core up runs, so that its interrupt is still pending in the NVIC.
+ ******************************************************************************/
+void sli_power_manager_statistics_on_wakeup(void)
+{
+  // Unsigned difference handles the 32-bit counter wrap.
+  uint32_t tick = sl_sleeptimer_get_tick_count() - sleep_entry_tick;
+
+  em_residency_tick[sleep_em] += tick;
+
+#if (SL_POWER_MANAGER_DEBUG == 1)
+  if (sleep_em == SL_POWER_MANAGER_EM1) {
+    log_em1_owners(tick);
+  }
+#endif
+
+  is_wakeup_attributed = false;
+  is_wakeup_window_open = true;
+  log_pending_irq_wakeups();
+}
+
+/***************************************************************************//**
+ * Record the exit of the sleep loop.
+ *
+ * @note Must be called with interrupts disabled.
+ ******************************************************************************/
+void sli_power_manager_statistics_on_exit(void)
+{
+  close_wakeup_window();
+}
+
+/***************************************************************************//**
+ * Count a wake-up for the given source.
+ ******************************************************************************/
+void sli_power_manager_statistics_log_wakeup(sl_power_manager_wakeup_source_t source)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  if (source >= SL_POWER_MANAGER_WAKEUP_SOURCE_COUNT) {
+    return;
+  }
+
+  CORE_ENTER_CRITICAL();
+  if (is_wakeup_window_open) {
+    wakeup_count[source]++;
+    is_wakeup_attributed = true;
+  }
+  CORE_EXIT_CRITICAL();
+}
+
+/***************************************************************************//**
+ * Get a snapshot of the energy mode statistics.
+ ******************************************************************************/
+sl_status_t sl_power_manager_statistics_get(sl_power_manager_statistics_t *statistics)
+{
+  CORE_DECLARE_IRQ_STATE;
+  uint64_t sleep_tick = 0;
+  uint8_t i;
+
+  if (statistics == NULL) {
+    return SL_STATUS_NULL_POINTER;
+  }
+
+  CORE_ENTER_CRITICAL();
+  statistics->elapsed_tick = sl_sleeptimer_get_tick_count64() - reset_tick;
+  for (i = SL_POWER_MANAGER_EM1; i < STATISTICS_EM_COUNT; i++) {
+    statistics->em_residency_tick[i] = em_residency_tick[i];
+    sleep_tick += em_residency_tick[i];
+  }
+  statistics->sleep_count = sleep_count;
+  memcpy(statistics->wakeup_count, wakeup_count, sizeof(wakeup_count));
+  CORE_EXIT_CRITICAL();
+
+  // EM0 is whatever was not spent sleeping.
+  statistics->em_residency_tick[SL_POWER_MANAGER_EM0] = (statistics->elapsed_tick > sleep_tick)
+                                                        ? (statistics->elapsed_tick - sleep_tick) : 0;
+
+  return SL_STATUS_OK;
+}
+
+/***************************************************************************//**
+ * Get the modules that kept the system in EM1.
+ ******************************************************************************/
+uint32_t sl_power_manager_statistics_get_em1_owners(sl_power_manager_statistics_em1_owner_t *owners,
+                                                    uint32_t                                max_count)
+{
+#if (SL_POWER_MANAGER_DEBUG == 1)
+  CORE_DECLARE_IRQ_STATE;
+  uint32_t count;
+
+  if (owners == NULL) {
+    return 0;
+  }
+
+  CORE_ENTER_CRITICAL();
+  count = (em1_owner_count < max_count) ? em1_owner_count : max_count;
+  memcpy(owners, em1_owner_table, count * sizeof(em1_owner_table[0]));
+  CORE_EXIT_CRITICAL();
+
+  return count;
+#else
+  (void)owners;
+  (void)max_count;
+  return 0;
+#endif
+}
+
+/***************************************************************************//**
+ * Clear all the counters and restart the elapsed time.
+ ******************************************************************************/
+void sl_power_manager_statistics_reset(void)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_CRITICAL();
+  memset(em_residency_tick, 0, sizeof(em_residency_tick));
+  memset(wakeup_count, 0, sizeof(wakeup_count));
+  sleep_count = 0;
+#if (SL_POWER_MANAGER_DEBUG == 1)
+  memset(em1_owner_table, 0, sizeof(em1_owner_table));
+  em1_owner_count = 0;
+  em1_owner_table_ran_out_of_entry = false;
+#endif
+  reset_tick = sl_sleeptimer_get_tick_count64();
+  CORE_EXIT_CRITICAL();
+}
+
+/***************************************************************************//**
+ * Print a table with the time spent in each energy mode, the wake-up sources
+ * and the EM1 requirement owners.
+ ******************************************************************************/
+void sl_power_manager_statistics_print(void)
+{
+  sl_power_manager_statistics_t statistics;
+  uint64_t ms;
+  uint8_t i;
+
+  sl_power_manager_statistics_get(&statistics);
+
+  printf("------------------------------------------\n");
+  sl_sleeptimer_tick64_to_ms(statistics.elapsed_tick, &ms);
+  printf("| EM residency over %lu ms, %lu sleeps\n",
+         (unsigned long)ms, (unsigned long)statistics.sleep_count);
+  printf("------------------------------------------\n");
+  for (i = SL_POWER_MANAGER_EM0; i < STATISTICS_EM_COUNT; i++) {
+    sl_sleeptimer_tick64_to_ms(statistics.em_residency_tick[i], &ms);
+    printf("|     EM%d: %lu ms (%lu permille)\n", i, (unsigned long)ms,
+           (statistics.elapsed_tick != 0)
+           ? (unsigned long)((statistics.em_residency_tick[i] * 1000) / statistics.elapsed_tick) : 0UL);
+  }
+  printf("------------------------------------------\n");
+  printf("| Wake-up sources\n");
+  printf("------------------------------------------\n");
+  for (i = 0; i < SL_POWER_MANAGER_WAKEUP_SOURCE_COUNT; i++) {
+    printf("|     %s: %lu\n", wakeup_source_name[i], (unsigned long)statistics.wakeup_count[i]);
+  }
+  printf("------------------------------------------\n");
+
+#if (SL_POWER_MANAGER_DEBUG == 1)
+  sl_power_manager_statistics_em1_owner_t owner;
+  uint32_t j;
+
+  if (em1_owner_table_ran_out_of_entry) {
+    printf("WARNING: Some EM1 requirement owners were not tracked. Increase SL_POWER_MANAGER_STATISTICS_EM1_OWNER_TABLE_SIZE\n");
+  }
+  printf("| EM1 requirement owners\n");
+  printf("------------------------------------------\n");
+  for (j = 0; j < SL_POWER_MANAGER_STATISTICS_EM1_OWNER_TABLE_SIZE; j++) {
+    CORE_DECLARE_IRQ_STATE;
+
+    CORE_ENTER_CRITICAL();
+    if (j >= em1_owner_count) {
+      CORE_EXIT_CRITICAL();
+      break;
+    }
+    owner = em1_owner_table[j];
+    CORE_EXIT_CRITICAL();
+
+    sl_sleeptimer_tick64_to_ms(owner.hold_tick, &ms);
+    printf("|     %s: %lu sleeps, %lu ms\n", owner.module_name,
+           (unsigned long)owner.hold_count, (unsigned long)ms);
+  }
+  printf("------------------------------------------\n");
+#endif
+}
+
+/***************************************************************************//**
+ * Print the statistics when the periodic report is due.
+ ******************************************************************************/
+void sl_power_manager_statistics_process_action(void)
+{
+#if (SL_POWER_MANAGER_STATISTICS_PRINT_PERIOD_MS > 0)
+  if (is_print_pending) {
+    is_print_pending = false;
+    sl_power_manager_statistics_print();
+  }
+#endif
+}
+
+/***************************************************************************//**
+ * Close the window opened at the last wake-up. A wake-up no source claimed
+ * is counted as "other".
+ ******************************************************************************/
+static void close_wakeup_window(void)
+{
+  if (is_wakeup_window_open && !is_wakeup_attributed) {
+    wakeup_count[SL_POWER_MANAGER_WAKEUP_SOURCE_OTHER]++;
+  }
+  is_wakeup_window_open = false;
+}
+
+/***************************************************************************//**
+ * Attribute the wake-up to the interrupts still pending in the NVIC.
+ *
+ * @note GPIO and radio ISRs live in the application and in the stack library,
+ *       so they cannot report themselves like the sleeptimer and IO Stream do.
+ ******************************************************************************/
+static void log_pending_irq_wakeups(void)
+{
+  if (NVIC_GetPendingIRQ(GPIO_ODD_IRQn) || NVIC_GetPendingIRQ(GPIO_EVEN_IRQn)) {
+    wakeup_count[SL_POWER_MANAGER_WAKEUP_SOURCE_GPIO]++;
+    is_wakeup_attributed = true;
+  }
+
+#if defined(_SILICON_LABS_32B_SERIES_2)
+  if (NVIC_GetPendingIRQ(AGC_IRQn)
+      || NVIC_GetPendingIRQ(BUFC_IRQn)
+      || NVIC_GetPendingIRQ(FRC_PRI_IRQn)
+      || NVIC_GetPendingIRQ(FRC_IRQn)
+      || NVIC_GetPendingIRQ(MODEM_IRQn)
+      || NVIC_GetPendingIRQ(PROTIMER_IRQn)
+      || NVIC_GetPendingIRQ(RAC_RSM_IRQn)
+      || NVIC_GetPendingIRQ(RAC_SEQ_IRQn)
+      || NVIC_GetPendingIRQ(SYNTH_IRQn)) {
+    wakeup_count[SL_POWER_MANAGER_WAKEUP_SOURCE_RADIO]++;
+    is_wakeup_attributed = true;
+  }
+#endif
+}
+
+#if (SL_POWER_MANAGER_DEBUG == 1)
+/***************************************************************************//**
+ * Charge an EM1 sleep to every module holding an EM1 requirement.
+ *
+ * @param tick  Duration of the sleep in sleeptimer ticks.
+ ******************************************************************************/
+static void log_em1_owners(uint32_t tick)
+{
+  sli_power_debug_requirement_entry_t *entry;
+
+  SL_SLIST_FOR_EACH_ENTRY(sli_power_manager_debug_get_em_requirement_owners(SL_POWER_MANAGER_EM1),
+                          entry, sli_power_debug_requirement_entry_t, node) {
+    uint32_t i;
+
+    // Module names are string literals, so comparing pointers is enough
+    // for the common case; fall back to strcmp for duplicated literals.
+    for (i = 0; i < em1_owner_count; i++) {
+      if ((em1_owner_table[i].module_name == entry->module_name)
+          || (strcmp(em1_owner_table[i].module_name, entry->module_name) == 0)) {
+        break;
+      }
+    }
+
+    if (i == em1_owner_count) {
+      if (em1_owner_count >= SL_POWER_MANAGER_STATISTICS_EM1_OWNER_TABLE_SIZE) {
+        em1_owner_table_ran_out_of_entry = true;
+        continue;
+      }
+      em1_owner_table[i].module_name = entry->module_name;
+      em1_owner_count++;
+    }
+
+    em1_owner_table[i].hold_count++;
+    em1_owner_table[i].hold_tick += tick;
+  }
+}
+#endif
+
+#if (SL_POWER_MANAGER_STATISTICS_PRINT_PERIOD_MS > 0)
+/***************************************************************************//**
+ * Callback for the periodic report timer.
+ *
+ * @note Printing is deferred to sl_power_manager_statistics_process_action()
+ *       since this runs in interrupt context.
+ ******************************************************************************/
+static void on_print_timeout(sl_sleeptimer_timer_handle_t *handle,
+                             void *data)
+{
+  (void)handle;
+  (void)data;
+
+  is_print_pending = true;
+}
+#endif
+
+#else // SL_POWER_MANAGER_STATISTICS
+
+// Keep the public API linkable when the feature is disabled so applications
+// do not need to guard their calls.
+
+sl_status_t sl_power_manager_statistics_get(sl_power_manager_statistics_t *statistics)
+{
+  (void)statistics;
+  return SL_STATUS_NOT_AVAILABLE;
+}
+
+uint32_t sl_power_manager_statistics_get_em1_owners(sl_power_manager_statistics_em1_owner_t *owners,
+                                                    uint32_t                                max_count)
+{
+  (void)owners;
+  (void)max_count;
+  return 0;
+}
+
+void sl_power_manager_statistics_reset(void)
+{
+}
+
+void sl_power_manager_statistics_print(void)
+{
+}
+
+void sl_power_manager_statistics_process_action(void)
+{
+}
+
+#endif // SL_POWER_MANAGER_STATISTICS
@@ -80,6 +80,37 @@ void sli_power_manager_apply_em(sl_power_manager_em_t em);
 
 void sli_power_manager_debug_init(void);
 
+#if (SL_POWER_MANAGER_DEBUG == 1)
+/*******************************************************************************
+ * Gets the list of modules currently holding a requirement on an energy mode.
+ *
+ * @param em  Energy mode (EM1 or EM2).
+ *
+ * @return Head of a list of sli_power_debug_requirement_entry_t.
+ ******************************************************************************/
+sl_slist_node_t *sli_power_manager_debug_get_em_requirement_owners(sl_power_manager_em_t em);
+#endif
+
+// The statistics hooks sit in the sleep loop; like the debug logging they are
+// pre-processor no-ops when the feature is disabled.
+#if (SL_POWER_MANAGER_STATISTICS == 1)
+void sli_power_manager_statistics_init(void);
+
+SL_CODE_CLASSIFY(SL_CODE_COMPONENT_POWER_MANAGER, SL_CODE_CLASS_TIME_CRITICAL)
+void sli_power_manager_statistics_on_sleep(sl_power_manager_em_t em);
+
+SL_CODE_CLASSIFY(SL_CODE_COMPONENT_POWER_MANAGER, SL_CODE_CLASS_TIME_CRITICAL)
+void sli_power_manager_statistics_on_wakeup(void);
+
+SL_CODE_CLASSIFY(SL_CODE_COMPONENT_POWER_MANAGER, SL_CODE_CLASS_TIME_CRITICAL)
+void sli_power_manager_statistics_on_exit(void);
+#else
+#define sli_power_manager_statistics_init()       /* no-op */
+#define sli_power_manager_statistics_on_sleep(em) /* no-op */
+#define sli_power_manager_statistics_on_wakeup()  /* no-op */
+#define sli_power_manager_statistics_on_exit()    /* no-op */
+#endif
+
 #if !defined(SL_CATALOG_POWER_MANAGER_NO_DEEPSLEEP_PRESENT)
 SL_CODE_CLASSIFY(SL_CODE_COMPONENT_POWER_MANAGER, SL_CODE_CLASS_TIME_CRITICAL)
 void sli_power_manager_save_states(void);
@@ -1314,6 +1314,12 @@ void process_timer_irq(uint8_t local_flag)
       update_delta_list();
     }
 
+#if defined(SL_CATALOG_POWER_MANAGER_PRESENT)
+    if (nb_timer_expire > 0u) {
+      sli_power_manager_statistics_log_wakeup(SL_POWER_MANAGER_WAKEUP_SOURCE_SLEEPTIMER);
+    }
+#endif
+
     // If the only timer expired is the internal Power Manager one,
     // from the Sleeptimer perspective, the system can go back to sleep after the ISR handling.
     sleep_on_isr_exit = false;
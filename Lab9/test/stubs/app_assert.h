@@ -0,0 +1,18 @@
+/* Host stand-in for app_assert.h: a failed assertion aborts the test. */
+#ifndef APP_ASSERT_H
+#define APP_ASSERT_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "sl_status.h"
+
+#define app_assert_status(sc)                                     \
+  do {                                                            \
+    if ((sc) != SL_STATUS_OK) {                                   \
+      fprintf(stderr, "%s:%d: status 0x%04x\n",                   \
+              __FILE__, __LINE__, (unsigned)(sc));                \
+      abort();                                                    \
+    }                                                             \
+  } while (0)
+
+#endif // APP_ASSERT_H
@@ -0,0 +1,77 @@
+/* Host stand-in for app_timer: timers only run when the test fires them. */
+#include <stddef.h>
+#include "app_timer.h"
+
+#define APP_TIMER_MAX 8
+
+static app_timer_t *timers[APP_TIMER_MAX];
+
+sl_status_t app_timer_start(app_timer_t *timer,
+                            uint32_t timeout_ms,
+                            app_timer_callback_t callback,
+                            void *callback_data,
+                            bool is_periodic)
+{
+  int free_slot = -1;
+
+  for (int i = 0; i < APP_TIMER_MAX; i++) {
+    if (timers[i] == timer) {
+      free_slot = i;
+      break;
+    }
+    if (timers[i] == NULL && free_slot < 0) {
+      free_slot = i;
+    }
+  }
+  if (free_slot < 0) {
+    return SL_STATUS_NO_MORE_RESOURCE;
+  }
+  timer->callback = callback;
+  timer->callback_data = callback_data;
+  timer->timeout_ms = timeout_ms;
+  timer->periodic = is_periodic;
+  timer->running = true;
+  timers[free_slot] = timer;
+  return SL_STATUS_OK;
+}
+
+sl_status_t app_timer_stop(app_timer_t *timer)
+{
+  for (int i = 0; i < APP_TIMER_MAX; i++) {
+    if (timers[i] == timer) {
+      timers[i] = NULL;
+    }
+  }
+  timer->running = false;
+  return SL_STATUS_OK;
+}
+
+void app_timer_fire_all(void)
+{
+  app_timer_t *due[APP_TIMER_MAX];
+
+  // Snapshot first: callbacks may start or stop timers.
+  for (int i = 0; i < APP_TIMER_MAX; i++) {
+    due[i] = timers[i];
+  }
+  for (int i = 0; i < APP_TIMER_MAX; i++) {
+    app_timer_t *timer = due[i];
+    if (timer == NULL || !timer->running) {
+      continue;
+    }
+    if (!timer->periodic) {
+      (void)app_timer_stop(timer);
+    }
+    timer->callback(timer, timer->callback_data);
+  }
+}
+
+int app_timer_running_count(void)
+{
+  int count = 0;
+
+  for (int i = 0; i < APP_TIMER_MAX; i++) {
+    count += (timers[i] != NULL);
+  }
+  return count;
+}
@@ -0,0 +1,38 @@
+/* Host stand-in for btl_interface.h: the bootloader calls made by the
+   components are mocked by each test. */
+#ifndef BTL_INTERFACE_H
+#define BTL_INTERFACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "btl_errorcode.h"
+
+typedef struct {
+  uint32_t address;
+  uint32_t length;
+} BootloaderStorageSlot_t;
+
+typedef struct {
+  uint32_t currentPageAddr;
+  uint32_t pageSize;
+  BootloaderStorageSlot_t storageSlotInfo;
+} BootloaderEraseStatus_t;
+
+typedef void (*BootloaderParserCallback_t)(uint32_t address,
+                                           uint8_t  *data,
+                                           size_t   length,
+                                           void     *context);
+
+int32_t bootloader_initChunkedEraseStorageSlot(uint32_t slotId,
+                                               BootloaderEraseStatus_t *eraseStat);
+int32_t bootloader_chunkedEraseStorageSlot(BootloaderEraseStatus_t *eraseStat);
+int32_t bootloader_writeStorage(uint32_t slotId,
+                                uint32_t offset,
+                                uint8_t *buffer,
+                                size_t length);
+int32_t bootloader_verifyImage(uint32_t slotId,
+                               BootloaderParserCallback_t metadataCallback);
+int32_t bootloader_setImageToBootload(int32_t slotId);
+void bootloader_rebootAndInstall(void);
+
+#endif // BTL_INTERFACE_H
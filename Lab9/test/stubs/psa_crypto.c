@@ -0,0 +1,147 @@
+/* SHA-256 (FIPS 180-4) behind the PSA hash calls used by the components. */
+#include <string.h>
+#include "psa/crypto.h"
+
+#define ROR(x, n)  (((x) >> (n)) | ((x) << (32 - (n))))
+
+static const uint32_t k[64] = {
+  0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+  0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+  0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+  0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+  0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+  0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+  0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+  0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+static void compress(uint32_t state[8], const uint8_t block[64])
+{
+  uint32_t w[64];
+  uint32_t a, b, c, d, e, f, g, h;
+
+  for (int i = 0; i < 16; i++) {
+    w[i] = ((uint32_t)block[4 * i] << 24) | ((uint32_t)block[4 * i + 1] << 16)
+           | ((uint32_t)block[4 * i + 2] << 8) | block[4 * i + 3];
+  }
+  for (int i = 16; i < 64; i++) {
+    uint32_t s0 = ROR(w[i - 15], 7) ^ ROR(w[i - 15], 18) ^ (w[i - 15] >> 3);
+    uint32_t s1 = ROR(w[i - 2], 17) ^ ROR(w[i - 2], 19) ^ (w[i - 2] >> 10);
+    w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+  }
+  a = state[0]; b = state[1]; c = state[2]; d = state[3];
+  e = state[4]; f = state[5]; g = state[6]; h = state[7];
+  for (int i = 0; i < 64; i++) {
+    uint32_t t1 = h + (ROR(e, 6) ^ ROR(e, 11) ^ ROR(e, 25)) + ((e & f) ^ (~e & g)) + k[i] + w[i];
+    uint32_t t2 = (ROR(a, 2) ^ ROR(a, 13) ^ ROR(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+    h = g; g = f; f = e; e = d + t1;
+    d = c; c = b; b = a; a = t1 + t2;
+  }
+  state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+  state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+}
+
+psa_status_t psa_hash_setup(psa_hash_operation_t *operation, psa_algorithm_t alg)
+{
+  static const uint32_t init[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+    0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+  };
+
+  if (alg != PSA_ALG_SHA_256) {
+    return PSA_ERROR_NOT_SUPPORTED;
+  }
+  if (operation->active) {
+    return PSA_ERROR_BAD_STATE;
+  }
+  memcpy(operation->state, init, sizeof(init));
+  operation->length = 0;
+  operation->block_len = 0;
+  operation->active = 1;
+  return PSA_SUCCESS;
+}
+
+psa_status_t psa_hash_update(psa_hash_operation_t *operation,
+                             const uint8_t *input,
+                             size_t input_length)
+{
+  if (!operation->active) {
+    return PSA_ERROR_BAD_STATE;
+  }
+  operation->length += input_length;
+  while (input_length > 0) {
+    size_t chunk = sizeof(operation->block) - operation->block_len;
+    if (chunk > input_length) {
+      chunk = input_length;
+    }
+    memcpy(&operation->block[operation->block_len], input, chunk);
+    operation->block_len += chunk;
+    input += chunk;
+    input_length -= chunk;
+    if (operation->block_len == sizeof(operation->block)) {
+      compress(operation->state, operation->block);
+      operation->block_len = 0;
+    }
+  }
+  return PSA_SUCCESS;
+}
+
+psa_status_t psa_hash_finish(psa_hash_operation_t *operation,
+                             uint8_t *hash,
+                             size_t hash_size,
+                             size_t *hash_length)
+{
+  uint64_t bits;
+
+  if (!operation->active) {
+    return PSA_ERROR_BAD_STATE;
+  }
+  if (hash_size < 32) {
+    return PSA_ERROR_BUFFER_TOO_SMALL;
+  }
+  bits = operation->length * 8;
+  operation->block[operation->block_len++] = 0x80;
+  if (operation->block_len > 56) {
+    memset(&operation->block[operation->block_len], 0, 64 - operation->block_len);
+    compress(operation->state, operation->block);
+    operation->block_len = 0;
+  }
+  memset(&operation->block[operation->block_len], 0, 56 - operation->block_len);
+  for (int i = 0; i < 8; i++) {
+    operation->block[56 + i] = (uint8_t)(bits >> (56 - 8 * i));
+  }
+  compress(operation->state, operation->block);
+  for (int i = 0; i < 32; i++) {
+    hash[i] = (uint8_t)(operation->state[i / 4] >> (24 - 8 * (i % 4)));
+  }
+  *hash_length = 32;
+  operation->active = 0;
+  return PSA_SUCCESS;
+}
+
+psa_status_t psa_hash_verify(psa_hash_operation_t *operation,
+                             const uint8_t *hash,
+                             size_t hash_length)
+{
+  uint8_t actual[32];
+  size_t actual_length;
+  uint8_t diff = 0;
+  psa_status_t status = psa_hash_finish(operation, actual, sizeof(actual), &actual_length);
+
+  if (status != PSA_SUCCESS) {
+    return status;
+  }
+  if (hash_length != actual_length) {
+    return PSA_ERROR_INVALID_SIGNATURE;
+  }
+  for (size_t i = 0; i < actual_length; i++) {
+    diff |= actual[i] ^ hash[i];
+  }
+  return (diff == 0) ? PSA_SUCCESS : PSA_ERROR_INVALID_SIGNATURE;
+}
+
+psa_status_t psa_hash_abort(psa_hash_operation_t *operation)
+{
+  memset(operation, 0, sizeof(*operation));
+  return PSA_SUCCESS;
+}
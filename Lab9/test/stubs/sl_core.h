@@ -0,0 +1,9 @@
+/* Host stand-in for sl_core.h: the tests run single threaded. */
+#ifndef SL_CORE_H
+#define SL_CORE_H
+
+#define CORE_DECLARE_IRQ_STATE  int core_irq_state_ = 0
+#define CORE_ENTER_ATOMIC()     (void)core_irq_state_
+#define CORE_EXIT_ATOMIC()      (void)core_irq_state_
+
+#endif // SL_CORE_H
@@ -0,0 +1,25 @@
+/* Host stand-in for sl_sleeptimer.h: one tick per millisecond, set by the
+   test. */
+#ifndef SL_SLEEPTIMER_H
+#define SL_SLEEPTIMER_H
+
+#include <stdint.h>
+
+extern uint32_t sl_sleeptimer_tick_count;
+
+static inline uint32_t sl_sleeptimer_get_tick_count(void)
+{
+  return sl_sleeptimer_tick_count;
+}
+
+static inline uint32_t sl_sleeptimer_ms_to_tick(uint16_t time_ms)
+{
+  return time_ms;
+}
+
+static inline uint32_t sl_sleeptimer_tick_to_ms(uint32_t tick)
+{
+  return tick;
+}
+
+#endif // SL_SLEEPTIMER_H
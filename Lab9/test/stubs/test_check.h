@@ -0,0 +1,28 @@
+/* Minimal checks for the host tests: report and count, keep going. */
+#ifndef TEST_CHECK_H
+#define TEST_CHECK_H
+
+#include <stdio.h>
+
+extern int test_failures;
+
+#define TEST_CHECK(cond)                                          \
+  do {                                                            \
+    if (!(cond)) {                                                \
+      printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+      test_failures++;                                            \
+    }                                                             \
+  } while (0)
+
+#define TEST_CHECK_EQ(actual, expected)                           \
+  do {                                                            \
+    long long a_ = (long long)(actual);                           \
+    long long e_ = (long long)(expected);                          \
+    if (a_ != e_) {                                               \
+      printf("%s:%d: %s is %lld, expected %lld\n",                \
+             __FILE__, __LINE__, #actual, a_, e_);                \
+      test_failures++;                                            \
+    }                                                             \
+  } while (0)
+
+#endif // TEST_CHECK_H
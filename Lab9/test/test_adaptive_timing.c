@@ -0,0 +1,236 @@
+/***************************************************************************//**
+ * @file
+ * @brief Host test of the adaptive timing component
+ *******************************************************************************
+ * Drives the state machine with Bluetooth events and timer ticks, and checks
+ * the advertising intervals and connection parameters it requests through a
+ * mocked Bluetooth API.
+ ******************************************************************************/
+
+#include <string.h>
+#include "app_timer.h"
+#include "sl_bt_adaptive_timing.h"
+#include "test_check.h"
+
+int test_failures;
+
+// Last requests seen by the mocked Bluetooth API
+static struct {
+  int adv_starts;
+  uint32_t adv_interval;
+  int param_requests;
+  uint16_t min_interval;
+  uint16_t max_interval;
+  uint16_t latency;
+  uint16_t timeout;
+} bt;
+
+sl_status_t sl_bt_advertiser_stop(uint8_t advertising_set)
+{
+  (void)advertising_set;
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_advertiser_set_timing(uint8_t advertising_set,
+                                        uint32_t interval_min,
+                                        uint32_t interval_max,
+                                        uint16_t duration,
+                                        uint8_t maxevents)
+{
+  (void)advertising_set;
+  (void)interval_max;
+  (void)duration;
+  (void)maxevents;
+  bt.adv_interval = interval_min;
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_legacy_advertiser_start(uint8_t advertising_set,
+                                          uint8_t connect)
+{
+  (void)advertising_set;
+  (void)connect;
+  bt.adv_starts++;
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_connection_set_parameters(uint8_t connection,
+                                            uint16_t min_interval,
+                                            uint16_t max_interval,
+                                            uint16_t latency,
+                                            uint16_t timeout,
+                                            uint16_t min_ce_length,
+                                            uint16_t max_ce_length)
+{
+  (void)connection;
+  (void)min_ce_length;
+  (void)max_ce_length;
+  bt.param_requests++;
+  bt.min_interval = min_interval;
+  bt.max_interval = max_interval;
+  bt.latency = latency;
+  bt.timeout = timeout;
+  return SL_STATUS_OK;
+}
+
+static sl_bt_adaptive_timing_state_t state(void)
+{
+  sl_bt_adaptive_timing_status_t status;
+
+  sl_bt_adaptive_timing_get_status(&status);
+  return status.state;
+}
+
+static void send_event(uint32_t id, uint8_t connection)
+{
+  sl_bt_msg_t evt;
+
+  memset(&evt, 0, sizeof(evt));
+  evt.header = id;
+  switch (id) {
+    case sl_bt_evt_connection_opened_id:
+      evt.data.evt_connection_opened.connection = connection;
+      break;
+    case sl_bt_evt_connection_closed_id:
+      evt.data.evt_connection_closed.connection = connection;
+      break;
+    case sl_bt_evt_gatt_server_attribute_value_id:
+      evt.data.evt_gatt_server_attribute_value.connection = connection;
+      break;
+    default:
+      break;
+  }
+  sl_bt_adaptive_timing_on_event(&evt);
+}
+
+// Let the given time pass in evaluation periods.
+static void advance_ms(uint32_t ms)
+{
+  for (uint32_t t = 0; t < ms; t += SL_BT_ADAPTIVE_TIMING_EVAL_PERIOD_MS) {
+    app_timer_fire_all();
+  }
+}
+
+static void test_advertising_back_off(void)
+{
+  TEST_CHECK_EQ(sl_bt_adaptive_timing_start_advertising(1), SL_STATUS_OK);
+  TEST_CHECK_EQ(state(), SL_BT_ADAPTIVE_TIMING_STATE_FAST_ADVERTISING);
+  TEST_CHECK_EQ(bt.adv_interval, SL_BT_ADAPTIVE_TIMING_FAST_ADV_INTERVAL);
+  TEST_CHECK_EQ(app_timer_running_count(), 1);
+
+  advance_ms(SL_BT_ADAPTIVE_TIMING_FAST_ADV_TIMEOUT_MS
+             - SL_BT_ADAPTIVE_TIMING_EVAL_PERIOD_MS);
+  TEST_CHECK_EQ(state(), SL_BT_ADAPTIVE_TIMING_STATE_FAST_ADVERTISING);
+
+  advance_ms(SL_BT_ADAPTIVE_TIMING_EVAL_PERIOD_MS);
+  TEST_CHECK_EQ(state(), SL_BT_ADAPTIVE_TIMING_STATE_SLOW_ADVERTISING);
+  TEST_CHECK_EQ(bt.adv_interval, SL_BT_ADAPTIVE_TIMING_SLOW_ADV_INTERVAL);
+  TEST_CHECK_EQ(bt.adv_starts, 2);
+  // Nothing left to evaluate while advertising slowly.
+  TEST_CHECK_EQ(app_timer_running_count(), 0);
+}
+
+static void test_connection_idle_and_active(void)
+{
+  int requests;
+
+  send_event(sl_bt_evt_connection_opened_id, 3);
+  TEST_CHECK_EQ(state(), SL_BT_ADAPTIVE_TIMING_STATE_CONNECTED_ACTIVE);
+  TEST_CHECK_EQ(bt.min_interval, SL_BT_ADAPTIVE_TIMING_ACTIVE_MIN_INTERVAL);
+  TEST_CHECK_EQ(bt.max_interval, SL_BT_ADAPTIVE_TIMING_ACTIVE_MAX_INTERVAL);
+  TEST_CHECK_EQ(bt.latency, SL_BT_ADAPTIVE_TIMING_ACTIVE_LATENCY);
+  TEST_CHECK_EQ(bt.timeout, SL_BT_ADAPTIVE_TIMING_SUPERVISION_TIMEOUT);
+  TEST_CHECK_EQ(app_timer_running_count(), 1);
+
+  // Activity in every period keeps the active profile.
+  requests = bt.param_requests;
+  for (int i = 0; i < 10; i++) {
+    sl_bt_adaptive_timing_report_activity();
+    advance_ms(SL_BT_ADAPTIVE_TIMING_EVAL_PERIOD_MS);
+  }
+  TEST_CHECK_EQ(state(), SL_BT_ADAPTIVE_TIMING_STATE_CONNECTED_ACTIVE);
+  TEST_CHECK_EQ(bt.param_requests, requests);
+
+  // Quiet for the idle timeout: back off once, with peripheral latency.
+  advance_ms(SL_BT_ADAPTIVE_TIMING_IDLE_TIMEOUT_MS);
+  TEST_CHECK_EQ(state(), SL_BT_ADAPTIVE_TIMING_STATE_CONNECTED_IDLE);
+  TEST_CHECK_EQ(bt.param_requests, requests + 1);
+  TEST_CHECK_EQ(bt.min_interval, SL_BT_ADAPTIVE_TIMING_IDLE_MIN_INTERVAL);
+  TEST_CHECK_EQ(bt.max_interval, SL_BT_ADAPTIVE_TIMING_IDLE_MAX_INTERVAL);
+  TEST_CHECK_EQ(bt.latency, SL_BT_ADAPTIVE_TIMING_IDLE_LATENCY);
+  advance_ms(10 * SL_BT_ADAPTIVE_TIMING_EVAL_PERIOD_MS);
+  TEST_CHECK_EQ(bt.param_requests, requests + 1);
+
+  // Reported activity is picked up at the next evaluation.
+  sl_bt_adaptive_timing_report_activity();
+  TEST_CHECK_EQ(state(), SL_BT_ADAPTIVE_TIMING_STATE_CONNECTED_IDLE);
+  advance_ms(SL_BT_ADAPTIVE_TIMING_EVAL_PERIOD_MS);
+  TEST_CHECK_EQ(state(), SL_BT_ADAPTIVE_TIMING_STATE_CONNECTED_ACTIVE);
+  TEST_CHECK_EQ(bt.min_interval, SL_BT_ADAPTIVE_TIMING_ACTIVE_MIN_INTERVAL);
+
+  // A client write switches back at once.
+  advance_ms(SL_BT_ADAPTIVE_TIMING_IDLE_TIMEOUT_MS);
+  TEST_CHECK_EQ(state(), SL_BT_ADAPTIVE_TIMING_STATE_CONNECTED_IDLE);
+  send_event(sl_bt_evt_gatt_server_attribute_value_id, 3);
+  TEST_CHECK_EQ(state(), SL_BT_ADAPTIVE_TIMING_STATE_CONNECTED_ACTIVE);
+  TEST_CHECK_EQ(bt.param_requests, requests + 4);
+}
+
+static void test_threshold(void)
+{
+  sl_bt_adaptive_timing_policy_t policy;
+
+  sl_bt_adaptive_timing_get_policy(&policy);
+  policy.active_threshold = 0;
+  TEST_CHECK_EQ(sl_bt_adaptive_timing_set_policy(&policy),
+                SL_STATUS_INVALID_PARAMETER);
+  policy.active_threshold = 3;
+  TEST_CHECK_EQ(sl_bt_adaptive_timing_set_policy(&policy), SL_STATUS_OK);
+
+  advance_ms(SL_BT_ADAPTIVE_TIMING_IDLE_TIMEOUT_MS);
+  TEST_CHECK_EQ(state(), SL_BT_ADAPTIVE_TIMING_STATE_CONNECTED_IDLE);
+
+  // Two events in a period are below the threshold, and do not add up
+  // with the next period.
+  for (int i = 0; i < 2; i++) {
+    sl_bt_adaptive_timing_report_activity();
+    sl_bt_adaptive_timing_report_activity();
+    advance_ms(SL_BT_ADAPTIVE_TIMING_EVAL_PERIOD_MS);
+    TEST_CHECK_EQ(state(), SL_BT_ADAPTIVE_TIMING_STATE_CONNECTED_IDLE);
+  }
+
+  for (int i = 0; i < 3; i++) {
+    sl_bt_adaptive_timing_report_activity();
+  }
+  advance_ms(SL_BT_ADAPTIVE_TIMING_EVAL_PERIOD_MS);
+  TEST_CHECK_EQ(state(), SL_BT_ADAPTIVE_TIMING_STATE_CONNECTED_ACTIVE);
+}
+
+static void test_disconnect(void)
+{
+  sl_bt_adaptive_timing_status_t status;
+
+  // Closing another connection changes nothing.
+  send_event(sl_bt_evt_connection_closed_id, 4);
+  TEST_CHECK_EQ(state(), SL_BT_ADAPTIVE_TIMING_STATE_CONNECTED_ACTIVE);
+
+  send_event(sl_bt_evt_connection_closed_id, 3);
+  sl_bt_adaptive_timing_get_status(&status);
+  TEST_CHECK_EQ(status.state, SL_BT_ADAPTIVE_TIMING_STATE_STOPPED);
+  TEST_CHECK_EQ(status.connection, SL_BT_INVALID_CONNECTION_HANDLE);
+  TEST_CHECK_EQ(app_timer_running_count(), 0);
+
+  TEST_CHECK_EQ(sl_bt_adaptive_timing_start_advertising(1), SL_STATUS_OK);
+  TEST_CHECK_EQ(bt.adv_interval, SL_BT_ADAPTIVE_TIMING_FAST_ADV_INTERVAL);
+}
+
+int main(void)
+{
+  test_advertising_back_off();
+  test_connection_idle_and_active();
+  test_threshold();
+  test_disconnect();
+
+  printf("test_adaptive_timing: %s\n", test_failures ? "FAILED" : "OK");
+  return test_failures != 0;
+}
@@ -0,0 +1,280 @@
+/***************************************************************************//**
+ * @file
+ * @brief Host test of the notification scheduler
+ *******************************************************************************
+ * Records the notifications handed to a mocked
+ * sl_bt_gatt_server_send_notification() and checks that values set between
+ * two passes are coalesced, that each connection gets at most its credits
+ * per credit period, and how a full TX queue is handled.
+ ******************************************************************************/
+
+#include <string.h>
+#include "app_timer.h"
+#include "sl_bt_notify_scheduler.h"
+#include "sl_bt_notify_scheduler_config.h"
+#include "test_check.h"
+
+#define CHAR_A  21
+#define CHAR_B  23
+
+int test_failures;
+
+typedef struct {
+  uint8_t connection;
+  uint16_t characteristic;
+  uint8_t value;
+} notification_t;
+
+static notification_t sent[256];
+static int sent_count;
+static int db_writes;
+static uint32_t pending_signals;
+// Notifications accepted before the mocked TX queue reports it is full.
+static int tx_queue_space = -1;
+
+sl_status_t sl_bt_external_signal(uint32_t signals)
+{
+  pending_signals |= signals;
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_gatt_server_write_attribute_value(uint16_t attribute,
+                                                    uint16_t offset,
+                                                    size_t value_len,
+                                                    const uint8_t *value)
+{
+  (void)attribute;
+  (void)offset;
+  (void)value_len;
+  (void)value;
+  db_writes++;
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_gatt_server_send_notification(uint8_t connection,
+                                                uint16_t characteristic,
+                                                size_t value_len,
+                                                const uint8_t *value)
+{
+  if (tx_queue_space == 0) {
+    return SL_STATUS_NO_MORE_RESOURCE;
+  }
+  if (tx_queue_space > 0) {
+    tx_queue_space--;
+  }
+  if (sent_count < (int)(sizeof(sent) / sizeof(sent[0]))) {
+    sent[sent_count].connection = connection;
+    sent[sent_count].characteristic = characteristic;
+    sent[sent_count].value = (value_len > 0) ? value[0] : 0;
+    sent_count++;
+  }
+  return SL_STATUS_OK;
+}
+
+static void send_event(sl_bt_msg_t *evt, uint32_t id)
+{
+  evt->header = id;
+  sl_bt_notify_scheduler_on_event(evt);
+}
+
+// Deliver the external signal the way the Bluetooth event loop would.
+static void run_event_loop(void)
+{
+  sl_bt_msg_t evt;
+
+  if (pending_signals == 0) {
+    return;
+  }
+  memset(&evt, 0, sizeof(evt));
+  evt.data.evt_system_external_signal.extsignals = pending_signals;
+  pending_signals = 0;
+  send_event(&evt, sl_bt_evt_system_external_signal_id);
+}
+
+static void open_connection(uint8_t connection)
+{
+  sl_bt_msg_t evt;
+
+  memset(&evt, 0, sizeof(evt));
+  evt.data.evt_connection_opened.connection = connection;
+  send_event(&evt, sl_bt_evt_connection_opened_id);
+}
+
+static void close_connection(uint8_t connection)
+{
+  sl_bt_msg_t evt;
+
+  memset(&evt, 0, sizeof(evt));
+  evt.data.evt_connection_closed.connection = connection;
+  send_event(&evt, sl_bt_evt_connection_closed_id);
+}
+
+static void subscribe(uint8_t connection, uint16_t characteristic, bool enable)
+{
+  sl_bt_msg_t evt;
+
+  memset(&evt, 0, sizeof(evt));
+  evt.data.evt_gatt_server_characteristic_status.connection = connection;
+  evt.data.evt_gatt_server_characteristic_status.characteristic = characteristic;
+  evt.data.evt_gatt_server_characteristic_status.status_flags =
+    sl_bt_gatt_server_client_config;
+  evt.data.evt_gatt_server_characteristic_status.client_config_flags =
+    enable ? sl_bt_gatt_notification : sl_bt_gatt_disable;
+  send_event(&evt, sl_bt_evt_gatt_server_characteristic_status_id);
+}
+
+static void set_value(uint16_t characteristic, uint8_t value)
+{
+  TEST_CHECK_EQ(sl_bt_notify_scheduler_set_value(characteristic, 1, &value),
+                SL_STATUS_OK);
+}
+
+static int count_sent(uint8_t connection, uint16_t characteristic)
+{
+  int count = 0;
+
+  for (int i = 0; i < sent_count; i++) {
+    if (sent[i].connection == connection
+        && sent[i].characteristic == characteristic) {
+      count++;
+    }
+  }
+  return count;
+}
+
+static void test_registration(void)
+{
+  TEST_CHECK_EQ(sl_bt_notify_scheduler_add(CHAR_A), SL_STATUS_OK);
+  TEST_CHECK_EQ(sl_bt_notify_scheduler_add(CHAR_B), SL_STATUS_OK);
+  TEST_CHECK_EQ(sl_bt_notify_scheduler_add(CHAR_A), SL_STATUS_OK);
+  TEST_CHECK_EQ(sl_bt_notify_scheduler_set_value(99, 0, NULL),
+                SL_STATUS_NOT_FOUND);
+  TEST_CHECK_EQ(sl_bt_notify_scheduler_set_value(CHAR_A,
+                                                 SL_BT_NOTIFY_SCHEDULER_MAX_VALUE_LEN + 1,
+                                                 NULL),
+                SL_STATUS_INVALID_PARAMETER);
+}
+
+static void test_coalescing(void)
+{
+  sl_bt_notify_scheduler_stats_t stats;
+
+  open_connection(1);
+  subscribe(1, CHAR_A, true);
+
+  // Five updates before the event loop runs: only the last one is sent,
+  // and the GATT database is written once.
+  for (uint8_t v = 1; v <= 5; v++) {
+    set_value(CHAR_A, v);
+  }
+  TEST_CHECK_EQ(sent_count, 0);
+  run_event_loop();
+  TEST_CHECK_EQ(sent_count, 1);
+  TEST_CHECK_EQ(sent[0].value, 5);
+  TEST_CHECK_EQ(db_writes, 1);
+
+  // Values of a characteristic nobody subscribed to only go to the database.
+  set_value(CHAR_B, 7);
+  run_event_loop();
+  TEST_CHECK_EQ(sent_count, 1);
+  TEST_CHECK_EQ(db_writes, 2);
+
+  sl_bt_notify_scheduler_get_stats(&stats);
+  TEST_CHECK_EQ(stats.updates, 6);
+  TEST_CHECK_EQ(stats.merged, 4);
+  TEST_CHECK_EQ(stats.sent, 1);
+
+  // Let the credits come back.
+  app_timer_fire_all();
+  TEST_CHECK_EQ(app_timer_running_count(), 0);
+}
+
+static void test_budget(void)
+{
+  int sent_before;
+
+  open_connection(2);
+  subscribe(2, CHAR_A, true);
+  subscribe(2, CHAR_B, true);
+  subscribe(1, CHAR_B, true);
+
+  // Each pass queues both values on both connections; each connection
+  // may send SL_BT_NOTIFY_SCHEDULER_TX_CREDITS of them per period.
+  sent_before = sent_count;
+  for (uint8_t v = 10; v < 20; v++) {
+    set_value(CHAR_A, v);
+    set_value(CHAR_B, v);
+    run_event_loop();
+  }
+  TEST_CHECK_EQ(sent_count - sent_before, 2 * SL_BT_NOTIFY_SCHEDULER_TX_CREDITS);
+  TEST_CHECK_EQ(count_sent(1, CHAR_A) + count_sent(1, CHAR_B) - 1,
+                SL_BT_NOTIFY_SCHEDULER_TX_CREDITS);
+  TEST_CHECK_EQ(app_timer_running_count(), 1);
+
+  // The next period sends the latest value of each characteristic, once.
+  sent_before = sent_count;
+  app_timer_fire_all();
+  TEST_CHECK_EQ(sent_count - sent_before, 4);
+  for (int i = sent_before; i < sent_count; i++) {
+    TEST_CHECK_EQ(sent[i].value, 19);
+  }
+
+  // Nothing pending and all credits back: the timer stops.
+  app_timer_fire_all();
+  TEST_CHECK_EQ(sent_count - sent_before, 4);
+  TEST_CHECK_EQ(app_timer_running_count(), 0);
+}
+
+static void test_tx_queue_full(void)
+{
+  sl_bt_notify_scheduler_stats_t before, after;
+  int sent_before = sent_count;
+
+  sl_bt_notify_scheduler_get_stats(&before);
+  tx_queue_space = 1;
+  set_value(CHAR_A, 30);
+  set_value(CHAR_B, 30);
+  run_event_loop();
+  sl_bt_notify_scheduler_get_stats(&after);
+  TEST_CHECK_EQ(sent_count - sent_before, 1);
+  TEST_CHECK(after.deferred > before.deferred);
+
+  // The deferred values are sent once the queue drains.
+  tx_queue_space = -1;
+  app_timer_fire_all();
+  TEST_CHECK_EQ(sent_count - sent_before, 4);
+  app_timer_fire_all();
+  TEST_CHECK_EQ(app_timer_running_count(), 0);
+}
+
+static void test_unsubscribe_and_close(void)
+{
+  sl_bt_notify_scheduler_stats_t before, after;
+  int sent_before = sent_count;
+
+  sl_bt_notify_scheduler_get_stats(&before);
+  set_value(CHAR_A, 40);
+  subscribe(2, CHAR_A, false);
+  close_connection(1);
+  run_event_loop();
+  sl_bt_notify_scheduler_get_stats(&after);
+  TEST_CHECK_EQ(sent_count, sent_before);
+  TEST_CHECK_EQ(after.dropped - before.dropped, 2);
+
+  set_value(CHAR_B, 41);
+  run_event_loop();
+  TEST_CHECK_EQ(sent_count - sent_before, 1);
+  TEST_CHECK_EQ(sent[sent_count - 1].connection, 2);
+}
+
+int main(void)
+{
+  test_registration();
+  test_coalescing();
+  test_budget();
+  test_tx_queue_full();
+  test_unsubscribe_and_close();
+
+  printf("test_notify_scheduler: %s\n", test_failures ? "FAILED" : "OK");
+  return test_failures != 0;
+}
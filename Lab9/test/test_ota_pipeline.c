@@ -0,0 +1,503 @@
+/***************************************************************************//**
+ * @file
+ * @brief Host test of the OTA receive pipeline
+ *******************************************************************************
+ * Streams an image into the RAM storage backend in packets of varying size,
+ * running the pipeline between packets the way the main loop would, and
+ * checks backpressure, the stored image, the erased pages and the digest
+ * check. The GATT transport is then driven with user write request events
+ * and a mocked sl_bt_gatt_server_send_user_write_response(). Last, an image
+ * goes through the bootloader storage backend over a mocked bootloader, which
+ * must verify it, select it and, once the connection is closed, reset into it.
+ ******************************************************************************/
+
+#include <stdbool.h>
+#include <string.h>
+#include "psa/crypto.h"
+#include "app_timer.h"
+#include "btl_interface.h"
+#include "gatt_db.h"
+#include "sl_bt_ota_pipeline.h"
+#include "sl_bt_ota_pipeline_config.h"
+#include "test_check.h"
+
+#define PAGE_SIZE   2048
+#define SLOT_SIZE   (16 * PAGE_SIZE)
+#define IMAGE_SIZE  (5 * PAGE_SIZE + 1234)
+
+#define NO_RESPONSE  0xffff
+
+int test_failures;
+uint32_t sl_sleeptimer_tick_count;
+
+static uint8_t image[IMAGE_SIZE];
+static uint8_t digest[SL_BT_OTA_PIPELINE_DIGEST_SIZE];
+static uint8_t slot[SLOT_SIZE];
+static sl_bt_ota_pipeline_ram_storage_t ram;
+
+// Last response seen by the mocked Bluetooth API
+static struct {
+  int count;
+  uint8_t connection;
+  uint16_t characteristic;
+  uint16_t att_errorcode;
+} response;
+
+static uint8_t closed_connection;
+
+// Mocked bootloader, with its storage slot in slot[]
+static struct {
+  bool present;
+  int32_t verify_result;
+  uint32_t erase_offset;
+  int verify_calls;
+  bool verified_image;        // The slot held the image when verified
+  int set_calls;
+  int32_t set_slot;
+  int reboot_calls;
+} bootloader;
+
+sl_status_t sl_bt_gatt_server_send_user_write_response(uint8_t connection,
+                                                       uint16_t characteristic,
+                                                       uint8_t att_errorcode)
+{
+  response.count++;
+  response.connection = connection;
+  response.characteristic = characteristic;
+  response.att_errorcode = att_errorcode;
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_connection_close(uint8_t connection)
+{
+  closed_connection = connection;
+  return SL_STATUS_OK;
+}
+
+int32_t bootloader_initChunkedEraseStorageSlot(uint32_t slotId,
+                                               BootloaderEraseStatus_t *eraseStat)
+{
+  if (!bootloader.present || slotId != SL_BT_OTA_PIPELINE_SLOT_ID) {
+    return BOOTLOADER_ERROR_STORAGE_INVALID_SLOT;
+  }
+  bootloader.erase_offset = 0;
+  eraseStat->currentPageAddr = 0;
+  eraseStat->pageSize = PAGE_SIZE;
+  eraseStat->storageSlotInfo.address = 0;
+  eraseStat->storageSlotInfo.length = SLOT_SIZE;
+  return BOOTLOADER_OK;
+}
+
+int32_t bootloader_chunkedEraseStorageSlot(BootloaderEraseStatus_t *eraseStat)
+{
+  if (bootloader.erase_offset >= SLOT_SIZE) {
+    return BOOTLOADER_ERROR_STORAGE_INVALID_ADDRESS;
+  }
+  memset(&slot[bootloader.erase_offset], 0xff, PAGE_SIZE);
+  bootloader.erase_offset += PAGE_SIZE;
+  eraseStat->currentPageAddr = bootloader.erase_offset;
+  return (bootloader.erase_offset < SLOT_SIZE) ? BOOTLOADER_ERROR_STORAGE_CONTINUE : BOOTLOADER_OK;
+}
+
+int32_t bootloader_writeStorage(uint32_t slotId, uint32_t offset, uint8_t *buffer, size_t length)
+{
+  if (slotId != SL_BT_OTA_PIPELINE_SLOT_ID || offset + length > bootloader.erase_offset) {
+    return BOOTLOADER_ERROR_STORAGE_NEEDS_ERASE;
+  }
+  memcpy(&slot[offset], buffer, length);
+  return BOOTLOADER_OK;
+}
+
+int32_t bootloader_verifyImage(uint32_t slotId, BootloaderParserCallback_t metadataCallback)
+{
+  (void)metadataCallback;
+  bootloader.verify_calls++;
+  bootloader.verified_image = (slotId == SL_BT_OTA_PIPELINE_SLOT_ID
+                               && memcmp(slot, image, IMAGE_SIZE) == 0);
+  return bootloader.verify_result;
+}
+
+int32_t bootloader_setImageToBootload(int32_t slotId)
+{
+  bootloader.set_calls++;
+  bootloader.set_slot = slotId;
+  return BOOTLOADER_OK;
+}
+
+void bootloader_rebootAndInstall(void)
+{
+  bootloader.reboot_calls++;
+}
+
+static void sha256(const uint8_t *data, size_t len, uint8_t *out)
+{
+  psa_hash_operation_t op = PSA_HASH_OPERATION_INIT;
+  size_t out_len;
+
+  psa_hash_setup(&op, PSA_ALG_SHA_256);
+  psa_hash_update(&op, data, len);
+  psa_hash_finish(&op, out, SL_BT_OTA_PIPELINE_DIGEST_SIZE, &out_len);
+}
+
+// Packet sizes of a BLE link with a few different MTUs.
+static size_t packet_size(int i)
+{
+  static const size_t sizes[] = { 244, 20, 182, 7, 244, 244, 100 };
+
+  return sizes[i % (int)(sizeof(sizes) / sizeof(sizes[0]))];
+}
+
+static const sl_bt_ota_pipeline_storage_t *fresh_slot(void)
+{
+  // Leftovers of a previous image: the pipeline must erase before writing.
+  memset(slot, 0x5a, sizeof(slot));
+  return sl_bt_ota_pipeline_ram_storage_init(&ram, slot, SLOT_SIZE, PAGE_SIZE);
+}
+
+static void test_sha256(void)
+{
+  static const uint8_t abc_digest[] = {
+    0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea, 0x41, 0x41, 0x40, 0xde,
+    0x5d, 0xae, 0x22, 0x23, 0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17, 0x7a, 0x9c,
+    0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00, 0x15, 0xad,
+  };
+  uint8_t out[SL_BT_OTA_PIPELINE_DIGEST_SIZE];
+
+  sha256((const uint8_t *)"abc", 3, out);
+  TEST_CHECK(memcmp(out, abc_digest, sizeof(out)) == 0);
+}
+
+static void test_transfer(void)
+{
+  sl_bt_ota_pipeline_stats_t stats;
+  size_t offset = 0;
+  int blocked = 0;
+  int i = 0;
+
+  TEST_CHECK_EQ(sl_bt_ota_pipeline_write(image, 4), SL_STATUS_INVALID_STATE);
+  TEST_CHECK_EQ(sl_bt_ota_pipeline_begin(fresh_slot(), IMAGE_SIZE, digest),
+                SL_STATUS_OK);
+
+  while (offset < IMAGE_SIZE) {
+    size_t len = packet_size(i);
+    sl_status_t sc;
+
+    if (len > IMAGE_SIZE - offset) {
+      len = IMAGE_SIZE - offset;
+    }
+    sc = sl_bt_ota_pipeline_write(&image[offset], len);
+    if (sc == SL_STATUS_WOULD_BLOCK) {
+      // Nothing of a refused packet is taken.
+      sl_bt_ota_pipeline_get_stats(&stats);
+      TEST_CHECK_EQ(stats.received, offset);
+      blocked++;
+    } else {
+      TEST_CHECK_EQ(sc, SL_STATUS_OK);
+      offset += len;
+      i++;
+    }
+    // The main loop gets one flash operation in every third packet.
+    if (i % 3 == 0 || sc == SL_STATUS_WOULD_BLOCK) {
+      sl_bt_ota_pipeline_process_action();
+    }
+    sl_sleeptimer_tick_count++;
+  }
+  TEST_CHECK(blocked > 0);
+
+  // The buffers never hold more than two of their sizes of unwritten data.
+  sl_bt_ota_pipeline_get_stats(&stats);
+  TEST_CHECK(stats.received - stats.written <= 2 * SL_BT_OTA_PIPELINE_BUFFER_SIZE);
+  TEST_CHECK(stats.stall_ms > 0);
+
+  TEST_CHECK_EQ(sl_bt_ota_pipeline_write(image, 1), SL_STATUS_INVALID_PARAMETER);
+  TEST_CHECK_EQ(sl_bt_ota_pipeline_finish(), SL_STATUS_OK);
+
+  sl_bt_ota_pipeline_get_stats(&stats);
+  TEST_CHECK_EQ(stats.state, SL_BT_OTA_PIPELINE_DONE);
+  TEST_CHECK_EQ(stats.written, IMAGE_SIZE);
+  TEST_CHECK(memcmp(slot, image, IMAGE_SIZE) == 0);
+  // Only the pages the image needs are erased; the rest is untouched.
+  TEST_CHECK_EQ(stats.erased, 6 * PAGE_SIZE);
+  TEST_CHECK_EQ(slot[6 * PAGE_SIZE], 0x5a);
+  TEST_CHECK_EQ(slot[IMAGE_SIZE], 0xff);
+}
+
+static void test_rejections(void)
+{
+  uint8_t bad_digest[SL_BT_OTA_PIPELINE_DIGEST_SIZE];
+
+  TEST_CHECK_EQ(sl_bt_ota_pipeline_begin(fresh_slot(), SLOT_SIZE + 1, digest),
+                SL_STATUS_INVALID_PARAMETER);
+  TEST_CHECK_EQ(sl_bt_ota_pipeline_begin(fresh_slot(), 0, digest),
+                SL_STATUS_INVALID_PARAMETER);
+
+  memcpy(bad_digest, digest, sizeof(bad_digest));
+  bad_digest[0] ^= 1;
+  TEST_CHECK_EQ(sl_bt_ota_pipeline_begin(fresh_slot(), 100, bad_digest),
+                SL_STATUS_OK);
+  TEST_CHECK_EQ(sl_bt_ota_pipeline_write(image, 50), SL_STATUS_OK);
+  TEST_CHECK_EQ(sl_bt_ota_pipeline_finish(), SL_STATUS_INVALID_STATE);
+  TEST_CHECK_EQ(sl_bt_ota_pipeline_write(&image[50], 50), SL_STATUS_OK);
+  TEST_CHECK_EQ(sl_bt_ota_pipeline_finish(), SL_STATUS_INVALID_SIGNATURE);
+
+  // Without a bootloader the default backend cannot start.
+  TEST_CHECK_EQ(sl_bt_ota_pipeline_begin(sl_bt_ota_pipeline_bootloader_storage(),
+                                         100, digest),
+                SL_STATUS_FAIL);
+
+  // Nothing to install from RAM.
+  TEST_CHECK_EQ(sl_bt_ota_pipeline_reboot(), SL_STATUS_INVALID_STATE);
+  TEST_CHECK_EQ(bootloader.verify_calls, 0);
+}
+
+static void write_request(uint8_t connection,
+                          uint16_t characteristic,
+                          uint8_t att_opcode,
+                          const uint8_t *data,
+                          size_t len)
+{
+  struct {
+    sl_bt_msg_t msg;
+    uint8_t payload[255];
+  } evt;
+  sl_bt_evt_gatt_server_user_write_request_t *req =
+    &evt.msg.data.evt_gatt_server_user_write_request;
+
+  memset(&evt, 0, sizeof(evt));
+  evt.msg.header = sl_bt_evt_gatt_server_user_write_request_id;
+  req->connection = connection;
+  req->characteristic = characteristic;
+  req->att_opcode = att_opcode;
+  req->value.len = (uint8_t)len;
+  memcpy(req->value.data, data, len);
+  response.att_errorcode = NO_RESPONSE;
+  sl_bt_ota_pipeline_on_event(&evt.msg);
+}
+
+static void send_begin(uint8_t connection, uint32_t size)
+{
+  uint8_t cmd[1 + 4 + SL_BT_OTA_PIPELINE_DIGEST_SIZE];
+
+  cmd[0] = SL_BT_OTA_PIPELINE_CMD_BEGIN;
+  cmd[1] = (uint8_t)size;
+  cmd[2] = (uint8_t)(size >> 8);
+  cmd[3] = (uint8_t)(size >> 16);
+  cmd[4] = (uint8_t)(size >> 24);
+  memcpy(&cmd[5], digest, SL_BT_OTA_PIPELINE_DIGEST_SIZE);
+  write_request(connection, gattdb_ota_pipeline_control,
+                sl_bt_gatt_write_request, cmd, sizeof(cmd));
+}
+
+static void send_command(uint8_t connection, uint8_t command)
+{
+  write_request(connection, gattdb_ota_pipeline_control,
+                sl_bt_gatt_write_request, &command, 1);
+}
+
+static void send_image(uint8_t connection)
+{
+  size_t offset = 0;
+
+  while (offset < IMAGE_SIZE) {
+    size_t len = (IMAGE_SIZE - offset < 244) ? IMAGE_SIZE - offset : 244;
+
+    write_request(connection, gattdb_ota_pipeline_data, sl_bt_gatt_write_request,
+                  &image[offset], len);
+    while (response.att_errorcode == NO_RESPONSE) {
+      sl_bt_ota_pipeline_gatt_process_action();
+    }
+    TEST_CHECK_EQ(response.att_errorcode, 0);
+    offset += len;
+  }
+}
+
+static void close_connection(uint8_t connection)
+{
+  sl_bt_msg_t evt;
+
+  memset(&evt, 0, sizeof(evt));
+  evt.header = sl_bt_evt_connection_closed_id;
+  evt.data.evt_connection_closed.connection = connection;
+  sl_bt_ota_pipeline_on_event(&evt);
+}
+
+static void test_gatt_write_requests(void)
+{
+  size_t offset = 0;
+  int held = 0;
+
+  sl_bt_ota_pipeline_gatt_set_storage(fresh_slot());
+  send_begin(1, IMAGE_SIZE);
+  TEST_CHECK_EQ(response.connection, 1);
+  TEST_CHECK_EQ(response.characteristic, gattdb_ota_pipeline_control);
+  TEST_CHECK_EQ(response.att_errorcode, 0);
+
+  // Only the connection that started the transfer may send data.
+  write_request(2, gattdb_ota_pipeline_data, sl_bt_gatt_write_request, image, 4);
+  TEST_CHECK_EQ(response.att_errorcode, SL_BT_OTA_PIPELINE_ATT_ERR_STATE);
+
+  // The client sends the next packet only once the previous one is answered.
+  while (offset < IMAGE_SIZE) {
+    size_t len = (IMAGE_SIZE - offset < 244) ? IMAGE_SIZE - offset : 244;
+
+    write_request(1, gattdb_ota_pipeline_data, sl_bt_gatt_write_request,
+                  &image[offset], len);
+    while (response.att_errorcode == NO_RESPONSE) {
+      held++;
+      // The held packet must not be answered before there is room.
+      sl_bt_ota_pipeline_gatt_process_action();
+    }
+    TEST_CHECK_EQ(response.characteristic, gattdb_ota_pipeline_data);
+    TEST_CHECK_EQ(response.att_errorcode, 0);
+    offset += len;
+  }
+  TEST_CHECK(held > 0);
+
+  send_command(1, SL_BT_OTA_PIPELINE_CMD_FINISH);
+  TEST_CHECK_EQ(response.att_errorcode, 0);
+  TEST_CHECK(memcmp(slot, image, IMAGE_SIZE) == 0);
+
+  // No transfer left to finish.
+  send_command(1, SL_BT_OTA_PIPELINE_CMD_FINISH);
+  TEST_CHECK_EQ(response.att_errorcode, SL_BT_OTA_PIPELINE_ATT_ERR_STATE);
+
+  // A RAM slot cannot be booted from: the connection stays open.
+  TEST_CHECK_EQ(app_timer_running_count(), 0);
+}
+
+static void test_gatt_write_commands(void)
+{
+  sl_bt_ota_pipeline_stats_t stats;
+  size_t offset = 0;
+  int count;
+
+  // Unpaced write commands overflow the buffers and abort the transfer.
+  sl_bt_ota_pipeline_gatt_set_storage(fresh_slot());
+  send_begin(1, IMAGE_SIZE);
+  TEST_CHECK_EQ(response.att_errorcode, 0);
+  count = response.count;
+  while (offset < IMAGE_SIZE) {
+    write_request(1, gattdb_ota_pipeline_data, sl_bt_gatt_write_command,
+                  &image[offset], 244);
+    sl_bt_ota_pipeline_get_stats(&stats);
+    if (stats.state != SL_BT_OTA_PIPELINE_RECEIVING) {
+      break;
+    }
+    offset += 244;
+  }
+  TEST_CHECK_EQ(stats.state, SL_BT_OTA_PIPELINE_IDLE);
+  TEST_CHECK(offset < IMAGE_SIZE);
+  // Write commands are never answered.
+  TEST_CHECK_EQ(response.count, count);
+
+  send_command(1, SL_BT_OTA_PIPELINE_CMD_FINISH);
+  TEST_CHECK_EQ(response.att_errorcode, SL_BT_OTA_PIPELINE_ATT_ERR_STATE);
+}
+
+static void test_gatt_control(void)
+{
+  sl_bt_ota_pipeline_stats_t stats;
+  uint8_t opcode = 0x7f;
+
+  write_request(1, gattdb_ota_pipeline_control, sl_bt_gatt_write_request,
+                &opcode, 1);
+  TEST_CHECK_EQ(response.att_errorcode, SL_BT_OTA_PIPELINE_ATT_ERR_PARAMETER);
+  send_begin(1, SLOT_SIZE + 1);
+  TEST_CHECK_EQ(response.att_errorcode, SL_BT_OTA_PIPELINE_ATT_ERR_PARAMETER);
+
+  // A second client cannot take over a transfer.
+  send_begin(1, IMAGE_SIZE);
+  TEST_CHECK_EQ(response.att_errorcode, 0);
+  send_begin(2, IMAGE_SIZE);
+  TEST_CHECK_EQ(response.att_errorcode, SL_BT_OTA_PIPELINE_ATT_ERR_STATE);
+
+  // Closing the connection aborts the transfer, and frees it for others.
+  close_connection(1);
+  sl_bt_ota_pipeline_get_stats(&stats);
+  TEST_CHECK_EQ(stats.state, SL_BT_OTA_PIPELINE_IDLE);
+  send_begin(2, IMAGE_SIZE);
+  TEST_CHECK_EQ(response.att_errorcode, 0);
+
+  send_command(2, SL_BT_OTA_PIPELINE_CMD_ABORT);
+  TEST_CHECK_EQ(response.att_errorcode, 0);
+  sl_bt_ota_pipeline_get_stats(&stats);
+  TEST_CHECK_EQ(stats.state, SL_BT_OTA_PIPELINE_IDLE);
+}
+
+static void test_gatt_install(void)
+{
+  sl_bt_ota_pipeline_stats_t stats;
+  uint8_t bad_digest[SL_BT_OTA_PIPELINE_DIGEST_SIZE];
+
+  memset(slot, 0x5a, sizeof(slot));
+  bootloader.present = true;
+  sl_bt_ota_pipeline_gatt_set_storage(sl_bt_ota_pipeline_bootloader_storage());
+
+  // An image the bootloader rejects is not selected, and nothing resets.
+  bootloader.verify_result = BOOTLOADER_ERROR_PARSER_SIGNATURE;
+  send_begin(1, IMAGE_SIZE);
+  TEST_CHECK_EQ(response.att_errorcode, 0);
+  send_image(1);
+  send_command(1, SL_BT_OTA_PIPELINE_CMD_FINISH);
+  TEST_CHECK_EQ(response.att_errorcode, SL_BT_OTA_PIPELINE_ATT_ERR_IMAGE);
+  TEST_CHECK_EQ(bootloader.verify_calls, 1);
+  TEST_CHECK_EQ(bootloader.set_calls, 0);
+  TEST_CHECK_EQ(app_timer_running_count(), 0);
+  TEST_CHECK_EQ(sl_bt_ota_pipeline_reboot(), SL_STATUS_INVALID_STATE);
+  TEST_CHECK_EQ(bootloader.reboot_calls, 0);
+
+  // A digest mismatch stops before the bootloader is asked.
+  memcpy(bad_digest, digest, sizeof(bad_digest));
+  bad_digest[0] ^= 1;
+  TEST_CHECK_EQ(sl_bt_ota_pipeline_begin(sl_bt_ota_pipeline_bootloader_storage(),
+                                         4, bad_digest),
+                SL_STATUS_OK);
+  TEST_CHECK_EQ(sl_bt_ota_pipeline_write(image, 4), SL_STATUS_OK);
+  TEST_CHECK_EQ(sl_bt_ota_pipeline_finish(), SL_STATUS_INVALID_SIGNATURE);
+  TEST_CHECK_EQ(bootloader.verify_calls, 1);
+
+  // A good image is verified in the slot, then selected for the next reset.
+  bootloader.verify_result = BOOTLOADER_OK;
+  send_begin(1, IMAGE_SIZE);
+  send_image(1);
+  send_command(1, SL_BT_OTA_PIPELINE_CMD_FINISH);
+  TEST_CHECK_EQ(response.att_errorcode, 0);
+  TEST_CHECK_EQ(bootloader.verify_calls, 2);
+  TEST_CHECK(bootloader.verified_image);
+  TEST_CHECK_EQ(bootloader.set_calls, 1);
+  TEST_CHECK_EQ(bootloader.set_slot, SL_BT_OTA_PIPELINE_SLOT_ID);
+  sl_bt_ota_pipeline_get_stats(&stats);
+  TEST_CHECK_EQ(stats.state, SL_BT_OTA_PIPELINE_INSTALLED);
+
+  // The response goes out first; the connection is closed after a delay,
+  // and the device resets into the bootloader once it is.
+  TEST_CHECK_EQ(bootloader.reboot_calls, 0);
+  TEST_CHECK_EQ(app_timer_running_count(), 1);
+  closed_connection = SL_BT_INVALID_CONNECTION_HANDLE;
+  app_timer_fire_all();
+  TEST_CHECK_EQ(closed_connection, 1);
+  TEST_CHECK_EQ(bootloader.reboot_calls, 0);
+  close_connection(2);
+  TEST_CHECK_EQ(bootloader.reboot_calls, 0);
+  close_connection(1);
+  TEST_CHECK_EQ(bootloader.reboot_calls, 1);
+}
+
+int main(void)
+{
+  for (size_t i = 0; i < sizeof(image); i++) {
+    image[i] = (uint8_t)(i * 131 + (i >> 8));
+  }
+  sha256(image, sizeof(image), digest);
+
+  test_sha256();
+  test_transfer();
+  test_rejections();
+  test_gatt_write_requests();
+  test_gatt_write_commands();
+  test_gatt_control();
+  test_gatt_install();
+
+  printf("test_ota_pipeline: %s\n", test_failures ? "FAILED" : "OK");
+  return test_failures != 0;
+}